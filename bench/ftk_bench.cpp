@@ -0,0 +1,402 @@
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "ftk/external/cxxopts.hpp"
+#include "ftk/filters/json_interface.hh"
+#include "ftk/filters/contour_tracker_2d_regular.hh"
+#include "ftk/filters/contour_tracker_3d_regular.hh"
+#include "ftk/filters/critical_line_tracker_3d_regular.hh"
+
+// ftk_bench: tracks features in the synthetic cases of ndarray_stream at 
+// given scales, thread backends, and numbers of threads, and reports 
+// throughput and memory usage in JSON.  Features are critical points (all 
+// cases), contours (scalar cases), and critical lines (the zero lines of 
+// the first two components in 3D vector cases); cases that do not fit a 
+// feature are skipped.  TDGL vortices are not covered, as there is no 
+// synthetic TDGL input.  With --baseline, the results are compared with a 
+// previous run and regressions are reported in the exit code.
+
+using namespace ftk;
+
+// bytes allocated with operator new, including those in libftk
+static std::atomic<size_t> bytes_allocated(0);
+
+void* operator new(size_t n)
+{
+  bytes_allocated += n;
+  if (void *p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+
+struct bench_case_t {
+  std::string name;
+  std::vector<int> dims; // at scale 1
+};
+
+static const std::vector<bench_case_t> all_cases = {
+  {"woven", {32, 32}},
+  {"double_gyre", {64, 32}},
+  {"merger_2d", {32, 32}},
+  {"moving_extremum_2d", {21, 21}},
+  {"moving_extremum_3d", {21, 21, 21}},
+  {"moving_ramp_3d", {21, 21, 21}},
+  {"tornado", {32, 32, 32}},
+  {"abc_flow", {32, 32, 32}}
+};
+
+static std::vector<std::string> split(const std::string& str, char delim = ',')
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss(str);
+  std::string token;
+  while (std::getline(ss, token, delim))
+    if (!token.empty()) tokens.push_back(token);
+  return tokens;
+}
+
+// resets the peak resident set size of the process (linux >= 4.0)
+static bool reset_peak_rss()
+{
+  std::ofstream f("/proc/self/clear_refs");
+  if (!f.is_open()) return false;
+  f << "5";
+  return f.good();
+}
+
+static size_t peak_rss()
+{
+  std::ifstream f("/proc/self/status");
+  std::string line;
+  while (std::getline(f, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::stoull(line.substr(6)) * 1024; // in kB
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss * 1024;
+}
+
+static std::string result_key(const json& r)
+{
+  std::stringstream ss;
+  ss << r.value("feature", "critical_point") << "/" 
+     << r["case"].get<std::string>() << "/" << r["dims"].dump() << "/"
+     << r["thread_backend"].get<std::string>() << "/" << r["nthreads"].get<int>();
+  return ss.str();
+}
+
+// drives a contour or critical line tracker w/ the stream, as ftk does
+template <typename Tracker, typename Push>
+static void track(Tracker& tracker, ndarray_stream<>& stream, Push push, json& timings)
+{
+  auto t0 = clock_type::now();
+  tracker.initialize();
+  stream.set_callback([&](int k, const ndarray<double>& field_data) {
+    push(field_data);
+    if (k != 0) tracker.advance_timestep();
+    if (k == (int)stream.n_timesteps() - 1) tracker.update_timestep();
+  });
+  stream.start();
+  stream.finish();
+
+  auto t1 = clock_type::now();
+  tracker.finalize();
+  auto t2 = clock_type::now();
+
+  timings["t_compute"] = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+  timings["t_finalize"] = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() * 1e-9;
+}
+
+static json run(const std::string& feature, const bench_case_t& c, int scale, int n_timesteps,
+    const std::string& backend, int nthreads, double threshold, const json& jconfig, bool verbose,
+    diy::mpi::communicator comm)
+{
+  std::vector<size_t> dims;
+  for (auto d : c.dims)
+    dims.push_back(d * scale);
+
+  json jstream = {
+    {"type", "synthetic"},
+    {"name", c.name},
+    {"dimensions", dims}
+  };
+  if (n_timesteps > 0) jstream["n_timesteps"] = n_timesteps;
+
+  json jc = jconfig;
+  jc["thread_backend"] = backend;
+  jc["nthreads"] = nthreads;
+
+  {
+    ndarray_stream<> stream(comm);
+    stream.configure(jstream);
+    const size_t nc = stream.n_components();
+    if ((feature == "contour" && nc != 1) || (feature == "critical_line" && (dims.size() != 3 || nc < 2)))
+      return json(); // skipped
+  }
+
+  // tracker outputs are suppressed unless verbose
+  int stderr_fd = -1;
+  if (!verbose) {
+    fflush(stderr);
+    stderr_fd = dup(2);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 2);
+    close(null_fd);
+  }
+
+  reset_peak_rss();
+  const size_t bytes0 = bytes_allocated;
+  auto t0 = clock_type::now();
+
+  size_t nsimplices = 0, npoints = 0, ntrajs = 0;
+  double kernel_time = 0;
+  json timings;
+  if (feature == "critical_point") {
+    ndarray_stream<> stream(comm);
+    stream.configure(jstream);
+
+    json_interface consumer;
+    consumer.configure(jc);
+    consumer.consume(stream, comm);
+
+    auto tracker = consumer.get_tracker();
+    auto rtracker = std::dynamic_pointer_cast<regular_tracker>(tracker);
+    if (rtracker) nsimplices = rtracker->get_number_of_scanned_simplices();
+    npoints = tracker->get_critical_points().size();
+    ntrajs = tracker->get_traced_critical_points().size();
+    kernel_time = tracker->get_accumulated_kernel_time();
+    timings = consumer.get_timings();
+  } else if (feature == "contour") {
+    ndarray_stream<> stream(comm);
+    stream.configure(jstream);
+
+    std::shared_ptr<contour_tracker_regular> tracker;
+    if (dims.size() == 2) {
+      tracker.reset(new contour_tracker_2d_regular(comm));
+      tracker->set_domain(lattice({0, 0}, {dims[0], dims[1]}));
+      tracker->set_array_domain(lattice({0, 0}, {dims[0], dims[1]}));
+    } else {
+      tracker.reset(new contour_tracker_3d_regular(comm));
+      tracker->set_domain(lattice({0, 0, 0}, {dims[0]-2, dims[1]-2, dims[2]-2}));
+      tracker->set_array_domain(lattice({0, 0, 0}, {dims[0], dims[1], dims[2]}));
+    }
+    tracker->set_end_timestep(stream.n_timesteps() - 1);
+    tracker->use_thread_backend(backend);
+    tracker->set_number_of_threads(nthreads);
+    tracker->set_threshold(threshold);
+    track(*tracker, stream, [&](const ndarray<double>& d) {tracker->push_field_data_snapshot(d);}, timings);
+
+    nsimplices = tracker->get_number_of_scanned_simplices();
+    npoints = tracker->get_discrete_intersections().size();
+    kernel_time = tracker->get_accumulated_kernel_time();
+  } else if (feature == "critical_line") {
+    ndarray_stream<> stream(comm);
+    stream.configure(jstream);
+
+    critical_line_tracker_3d_regular tracker(comm);
+    tracker.set_domain(lattice({0, 0, 0}, {dims[0]-2, dims[1]-2, dims[2]-2}));
+    tracker.set_array_domain(lattice({0, 0, 0}, {dims[0], dims[1], dims[2]}));
+    tracker.set_end_timestep(stream.n_timesteps() - 1);
+    tracker.use_thread_backend(backend);
+    tracker.set_number_of_threads(nthreads);
+
+    track(tracker, stream, [&](const ndarray<double>& d) { // zero lines of the first two components
+      auto uv = d.slice({0, 0, 0, 0}, {2, d.dim(1), d.dim(2), d.dim(3)});
+      uv.set_multicomponents();
+      tracker.push_field_data_snapshot(ndarray<float>(uv));
+    }, timings);
+
+    nsimplices = tracker.get_number_of_scanned_simplices();
+    npoints = tracker.get_number_of_intersections();
+    kernel_time = tracker.get_accumulated_kernel_time();
+  } else 
+    fatal("unknown feature " + feature);
+
+  auto t1 = clock_type::now();
+  const double total_time = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+
+  if (!verbose) {
+    fflush(stderr);
+    dup2(stderr_fd, 2);
+    close(stderr_fd);
+  }
+
+  json r;
+  r["feature"] = feature;
+  r["case"] = c.name;
+  r["dims"] = dims;
+  r["n_timesteps"] = jstream.contains("n_timesteps") ? jstream["n_timesteps"] : json();
+  r["thread_backend"] = backend;
+  r["nthreads"] = nthreads;
+  r["simplices"] = nsimplices;
+  r["points"] = npoints;
+  r["trajectories"] = ntrajs;
+  r["kernel_time"] = kernel_time;
+  r["simplices_per_second"] = kernel_time > 0 ? nsimplices / kernel_time : 0.0;
+  r["points_per_second"] = kernel_time > 0 ? npoints / kernel_time : 0.0;
+  r["tracing_time"] = timings["t_finalize"];
+  r["total_time"] = total_time;
+  r["peak_rss_bytes"] = peak_rss();
+  r["bytes_allocated"] = bytes_allocated - bytes0;
+  return r;
+}
+
+// returns the number of regressions
+static int compare(const json& results, const json& baseline, double tolerance)
+{
+  std::map<std::string, json> base;
+  for (const auto& r : baseline["results"])
+    base[result_key(r)] = r;
+
+  int nregressions = 0;
+  fprintf(stderr, "%-48s %14s %14s %8s\n", "case", "baseline", "current", "ratio");
+  for (const auto& r : results["results"]) {
+    const auto key = result_key(r);
+    if (base.find(key) == base.end()) {
+      fprintf(stderr, "%-48s %14s %14.4g %8s\n", key.c_str(), "-",
+          r["simplices_per_second"].get<double>(), "-");
+      continue;
+    }
+
+    const double b = base[key]["simplices_per_second"],
+                 x = r["simplices_per_second"],
+                 ratio = b > 0 ? x / b : 1.0;
+    const bool regressed = ratio < 1.0 - tolerance;
+    fprintf(stderr, "%-48s %14.4g %14.4g %8.3f%s\n", key.c_str(), b, x, ratio,
+        regressed ? "  REGRESSION" : "");
+    nregressions += regressed;
+  }
+  return nregressions;
+}
+
+int main(int argc, char **argv)
+{
+  diy::mpi::environment env(argc, argv);
+  diy::mpi::communicator comm;
+
+  std::string features_str, cases_str, scales_str, backends_str, nthreads_str,
+    config_str, output_filename, baseline_filename;
+  int n_timesteps = 16;
+  double tolerance = 0.1, threshold = 0.0;
+  bool verbose = false;
+
+  cxxopts::Options options(argv[0]);
+  options.add_options()
+    ("f,features", "Features (critical_point|contour|critical_line), comma-separated",
+     cxxopts::value<std::string>(features_str)->default_value("critical_point"))
+    ("threshold", "Threshold of contours",
+     cxxopts::value<double>(threshold)->default_value("0"))
+    ("c,cases", "Synthetic cases, comma-separated",
+     cxxopts::value<std::string>(cases_str)->default_value(
+       "woven,double_gyre,merger_2d,moving_extremum_2d,moving_extremum_3d,moving_ramp_3d,tornado,abc_flow"))
+    ("s,scales", "Scales of the default dimensions of the cases, comma-separated",
+     cxxopts::value<std::string>(scales_str)->default_value("1"))
+    ("n,timesteps", "Number of timesteps; 0 for the default of each case",
+     cxxopts::value<int>(n_timesteps)->default_value("16"))
+    ("thread-backends", "Thread backends (pthread|openmp|tbb|all), comma-separated",
+     cxxopts::value<std::string>(backends_str)->default_value("pthread"))
+    ("nthreads", "Numbers of threads, comma-separated; 0 for the number of hardware threads",
+     cxxopts::value<std::string>(nthreads_str)->default_value("0"))
+    ("config", "Additional tracker options in JSON, e.g. '{\"enable_cell_culling\": false}'",
+     cxxopts::value<std::string>(config_str)->default_value("{}"))
+    ("o,output", "Output JSON file; stdout if not given",
+     cxxopts::value<std::string>(output_filename))
+    ("baseline", "Compare with results of a previous run",
+     cxxopts::value<std::string>(baseline_filename))
+    ("tolerance", "Relative slowdown (in simplices/s) reported as a regression",
+     cxxopts::value<double>(tolerance)->default_value("0.1"))
+    ("v,verbose", "Do not suppress tracker outputs",
+     cxxopts::value<bool>(verbose))
+    ("h,help", "Print this information");
+  auto results_opts = options.parse(argc, argv);
+
+  if (results_opts.count("help")) {
+    std::cerr << options.help() << std::endl;
+    return 0;
+  }
+
+  std::vector<bench_case_t> cases;
+  for (const auto& name : split(cases_str)) {
+    auto it = std::find_if(all_cases.begin(), all_cases.end(),
+        [&](const bench_case_t& c) { return c.name == name; });
+    if (it == all_cases.end()) fatal("unknown case " + name);
+    cases.push_back(*it);
+  }
+
+  std::vector<std::string> backends = split(backends_str);
+  if (backends_str == "all") {
+    backends = {"pthread"};
+#if FTK_HAVE_OPENMP
+    backends.push_back("openmp");
+#endif
+#if FTK_HAVE_TBB
+    backends.push_back("tbb");
+#endif
+  }
+
+  std::vector<int> nthreads_list;
+  for (const auto& s : split(nthreads_str)) {
+    const int n = std::stoi(s);
+    nthreads_list.push_back(n > 0 ? n : std::thread::hardware_concurrency());
+  }
+
+  const json jconfig = json::parse(config_str);
+
+  json results;
+  results["ftk_version"] = FTK_VERSION;
+  results["hardware_concurrency"] = std::thread::hardware_concurrency();
+  results["config"] = jconfig;
+  results["results"] = json::array();
+
+  for (const auto& feature : split(features_str))
+    for (const auto& c : cases)
+      for (const auto& scale : split(scales_str))
+        for (const auto& backend : backends)
+          for (const auto nthreads : nthreads_list) {
+            auto r = run(feature, c, std::stoi(scale), n_timesteps, backend, nthreads, threshold, jconfig, verbose, comm);
+            if (r.is_null()) continue;
+            if (comm.rank() == 0)
+              fprintf(stderr, "%s: simplices/s=%g, points/s=%g, tracing_time=%f, peak_rss=%zu, bytes_allocated=%zu\n",
+                  result_key(r).c_str(),
+                  r["simplices_per_second"].get<double>(),
+                  r["points_per_second"].get<double>(),
+                  r["tracing_time"].get<double>(),
+                  r["peak_rss_bytes"].get<size_t>(),
+                  r["bytes_allocated"].get<size_t>());
+            results["results"].push_back(r);
+          }
+
+  if (comm.rank() != 0) return 0;
+
+  if (output_filename.empty())
+    std::cout << results.dump(2) << std::endl;
+  else {
+    std::ofstream f(output_filename);
+    f << results.dump(2) << std::endl;
+  }
+
+  if (!baseline_filename.empty()) {
+    std::ifstream f(baseline_filename);
+    if (!f.is_open()) fatal("unable to open baseline " + baseline_filename);
+    json baseline;
+    f >> baseline;
+
+    const int nregressions = compare(results, baseline, tolerance);
+    if (nregressions) {
+      fprintf(stderr, "%d regression(s) beyond tolerance %g\n", nregressions, tolerance);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include "ftk/external/cxxopts.hpp"
+#include "ftk/external/json.hh"
+#include "ftk/numeric/polynomial_solver.hh"
+#include "ftk/error.hh"
+
+// ftk_polynomial_bench: solves random polynomials of given degrees with known
+// roots by the builtin batched solver and, if available, MPSolve, and reports
+// throughput and accuracy (relative errors of the roots) in JSON.
+
+using namespace ftk;
+using nlohmann::json;
+typedef std::chrono::high_resolution_clock clock_type;
+
+// polynomials w/ random roots, half of which (rounded down to pairs) are complex conjugates
+static void generate(int n, size_t count, unsigned seed,
+    std::vector<double>& P, std::vector<std::complex<double>>& roots)
+{
+  std::mt19937 gen(seed);
+  std::normal_distribution<double> d(0, 1);
+
+  P.resize(count * (n+1));
+  roots.resize(count * n);
+  for (size_t i = 0; i < count; i ++) {
+    std::complex<double> *r = &roots[i*n];
+    const int npairs = n / 4;
+    for (int j = 0; j < npairs; j ++) {
+      r[2*j] = std::complex<double>(d(gen), std::abs(d(gen)) + 0.1);
+      r[2*j+1] = std::conj(r[2*j]);
+    }
+    for (int j = 2 * npairs; j < n; j ++)
+      r[j] = d(gen);
+
+    std::vector<std::complex<double>> c(n+1, 0.0); // product of (x - r_j)
+    c[0] = 1.0;
+    for (int j = 0; j < n; j ++) {
+      for (int k = j+1; k > 0; k --)
+        c[k] = c[k-1] - r[j] * c[k];
+      c[0] = -r[j] * c[0];
+    }
+    const double a = d(gen) + 2.0; // leading coefficient
+    for (int k = 0; k <= n; k ++)
+      P[i*(n+1)+k] = a * c[k].real();
+  }
+}
+
+// max and mean relative errors, matching each true root with the nearest unmatched computed root
+static void accuracy(int n, size_t count,
+    const std::vector<std::complex<double>>& truth, const std::vector<std::complex<double>>& x,
+    double& max_error, double& mean_error)
+{
+  max_error = mean_error = 0;
+  for (size_t i = 0; i < count; i ++) {
+    std::vector<bool> used(n, false);
+    for (int j = 0; j < n; j ++) {
+      const auto r = truth[i*n+j];
+      int best = -1;
+      double e = std::numeric_limits<double>::infinity();
+      for (int k = 0; k < n; k ++)
+        if (!used[k] && std::abs(x[i*n+k] - r) < e) {
+          e = std::abs(x[i*n+k] - r);
+          best = k;
+        }
+      if (best >= 0) used[best] = true;
+      e /= std::max(1.0, std::abs(r));
+      if (!(e <= max_error)) max_error = e; // incl. nans
+      mean_error += e;
+    }
+  }
+  mean_error /= count * n;
+}
+
+static json run(const std::string& solver, int n, size_t count, unsigned seed)
+{
+  std::vector<double> P;
+  std::vector<std::complex<double>> truth;
+  generate(n, count, seed, P, truth);
+
+  std::vector<std::complex<double>> x(count * n);
+  std::vector<int> nroots(count);
+
+  auto t0 = clock_type::now();
+  if (solver == "builtin")
+    solve_polynomials_batch(P.data(), n, count, x.data(), nroots.data());
+  else if (solver == "mpsolve") {
+    std::vector<double> re(n), im(n);
+    for (size_t i = 0; i < count; i ++) {
+      if (!solve_polynomials_mpsolve(&P[i*(n+1)], n, re.data(), im.data()))
+        return json();
+      for (int j = 0; j < n; j ++)
+        x[i*n+j] = std::complex<double>(re[j], im[j]);
+    }
+  } else
+    fatal("unknown solver " + solver);
+  auto t1 = clock_type::now();
+  const double time = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+
+  double max_error, mean_error;
+  accuracy(n, count, truth, x, max_error, mean_error);
+
+  json r;
+  r["solver"] = solver;
+  r["degree"] = n;
+  r["count"] = count;
+  r["time"] = time;
+  r["polynomials_per_second"] = time > 0 ? count / time : 0.0;
+  r["max_relative_error"] = max_error;
+  r["mean_relative_error"] = mean_error;
+  return r;
+}
+
+int main(int argc, char **argv)
+{
+  int count = 100000, seed = 0;
+  std::string output_filename;
+
+  cxxopts::Options options(argv[0]);
+  options.add_options()
+    ("n,count", "Number of polynomials per degree",
+     cxxopts::value<int>(count)->default_value("100000"))
+    ("seed", "Random seed",
+     cxxopts::value<int>(seed)->default_value("0"))
+    ("o,output", "Output JSON file; stdout if not given",
+     cxxopts::value<std::string>(output_filename))
+    ("h,help", "Print this information");
+  auto results_opts = options.parse(argc, argv);
+
+  if (results_opts.count("help")) {
+    std::cerr << options.help() << std::endl;
+    return 0;
+  }
+
+  json results;
+  results["results"] = json::array();
+  for (const auto solver : {"builtin", "mpsolve"})
+    for (int n = 1; n <= polynomial_solver_max_degree; n ++) {
+      auto r = run(solver, n, count, seed + n);
+      if (r.is_null()) {
+        fprintf(stderr, "%s: not available\n", solver);
+        break;
+      }
+      fprintf(stderr, "%s/%d: polynomials/s=%g, max_relative_error=%g, mean_relative_error=%g\n",
+          solver, n,
+          r["polynomials_per_second"].get<double>(),
+          r["max_relative_error"].get<double>(),
+          r["mean_relative_error"].get<double>());
+      results["results"].push_back(r);
+    }
+
+  if (output_filename.empty())
+    std::cout << results.dump(2) << std::endl;
+  else {
+    std::ofstream f(output_filename);
+    f << results.dump(2) << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef _FTK_CONCURRENT_UNION_FIND_H
+#define _FTK_CONCURRENT_UNION_FIND_H
+
+#include <ftk/config.hh>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Lock-free union-find of elements 0..n-1 for shared-memory parallelism;
+// unite and find may be called concurrently by any number of threads.
+// Roots are linked by index (the larger root to the smaller one), so that
+// the root of a set is always its smallest element.
+
+// Reference
+  // Paper: "Wait-free Parallel Algorithms for the Union-Find Problem"
+
+namespace ftk {
+
+template <class IdType=int>
+struct concurrent_union_find
+{
+  concurrent_union_find(IdType size) : n(size), id2parent(new std::atomic<IdType>[size]) {
+    for (IdType i = 0; i < n; i ++)
+      id2parent[i].store(i, std::memory_order_relaxed);
+  }
+
+  IdType size() const {return n;}
+
+  // Operations
+  void unite(IdType i, IdType j) {
+    while (true) {
+      i = find(i);
+      j = find(j);
+      if (i == j) return;
+      if (i < j) std::swap(i, j);
+
+      IdType expected = i; // link i to j if i is still a root
+      if (id2parent[i].compare_exchange_weak(expected, j))
+        return;
+    }
+  }
+
+  // Queries
+
+  // Find the root of an element.
+    // Path compression by path halving method
+  IdType find(IdType i) {
+    while (true) {
+      IdType p = id2parent[i].load();
+      if (p == i) return i;
+
+      const IdType gp = id2parent[p].load();
+      if (p != gp) // parents only move towards the root, so a failure is harmless
+        id2parent[i].compare_exchange_weak(p, gp);
+      i = gp;
+    }
+  }
+
+  bool same_set(IdType i, IdType j) {
+    while (true) {
+      i = find(i);
+      j = find(j);
+      if (i == j) return true;
+      if (id2parent[i].load() == i) return false; // i was not linked in the meantime
+    }
+  }
+
+private:
+  const IdType n;
+  std::unique_ptr<std::atomic<IdType>[]> id2parent;
+};
+
+}
+
+#endif
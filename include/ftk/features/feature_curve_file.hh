@@ -0,0 +1,495 @@
+#ifndef _FTK_FEATURE_CURVE_FILE_HH
+#define _FTK_FEATURE_CURVE_FILE_HH
+
+#include <ftk/config.hh>
+#include <ftk/features/feature_point_store.hh>
+#include <ftk/utils/serialization.hh>
+#include <ftk/error.hh>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#if FTK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace ftk {
+
+// Indexed on-disk container of feature curves.  Curves are appended to
+// chunks of roughly `chunk_size' points; each chunk is a serialized
+// feature_point_store_t, optionally compressed with zlib.  The index at the
+// end of the file keeps the extent of each chunk and the id, time range,
+// timestep range, and bounding box of each curve, so that curves can be
+// read by id, and time windows, slices, and spatial queries only read and
+// decode the chunks they need.
+//
+// Layout: header | chunk 0 | chunk 1 | ... | index | footer, where the
+// footer is the offset and size of the index and the magic string.  Chunks
+// are written as they fill up, and the index and footer are written once by
+// close(), so the file is only readable after it is closed.
+struct feature_curve_file_chunk_t {
+  uint64_t offset = 0, nbytes = 0, raw_nbytes = 0;
+  uint8_t compressed = 0;
+  uint64_t ncurves = 0, npoints = 0;
+  double tmin = 0, tmax = 0;
+  int timestep_min = 0, timestep_max = 0;
+  std::array<double, 3> bbmin = {0}, bbmax = {0};
+};
+
+struct feature_curve_file_entry_t {
+  int id = 0;
+  uint32_t chunk = 0, index = 0; // curve index in the chunk
+  uint64_t npoints = 0;
+  double tmin = 0, tmax = 0;
+  int timestep_min = 0, timestep_max = 0;
+  std::array<double, 3> bbmin = {0}, bbmax = {0};
+  uint32_t consistent_type = 0;
+
+  bool overlaps(double t0, double t1) const {return tmax >= t0 && tmin <= t1;}
+  bool contains_timestep(int t) const {return timestep_min <= t && t <= timestep_max;}
+  bool intersects(const std::array<double, 3>& lo, const std::array<double, 3>& hi, int cpdims) const {
+    for (int k = 0; k < cpdims; k ++)
+      if (bbmax[k] < lo[k] || bbmin[k] > hi[k]) return false;
+    return true;
+  }
+};
+
+struct feature_curve_file_writer {
+  feature_curve_file_writer() {}
+  ~feature_curve_file_writer() { close(); }
+
+  // truncates the file, or appends to an existing file if `append' is true
+  void open(const std::string& filename, int cpdims, int nscalars, bool append = false);
+  void close();
+  bool is_open() const {return fp != NULL;}
+
+  void set_chunk_size(size_t n) {chunk_size = std::max(size_t(1), n);} // in number of points
+  void set_compression(bool b);
+
+  void append(const feature_curve_t& curve, int id);
+  void append(const feature_curve_set_t& curves);
+  void append(const feature_point_store_t<>& curves);
+  void flush(); // writes buffered curves as a chunk
+
+  size_t get_number_of_curves() const {return entries.size() + buffer.n_curves();}
+
+protected:
+  void write_chunk();
+  void write_index();
+
+protected:
+  FILE *fp = NULL;
+  size_t chunk_size = 65536;
+  bool compression = false;
+
+  feature_point_store_t<> buffer;
+  std::vector<feature_curve_file_chunk_t> chunks;
+  std::vector<feature_curve_file_entry_t> entries;
+  uint64_t end_of_chunks = 0;
+};
+
+struct feature_curve_file_reader {
+  feature_curve_file_reader() {}
+  feature_curve_file_reader(const std::string& filename) { open(filename); }
+  ~feature_curve_file_reader() { close(); }
+
+  void open(const std::string& filename);
+  void close();
+
+  int get_cpdims() const {return cpdims;}
+  int get_number_of_scalar_components() const {return nscalars;}
+  size_t n_curves() const {return entries.size();}
+  const std::vector<feature_curve_file_chunk_t>& get_chunks() const {return chunks;}
+  const std::vector<feature_curve_file_entry_t>& get_entries() const {return entries;}
+
+  bool has(int id) const {return id2entry.find(id) != id2entry.end();}
+  feature_curve_t read(int id); // fatal if not exist
+  feature_curve_set_t read_all();
+
+  // only reads chunks with curves that pass the index filter, and then
+  // (optionally) keeps the curves that pass the curve filter
+  feature_curve_set_t select(std::function<bool(const feature_curve_file_entry_t&)> index_filter,
+      std::function<bool(const feature_curve_t&)> curve_filter = nullptr);
+
+  feature_curve_set_t intercept(int t0, int t1); // same as feature_curve_set_t::intercept
+  std::vector<feature_point_t> slice(int t); // ordinal points of timestep t
+  std::map<int, std::vector<feature_point_t>> slice_all(); // ordinal points of all timesteps, loading each chunk once
+  feature_curve_set_t select_bbox(const std::array<double, 3>& lo, const std::array<double, 3>& hi); // curves whose bounding box intersects [lo, hi]
+
+  size_t get_number_of_chunks_loaded() const {return nchunks_loaded;}
+
+protected:
+  const feature_point_store_t<>& load_chunk(uint32_t i);
+
+protected:
+  FILE *fp = NULL;
+  int cpdims = 3, nscalars = 0;
+  std::vector<feature_curve_file_chunk_t> chunks;
+  std::vector<feature_curve_file_entry_t> entries;
+  std::map<int, size_t> id2entry;
+
+  // the most recently decoded chunk
+  int cached_chunk = -1;
+  feature_point_store_t<> cache;
+  size_t nchunks_loaded = 0;
+};
+
+/////
+namespace detail {
+  static const char feature_curve_file_magic[8] = {'F', 'T', 'K', 'C', 'U', 'R', 'V', '1'};
+  static const size_t feature_curve_file_header_size = 8 + 2 * sizeof(int32_t);
+  static const size_t feature_curve_file_footer_size = 2 * sizeof(uint64_t) + 8;
+
+  inline void fwrite_checked(const void *p, size_t n, FILE *fp) {
+    if (n > 0 && fwrite(p, 1, n, fp) != n)
+      fatal("unable to write the feature curve file");
+  }
+
+  inline void fread_checked(void *p, size_t n, FILE *fp) {
+    if (n > 0 && fread(p, 1, n, fp) != n)
+      fatal("corrupted feature curve file");
+  }
+
+  inline void read_feature_curve_file_index(FILE *fp, int &cpdims, int &nscalars,
+      std::vector<feature_curve_file_chunk_t>& chunks,
+      std::vector<feature_curve_file_entry_t>& entries,
+      uint64_t &index_offset)
+  {
+    char magic[8];
+    int32_t dims[2];
+    fseeko(fp, 0, SEEK_SET);
+    fread_checked(magic, 8, fp);
+    if (memcmp(magic, feature_curve_file_magic, 8) != 0)
+      fatal("not a feature curve file");
+    fread_checked(dims, sizeof(dims), fp);
+    cpdims = dims[0];
+    nscalars = dims[1];
+
+    uint64_t footer[2]; // index offset and size
+    fseeko(fp, -off_t(feature_curve_file_footer_size), SEEK_END);
+    fread_checked(footer, sizeof(footer), fp);
+    fread_checked(magic, 8, fp);
+    if (memcmp(magic, feature_curve_file_magic, 8) != 0)
+      fatal("incomplete feature curve file");
+    index_offset = footer[0];
+
+    std::string buf(footer[1], '\0');
+    fseeko(fp, index_offset, SEEK_SET);
+    fread_checked(&buf[0], buf.size(), fp);
+
+    diy::StringBuffer bb(buf);
+    diy::load(bb, chunks);
+    diy::load(bb, entries);
+  }
+}
+
+inline void feature_curve_file_writer::set_compression(bool b)
+{
+#if FTK_HAVE_ZLIB
+  compression = b;
+#else
+  if (b) warn("FTK not compiled with zlib; feature curves are not compressed");
+  compression = false;
+#endif
+}
+
+inline void feature_curve_file_writer::open(const std::string& filename, int cpdims, int nscalars, bool append)
+{
+  close();
+  chunks.clear();
+  entries.clear();
+  buffer.reset(cpdims, nscalars, true);
+
+  if (append) fp = fopen(filename.c_str(), "r+b");
+  if (fp) { // resume from the existing index; new chunks overwrite the old index, which is rewritten by close()
+    int cpdims0, nscalars0;
+    detail::read_feature_curve_file_index(fp, cpdims0, nscalars0, chunks, entries, end_of_chunks);
+    if (cpdims0 != cpdims || nscalars0 != nscalars)
+      fatal("cannot append to " + filename + " with different dimensions or scalar components");
+    fseeko(fp, end_of_chunks, SEEK_SET);
+  } else {
+    fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+      fatal("unable to open " + filename + " for writing feature curves");
+
+    const int32_t dims[2] = {cpdims, nscalars};
+    detail::fwrite_checked(detail::feature_curve_file_magic, 8, fp);
+    detail::fwrite_checked(dims, sizeof(dims), fp);
+    end_of_chunks = detail::feature_curve_file_header_size;
+  }
+}
+
+inline void feature_curve_file_writer::close()
+{
+  if (!fp) return;
+  flush();
+  write_index();
+  fclose(fp);
+  fp = NULL;
+}
+
+inline void feature_curve_file_writer::append(const feature_curve_t& curve, int id)
+{
+  if (!fp)
+    fatal("feature curve file not open");
+
+  buffer.add(curve, id);
+  if (buffer.size() >= chunk_size)
+    flush();
+}
+
+inline void feature_curve_file_writer::append(const feature_curve_set_t& curves)
+{
+  for (const auto &kv : curves)
+    append(kv.second, kv.first);
+}
+
+inline void feature_curve_file_writer::append(const feature_point_store_t<>& curves)
+{
+  if (!fp)
+    fatal("feature curve file not open");
+
+  for (size_t i = 0; i < curves.n_curves(); i ++) {
+    buffer.add(curves, i);
+    if (buffer.size() >= chunk_size)
+      flush();
+  }
+}
+
+inline void feature_curve_file_writer::flush()
+{
+  if (!fp) return;
+  write_chunk();
+  fflush(fp);
+}
+
+inline void feature_curve_file_writer::write_chunk()
+{
+  if (buffer.n_curves() == 0) return;
+
+  feature_curve_file_chunk_t chunk;
+  chunk.offset = end_of_chunks;
+  chunk.ncurves = buffer.n_curves();
+  chunk.npoints = buffer.size();
+
+  // index entries, with extents computed from the points
+  const int cpdims = buffer.get_cpdims();
+  chunk.timestep_min = std::numeric_limits<int>::max();
+  chunk.timestep_max = std::numeric_limits<int>::lowest();
+  chunk.bbmin.fill(std::numeric_limits<double>::max());
+  chunk.bbmax.fill(std::numeric_limits<double>::lowest());
+  chunk.tmin = std::numeric_limits<double>::max();
+  chunk.tmax = std::numeric_limits<double>::lowest();
+
+  for (size_t i = 0; i < buffer.n_curves(); i ++) {
+    feature_curve_file_entry_t e;
+    e.id = buffer.curve_ids[i];
+    e.chunk = chunks.size();
+    e.index = i;
+    e.npoints = buffer.curve_size(i);
+    e.consistent_type = buffer.consistent_type[i];
+    e.tmin = std::numeric_limits<double>::max();
+    e.tmax = std::numeric_limits<double>::lowest();
+    e.timestep_min = std::numeric_limits<int>::max();
+    e.timestep_max = std::numeric_limits<int>::lowest();
+    e.bbmin.fill(std::numeric_limits<double>::max());
+    e.bbmax.fill(std::numeric_limits<double>::lowest());
+    for (size_t k = buffer.offsets[i]; k < buffer.offsets[i+1]; k ++) {
+      e.tmin = std::min(e.tmin, buffer.t[k]);
+      e.tmax = std::max(e.tmax, buffer.t[k]);
+      e.timestep_min = std::min(e.timestep_min, buffer.timestep[k]);
+      e.timestep_max = std::max(e.timestep_max, buffer.timestep[k]);
+      for (int j = 0; j < cpdims; j ++) {
+        e.bbmin[j] = std::min(e.bbmin[j], buffer.x[j][k]);
+        e.bbmax[j] = std::max(e.bbmax[j], buffer.x[j][k]);
+      }
+    }
+
+    chunk.tmin = std::min(chunk.tmin, e.tmin);
+    chunk.tmax = std::max(chunk.tmax, e.tmax);
+    chunk.timestep_min = std::min(chunk.timestep_min, e.timestep_min);
+    chunk.timestep_max = std::max(chunk.timestep_max, e.timestep_max);
+    for (int j = 0; j < cpdims; j ++) {
+      chunk.bbmin[j] = std::min(chunk.bbmin[j], e.bbmin[j]);
+      chunk.bbmax[j] = std::max(chunk.bbmax[j], e.bbmax[j]);
+    }
+    entries.push_back(e);
+  }
+
+  // payload
+  std::string buf;
+  diy::serializeToString(buffer, buf);
+  chunk.raw_nbytes = buf.size();
+
+#if FTK_HAVE_ZLIB
+  if (compression) {
+    uLongf n = compressBound(buf.size());
+    std::string zbuf(n, '\0');
+    if (compress2((Bytef*)&zbuf[0], &n, (const Bytef*)buf.data(), buf.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+      fatal("unable to compress feature curves");
+    zbuf.resize(n);
+    buf.swap(zbuf);
+    chunk.compressed = 1;
+  }
+#endif
+  chunk.nbytes = buf.size();
+
+  fseeko(fp, end_of_chunks, SEEK_SET);
+  detail::fwrite_checked(buf.data(), buf.size(), fp);
+  end_of_chunks += buf.size();
+  chunks.push_back(chunk);
+
+  buffer.clear();
+}
+
+inline void feature_curve_file_writer::write_index()
+{
+  std::string buf;
+  diy::StringBuffer bb(buf);
+  diy::save(bb, chunks);
+  diy::save(bb, entries);
+
+  const uint64_t footer[2] = {end_of_chunks, buf.size()};
+  fseeko(fp, end_of_chunks, SEEK_SET);
+  detail::fwrite_checked(buf.data(), buf.size(), fp);
+  detail::fwrite_checked(footer, sizeof(footer), fp);
+  detail::fwrite_checked(detail::feature_curve_file_magic, 8, fp);
+
+  // drop the stale tail, if any, of a previous index
+  if (ftruncate(fileno(fp), ftello(fp)) != 0)
+    warn("unable to truncate the feature curve file");
+}
+
+/////
+inline void feature_curve_file_reader::open(const std::string& filename)
+{
+  close();
+  fp = fopen(filename.c_str(), "rb");
+  if (!fp)
+    fatal("unable to open " + filename);
+
+  uint64_t index_offset;
+  detail::read_feature_curve_file_index(fp, cpdims, nscalars, chunks, entries, index_offset);
+
+  for (size_t i = 0; i < entries.size(); i ++)
+    id2entry[entries[i].id] = i;
+}
+
+inline void feature_curve_file_reader::close()
+{
+  if (fp) fclose(fp);
+  fp = NULL;
+  chunks.clear();
+  entries.clear();
+  id2entry.clear();
+  cached_chunk = -1;
+  nchunks_loaded = 0;
+}
+
+inline const feature_point_store_t<>& feature_curve_file_reader::load_chunk(uint32_t i)
+{
+  if (cached_chunk == int(i)) return cache;
+
+  const auto &chunk = chunks[i];
+  std::string buf(chunk.nbytes, '\0');
+  fseeko(fp, chunk.offset, SEEK_SET);
+  detail::fread_checked(&buf[0], buf.size(), fp);
+
+  if (chunk.compressed) {
+#if FTK_HAVE_ZLIB
+    uLongf n = chunk.raw_nbytes;
+    std::string raw(n, '\0');
+    if (uncompress((Bytef*)&raw[0], &n, (const Bytef*)buf.data(), buf.size()) != Z_OK || n != chunk.raw_nbytes)
+      fatal("unable to decompress feature curves");
+    buf.swap(raw);
+#else
+    fatal("FTK not compiled with zlib; unable to read compressed feature curves");
+#endif
+  }
+
+  diy::StringBuffer bb(buf);
+  diy::load(bb, cache);
+  cached_chunk = i;
+  nchunks_loaded ++;
+  return cache;
+}
+
+inline feature_curve_t feature_curve_file_reader::read(int id)
+{
+  auto it = id2entry.find(id);
+  if (it == id2entry.end())
+    fatal("feature curve " + std::to_string(id) + " not found");
+
+  const auto &e = entries[it->second];
+  return load_chunk(e.chunk).curve(e.index);
+}
+
+inline feature_curve_set_t feature_curve_file_reader::select(
+    std::function<bool(const feature_curve_file_entry_t&)> index_filter,
+    std::function<bool(const feature_curve_t&)> curve_filter)
+{
+  // entries are ordered by chunk, so that each chunk is loaded at most once
+  feature_curve_set_t results;
+  for (const auto &e : entries) {
+    if (index_filter && !index_filter(e)) continue;
+    feature_curve_t curve = load_chunk(e.chunk).curve(e.index);
+    if (curve_filter && !curve_filter(curve)) continue;
+    results.insert(std::make_pair(e.id, curve));
+  }
+  return results;
+}
+
+inline feature_curve_set_t feature_curve_file_reader::read_all()
+{
+  return select(nullptr);
+}
+
+inline feature_curve_set_t feature_curve_file_reader::intercept(int t0, int t1)
+{
+  feature_curve_set_t results;
+  auto curves = select([&](const feature_curve_file_entry_t& e) { return e.overlaps(t0, t1); });
+  for (const auto &kv : curves) {
+    auto curve = kv.second.intercept(t0, t1);
+    if (!curve.empty())
+      results.insert({kv.first, curve});
+  }
+  return results;
+}
+
+inline std::vector<feature_point_t> feature_curve_file_reader::slice(int t)
+{
+  std::vector<feature_point_t> results;
+  for (const auto &e : entries) {
+    if (!e.contains_timestep(t)) continue;
+    const auto &store = load_chunk(e.chunk);
+    for (size_t j = 0; j < store.curve_size(e.index); j ++) {
+      const size_t k = store.offsets[e.index] + j;
+      if (store.ordinal[k] && store.timestep[k] == t)
+        results.push_back(store.point(e.index, j));
+    }
+  }
+  return results;
+}
+
+inline std::map<int, std::vector<feature_point_t>> feature_curve_file_reader::slice_all()
+{
+  std::map<int, std::vector<feature_point_t>> results;
+  for (const auto &e : entries) {
+    const auto &store = load_chunk(e.chunk);
+    for (size_t j = 0; j < store.curve_size(e.index); j ++) {
+      const size_t k = store.offsets[e.index] + j;
+      if (store.ordinal[k])
+        results[store.timestep[k]].push_back(store.point(e.index, j));
+    }
+  }
+  return results;
+}
+
+inline feature_curve_set_t feature_curve_file_reader::select_bbox(const std::array<double, 3>& lo, const std::array<double, 3>& hi)
+{
+  return select([&](const feature_curve_file_entry_t& e) { return e.intersects(lo, hi, cpdims); });
+}
+
+}
+
+#endif
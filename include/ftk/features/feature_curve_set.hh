@@ -3,6 +3,7 @@
 
 #include <ftk/features/feature_curve.hh>
 #include <map>
+#include <list>
 
 #if FTK_HAVE_VTK
 #include <vtkUnsignedIntArray.h>
@@ -111,6 +112,11 @@ namespace diy {
       // s[id] = traj;
     }
   }
+
+  template <> struct Serialization<ftk::feature_curve_set_t> { // for containers of curve sets, e.g. gathered fragments
+    static void save(diy::BinaryBuffer& bb, const ftk::feature_curve_set_t& s) { diy::save(bb, s); }
+    static void load(diy::BinaryBuffer& bb, ftk::feature_curve_set_t& s) { diy::load(bb, s); }
+  };
 } // namespace diy
 
 //////
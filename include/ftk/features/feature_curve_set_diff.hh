@@ -0,0 +1,204 @@
+#ifndef _FTK_FEATURE_CURVE_SET_DIFF_HH
+#define _FTK_FEATURE_CURVE_SET_DIFF_HH
+
+#include <ftk/features/feature_curve_set.hh>
+#include <ftk/external/json.hh>
+#include <cmath>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace ftk {
+
+using nlohmann::json;
+
+// Differences between two sets of trajectories, e.g. the outputs of a
+// reference and an optimized code path on the same input.  Points are
+// matched by tags (mesh elements), which do not depend on the ordering or
+// labeling of trajectories; a trajectory of one set corresponds to the
+// trajectories of the other set that contain its points.
+struct feature_curve_set_diff_t {
+  size_t ncurves[2] = {0, 0}, npoints[2] = {0, 0}; // reference, other
+
+  // topology
+  size_t nmatched_curves = 0; // one-to-one w/ identical points
+  size_t nchanged_curves = 0; // one-to-one, but points or loopness differ
+  size_t nsplit_curves = 0; // reference curves broken into multiple curves
+  size_t nmerged_curves = 0; // curves combining multiple reference curves
+  size_t nmissing_points = 0, nextra_points = 0; // tags only in the reference/other
+
+  // geometry and types of the matched points
+  size_t ntype_changes = 0;
+  double max_position_delta = 0, mean_position_delta = 0;
+  double max_time_delta = 0, max_scalar_delta = 0;
+
+  std::vector<std::string> events; // human-readable topology changes, capped by max_events
+  static const size_t max_events = 32;
+
+  bool topology_changed() const;
+  bool identical(double tolerance = 0) const; // no topology/type changes and deltas within the tolerance
+
+  json to_json() const;
+  void print(std::ostream& os) const;
+
+protected:
+  void add_event(const std::string& e) {if (events.size() < max_events) events.push_back(e);}
+  friend feature_curve_set_diff_t diff_feature_curve_sets(const feature_curve_set_t&, const feature_curve_set_t&);
+};
+
+feature_curve_set_diff_t diff_feature_curve_sets(const feature_curve_set_t& reference, const feature_curve_set_t& other);
+
+/////
+inline bool feature_curve_set_diff_t::topology_changed() const
+{
+  return ncurves[0] != ncurves[1] || nchanged_curves || nsplit_curves || nmerged_curves
+    || nmissing_points || nextra_points;
+}
+
+inline bool feature_curve_set_diff_t::identical(double tolerance) const
+{
+  return !topology_changed() && ntype_changes == 0
+    && max_position_delta <= tolerance && max_time_delta <= tolerance && max_scalar_delta <= tolerance;
+}
+
+inline json feature_curve_set_diff_t::to_json() const
+{
+  json j;
+  j["ncurves"] = {ncurves[0], ncurves[1]};
+  j["npoints"] = {npoints[0], npoints[1]};
+  j["matched_curves"] = nmatched_curves;
+  j["changed_curves"] = nchanged_curves;
+  j["split_curves"] = nsplit_curves;
+  j["merged_curves"] = nmerged_curves;
+  j["missing_points"] = nmissing_points;
+  j["extra_points"] = nextra_points;
+  j["type_changes"] = ntype_changes;
+  j["max_position_delta"] = max_position_delta;
+  j["mean_position_delta"] = mean_position_delta;
+  j["max_time_delta"] = max_time_delta;
+  j["max_scalar_delta"] = max_scalar_delta;
+  j["topology_changed"] = topology_changed();
+  j["events"] = events;
+  return j;
+}
+
+inline void feature_curve_set_diff_t::print(std::ostream& os) const
+{
+  os << "curves: " << ncurves[0] << " vs " << ncurves[1]
+     << ", points: " << npoints[0] << " vs " << npoints[1] << std::endl
+     << "matched=" << nmatched_curves << ", changed=" << nchanged_curves
+     << ", split=" << nsplit_curves << ", merged=" << nmerged_curves
+     << ", missing_points=" << nmissing_points << ", extra_points=" << nextra_points << std::endl
+     << "type_changes=" << ntype_changes
+     << ", max_position_delta=" << max_position_delta
+     << ", mean_position_delta=" << mean_position_delta
+     << ", max_time_delta=" << max_time_delta
+     << ", max_scalar_delta=" << max_scalar_delta << std::endl;
+  for (const auto &e : events)
+    os << "  " << e << std::endl;
+}
+
+inline feature_curve_set_diff_t diff_feature_curve_sets(const feature_curve_set_t& reference, const feature_curve_set_t& other)
+{
+  feature_curve_set_diff_t d;
+
+  struct location_t {
+    const feature_curve_t *curve;
+    int curve_id;
+    const feature_point_t *point;
+  };
+  typedef std::unordered_map<unsigned long long, location_t> tag_map_t;
+
+  const feature_curve_set_t *sets[2] = {&reference, &other};
+  tag_map_t tags[2];
+  for (int k = 0; k < 2; k ++) {
+    d.ncurves[k] = sets[k]->size();
+    for (const auto &kv : *sets[k])
+      for (const auto &p : kv.second)
+        if (tags[k].insert({p.tag, {&kv.second, kv.first, &p}}).second) // repeated points of loops are counted once
+          d.npoints[k] ++;
+  }
+
+  // points
+  size_t nmatched_points = 0;
+  for (const auto &kv : tags[0]) {
+    const auto it = tags[1].find(kv.first);
+    if (it == tags[1].end()) {
+      d.nmissing_points ++;
+      continue;
+    }
+
+    const feature_point_t &p = *kv.second.point, &q = *it->second.point;
+    double dist2 = 0;
+    for (int i = 0; i < 3; i ++)
+      dist2 += (p.x[i] - q.x[i]) * (p.x[i] - q.x[i]);
+    const double dist = std::sqrt(dist2);
+    d.max_position_delta = std::max(d.max_position_delta, dist);
+    d.mean_position_delta += dist;
+    d.max_time_delta = std::max(d.max_time_delta, std::abs(p.t - q.t));
+    for (int i = 0; i < FTK_CP_MAX_NUM_VARS; i ++) {
+      const double ds = std::abs(p.scalar[i] - q.scalar[i]);
+      if (!(ds <= d.max_scalar_delta) && !(std::isnan(p.scalar[i]) && std::isnan(q.scalar[i])))
+        d.max_scalar_delta = ds; // incl. nans on one side
+    }
+    if (p.type != q.type)
+      d.ntype_changes ++;
+    nmatched_points ++;
+  }
+  if (nmatched_points)
+    d.mean_position_delta /= nmatched_points;
+  d.nextra_points = d.npoints[1] - nmatched_points;
+
+  // curves; correspondences are the curves in the other set sharing points
+  auto correspondences = [&](int k, const feature_curve_t& c) {
+    std::map<const feature_curve_t*, int> curves; // to ids
+    for (const auto &p : c) {
+      const auto it = tags[1-k].find(p.tag);
+      if (it != tags[1-k].end())
+        curves[it->second.curve] = it->second.curve_id;
+    }
+    return curves;
+  };
+
+  auto same_points = [&](const feature_curve_t& c, const feature_curve_t& c1) {
+    std::set<unsigned long long> s, s1;
+    for (const auto &p : c) s.insert(p.tag);
+    for (const auto &p : c1) s1.insert(p.tag);
+    return s == s1;
+  };
+
+  for (const auto &kv : reference) {
+    const auto curves = correspondences(0, kv.second);
+    if (curves.empty())
+      d.add_event("curve " + std::to_string(kv.first) + " vanished");
+    else if (curves.size() > 1) {
+      d.nsplit_curves ++;
+      d.add_event("curve " + std::to_string(kv.first) + " split into " + std::to_string(curves.size()) + " curves");
+    } else {
+      const feature_curve_t &c1 = *curves.begin()->first;
+      if (correspondences(1, c1).size() > 1) continue; // counted as a merge below
+      else if (kv.second.loop == c1.loop && same_points(kv.second, c1))
+        d.nmatched_curves ++;
+      else {
+        d.nchanged_curves ++;
+        d.add_event("curve " + std::to_string(kv.first) + " changed into curve " + std::to_string(curves.begin()->second));
+      }
+    }
+  }
+
+  for (const auto &kv : other) {
+    const auto curves = correspondences(1, kv.second);
+    if (curves.empty())
+      d.add_event("curve " + std::to_string(kv.first) + " appeared");
+    else if (curves.size() > 1) {
+      d.nmerged_curves ++;
+      d.add_event("curve " + std::to_string(kv.first) + " merged " + std::to_string(curves.size()) + " curves");
+    }
+  }
+
+  return d;
+}
+
+}
+
+#endif
@@ -43,6 +43,7 @@ struct feature_point_t {
     for (int i = 0; i < 3; i ++)
       x[i] = cp.x[i];
     t = cp.t;
+    cond = cp.cond;
     for (int i = 0; i < FTK_CP_MAX_NUM_VARS; i ++)
       scalar[i] = cp.scalar[i];
     type = cp.type;
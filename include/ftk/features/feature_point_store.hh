@@ -0,0 +1,708 @@
+#ifndef _FTK_FEATURE_POINT_STORE_HH
+#define _FTK_FEATURE_POINT_STORE_HH
+
+#include <ftk/config.hh>
+#include <ftk/features/feature_curve_set.hh>
+#include <ftk/utils/serialization.hh>
+#include <ftk/error.hh>
+
+namespace ftk {
+
+// Columnar (SoA) storage of feature points and curves.  Each field of
+// feature_point_t is kept in its own typed column; only the first `cpdims'
+// coordinates and the active scalar components are allocated, velocities
+// are optional, and real-valued columns are stored in F (e.g. float).
+// Points of the i-th curve are [offsets[i], offsets[i+1]); points after
+// offsets.back() belong to the curve that is being appended.  The id of
+// a point is the id of its curve.
+template <typename F=double>
+struct feature_point_store_t {
+  feature_point_store_t(int cpdims_ = 3, int nscalars_ = 1, bool has_velocity_ = false) {
+    reset(cpdims_, nscalars_, has_velocity_);
+  }
+
+  void reset(int cpdims, int nscalars, bool has_velocity);
+  void clear() { reset(cpdims, nscalars, has_velocity); }
+  void reserve(size_t npoints);
+
+  int get_cpdims() const {return cpdims;}
+  int get_number_of_scalar_components() const {return nscalars;}
+  bool has_velocities() const {return has_velocity;}
+
+  size_t size() const {return t.size();} // number of points
+  size_t n_curves() const {return curve_ids.size();}
+  size_t curve_size(size_t i) const {return offsets[i+1] - offsets[i];}
+  size_t memory_usage() const; // in bytes
+
+public: // points
+  void push_back(const feature_point_t& p); // appends a point to the open curve
+  feature_point_t point(size_t k) const; // without the curve id
+  feature_point_t point(size_t i, size_t j) const; // the j-th point of the i-th curve
+
+public: // curves
+  int close_curve(bool loop = false); // closes the open curve with a new id
+  void close_curve(int id, bool loop);
+  int add(const feature_curve_t& curve); // with a new id
+  void add(const feature_curve_t& curve, int id);
+  template <typename G> void add(const feature_point_store_t<G>& s, size_t i); // the i-th curve of another store, with its id and statistics
+
+  feature_curve_t curve(size_t i) const;
+  int get_new_id() const { return curve_ids.empty() ? 0 : max_curve_id + 1; }
+
+  void from_curve_set(const feature_curve_set_t& s);
+  feature_curve_set_t to_curve_set() const;
+
+  void update_statistics(); // same as feature_curve_t::update_statistics for all curves
+
+  void filter(std::function<bool(const feature_curve_t&)> f); // keeps curves that pass f, tested one at a time
+  void discard_interval_points(); // same as feature_curve_t::discard_interval_points for all curves
+
+public: // slicing
+  std::vector<size_t> slice_indices(int timestep) const; // ordinal points of the timestep
+  std::map<int, std::vector<feature_point_t>> slice() const; // ordinal points of all timesteps
+
+public: // IO
+  void write_text(std::ostream& os, const std::vector<std::string>& scalar_components) const;
+  void write_binary(const std::string& filename) const;
+  void read_binary(const std::string& filename);
+
+#if FTK_HAVE_VTK
+  vtkSmartPointer<vtkPolyData> to_vtp(const std::vector<std::string> &scalar_components, double tfactor=1.0) const;
+#endif
+
+public: // point columns
+  std::vector<std::vector<F>> x; // cpdims columns
+  std::vector<F> t, cond;
+  std::vector<std::vector<F>> scalar; // nscalars columns
+  std::vector<std::vector<F>> v; // cpdims columns if has_velocity, otherwise empty
+  std::vector<int> timestep;
+  std::vector<uint32_t> type;
+  std::vector<uint8_t> ordinal;
+  std::vector<uint64_t> tag;
+
+public: // curve columns
+  std::vector<size_t> offsets; // n_curves()+1 entries
+  std::vector<int> curve_ids;
+  std::vector<uint8_t> loops;
+
+  // statistics, valid after update_statistics()
+  std::vector<std::vector<F>> smin, smax; // nscalars columns
+  std::vector<std::vector<F>> bbmin, bbmax; // cpdims columns
+  std::vector<F> tmin, tmax, vmmin, vmmax;
+  std::vector<uint32_t> consistent_type;
+
+protected:
+  template <typename C> static void resize_columns(std::vector<C>& cols, int n, size_t m) {
+    cols.resize(n);
+    for (auto &c : cols) c.resize(m);
+  }
+  template <typename C> static void gather_column(std::vector<C>& col, const std::vector<size_t>& indices) { // in place; indices are ascending
+    for (size_t j = 0; j < indices.size(); j ++)
+      col[j] = col[indices[j]];
+    col.resize(indices.size());
+  }
+  void resize_statistics(size_t n);
+  template <typename G> void copy_statistics(const feature_point_store_t<G>& s, size_t i, size_t j); // of the i-th curve of s to the j-th curve
+  void print_point(std::ostream& os, size_t k, int id, const std::vector<std::string>& scalar_components) const;
+
+protected:
+  friend struct diy::Serialization<feature_point_store_t<F>>;
+  int cpdims = 3, nscalars = 1;
+  bool has_velocity = false;
+  int max_curve_id = -1;
+};
+
+/////
+template <typename F>
+void feature_point_store_t<F>::reset(int cpdims_, int nscalars_, bool has_velocity_)
+{
+  if (cpdims_ < 1 || cpdims_ > 3)
+    fatal("invalid number of spatial dimensions for the feature point store");
+  if (nscalars_ < 0 || nscalars_ > FTK_CP_MAX_NUM_VARS)
+    fatal("invalid number of scalar components for the feature point store");
+
+  cpdims = cpdims_;
+  nscalars = nscalars_;
+  has_velocity = has_velocity_;
+  max_curve_id = -1;
+
+  x.assign(cpdims, std::vector<F>());
+  scalar.assign(nscalars, std::vector<F>());
+  v.assign(has_velocity ? cpdims : 0, std::vector<F>());
+  t.clear(); cond.clear();
+  timestep.clear(); type.clear(); ordinal.clear(); tag.clear();
+
+  offsets.assign(1, 0);
+  curve_ids.clear();
+  loops.clear();
+  resize_statistics(0);
+}
+
+template <typename F>
+void feature_point_store_t<F>::reserve(size_t n)
+{
+  for (auto &c : x) c.reserve(n);
+  for (auto &c : scalar) c.reserve(n);
+  for (auto &c : v) c.reserve(n);
+  t.reserve(n); cond.reserve(n);
+  timestep.reserve(n); type.reserve(n); ordinal.reserve(n); tag.reserve(n);
+}
+
+template <typename F>
+size_t feature_point_store_t<F>::memory_usage() const
+{
+  const size_t n = size(), m = n_curves();
+  const size_t ncols = x.size() + scalar.size() + v.size() + 2;
+  return n * (ncols * sizeof(F) + sizeof(int) + sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t))
+    + offsets.size() * sizeof(size_t)
+    + m * (sizeof(int) + sizeof(uint8_t) + sizeof(uint32_t) + (2*nscalars + 2*cpdims + 4) * sizeof(F));
+}
+
+template <typename F>
+void feature_point_store_t<F>::resize_statistics(size_t n)
+{
+  resize_columns(smin, nscalars, n);
+  resize_columns(smax, nscalars, n);
+  resize_columns(bbmin, cpdims, n);
+  resize_columns(bbmax, cpdims, n);
+  tmin.resize(n); tmax.resize(n);
+  vmmin.resize(n); vmmax.resize(n);
+  consistent_type.resize(n);
+}
+
+template <typename F>
+void feature_point_store_t<F>::push_back(const feature_point_t& p)
+{
+  for (int k = 0; k < cpdims; k ++)
+    x[k].push_back(p.x[k]);
+  t.push_back(p.t);
+  cond.push_back(p.cond);
+  for (int k = 0; k < nscalars; k ++)
+    scalar[k].push_back(p.scalar[k]);
+  for (size_t k = 0; k < v.size(); k ++)
+    v[k].push_back(p.v[k]);
+  timestep.push_back(p.timestep);
+  type.push_back(p.type);
+  ordinal.push_back(p.ordinal);
+  tag.push_back(p.tag);
+}
+
+template <typename F>
+feature_point_t feature_point_store_t<F>::point(size_t k) const
+{
+  feature_point_t p;
+  for (int j = 0; j < cpdims; j ++)
+    p.x[j] = x[j][k];
+  p.t = t[k];
+  p.cond = cond[k];
+  for (int j = 0; j < nscalars; j ++)
+    p.scalar[j] = scalar[j][k];
+  for (size_t j = 0; j < v.size(); j ++)
+    p.v[j] = v[j][k];
+  p.timestep = timestep[k];
+  p.type = type[k];
+  p.ordinal = ordinal[k];
+  p.tag = tag[k];
+  return p;
+}
+
+template <typename F>
+feature_point_t feature_point_store_t<F>::point(size_t i, size_t j) const
+{
+  feature_point_t p = point(offsets[i] + j);
+  p.id = curve_ids[i];
+  return p;
+}
+
+template <typename F>
+void feature_point_store_t<F>::close_curve(int id, bool loop)
+{
+  offsets.push_back(size());
+  curve_ids.push_back(id);
+  loops.push_back(loop);
+  max_curve_id = std::max(max_curve_id, id);
+  resize_statistics(n_curves());
+}
+
+template <typename F>
+int feature_point_store_t<F>::close_curve(bool loop)
+{
+  const int id = get_new_id();
+  close_curve(id, loop);
+  return id;
+}
+
+template <typename F>
+void feature_point_store_t<F>::add(const feature_curve_t& c, int id)
+{
+  if (size() != offsets.back())
+    fatal("cannot add a curve while another curve is open");
+
+  for (const auto &p : c)
+    push_back(p);
+  close_curve(id, c.loop);
+
+  // keep the statistics of the curve
+  const size_t i = n_curves() - 1;
+  for (int k = 0; k < nscalars; k ++) {
+    smin[k][i] = c.min[k];
+    smax[k][i] = c.max[k];
+  }
+  for (int k = 0; k < cpdims; k ++) {
+    bbmin[k][i] = c.bbmin[k];
+    bbmax[k][i] = c.bbmax[k];
+  }
+  tmin[i] = c.tmin; tmax[i] = c.tmax;
+  vmmin[i] = c.vmmin; vmmax[i] = c.vmmax;
+  consistent_type[i] = c.consistent_type;
+}
+
+template <typename F>
+int feature_point_store_t<F>::add(const feature_curve_t& c)
+{
+  const int id = get_new_id();
+  add(c, id);
+  return id;
+}
+
+template <typename F>
+template <typename G>
+void feature_point_store_t<F>::add(const feature_point_store_t<G>& s, size_t i)
+{
+  if (size() != offsets.back())
+    fatal("cannot add a curve while another curve is open");
+
+  // column by column; columns missing in s are zeros
+  const size_t n = s.curve_size(i), k0 = s.offsets[i], k1 = s.offsets[i+1];
+  auto append = [&](std::vector<F>& col, const std::vector<G>* src) {
+    if (src) col.insert(col.end(), src->begin() + k0, src->begin() + k1);
+    else col.resize(col.size() + n, F(0));
+  };
+  for (int k = 0; k < cpdims; k ++)
+    append(x[k], k < s.get_cpdims() ? &s.x[k] : NULL);
+  append(t, &s.t);
+  append(cond, &s.cond);
+  for (int k = 0; k < nscalars; k ++)
+    append(scalar[k], k < s.get_number_of_scalar_components() ? &s.scalar[k] : NULL);
+  for (size_t k = 0; k < v.size(); k ++)
+    append(v[k], k < s.v.size() ? &s.v[k] : NULL);
+  timestep.insert(timestep.end(), s.timestep.begin() + k0, s.timestep.begin() + k1);
+  type.insert(type.end(), s.type.begin() + k0, s.type.begin() + k1);
+  ordinal.insert(ordinal.end(), s.ordinal.begin() + k0, s.ordinal.begin() + k1);
+  tag.insert(tag.end(), s.tag.begin() + k0, s.tag.begin() + k1);
+
+  close_curve(s.curve_ids[i], s.loops[i]);
+  copy_statistics(s, i, n_curves() - 1);
+}
+
+template <typename F>
+template <typename G>
+void feature_point_store_t<F>::copy_statistics(const feature_point_store_t<G>& s, size_t i, size_t j)
+{
+  const int ns = s.get_number_of_scalar_components(), nd = s.get_cpdims();
+  for (int k = 0; k < nscalars; k ++) {
+    smin[k][j] = k < ns ? F(s.smin[k][i]) : F(0);
+    smax[k][j] = k < ns ? F(s.smax[k][i]) : F(0);
+  }
+  for (int k = 0; k < cpdims; k ++) {
+    bbmin[k][j] = k < nd ? F(s.bbmin[k][i]) : F(0);
+    bbmax[k][j] = k < nd ? F(s.bbmax[k][i]) : F(0);
+  }
+  tmin[j] = s.tmin[i]; tmax[j] = s.tmax[i];
+  vmmin[j] = s.vmmin[i]; vmmax[j] = s.vmmax[i];
+  consistent_type[j] = s.consistent_type[i];
+}
+
+template <typename F>
+feature_curve_t feature_point_store_t<F>::curve(size_t i) const
+{
+  feature_curve_t c;
+  c.reserve(curve_size(i));
+  for (size_t k = offsets[i]; k < offsets[i+1]; k ++) {
+    c.push_back(point(k));
+    c.back().id = curve_ids[i];
+  }
+
+  c.id = curve_ids[i];
+  c.loop = loops[i];
+  c.min.fill(0); c.max.fill(0); c.persistence.fill(0);
+  c.bbmin.fill(0); c.bbmax.fill(0);
+  for (int k = 0; k < nscalars; k ++) {
+    c.min[k] = smin[k][i];
+    c.max[k] = smax[k][i];
+    c.persistence[k] = smax[k][i] - smin[k][i];
+  }
+  for (int k = 0; k < cpdims; k ++) {
+    c.bbmin[k] = bbmin[k][i];
+    c.bbmax[k] = bbmax[k][i];
+  }
+  c.tmin = tmin[i]; c.tmax = tmax[i];
+  c.vmmin = vmmin[i]; c.vmmax = vmmax[i];
+  c.consistent_type = consistent_type[i];
+  return c;
+}
+
+template <typename F>
+void feature_point_store_t<F>::from_curve_set(const feature_curve_set_t& s)
+{
+  clear();
+
+  size_t n = 0;
+  for (const auto &kv : s)
+    n += kv.second.size();
+  reserve(n);
+
+  for (const auto &kv : s)
+    add(kv.second, kv.first);
+}
+
+template <typename F>
+feature_curve_set_t feature_point_store_t<F>::to_curve_set() const
+{
+  feature_curve_set_t s;
+  for (size_t i = 0; i < n_curves(); i ++)
+    s.insert(std::make_pair(curve_ids[i], curve(i)));
+  return s;
+}
+
+template <typename F>
+void feature_point_store_t<F>::update_statistics()
+{
+  // column by column; the values of inactive scalars and coordinates are zeros
+  // in feature_curve_t and thus not kept
+  resize_statistics(n_curves());
+
+  auto minmax = [&](const std::vector<F>& col, std::vector<F>& lo, std::vector<F>& hi) {
+    for (size_t i = 0; i < n_curves(); i ++) {
+      if (curve_size(i) == 0) continue; // nothing to do
+      F a = std::numeric_limits<F>::max(), b = std::numeric_limits<F>::lowest();
+      for (size_t k = offsets[i]; k < offsets[i+1]; k ++) {
+        a = std::min(a, col[k]);
+        b = std::max(b, col[k]);
+      }
+      lo[i] = a;
+      hi[i] = b;
+    }
+  };
+
+  for (int k = 0; k < nscalars; k ++)
+    minmax(scalar[k], smin[k], smax[k]);
+  for (int k = 0; k < cpdims; k ++)
+    minmax(x[k], bbmin[k], bbmax[k]);
+  minmax(t, tmin, tmax);
+
+  for (size_t i = 0; i < n_curves(); i ++) {
+    if (curve_size(i) == 0) continue;
+    F a = std::numeric_limits<F>::max(), b = std::numeric_limits<F>::lowest();
+    for (size_t k = offsets[i]; k < offsets[i+1]; k ++) {
+      F vm2 = 0;
+      for (size_t j = 0; j < v.size(); j ++)
+        vm2 += v[j][k] * v[j][k];
+      a = std::min(a, F(std::sqrt(vm2)));
+      b = std::max(b, F(std::sqrt(vm2)));
+    }
+    vmmin[i] = a;
+    vmmax[i] = b;
+
+    uint32_t ct = type[offsets[i]];
+    for (size_t k = offsets[i]; k < offsets[i+1]; k ++)
+      if (type[k] != ct) {
+        ct = 0;
+        break;
+      }
+    consistent_type[i] = ct;
+  }
+}
+
+template <typename F>
+void feature_point_store_t<F>::filter(std::function<bool(const feature_curve_t&)> f)
+{
+  feature_point_store_t<F> s(cpdims, nscalars, has_velocity);
+  for (size_t i = 0; i < n_curves(); i ++)
+    if (f(curve(i)))
+      s.add(*this, i);
+  s.max_curve_id = max_curve_id; // ids of removed curves are not reused
+  std::swap(*this, s);
+}
+
+template <typename F>
+void feature_point_store_t<F>::discard_interval_points()
+{
+  if (size() != offsets.back())
+    fatal("cannot discard points while a curve is open");
+
+  // compacts all point columns in place with the same mapping
+  std::vector<size_t> kept;
+  kept.reserve(size());
+  for (size_t i = 0; i < n_curves(); i ++) {
+    const size_t k0 = offsets[i];
+    offsets[i] = kept.size();
+    for (size_t k = k0; k < offsets[i+1]; k ++)
+      if (ordinal[k]) kept.push_back(k);
+  }
+  offsets.back() = kept.size();
+
+  for (auto &c : x) gather_column(c, kept);
+  for (auto &c : scalar) gather_column(c, kept);
+  for (auto &c : v) gather_column(c, kept);
+  gather_column(t, kept); gather_column(cond, kept);
+  gather_column(timestep, kept); gather_column(type, kept);
+  gather_column(ordinal, kept); gather_column(tag, kept);
+}
+
+template <typename F>
+std::vector<size_t> feature_point_store_t<F>::slice_indices(int ts) const
+{
+  std::vector<size_t> results;
+  for (size_t k = 0; k < offsets.back(); k ++)
+    if (ordinal[k] && timestep[k] == ts)
+      results.push_back(k);
+  return results;
+}
+
+template <typename F>
+std::map<int, std::vector<feature_point_t>> feature_point_store_t<F>::slice() const
+{
+  std::map<int, std::vector<feature_point_t>> results;
+  for (size_t i = 0; i < n_curves(); i ++)
+    for (size_t k = offsets[i]; k < offsets[i+1]; k ++)
+      if (ordinal[k]) {
+        feature_point_t p = point(k);
+        p.id = curve_ids[i];
+        results[p.timestep].push_back(p);
+      }
+  return results;
+}
+
+template <typename F>
+void feature_point_store_t<F>::print_point(std::ostream& os, size_t k, int id, const std::vector<std::string>& scalar_components) const
+{
+  // same as feature_point_t::print
+  auto xk = [&](int j) { return j < cpdims ? x[j][k] : F(0); };
+  auto vk = [&](size_t j) { return j < v.size() ? v[j][k] : F(0); };
+  auto sk = [&](int j) { return j < nscalars ? scalar[j][k] : F(0); };
+
+  if (cpdims == 2) os << "x=(" << xk(0) << ", " << xk(1) << "), ";
+  else os << "x=(" << xk(0) << ", " << xk(1) << ", " << xk(2) << "), ";
+  os << "t=" << t[k] << ", ";
+  os << "cond=" << cond[k] << ", ";
+  for (size_t j = 0; j < scalar_components.size(); j ++)
+    os << scalar_components[j] << "=" << sk(j) << ", ";
+  os << "v=";
+  if (cpdims == 2) os << "(" << vk(0) << ", " << vk(1) << "), ";
+  else os << "(" << vk(0) << ", " << vk(1) << ", " << vk(2) << "), ";
+  os << "type=" << type[k] << ", ";
+  os << "timestep=" << timestep[k] << ", ";
+  os << "ordinal=" << bool(ordinal[k]) << ", ";
+  os << "tag=" << tag[k] << ", ";
+  os << "id=" << id;
+}
+
+template <typename F>
+void feature_point_store_t<F>::write_text(std::ostream& os, const std::vector<std::string>& scalar_components) const
+{
+  // same as feature_curve_set_t::write_text
+  const size_t ns = scalar_components.size();
+  if (ns > size_t(nscalars))
+    fatal("more scalar components requested than stored");
+
+  os << "#trajectories=" << n_curves() << std::endl;
+  for (size_t i = 0; i < n_curves(); i ++) {
+    os << "--trajectory " << curve_ids[i] << ", ";
+
+    if (ns > 0) {
+      os << "min=(";
+      for (size_t k = 0; k < ns; k ++)
+        os << smin[k][i] << (k < ns-1 ? ", " : "), ");
+      os << "max=(";
+      for (size_t k = 0; k < ns; k ++)
+        os << smax[k][i] << (k < ns-1 ? ", " : "), ");
+      os << "persistence=(";
+      for (size_t k = 0; k < ns; k ++)
+        os << smax[k][i] - smin[k][i] << (k < ns-1 ? ", " : "), ");
+    }
+
+    os << "bbmin=(";
+    for (int k = 0; k < cpdims; k ++)
+      os << bbmin[k][i] << ", ";
+    os << "bbmax=(";
+    for (int k = 0; k < cpdims; k ++)
+      os << bbmax[k][i] << ", ";
+
+    os << "tmin=" << tmin[i] << ", tmax=" << tmax[i] << ", ";
+    os << "consistent_type=" << consistent_type[i] << ", ";
+    os << "loop=" << bool(loops[i]);
+    os << std::endl;
+
+    for (size_t k = offsets[i]; k < offsets[i+1]; k ++) {
+      os << "---";
+      print_point(os, k, curve_ids[i], scalar_components);
+      os << std::endl;
+    }
+  }
+}
+
+template <typename F>
+void feature_point_store_t<F>::write_binary(const std::string& filename) const
+{
+  diy::serializeToFile(*this, filename);
+}
+
+template <typename F>
+void feature_point_store_t<F>::read_binary(const std::string& filename)
+{
+  diy::unserializeFromFile(filename, *this);
+}
+
+#if FTK_HAVE_VTK
+template <typename F>
+vtkSmartPointer<vtkPolyData> feature_point_store_t<F>::to_vtp(const std::vector<std::string> &scalar_components, double tfactor) const
+{
+  // same as feature_curve_set_t::to_vtp; loops repeat their first point
+  vtkSmartPointer<vtkPolyData> polyData = vtkPolyData::New();
+  vtkSmartPointer<vtkPoints> points = vtkPoints::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkCellArray::New();
+  vtkSmartPointer<vtkCellArray> verts = vtkCellArray::New();
+
+  std::vector<size_t> indices; // point index of each vtk point
+  std::vector<int> ids;
+  for (size_t i = 0; i < n_curves(); i ++) {
+    const size_t n = curve_size(i);
+    if (n == 0) continue;
+    const size_t npts = loops[i] ? n+1 : n;
+
+    vtkSmartPointer<vtkPolyLine> obj = vtkPolyLine::New();
+    obj->GetPointIds()->SetNumberOfIds(npts);
+    for (size_t j = 0; j < npts; j ++) {
+      obj->GetPointIds()->SetId(j, indices.size());
+      indices.push_back(offsets[i] + j % n);
+      ids.push_back(curve_ids[i]);
+    }
+
+    if (n < 2) verts->InsertNextCell(obj);
+    else lines->InsertNextCell(obj);
+  }
+
+  const size_t nv = indices.size();
+  for (const auto k : indices)
+    points->InsertNextPoint(x[0][k], cpdims > 1 ? x[1][k] : 0,
+        cpdims == 2 ? t[k] * tfactor : (cpdims > 2 ? x[2][k] : 0));
+
+  polyData->SetPoints(points);
+  polyData->SetLines(lines);
+  polyData->SetVerts(verts);
+
+  vtkSmartPointer<vtkUnsignedIntArray> types = vtkSmartPointer<vtkUnsignedIntArray>::New();
+  types->SetNumberOfValues(nv);
+  vtkSmartPointer<vtkUnsignedIntArray> vids = vtkSmartPointer<vtkUnsignedIntArray>::New();
+  vids->SetNumberOfValues(nv);
+  vtkSmartPointer<vtkFloatArray> vels = vtkSmartPointer<vtkFloatArray>::New();
+  vels->SetNumberOfComponents(3);
+  vels->SetNumberOfTuples(nv);
+  vtkSmartPointer<vtkFloatArray> time = vtkSmartPointer<vtkFloatArray>::New();
+  time->SetNumberOfValues(nv);
+  vtkSmartPointer<vtkFloatArray> conds = vtkSmartPointer<vtkFloatArray>::New();
+  conds->SetNumberOfValues(nv);
+
+  for (size_t i = 0; i < nv; i ++) {
+    const size_t k = indices[i];
+    types->SetValue(i, type[k]);
+    vids->SetValue(i, ids[i]);
+    float vel[3] = {0};
+    for (size_t j = 0; j < v.size(); j ++)
+      vel[j] = v[j][k];
+    vels->SetTuple3(i, vel[0], vel[1], vel[2]);
+    time->SetValue(i, t[k]);
+    conds->SetValue(i, cond[k]);
+  }
+
+  types->SetName("type");
+  polyData->GetPointData()->AddArray(types);
+  vids->SetName("id");
+  polyData->GetPointData()->AddArray(vids);
+  vels->SetName("velocity");
+  polyData->GetPointData()->AddArray(vels);
+  time->SetName("time");
+  polyData->GetPointData()->AddArray(time);
+  conds->SetName("cond");
+  polyData->GetPointData()->AddArray(conds);
+
+  for (int k = 0; k < int(scalar_components.size()) && k < nscalars; k ++) {
+    vtkSmartPointer<vtkFloatArray> s = vtkSmartPointer<vtkFloatArray>::New();
+    s->SetNumberOfValues(nv);
+    for (size_t i = 0; i < nv; i ++)
+      s->SetValue(i, scalar[k][indices[i]]);
+    s->SetName(scalar_components[k].c_str());
+    polyData->GetPointData()->AddArray(s);
+  }
+
+  return polyData;
+}
+#endif
+
+}
+
+// serialization; columns are written as raw arrays
+namespace diy {
+  template <typename F> struct Serialization<ftk::feature_point_store_t<F>> {
+    static void save(diy::BinaryBuffer& bb, const ftk::feature_point_store_t<F> &s) {
+      diy::save(bb, s.get_cpdims());
+      diy::save(bb, s.get_number_of_scalar_components());
+      diy::save(bb, s.has_velocities());
+      diy::save(bb, s.x);
+      diy::save(bb, s.t);
+      diy::save(bb, s.cond);
+      diy::save(bb, s.scalar);
+      diy::save(bb, s.v);
+      diy::save(bb, s.timestep);
+      diy::save(bb, s.type);
+      diy::save(bb, s.ordinal);
+      diy::save(bb, s.tag);
+      diy::save(bb, s.offsets);
+      diy::save(bb, s.curve_ids);
+      diy::save(bb, s.loops);
+      diy::save(bb, s.smin);
+      diy::save(bb, s.smax);
+      diy::save(bb, s.bbmin);
+      diy::save(bb, s.bbmax);
+      diy::save(bb, s.tmin);
+      diy::save(bb, s.tmax);
+      diy::save(bb, s.vmmin);
+      diy::save(bb, s.vmmax);
+      diy::save(bb, s.consistent_type);
+    }
+
+    static void load(diy::BinaryBuffer& bb, ftk::feature_point_store_t<F> &s) {
+      int cpdims, nscalars;
+      bool has_velocity;
+      diy::load(bb, cpdims);
+      diy::load(bb, nscalars);
+      diy::load(bb, has_velocity);
+      s.reset(cpdims, nscalars, has_velocity);
+      diy::load(bb, s.x);
+      diy::load(bb, s.t);
+      diy::load(bb, s.cond);
+      diy::load(bb, s.scalar);
+      diy::load(bb, s.v);
+      diy::load(bb, s.timestep);
+      diy::load(bb, s.type);
+      diy::load(bb, s.ordinal);
+      diy::load(bb, s.tag);
+      diy::load(bb, s.offsets);
+      diy::load(bb, s.curve_ids);
+      diy::load(bb, s.loops);
+      diy::load(bb, s.smin);
+      diy::load(bb, s.smax);
+      diy::load(bb, s.bbmin);
+      diy::load(bb, s.bbmax);
+      diy::load(bb, s.tmin);
+      diy::load(bb, s.tmax);
+      diy::load(bb, s.vmmin);
+      diy::load(bb, s.vmmax);
+      diy::load(bb, s.consistent_type);
+      s.max_curve_id = s.curve_ids.empty() ? -1 : *std::max_element(s.curve_ids.begin(), s.curve_ids.end());
+    }
+  };
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <ftk/config.hh>
 #include <ftk/filters/tracker.hh>
 #include <ftk/tracking_graph/tracking_graph.hh>
+#include <ftk/tracking_graph/streaming_tracking_graph.hh>
 
 namespace ftk {
 
@@ -28,8 +29,16 @@ struct connected_component_tracker : public tracker
 
   const ftk::tracking_graph<>& get_tracking_graph() const {return tg;}
 
+  // labels and events are produced every timestep instead of in finalize(); 
+  // only the last window_size timesteps of the graph are kept in memory
+  void enable_streaming_tracking_graph(size_t window_size = 2, const std::string& flush_filename = "");
+  bool is_streaming() const {return streaming;}
+  ftk::streaming_tracking_graph<TimeIndexType, LabelIdType>& get_streaming_tracking_graph() {return stg;}
+
 protected:
   ftk::tracking_graph<TimeIndexType, LabelIdType> tg;
+  ftk::streaming_tracking_graph<TimeIndexType, LabelIdType> stg;
+  bool streaming = false;
   std::deque<std::vector<LabelIdType>> labeled_data_snapshots;
   TimeIndexType current_timestep = 0;
 };
@@ -39,13 +48,34 @@ protected:
 template <typename TimeIndexType, typename LabelIdType>
 void connected_component_tracker<TimeIndexType, LabelIdType>::finalize()
 {
-  tg.relabel();
+  if (streaming) stg.finish();
+  else tg.relabel();
+}
+
+template <typename TimeIndexType, typename LabelIdType>
+void connected_component_tracker<TimeIndexType, LabelIdType>::enable_streaming_tracking_graph(size_t window_size, const std::string& flush_filename)
+{
+  streaming = true;
+  stg.set_window_size(window_size);
+  if (!flush_filename.empty())
+    stg.set_flush_filename(flush_filename);
 }
 
 template <typename TimeIndexType, typename LabelIdType>
 void connected_component_tracker<TimeIndexType, LabelIdType>::update_timestep()
 {
-  if (labeled_data_snapshots.size() < 2) return;
+  if (streaming) {
+    std::set<LabelIdType> labels;
+    for (const auto l : labeled_data_snapshots.back())
+      if (l != 0) labels.insert(l);
+    for (const auto l : labels)
+      stg.add_node(l);
+  }
+
+  if (labeled_data_snapshots.size() < 2) {
+    if (streaming) stg.advance_timestep();
+    return;
+  }
 
   const auto &labels0 = labeled_data_snapshots[0],
              &labels1 = labeled_data_snapshots[1];
@@ -53,8 +83,11 @@ void connected_component_tracker<TimeIndexType, LabelIdType>::update_timestep()
   for (size_t i = 0; i < labels0.size(); i ++)
     if (labels0[i] != 0 && labels1[i] != 0) {
       // fprintf(stderr, "edge: %d --> %d\n", labels0[i], labels1[i]);
-      tg.add_edge(current_timestep-1, labels0[i], current_timestep, labels1[i]);
+      if (streaming) stg.add_edge(labels0[i], labels1[i]);
+      else tg.add_edge(current_timestep-1, labels0[i], current_timestep, labels1[i]);
     }
+  
+  if (streaming) stg.advance_timestep();
 }
 
 template <typename TimeIndexType, typename LabelIdType>
@@ -203,6 +203,7 @@ inline bool contour_tracker_2d_regular::check_simplex(
 inline void contour_tracker_2d_regular::update_timestep()
 {
   if (comm.rank() == 0) fprintf(stderr, "current_timestep=%d\n", current_timestep);
+  instrumentation::scoped_timer timer(instr, "update_timestep");
 
   auto func = [=](element_t e) {
     feature_point_t p;
@@ -224,9 +225,15 @@ inline void contour_tracker_2d_regular::update_timestep()
     }
   };
 
-  m.element_for_ordinal(1, current_timestep, func, xl, nthreads, enable_set_affinity);
+  typedef std::chrono::high_resolution_clock clock_type;
+  auto t0 = clock_type::now();
+
+  element_for_ordinal(1, func);
   if (field_data_snapshots.size() >= 2) // interval
-    m.element_for_interval(1, current_timestep, current_timestep+1, func, xl, nthreads, enable_set_affinity);
+    element_for_interval(1, func);
+  
+  auto t1 = clock_type::now();
+  accumulated_kernel_time += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
 }
 
 inline void contour_tracker_2d_regular::simplex_coordinates(
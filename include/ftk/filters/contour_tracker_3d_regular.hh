@@ -178,7 +178,7 @@ inline void contour_tracker_3d_regular::finalize()
   double max_accumulated_kernel_time;
   diy::mpi::reduce(comm, accumulated_kernel_time, max_accumulated_kernel_time, get_root_proc(), diy::mpi::maximum<double>());
   if (comm.rank() == get_root_proc())
-    fprintf(stderr, "max_accumulated_kernel_time=%f\n", accumulated_kernel_time);
+    fprintf(stderr, "max_accumulated_kernel_time=%f\n", max_accumulated_kernel_time);
   
   diy::mpi::gather(comm, intersections, intersections, get_root_proc());
   diy::mpi::gather(comm, related_cells, related_cells, get_root_proc());
@@ -278,6 +278,7 @@ inline void contour_tracker_3d_regular::update_timestep()
   
   typedef std::chrono::high_resolution_clock clock_type;
   auto t0 = clock_type::now();
+  instrumentation::scoped_timer timer(instr, "update_timestep");
   
   auto get_relatetd_cels = [&](element_t e) {
     std::set<element_t> my_related_cells;
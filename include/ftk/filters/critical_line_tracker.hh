@@ -39,8 +39,18 @@ protected:
     ndarray<float> v, w; // vector fields, optional
     ndarray<float> J; // jacobian, optional
     ndarray<float> vorticity; // vorticity field, optional
+
+    // fixed-point uv for robust detection, quantized once per snapshot in the 
+    // layout of uv, i.e. uv_fixed[k*2 + j]; simplex tests gather the vertices 
+    // of one simplex at a time, so both components of a vertex are adjacent
+    std::vector<long long> uv_fixed;
   };
   std::deque<field_data_snapshot_t> field_data_snapshots;
+
+  // uv are quantized w/ a fixed factor of 2^21, the largest factor that the 
+  // critical point trackers derive from the resolution of the vector fields
+  static constexpr long long uv_scaling_factor = 1LL << 21;
+  void quantize_uv(field_data_snapshot_t&) const;
 };
 
 /////
@@ -61,6 +71,16 @@ inline bool critical_line_tracker::pop_field_data_snapshot()
   } else return false;
 }
   
+inline void critical_line_tracker::quantize_uv(field_data_snapshot_t& s) const
+{
+  const size_t n = s.uv.nelem();
+  const float *p = s.uv.data();
+
+  s.uv_fixed.resize(n);
+  for (size_t i = 0; i < n; i ++)
+    s.uv_fixed[i] = uv_scaling_factor * p[i];
+}
+
 inline void critical_line_tracker::push_field_data_snapshot(const ndarray<float> &data)
 {
   field_data_snapshot_t snapshot; 
@@ -23,6 +23,7 @@ public:
 
   void read_surfaces(const std::string& filename, std::string format="auto");
 
+  size_t get_number_of_intersections() const {return intersections.size();} // gathered to the root proc by finalize()
   void write_intersections(const std::string& filename) const;
   void write_sliced(const std::string& pattern) const;
   void write_surfaces(const std::string& filename, std::string format="auto") const;
@@ -45,6 +46,9 @@ protected:
       const std::vector<std::vector<int>>& vertices,
       float X[][4],
       float UV[][2]) const;
+  void simplex_values_fixed(
+      const std::vector<std::vector<int>>& vertices,
+      long long UVf[][2]) const;
 
   virtual std::vector<std::string> varnames() const { return {}; } // varnames for additional variables stored in scalar
 };
@@ -56,7 +60,7 @@ inline void critical_line_tracker_3d_regular::finalize()
   double max_accumulated_kernel_time;
   diy::mpi::reduce(comm, accumulated_kernel_time, max_accumulated_kernel_time, get_root_proc(), diy::mpi::maximum<double>());
   if (comm.rank() == get_root_proc())
-    fprintf(stderr, "max_accumulated_kernel_time=%f\n", accumulated_kernel_time);
+    fprintf(stderr, "max_accumulated_kernel_time=%f\n", max_accumulated_kernel_time);
   
   diy::mpi::gather(comm, intersections, intersections, get_root_proc());
   diy::mpi::gather(comm, related_cells, related_cells, get_root_proc());
@@ -150,13 +154,11 @@ inline bool critical_line_tracker_3d_regular::check_simplex(
   float mu[3], // barycentric coordinates
         cond; // condition number
 
-  const long long factor = 2 << 20; // TODO
-  long long UVf[3][2];
+  long long UVf[3][2]; // quantized in update_timestep()
+  simplex_values_fixed(vertices, UVf);
   for (int i = 0; i < 3; i ++)
-    for (int j = 0; j < 2; j ++) {
-      UVf[i][j] = factor * UV[i][j];
+    for (int j = 0; j < 2; j ++)
       uv[i][j] = UV[i][j];
-    }
   
   int indices[3];
   simplex_indices(vertices, indices);
@@ -196,8 +198,13 @@ inline void critical_line_tracker_3d_regular::update_timestep()
   if (comm.rank() == 0) fprintf(stderr, "current_timestep=%d\n", current_timestep);
   // std::cerr << field_data_snapshots[0].uv.shape() << std::endl;
 
+  for (auto &s : field_data_snapshots)
+    if (s.uv_fixed.empty())
+      quantize_uv(s);
+
   typedef std::chrono::high_resolution_clock clock_type;
   auto t0 = clock_type::now();
+  instrumentation::scoped_timer timer(instr, "update_timestep");
 
   auto get_relatetd_cels = [&](element_t e) {
     std::set<element_t> my_related_cells;
@@ -259,6 +266,22 @@ inline void critical_line_tracker_3d_regular::simplex_values(
   }
 }
 
+inline void critical_line_tracker_3d_regular::simplex_values_fixed(
+      const std::vector<std::vector<int>>& vertices,
+      long long UVf[][2]) const
+{
+  for (int i = 0; i < vertices.size(); i ++) {
+    const int iv = vertices[i][3] == current_timestep ? 0 : 1;
+    const auto &f = field_data_snapshots[iv];
+
+    const size_t k = (vertices[i][0] - local_array_domain.start(0)) 
+      + (vertices[i][1] - local_array_domain.start(1)) * f.uv.dim(1)
+      + (vertices[i][2] - local_array_domain.start(2)) * f.uv.dim(1) * f.uv.dim(2);
+    UVf[i][0] = f.uv_fixed[k*2];
+    UVf[i][1] = f.uv_fixed[k*2+1];
+  }
+}
+
 inline void critical_line_tracker_3d_regular::write_surfaces(const std::string& filename, std::string format) const 
 {
   if (comm.rank() == get_root_proc()) {
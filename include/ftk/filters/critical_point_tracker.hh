@@ -3,11 +3,15 @@
 
 #include <ftk/config.hh>
 #include <ftk/algorithms/cca.hh>
+#include <ftk/basic/simple_union_find.hh>
 #include <ftk/features/feature_point.hh>
 #include <ftk/features/feature_curve.hh>
 #include <ftk/features/feature_curve_set.hh>
+#include <ftk/features/feature_point_store.hh>
+#include <ftk/features/feature_curve_file.hh>
 #include <ftk/filters/filter.hh>
 #include <ftk/filters/tracker.hh>
+#include <ftk/storage/base.h>
 #include <ftk/geometry/points2vtk.hh>
 #include <ftk/geometry/cc2curves.hh>
 #include <ftk/geometry/write_polydata.hh>
@@ -22,13 +26,40 @@ enum {
   SOURCE_DERIVED // implicit
 };
 
+// field data of a timestep, stored in the value type T of the inputs (e.g.
+// float for single-precision data); the fixed-point vectors for robust 
+// detection are the same for all value types
+template <typename T=double>
+struct critical_point_field_data_snapshot {
+  ndarray<T> scalar, vector, jacobian;
+  ndarray<T> attached; // attached variables, see critical_point_tracker_regular
+  std::vector<int> origin; // lower corner of cropped arrays in the grid, see critical_point_tracker_regular
+
+  // fixed-point vector field for robust detection w/o gmp, quantized once 
+  // per scaling factor and stored component by component (SoA), i.e. the 
+  // j-th component of the k-th vertex is vector_fixed[j*vector_fixed_n + k].
+  // The cell sign masks of the regular trackers are scanned over each 
+  // component array in vectorizable loops; check_simplex gathers vertices
+  // through fixed_vector()
+  double vector_resolution = -1; // cached vector.resolution(); negative if not computed yet
+  uint64_t vector_fixed_factor = 0;
+  size_t vector_fixed_n = 0;
+  std::vector<int64_t> vector_fixed;
+  int64_t fixed_vector(int j, size_t k) const { return vector_fixed[j * vector_fixed_n + k]; } // j-th component of the k-th vertex
+
+  // per-cell sign masks of vector components, see critical_point_tracker_regular
+  std::vector<uint8_t> cell_sign_mask;
+  uint64_t cell_sign_mask_factor = 0; // 0 for exact signs
+};
+
 struct critical_point_tracker : public virtual tracker {
   critical_point_tracker(diy::mpi::communicator comm) : tracker(comm) {}
 
   virtual void update() {}; 
   void reset() {
-    field_data_snapshots.clear();
     traced_critical_points.clear();
+    compact_trajectories.clear();
+    min_trajectory_id = 0;
   }
 
   void set_enable_robust_detection(bool b) { enable_robust_detection = b; }
@@ -37,6 +68,17 @@ struct critical_point_tracker : public virtual tracker {
   void set_enable_discarding_degenerate_points(bool b) { enable_discarding_degenerate_points = b; }
   void set_enable_ignoring_degenerate_points(bool b) { enable_ignoring_degenerate_points = b; }
 
+  // With compact trajectories, traced critical points are kept in a columnar
+  // store (see feature_point_store.hh) instead of a feature_curve_set_t:
+  // offline tracing appends curves to the store, and statistics, selection,
+  // slicing, the trajectory writers, and the storage work on the store.  
+  // Trajectories traced otherwise (streaming, spilling, time intervals) are
+  // moved to the store by finalize().  Post-processing that edits curves 
+  // (e.g. splitting or smoothing types) needs a feature_curve_set_t and is 
+  // not available.
+  void set_enable_compact_trajectories(bool b) { enable_compact_trajectories = b; }
+  bool is_compact() const { return enable_compact_trajectories; }
+
   void set_type_filter(unsigned int);
   
   void set_scalar_field_source(int s) {scalar_field_source = s;}
@@ -49,11 +91,28 @@ struct critical_point_tracker : public virtual tracker {
 
   void update_traj_statistics();
 
-  void select_trajectories(std::function<bool(const feature_curve_t& traj)>);
+  // the index filter, if given, must accept every entry whose curve passes the 
+  // curve filter; chunks of an opened indexed file w/o accepted entries are skipped
+  void select_trajectories(std::function<bool(const feature_curve_t& traj)>, 
+      std::function<bool(const feature_curve_file_entry_t&)> index_filter = nullptr);
   void select_sliced_critical_points(std::function<bool(const feature_point_t& cp)>);
 
   void slice_traced_critical_points(); // slice traces after finalization
 
+  // time-parallel tracking: merges trajectories traced independently in time 
+  // intervals; fragments[i] covers timesteps [bounds[i], bounds[i+1]].  An 
+  // ordinal critical point on a shared timestep is detected in both adjacent 
+  // intervals with the same tag (the ID of the simplex in the spacetime mesh),
+  // so fragments are connected through the tags on each boundary timestep, 
+  // and connected fragments are reordered into a single trajectory.
+  void stitch_traced_critical_points(const std::vector<feature_curve_set_t>& fragments, 
+      const std::vector<int>& bounds);
+
+  // fixes the vector resolution, and thus the scaling factor for robust 
+  // detection, regardless of the snapshots pushed to this tracker; used by 
+  // time-parallel tracking to quantize shared timesteps identically
+  void set_fixed_vector_field_resolution(double r) {vector_field_resolution = r; fixed_vector_field_resolution = true;}
+
 public:
   // virtual void initialize() = 0;
   // virtual void finalize() = 0;
@@ -61,20 +120,62 @@ public:
   bool advance_timestep();
   // virtual void update_timestep() = 0;
 
+public: // checkpoint and restart
+  void save_checkpoint(diy::BinaryBuffer&) const;
+  void load_checkpoint(diy::BinaryBuffer&);
+
+public: // incremental output to a key-value store; keys are given by storage::feature_key
+  // - critical_points: discrete critical points detected in each timestep by each process
+  // - critical_point_segments: raw trajectories, by the timestep in which they are completed 
+  //   if streaming, otherwise by their last timestep once traced in finalize()
+  // - critical_point_trajectories: final trajectories, grouped by their first timestep
+  // - sliced_critical_points: sliced critical points of each timestep, if sliced
+  // With eviction, features are dropped from memory once written to the store: 
+  // discrete critical points w/o streaming trajectories (regular grids w/o 
+  // spilling; loaded back from the store by finalize()), and trajectories 
+  // completed while streaming, which are then only kept as segments.
+  void set_storage(std::shared_ptr<storage> s) {store = s;}
+  std::shared_ptr<storage> get_storage() const {return store;}
+  void set_enable_evicting_stored_features(bool b) {enable_evicting_stored_features = b;}
+  bool is_evicting_stored_features() const {return store && enable_evicting_stored_features;}
+  void store_traced_critical_points(); // trajectories and sliced critical points; root only
+
 public: // i/o for traced critical points (trajectories)
   const feature_curve_set_t& get_traced_critical_points() const {return traced_critical_points;}
   feature_curve_set_t& get_traced_critical_points() {return traced_critical_points;}
+  template <typename F=double> feature_point_store_t<F> get_traced_critical_points_store() const; // columnar copy with active scalars only
+  template <typename F=double> feature_point_store_t<F> release_traced_critical_points_store(); // same as above, but moves curves out one by one w/o a full copy
+  const feature_point_store_t<>& get_compact_traced_critical_points() const {return compact_trajectories;}
 
-  json get_traced_critical_points_json() const {return json(traced_critical_points);}
+  json get_traced_critical_points_json() const {return is_compact() ? json(compact_trajectories.to_curve_set()) : json(traced_critical_points);}
   void write_traced_critical_points_json(const std::string& filename, int indent=0) const;
   void read_traced_critical_points_json(const std::string& filename);
   void write_traced_critical_points_binary(const std::string& filename) const;
   void read_traced_critical_points_binary(const std::string& filename);
+  void write_traced_critical_points_indexed(const std::string& filename) const; // see feature_curve_file.hh
+  void read_traced_critical_points_indexed(const std::string& filename, // only curves that pass the index filter are read
+      std::function<bool(const feature_curve_file_entry_t&)> index_filter = nullptr);
+  // opens an indexed file w/o reading trajectories; until trajectories are read, 
+  // slicing, intercepting, and selecting trajectories query the index and only 
+  // decode the chunks they need
+  void open_traced_critical_points_indexed(const std::string& filename);
   void write_traced_critical_points_text(std::ostream& os) const;
   void write_traced_critical_points_text(const std::string& filename) const;
+
+  // With streaming trajectories, trajectories completed in a timestep are 
+  // appended to the indexed file (root proc only) and released from memory;
+  // the remaining trajectories are appended and the file is closed by 
+  // write_traced_critical_points_indexed() with the same filename.  Streamed 
+  // trajectories are not post-processed except for the statistics and the 
+  // filter, if given.
+  void stream_traced_critical_points_indexed(const std::string& filename, 
+      std::function<bool(const feature_curve_t&)> filter = nullptr);
+  bool is_streaming_indexed() const {return traced_writer != nullptr;}
   void write_traced_critical_points_vtk(const std::string& filename) const;
 #if FTK_HAVE_VTK
-  vtkSmartPointer<vtkPolyData> get_traced_critical_points_vtk() const {return traced_critical_points.to_vtp(cpdims(), scalar_components);}
+  vtkSmartPointer<vtkPolyData> get_traced_critical_points_vtk() const {
+    return is_compact() ? compact_trajectories.to_vtp(scalar_components) : traced_critical_points.to_vtp(cpdims(), scalar_components);
+  }
 #endif
 
 public: // i/o for sliced critical points
@@ -90,7 +191,11 @@ public: // i/o for sliced critical points
 #endif
 
 public: // i/o for intercepted traced
-  feature_curve_set_t get_intercepted_critical_point(int t0, int t1) const {return traced_critical_points.intercept(t0, t1);}
+  feature_curve_set_t get_intercepted_critical_point(int t0, int t1) const {
+    if (traced_archive) return traced_archive->intercept(t0, t1);
+    else if (is_compact()) return compact_trajectories.to_curve_set().intercept(t0, t1);
+    else return traced_critical_points.intercept(t0, t1);
+  }
   void write_intercepted_critical_points_vtk(int t0, int t1, const std::string& filename) const;
   void write_intercepted_critical_points_text(int t0, int t1, const std::string& filename) const;
   void write_intercepted_critical_points_json(int t0, int t1, const std::string& filename) const;
@@ -119,19 +224,32 @@ public: // post-processing and simplification
   // void foreach_trajectory(std::function<void(int, feature_curve_t&)> f) {for (int i = 0; i < traced_critical_points.size(); i ++) f(i, traced_critical_points[i]);}
   // void split_trajectories();
 
-public: // inputs
-  bool pop_field_data_snapshot();
+public: // inputs; snapshots are kept by the derived trackers in their own value types
+  virtual bool pop_field_data_snapshot() = 0;
+  virtual size_t get_number_of_field_data_snapshots() const = 0;
   virtual void push_field_data_snapshot(
       const ndarray<double> &scalar, 
       const ndarray<double> &vector,
-      const ndarray<double> &jacobian);
-  virtual void push_scalar_field_snapshot(const ndarray<double> &scalar);
-  virtual void push_vector_field_snapshot(const ndarray<double> &vector);
+      const ndarray<double> &jacobian) = 0;
+  virtual void push_scalar_field_snapshot(const ndarray<double> &scalar) = 0;
+  virtual void push_vector_field_snapshot(const ndarray<double> &vector) = 0;
+
+  // single-precision inputs are converted to double, unless the tracker keeps float data
+  virtual void push_field_data_snapshot(
+      const ndarray<float> &scalar, 
+      const ndarray<float> &vector,
+      const ndarray<float> &jacobian);
+  virtual void push_scalar_field_snapshot(const ndarray<float> &scalar);
+  virtual void push_vector_field_snapshot(const ndarray<float> &vector);
 
 protected:
   bool filter_critical_point_type(const feature_point_t& cp);
 
-  void update_vector_field_scaling_factor(int minbits=8, int maxbits=21);
+  // updates the scaling factor with the resolutions of the vector fields 
+  // and (re)quantizes the snapshots
+  template <typename S, typename F> // F gives the vector resolution of a snapshot
+  void update_vector_field_scaling_factor(std::deque<S>& snapshots, const F& resolution, 
+      int minbits=8, int maxbits=21);
 
 protected:
   template <typename I> // mesh element type
@@ -148,18 +266,53 @@ protected:
 		std::map<I, feature_point_t> &discrete_critical_points, // id of each cp will be updated
 		std::function<std::set<I>(I)> neighbors);
 
+	// same as above, for points sorted by tags (e.g. merged from spilled runs), 
+	// with neighbors given by tags
+	std::vector<feature_curve_t> trace_critical_points_offline(
+		std::vector<feature_point_t> &critical_points, // id of each cp will be updated
+		std::function<std::set<unsigned long long>(unsigned long long)> neighbors);
+
+	// same as the first, but appends the trajectories to the store w/o 
+	// building feature_curve_t's; returns the number of trajectories
+	template <typename I, typename F>
+	size_t trace_critical_points_offline(
+		std::map<I, feature_point_t> &discrete_critical_points,
+		std::function<std::set<I>(I)> neighbors,
+		feature_point_store_t<F>& store);
+
+	void compact_traced_critical_points(); // moves traced_critical_points to the compact store, if compact
+
 protected:
-  struct field_data_snapshot_t {
-    ndarray<double> scalar, vector, jacobian;
-  };
+  void stage_critical_point(const feature_point_t& cp) {if (store) staged_critical_points.push_back(cp);} // caller holds the lock
+  void store_critical_points(); // staged critical points of the current timestep
+  void store_trajectory_segments(const feature_curve_set_t& trajectories, const std::vector<int>& ids); // trajectories completed in the current timestep
+  void store_trajectory_segments(); // traced trajectories w/o streaming; root only
+  void store_trajectories(const std::string& type, bool by_last_timestep); // traced trajectories grouped by their first/last timesteps
+  void stream_trajectories(feature_curve_set_t& trajectories, const std::vector<int>& ids); // appends (if streaming indexed) and erases (also if evicting) completed trajectories
+
+  std::shared_ptr<storage> store;
+  bool enable_evicting_stored_features = false;
+  std::vector<feature_point_t> staged_critical_points;
 
-  std::deque<field_data_snapshot_t> field_data_snapshots;
+protected:
+  template <typename T>
+  static void quantize_vector_field(critical_point_field_data_snapshot<T>&, uint64_t factor);
+  static int64_t fixed_point(double x, uint64_t factor) { // non-finite values are rejected by the tests anyways
+    return std::isfinite(x) ? static_cast<int64_t>(x * factor) : 0;
+  }
   
   // for robust detection
   double vector_field_resolution = std::numeric_limits<double>::max(); // min abs nonzero value of vector field.  for robust cp detection w/o gmp
   uint64_t vector_field_scaling_factor = 1;
+  bool fixed_vector_field_resolution = false;
   
   feature_curve_set_t traced_critical_points;
+  feature_point_store_t<> compact_trajectories; // instead of traced_critical_points, if compact
+  std::shared_ptr<feature_curve_file_reader> traced_archive; // opened but not read, root proc only
+  std::shared_ptr<feature_curve_file_writer> traced_writer; // streamed indexed output, root proc only
+  std::string traced_writer_filename;
+  std::function<bool(const feature_curve_t&)> traced_writer_filter;
+  int min_trajectory_id = 0; // ids below are taken by streamed trajectories
   std::map<int/*time*/, std::vector<feature_point_t>> sliced_critical_points;
 
   // type filter
@@ -179,6 +332,7 @@ protected:
   bool enable_discarding_interval_points = false;
   bool enable_discarding_degenerate_points = false;
   bool enable_ignoring_degenerate_points = false;
+  bool enable_compact_trajectories = false;
 };
 
 ///////
@@ -196,40 +350,21 @@ inline bool critical_point_tracker::filter_critical_point_type(
 }
 
 inline void critical_point_tracker::push_field_data_snapshot(
-    const ndarray<double>& scalar,
-    const ndarray<double>& vector,
-    const ndarray<double>& jacobian)
+    const ndarray<float>& scalar,
+    const ndarray<float>& vector,
+    const ndarray<float>& jacobian)
 {
-  field_data_snapshot_t snapshot;
-  snapshot.scalar = scalar;
-  snapshot.vector = vector;
-  snapshot.jacobian = jacobian;
-
-  field_data_snapshots.emplace_back(snapshot);
+  push_field_data_snapshot(ndarray<double>(scalar), ndarray<double>(vector), ndarray<double>(jacobian));
 }
 
-inline void critical_point_tracker::push_scalar_field_snapshot(const ndarray<double>& scalar)
+inline void critical_point_tracker::push_scalar_field_snapshot(const ndarray<float>& scalar)
 {
-  field_data_snapshot_t snapshot;
-  snapshot.scalar = scalar;
-
-  field_data_snapshots.emplace_back(snapshot);
+  push_scalar_field_snapshot(ndarray<double>(scalar));
 }
 
-inline void critical_point_tracker::push_vector_field_snapshot(const ndarray<double>& vector)
+inline void critical_point_tracker::push_vector_field_snapshot(const ndarray<float>& vector)
 {
-  field_data_snapshot_t snapshot;
-  snapshot.vector = vector;
-
-  field_data_snapshots.emplace_back(snapshot);
-}
-
-inline bool critical_point_tracker::pop_field_data_snapshot()
-{
-  if (field_data_snapshots.size() > 0) {
-    field_data_snapshots.pop_front();
-    return true;
-  } else return false;
+  push_vector_field_snapshot(ndarray<double>(vector));
 }
 
 //////
@@ -245,7 +380,7 @@ inline void critical_point_tracker::write_intercepted_critical_points_vtk(int t0
 inline void critical_point_tracker::write_traced_critical_points_vtk(const std::string& filename) const
 {
   if (comm.rank() == get_root_proc()) {
-    auto poly = traced_critical_points.to_vtp(cpdims(), scalar_components); 
+    auto poly = get_traced_critical_points_vtk();
     write_polydata(filename, poly);
   }
 }
@@ -351,21 +486,103 @@ inline void critical_point_tracker::read_critical_points_binary(const std::strin
 
 inline void critical_point_tracker::write_traced_critical_points_binary(const std::string& filename) const
 {
-  if (is_root_proc()) 
-    diy::serializeToFile(traced_critical_points, filename);
+  if (is_root_proc()) {
+    if (is_compact()) compact_trajectories.write_binary(filename);
+    else diy::serializeToFile(traced_critical_points, filename);
+  }
 }
 
 inline void critical_point_tracker::read_traced_critical_points_binary(const std::string& filename)
 {
-  if (is_root_proc()) 
-    diy::unserializeFromFile(filename, traced_critical_points);
+  if (is_root_proc()) {
+    if (is_compact()) compact_trajectories.read_binary(filename);
+    else diy::unserializeFromFile(filename, traced_critical_points);
+  }
+}
+
+inline void critical_point_tracker::stream_traced_critical_points_indexed(const std::string& filename,
+    std::function<bool(const feature_curve_t&)> filter)
+{
+  if (!enable_streaming_trajectories)
+    fatal("streamed indexed outputs need streaming trajectories");
+
+  traced_writer.reset(new feature_curve_file_writer);
+  traced_writer_filename = filename;
+  traced_writer_filter = filter;
+  if (is_root_proc()) {
+#if FTK_HAVE_ZLIB
+    traced_writer->set_compression(true);
+#endif
+    traced_writer->open(filename, cpdims(), scalar_components.size());
+  }
+}
+
+inline void critical_point_tracker::stream_trajectories(feature_curve_set_t& trajectories, const std::vector<int>& ids)
+{
+  if (!traced_writer && !is_evicting_stored_features()) return;
+
+  for (const auto id : ids) {
+    auto it = trajectories.find(id);
+    if (it == trajectories.end()) continue;
+
+    if (traced_writer) {
+      it->second.update_statistics();
+      if (!traced_writer_filter || traced_writer_filter(it->second))
+        traced_writer->append(it->second, id);
+    }
+    min_trajectory_id = std::max(min_trajectory_id, id + 1);
+    trajectories.erase(it);
+  }
+}
+
+inline void critical_point_tracker::write_traced_critical_points_indexed(const std::string& filename) const
+{
+  if (traced_writer && filename == traced_writer_filename) { // the rest of the streamed file
+    if (is_root_proc()) {
+      for (const auto &kv : traced_critical_points)
+        if (!traced_writer_filter || traced_writer_filter(kv.second))
+          traced_writer->append(kv.second, kv.first);
+      traced_writer->close();
+    }
+    return;
+  }
+
+  if (is_root_proc()) {
+    feature_curve_file_writer writer;
+#if FTK_HAVE_ZLIB
+    writer.set_compression(true);
+#endif
+    writer.open(filename, cpdims(), scalar_components.size());
+    if (is_compact()) writer.append(compact_trajectories);
+    else writer.append(traced_critical_points);
+    writer.close();
+  }
+}
+
+inline void critical_point_tracker::read_traced_critical_points_indexed(const std::string& filename,
+    std::function<bool(const feature_curve_file_entry_t&)> index_filter)
+{
+  traced_archive.reset();
+  if (is_root_proc()) {
+    feature_curve_file_reader reader(filename);
+    traced_critical_points = reader.select(index_filter);
+    compact_traced_critical_points();
+  }
+}
+
+inline void critical_point_tracker::open_traced_critical_points_indexed(const std::string& filename)
+{
+  traced_critical_points.clear();
+  if (is_root_proc())
+    traced_archive.reset(new feature_curve_file_reader(filename));
 }
 
 inline void critical_point_tracker::write_traced_critical_points_text(const std::string& filename) const
 {
   if (is_root_proc()) {
     std::ofstream out(filename);
-    traced_critical_points.write_text(out, cpdims(), scalar_components);
+    if (is_compact()) compact_trajectories.write_text(out, scalar_components);
+    else traced_critical_points.write_text(out, cpdims(), scalar_components);
     out.close();
   }
 }
@@ -490,6 +707,7 @@ inline void critical_point_tracker::read_traced_critical_points_json(const std::
     f.close(); 
     // traced_critical_points = j.get<std::map<int, feature_curve_t>>();
     traced_critical_points = j.get<feature_curve_set_t>();
+    compact_traced_critical_points();
   }
 }
 
@@ -535,7 +753,8 @@ void critical_point_tracker::trace_critical_points_online(
   //   std::cerr << "----" << kv.second.tag << ", " << kv.first << ", " << tag_to_element(kv.second.tag) << std::endl;
 
   // 1. continue existing trajectories
-  trajectories.foreach([&](feature_curve_t& traj) {
+  std::vector<int> completed;
+  trajectories.foreach([&](int id, feature_curve_t& traj) {
     if (traj.complete) {
       // fprintf(stderr, "traj already complete.\n");
       return; // continue;
@@ -598,38 +817,40 @@ void critical_point_tracker::trace_critical_points_online(
         break;
     }
 
-    if (!continued) traj.complete = true;
+    if (!continued) {
+      traj.complete = true;
+      completed.push_back(id);
+    }
   });
+  store_trajectory_segments(trajectories, completed);
+  stream_trajectories(trajectories, completed);
 
   // 2. generate new trajectories for the rest of discrete critical points
-  std::set<I> elements;
-  for (const auto &kv : discrete_critical_points)
-    elements.insert(kv.first);
-  auto connected_components = extract_connected_components<I, std::set<I>>(
-      neighbors, elements);
-
-  for (const auto &component : connected_components) 
-  {
-    auto linear_graphs = ftk::connected_component_to_linear_components<I>(component, neighbors);
-    assert(linear_graphs.size() == 1);
-    // fprintf(stderr, "size_component=%zu, size_linear_graph=%zu\n", component.size(), linear_graphs.size());
-    for (int j = 0; j < linear_graphs.size(); j ++) {
-      const auto &linear_graph = linear_graphs[j];
-      feature_curve_t traj;
-      traj.loop = is_loop(linear_graph, neighbors);
-
-      // const int new_id = trajectories.size();
-      for (int k = 0; k < linear_graph.size(); k ++) {
-        const auto &cp = discrete_critical_points[linear_graph[k]];
-        traj.push_back(cp);
-        // if (cp.ordinal) // TODO FIXME
-        //   sliced_critical_points[cp.timestep].push_back(cp);
-        //   // sliced_critical_points[cp.timestep][new_id] = cp;
-      }
-      // trajectories.push_back(traj);
-      trajectories.add(traj);
-      // fprintf(stderr, "birth.\n");
+  std::vector<I> elements;
+  std::vector<unsigned long long> tags;
+  for (const auto &kv : discrete_critical_points) {
+    elements.push_back(kv.first);
+    tags.push_back(kv.second.tag);
+  }
+  std::vector<bool> loops;
+  const auto linear_graphs = nodes_to_linear_components_parallel<I>(
+      elements, neighbors, loops, thread_backend, nthreads, enable_set_affinity, 
+      [&](int i) {return tags[i];});
+
+  for (size_t j = 0; j < linear_graphs.size(); j ++) {
+    const auto &linear_graph = linear_graphs[j];
+    feature_curve_t traj;
+    traj.loop = loops[j];
+
+    for (size_t k = 0; k < linear_graph.size(); k ++) {
+      const auto &cp = discrete_critical_points[elements[linear_graph[k]]];
+      traj.push_back(cp);
+      // if (cp.ordinal) // TODO FIXME
+      //   sliced_critical_points[cp.timestep].push_back(cp);
+      //   // sliced_critical_points[cp.timestep][new_id] = cp;
     }
+    const int id = trajectories.empty() ? 0 : trajectories.rbegin()->first + 1;
+    trajectories.add(traj, std::max(id, min_trajectory_id));
   }
 
   // 3. clear discrete critical points
@@ -638,16 +859,133 @@ void critical_point_tracker::trace_critical_points_online(
   // write_sliced_critical_points_text(current_timestep, std::cerr);
 }
 
+inline void critical_point_tracker::stitch_traced_critical_points(
+    const std::vector<feature_curve_set_t>& sets, const std::vector<int>& bounds)
+{
+  std::vector<const feature_curve_t*> fragments;
+  std::vector<size_t> offsets(1, 0); // fragments of the i-th interval start at offsets[i]
+  for (const auto &s : sets) {
+    for (const auto &kv : s)
+      fragments.push_back(&kv.second);
+    offsets.push_back(fragments.size());
+  }
+
+  // fragments of adjacent intervals are connected through the ordinal points 
+  // on their shared timestep
+  simple_union_find<size_t> uf(fragments.size());
+  std::vector<bool> stitched(fragments.size(), false);
+  for (size_t i = 1; i < sets.size(); i ++) {
+    const int b = bounds[i];
+    std::map<unsigned long long, size_t> owners; // by tags on the boundary
+    for (size_t l = offsets[i-1]; l < offsets[i]; l ++)
+      for (const auto &p : *fragments[l])
+        if (p.ordinal && p.timestep == b)
+          owners[p.tag] = l;
+
+    for (size_t l = offsets[i]; l < offsets[i+1]; l ++)
+      for (const auto &p : *fragments[l]) {
+        if (!p.ordinal || p.timestep != b) continue;
+        auto it = owners.find(p.tag);
+        if (it != owners.end()) {
+          uf.unite(l, it->second);
+          stitched[l] = stitched[it->second] = true;
+        }
+      }
+  }
+
+  std::map<size_t, std::vector<size_t>> groups; // of stitched fragments
+  for (size_t i = 0; i < fragments.size(); i ++) {
+    if (stitched[i]) groups[uf.find(i)].push_back(i);
+    else traced_critical_points.add(*fragments[i]);
+  }
+
+  for (const auto &kv : groups) {
+    // points and links of the merged fragments, keyed by tags; each point
+    // has at most two links as the fragments are curves
+    std::map<unsigned long long, feature_point_t> points;
+    std::map<unsigned long long, std::set<unsigned long long>> links;
+    auto link = [&](unsigned long long i, unsigned long long j) {
+      links[i].insert(j);
+      links[j].insert(i);
+    };
+    for (const auto i : kv.second) {
+      const auto &c = *fragments[i];
+      for (size_t k = 0; k < c.size(); k ++) {
+        points[c[k].tag] = c[k];
+        links[c[k].tag];
+        if (k > 0) link(c[k-1].tag, c[k].tag);
+      }
+      if (c.loop && c.size() > 2)
+        link(c.back().tag, c.front().tag);
+    }
+
+    // walk from the ends first, then from any point of the remaining loops
+    std::set<unsigned long long> visited;
+    auto walk = [&](unsigned long long current, bool loop) {
+      feature_curve_t curve;
+      curve.loop = loop;
+      while (1) {
+        curve.push_back(points[current]);
+        visited.insert(current);
+
+        bool has_next = false;
+        for (const auto j : links[current])
+          if (visited.find(j) == visited.end()) {
+            current = j;
+            has_next = true;
+            break;
+          }
+        if (!has_next) break;
+      }
+      traced_critical_points.add(curve);
+    };
+
+    for (const auto &l : links)
+      if (l.second.size() < 2 && visited.find(l.first) == visited.end())
+        walk(l.first, false);
+    for (const auto &l : links)
+      if (visited.find(l.first) == visited.end())
+        walk(l.first, true);
+  }
+}
+
 inline void critical_point_tracker::update_traj_statistics()
 {
-  traced_critical_points.foreach([](feature_curve_t& t) {
-      t.update_statistics();
-  });
+  compact_traced_critical_points();
+  if (is_compact()) 
+    compact_trajectories.update_statistics();
+  else 
+    traced_critical_points.foreach([](feature_curve_t& t) {
+        t.update_statistics();
+    });
 }
 
-inline void critical_point_tracker::select_trajectories(std::function<bool(const feature_curve_t& traj)> f)
+inline void critical_point_tracker::compact_traced_critical_points()
 {
-  traced_critical_points.filter(f);
+  if (!is_compact()) return;
+  if (compact_trajectories.n_curves() == 0) // velocities are only derived by post-processing
+    compact_trajectories.reset(cpdims(), scalar_components.size(), false);
+
+  size_t n = 0;
+  for (const auto &kv : traced_critical_points)
+    n += kv.second.size();
+  compact_trajectories.reserve(compact_trajectories.size() + n);
+  for (auto it = traced_critical_points.begin(); it != traced_critical_points.end(); ) {
+    compact_trajectories.add(it->second, it->first);
+    it = traced_critical_points.erase(it);
+  }
+}
+
+inline void critical_point_tracker::select_trajectories(std::function<bool(const feature_curve_t& traj)> f,
+    std::function<bool(const feature_curve_file_entry_t&)> index_filter)
+{
+  if (traced_archive) { // only selected trajectories are kept in memory
+    traced_critical_points = traced_archive->select(index_filter, f);
+    traced_archive.reset();
+  } else if (is_compact())
+    compact_trajectories.filter(f);
+  else
+    traced_critical_points.filter(f);
 }
 
 inline void critical_point_tracker::select_sliced_critical_points(std::function<bool(const feature_point_t& cp)> f)
@@ -670,45 +1008,166 @@ std::vector<feature_curve_t> critical_point_tracker::trace_critical_points_offli
 {
   std::vector<feature_curve_t> traced_critical_points;
 
-  std::set<element_t> elements;
-  for (const auto &kv : discrete_critical_points)
-    elements.insert(kv.first);
-  auto connected_components = extract_connected_components<element_t, std::set<element_t>>(
-      neighbors, elements);
-
-  // fprintf(stderr, "#cc=%zu\n", connected_components.size());
-  // int sum = 0;
-  // for (auto c : connected_components)
-  //   sum += c.size();
-  // fprintf(stderr, "#sum=%d, #dcp=%zu\n", sum, discrete_critical_points.size());
-
-  // int sum1 = 0;
-  for (const auto &component : connected_components) {
-    std::vector<std::vector<double>> mycurves;
-    auto linear_graphs = ftk::connected_component_to_linear_components<element_t>(component, neighbors);
-    for (int j = 0; j < linear_graphs.size(); j ++) {
-      const unsigned int id = traced_critical_points.size(); 
-
-      feature_curve_t traj; 
-      traj.loop = is_loop(linear_graphs[j], neighbors);
-      for (int k = 0; k < linear_graphs[j].size(); k ++) {
-        auto &cp = discrete_critical_points[linear_graphs[j][k]];
-        cp.id = id;
-
-        traj.push_back(cp);
-        // sum1 ++;
-      }
-      traced_critical_points.emplace_back(traj);
+  std::vector<element_t> elements;
+  std::vector<feature_point_t*> cps;
+  for (auto &kv : discrete_critical_points) {
+    elements.push_back(kv.first);
+    cps.push_back(&kv.second);
+  }
+
+  std::vector<bool> loops;
+  const auto linear_graphs = nodes_to_linear_components_parallel<element_t>(
+      elements, neighbors, loops, thread_backend, nthreads, enable_set_affinity, 
+      [&](int i) {return cps[i]->tag;});
+
+  for (size_t j = 0; j < linear_graphs.size(); j ++) {
+    const unsigned int id = traced_critical_points.size(); 
+
+    feature_curve_t traj; 
+    traj.loop = loops[j];
+    for (size_t k = 0; k < linear_graphs[j].size(); k ++) {
+      auto &cp = *cps[linear_graphs[j][k]];
+      cp.id = id;
+      traj.push_back(cp);
     }
+    traced_critical_points.emplace_back(traj);
   }
 
-  // fprintf(stderr, "#sum1=%d\n", sum1);
+  return traced_critical_points;
+}
+
+inline std::vector<feature_curve_t> critical_point_tracker::trace_critical_points_offline(
+	std::vector<feature_point_t> &critical_points,
+	std::function<std::set<unsigned long long>(unsigned long long)> neighbors)
+{
+  std::vector<feature_curve_t> traced_critical_points;
+
+  std::vector<unsigned long long> tags;
+  tags.reserve(critical_points.size());
+  for (const auto &cp : critical_points)
+    tags.push_back(cp.tag);
+
+  std::vector<bool> loops;
+  const auto linear_graphs = nodes_to_linear_components_parallel<unsigned long long>(
+      tags, neighbors, loops, thread_backend, nthreads, enable_set_affinity, 
+      [&](int i) {return tags[i];});
+
+  for (size_t j = 0; j < linear_graphs.size(); j ++) {
+    const unsigned int id = traced_critical_points.size(); 
+
+    feature_curve_t traj; 
+    traj.loop = loops[j];
+    for (size_t k = 0; k < linear_graphs[j].size(); k ++) {
+      auto &cp = critical_points[linear_graphs[j][k]];
+      cp.id = id;
+      traj.push_back(cp);
+    }
+    traced_critical_points.emplace_back(traj);
+  }
 
   return traced_critical_points;
 }
 
+template <typename element_t, typename F>
+size_t critical_point_tracker::trace_critical_points_offline(
+	std::map<element_t, feature_point_t> &discrete_critical_points,
+	std::function<std::set<element_t>(element_t)> neighbors,
+  feature_point_store_t<F>& store)
+{
+  std::vector<element_t> elements;
+  std::vector<feature_point_t*> cps;
+  for (auto &kv : discrete_critical_points) {
+    elements.push_back(kv.first);
+    cps.push_back(&kv.second);
+  }
+
+  std::vector<bool> loops;
+  const auto linear_graphs = nodes_to_linear_components_parallel<element_t>(
+      elements, neighbors, loops, thread_backend, nthreads, enable_set_affinity, 
+      [&](int i) {return cps[i]->tag;});
+
+  const size_t n0 = store.n_curves();
+  store.reserve(store.size() + discrete_critical_points.size());
+  for (size_t j = 0; j < linear_graphs.size(); j ++) {
+    const int id = store.get_new_id();
+    for (size_t k = 0; k < linear_graphs[j].size(); k ++) {
+      auto &cp = *cps[linear_graphs[j][k]];
+      cp.id = id;
+      store.push_back(cp);
+    }
+    store.close_curve(id, loops[j]);
+  }
+
+  return store.n_curves() - n0;
+}
+
+template <typename F>
+feature_point_store_t<F> critical_point_tracker::get_traced_critical_points_store() const
+{
+  if (is_compact()) {
+    feature_point_store_t<F> store(cpdims(), scalar_components.size(), compact_trajectories.has_velocities());
+    store.reserve(compact_trajectories.size());
+    for (size_t i = 0; i < compact_trajectories.n_curves(); i ++)
+      store.add(compact_trajectories, i);
+    return store;
+  }
+
+  bool has_velocity = false; // velocities are only kept if derived
+  for (const auto &kv : traced_critical_points)
+    for (const auto &p : kv.second)
+      if (p.v[0] != 0 || p.v[1] != 0 || p.v[2] != 0) {
+        has_velocity = true;
+        break;
+      }
+
+  feature_point_store_t<F> store(cpdims(), scalar_components.size(), has_velocity);
+  store.from_curve_set(traced_critical_points);
+  return store;
+}
+
+template <typename F>
+feature_point_store_t<F> critical_point_tracker::release_traced_critical_points_store()
+{
+  if (is_compact()) {
+    auto store = get_traced_critical_points_store<F>();
+    compact_trajectories.clear();
+    return store;
+  }
+
+  bool has_velocity = false;
+  size_t n = 0;
+  for (const auto &kv : traced_critical_points) {
+    n += kv.second.size();
+    for (const auto &p : kv.second)
+      if (p.v[0] != 0 || p.v[1] != 0 || p.v[2] != 0)
+        has_velocity = true;
+  }
+
+  feature_point_store_t<F> store(cpdims(), scalar_components.size(), has_velocity);
+  store.reserve(n);
+  for (auto it = traced_critical_points.begin(); it != traced_critical_points.end(); ) {
+    store.add(it->second, it->first);
+    it = traced_critical_points.erase(it);
+  }
+  return store;
+}
+
 inline void critical_point_tracker::slice_traced_critical_points()
 {
+  if (traced_archive) {
+    for (auto &kv : traced_archive->slice_all()) {
+      auto &cps = sliced_critical_points[kv.first];
+      cps.insert(cps.end(), kv.second.begin(), kv.second.end());
+    }
+    return;
+  } else if (is_compact()) {
+    for (auto &kv : compact_trajectories.slice()) {
+      auto &cps = sliced_critical_points[kv.first];
+      cps.insert(cps.end(), kv.second.begin(), kv.second.end());
+    }
+    return;
+  }
+
   int sum0 = 0;
   for (const auto &kv : traced_critical_points) {
     const auto &traj = kv.second;
@@ -729,20 +1188,128 @@ inline void critical_point_tracker::slice_traced_critical_points()
   fprintf(stderr, "#sum_sliced=%d, %d\n", sum, sum0);
 }
 
+inline void critical_point_tracker::save_checkpoint(diy::BinaryBuffer& bb) const
+{
+  diy::save(bb, current_timestep);
+  diy::save(bb, accumulated_kernel_time);
+  diy::save(bb, vector_field_resolution);
+  diy::save(bb, vector_field_scaling_factor);
+  diy::save(bb, traced_critical_points);
+  diy::save(bb, sliced_critical_points);
+}
+
+inline void critical_point_tracker::load_checkpoint(diy::BinaryBuffer& bb)
+{
+  diy::load(bb, current_timestep);
+  diy::load(bb, accumulated_kernel_time);
+  diy::load(bb, vector_field_resolution);
+  diy::load(bb, vector_field_scaling_factor);
+  traced_critical_points.clear();
+  diy::load(bb, traced_critical_points);
+  sliced_critical_points.clear();
+  diy::load(bb, sliced_critical_points);
+}
+
+inline void critical_point_tracker::store_critical_points()
+{
+  if (!store) return;
+
+  store->put_obj(storage::feature_key("critical_points", current_timestep, comm.rank()), staged_critical_points);
+  store->flush(); // visible to readers once the timestep is done
+  staged_critical_points.clear();
+}
+
+inline void critical_point_tracker::store_trajectory_segments(const feature_curve_set_t& trajectories, const std::vector<int>& ids)
+{
+  if (!store || ids.empty()) return;
+
+  feature_point_store_t<double> segments(cpdims(), scalar_components.size());
+  for (const auto id : ids) {
+    const auto it = trajectories.find(id);
+    if (it != trajectories.end())
+      segments.add(it->second, id);
+  }
+  store->put_obj(storage::feature_key("critical_point_segments", current_timestep, comm.rank()), segments);
+}
+
+inline void critical_point_tracker::store_trajectory_segments()
+{
+  if (!store || !is_root_proc() || enable_streaming_trajectories) return; // already stored
+  store_trajectories("critical_point_segments", true);
+  store->flush();
+}
+
+inline void critical_point_tracker::store_trajectories(const std::string& type, bool by_last_timestep)
+{
+  auto key = [&](int t, int timestep) { // first or last timestep so far
+    return by_last_timestep ? std::max(t, timestep) : std::min(t, timestep);
+  };
+  const int t00 = by_last_timestep ? std::numeric_limits<int>::lowest() : std::numeric_limits<int>::max();
+
+  // compact and still-traced curves may share a key; merge them so that one put_obj covers both
+  std::map<int, feature_point_store_t<double>> groups; // by the first/last timestep
+  auto group = [&](int t) -> feature_point_store_t<double>& {
+    auto it = groups.find(t);
+    if (it == groups.end())
+      it = groups.insert(std::make_pair(t, feature_point_store_t<double>(cpdims(), scalar_components.size()))).first;
+    return it->second;
+  };
+
+  if (is_compact()) {
+    const auto &ts = compact_trajectories.timestep;
+    for (size_t i = 0; i < compact_trajectories.n_curves(); i ++) {
+      const size_t k0 = compact_trajectories.offsets[i], k1 = compact_trajectories.offsets[i+1];
+      if (k0 == k1) continue;
+      int t = t00;
+      for (size_t k = k0; k < k1; k ++)
+        t = key(t, ts[k]);
+      group(t).add(compact_trajectories, i);
+    }
+  }
+
+  traced_critical_points.foreach([&](int id, const feature_curve_t& traj) {
+    if (traj.empty()) return;
+    int t = t00;
+    for (const auto &p : traj)
+      t = key(t, p.timestep);
+    group(t).add(traj, id);
+  });
+
+  for (const auto &kv : groups)
+    store->put_obj(storage::feature_key(type, kv.first, comm.rank()), kv.second);
+}
+
+inline void critical_point_tracker::store_traced_critical_points()
+{
+  if (!store || !is_root_proc()) return;
+
+  store_trajectories("critical_point_trajectories", false);
+  for (const auto &kv : sliced_critical_points)
+    store->put_obj(storage::feature_key("sliced_critical_points", kv.first, comm.rank()), kv.second);
+
+  store->flush();
+}
+
 inline bool critical_point_tracker::advance_timestep()
 {
   update_timestep();
   pop_field_data_snapshot();
 
   current_timestep ++;
-  return field_data_snapshots.size() > 0;
+  return get_number_of_field_data_snapshots() > 0;
 }
   
-inline void critical_point_tracker::update_vector_field_scaling_factor(int minbits, int maxbits)
+template <typename S, typename F>
+inline void critical_point_tracker::update_vector_field_scaling_factor(
+    std::deque<S>& snapshots, const F& resolution, int minbits, int maxbits)
 {
   // vector_field_resolution = std::numeric_limits<double>::max();
-  for (const auto &s : field_data_snapshots)
-    vector_field_resolution = std::min(vector_field_resolution, s.vector.resolution());
+  for (auto &s : snapshots) {
+    if (s.vector_resolution < 0) 
+      s.vector_resolution = resolution(s);
+    if (!fixed_vector_field_resolution)
+      vector_field_resolution = std::min(vector_field_resolution, s.vector_resolution);
+  }
   
   int nbits = std::ceil(std::log2(1.0 / vector_field_resolution));
   nbits = std::max(minbits, std::min(nbits, maxbits));
@@ -752,6 +1319,32 @@ inline void critical_point_tracker::update_vector_field_scaling_factor(int minbi
   std::cerr << "resolution=" << vector_field_resolution 
     << ", factor=" << vector_field_scaling_factor 
     << ", nbits=" << nbits << std::endl;
+
+  // the factor only grows, so a snapshot is requantized at most once per change of the factor
+  for (auto &s : snapshots)
+    if (s.vector_fixed_factor != vector_field_scaling_factor)
+      quantize_vector_field(s, vector_field_scaling_factor);
+}
+
+template <typename T>
+inline void critical_point_tracker::quantize_vector_field(critical_point_field_data_snapshot<T>& s, uint64_t factor)
+{
+  if (s.vector.empty()) return;
+
+  const int ncomps = s.vector.dim(0);
+  const size_t n = s.vector.nelem() / ncomps;
+  const T *p = s.vector.data();
+
+  s.vector_fixed.resize(n * ncomps);
+  s.vector_fixed_n = n;
+  s.vector_fixed_factor = factor;
+  
+  for (int j = 0; j < ncomps; j ++) {
+    int64_t *q = &s.vector_fixed[j * n];
+    for (size_t k = 0; k < n; k ++) {
+      q[k] = fixed_point(p[k*ncomps + j], factor);
+    }
+  }
 }
 
 }
@@ -42,7 +42,27 @@ extract_cp2dt_cuda(
     const double *Sc, // scalar of current timestep
     const double *Sn, // scalar of next timestep
     bool use_explicit_coords,
-    const double *coords // coords of vertices
+    const double *coords, // coords of vertices
+    double fixed_factor, // vectors are quantized by fixed_factor for the robust test
+    size_t *nsimplices = NULL // incremented by the number of simplices scanned
+  ); 
+
+extern std::vector<ftk::feature_point_lite_t> // single precision
+extract_cp2dt_cuda(
+    int scope, int current_timestep, 
+    const ftk::lattice& domain, // 3D
+    const ftk::lattice& core, // 3D
+    const ftk::lattice& ext, // 2D, array dimension
+    const float *Vc, // current timestep
+    const float *Vn, // next timestep
+    const float *Jc, // jacobian of current timestep
+    const float *Jn, // jacobian of next timestep
+    const float *Sc, // scalar of current timestep
+    const float *Sn, // scalar of next timestep
+    bool use_explicit_coords,
+    const double *coords, // coords of vertices
+    double fixed_factor, // vectors are quantized by fixed_factor for the robust test
+    size_t *nsimplices = NULL // incremented by the number of simplices scanned
   ); 
 
 extern std::vector<ftk::feature_point_lite_t> // <3, double>> 
@@ -61,6 +81,35 @@ extract_cp2dt_sycl(
     const double *coords // coords of vertices
   ); 
 
+extern std::vector<ftk::feature_point_lite_t> // cpu kernels; vectors are quantized by fixed_factor for the robust test
+extract_cp2dt_cpu(
+    int scope, int current_timestep, 
+    const ftk::lattice& domain, // 3D
+    const ftk::lattice& core, // 3D
+    const ftk::lattice& ext, // 2D, array dimension
+    const double *Vc, const double *Vn, // vectors of the current and next timesteps
+    const double *Jc, const double *Jn, // jacobians
+    const double *Sc, const double *Sn, // scalars
+    bool use_explicit_coords,
+    const double *coords, // coords of vertices
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads,
+    size_t *nsimplices = NULL // incremented by the number of simplices scanned
+  ); 
+
+extern std::vector<ftk::feature_point_lite_t>
+extract_cp2dt_cpu(
+    int scope, int current_timestep, 
+    const ftk::lattice& domain, const ftk::lattice& core, const ftk::lattice& ext,
+    const float *Vc, const float *Vn,
+    const float *Jc, const float *Jn,
+    const float *Sc, const float *Sn,
+    bool use_explicit_coords, const double *coords,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads,
+    size_t *nsimplices = NULL // incremented by the number of simplices scanned
+  ); 
+
 static std::vector<ftk::feature_point_lite_t>
 extract_cp2dt_xl_wrapper(
     int xl,
@@ -75,13 +124,20 @@ extract_cp2dt_xl_wrapper(
     const double *Sc, // scalar of current timestep
     const double *Sn, // scalar of next timestep
     bool use_explicit_coords,
-    const double *coords // coords of vertices
+    const double *coords, // coords of vertices
+    double fixed_factor = FTK_FP_PRECISION, // quantization of vectors for the robust test
+    bool symmetric_jacobian = true, // cpu only
+    int thread_backend = ftk::FTK_THREAD_PTHREAD, int nthreads = 1, // cpu only
+    size_t *nsimplices = NULL // cpu and cuda only
   )
 {
   using namespace ftk;
-  if (xl == FTK_XL_CUDA) {
+  if (xl == FTK_XL_CPU) {
+    return extract_cp2dt_cpu(scope, current_timestep, domain, core, ext, Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords, 
+        fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  } else if (xl == FTK_XL_CUDA) {
 #if FTK_HAVE_CUDA
-    return extract_cp2dt_cuda(scope, current_timestep, domain, core, ext, Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords);
+    return extract_cp2dt_cuda(scope, current_timestep, domain, core, ext, Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords, fixed_factor, nsimplices);
 #else
     fatal(FTK_ERR_NOT_BUILT_WITH_CUDA);
     return std::vector<ftk::feature_point_lite_t>();
@@ -99,29 +155,93 @@ extract_cp2dt_xl_wrapper(
   }
 }
 
+static std::vector<ftk::feature_point_lite_t>
+extract_cp2dt_xl_wrapper(
+    int xl,
+    int scope, int current_timestep, 
+    const ftk::lattice& domain, // 3D
+    const ftk::lattice& core, // 3D
+    const ftk::lattice& ext, // 2D, array dimension
+    const float *Vc, // current timestep
+    const float *Vn, // next timestep
+    const float *Jc, // jacobian of current timestep
+    const float *Jn, // jacobian of next timestep
+    const float *Sc, // scalar of current timestep
+    const float *Sn, // scalar of next timestep
+    bool use_explicit_coords,
+    const double *coords, // coords of vertices
+    double fixed_factor = FTK_FP_PRECISION, // quantization of vectors for the robust test
+    bool symmetric_jacobian = true, // cpu only
+    int thread_backend = ftk::FTK_THREAD_PTHREAD, int nthreads = 1, // cpu only
+    size_t *nsimplices = NULL // cpu and cuda only
+  )
+{
+  using namespace ftk;
+  if (xl == FTK_XL_CPU) {
+    return extract_cp2dt_cpu(scope, current_timestep, domain, core, ext, Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords, 
+        fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  } else if (xl == FTK_XL_CUDA) {
+#if FTK_HAVE_CUDA
+    return extract_cp2dt_cuda(scope, current_timestep, domain, core, ext, Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords, fixed_factor, nsimplices);
+#else
+    fatal(FTK_ERR_NOT_BUILT_WITH_CUDA);
+    return std::vector<ftk::feature_point_lite_t>();
+#endif
+  } else { // the sycl extractor is double-precision only
+    fatal(FTK_ERR_ACCELERATOR_UNSUPPORTED);
+    return std::vector<ftk::feature_point_lite_t>();
+  }
+}
+
 namespace ftk {
 
 // typedef critical_point_t<3, double> critical_point_t;
 
-struct critical_point_tracker_2d_regular : public critical_point_tracker_regular {
+template <typename T=double> // value type of field data
+struct critical_point_tracker_2d_regular : public critical_point_tracker_regular<T> {
   critical_point_tracker_2d_regular(diy::mpi::communicator comm) : 
-    critical_point_tracker_regular(comm, 2),
-    tracker(comm)
+    tracker(comm),
+    critical_point_tracker_regular<T>(comm, 2)
   {}
   virtual ~critical_point_tracker_2d_regular() {}
 
   int cpdims() const { return 2; }
 
   void finalize();
-  void reset();
 
   void update_timestep();
 
-  void push_scalar_field_snapshot(const ndarray<double>&);
-  void push_vector_field_snapshot(const ndarray<double>&);
+protected:
+  void push_scalar_field(const ndarray<T>&);
+  void push_vector_field(const ndarray<T>&);
 
 protected:
   typedef simplicial_regular_mesh_element element_t;
+  typedef critical_point_tracker_regular<T> base_t;
+  typedef typename base_t::field_data_snapshot_t field_data_snapshot_t;
+
+  // members of the (dependent) base classes
+  using base_t::comm; using base_t::xl; using base_t::mutex; using base_t::instr;
+  using base_t::thread_backend; using base_t::nthreads; using base_t::enable_set_affinity; using base_t::parallel_for;
+  using base_t::current_timestep; using base_t::accumulated_kernel_time; using base_t::get_root_proc; using base_t::start_timestep;
+  using base_t::m; using base_t::domain; using base_t::local_domain; using base_t::local_array_domain;
+  using base_t::use_explicit_coords; using base_t::coords; using base_t::simplex_indices;
+  using base_t::field_data_snapshots; using base_t::discrete_critical_points; 
+  using base_t::connected_components; using base_t::traced_critical_points; 
+  using base_t::scalar_field_source; using base_t::vector_field_source; using base_t::jacobian_field_source;
+  using base_t::is_jacobian_field_symmetric; using base_t::filter_critical_point_type;
+  using base_t::stage_critical_point; using base_t::store_critical_points;
+  using base_t::is_spilling; using base_t::spill_discrete_critical_points; using base_t::trace_spilled_critical_points;
+  using base_t::evict_stored_critical_points; using base_t::load_stored_critical_points;
+  using base_t::enable_streaming_trajectories; using base_t::enable_discarding_interval_points;
+  using base_t::update_traj_statistics;
+  using base_t::update_vector_field_scaling_factor; using base_t::vector_field_scaling_factor;
+  using base_t::fixed_point; using base_t::fixed_vector;
+  using base_t::enable_cell_culling; using base_t::update_cell_sign_masks; using base_t::element_for_culled;
+  using base_t::print_cell_culling_statistics;
+  using base_t::use_lazy_derivatives; using base_t::update_lazy_cache_stamp; 
+  using base_t::is_lazy; using base_t::lazy_vector; using base_t::snapshot_dim;
+  using base_t::update_blocks; using base_t::snapshot_start;
   
 protected:
   bool check_simplex(const element_t& s, feature_point_t& cp);
@@ -129,94 +249,72 @@ protected:
   void trace_connected_components();
 
   virtual void simplex_coordinates(const std::vector<std::vector<int>>& vertices, double X[][3]) const;
-  template <typename T=double> void simplex_vectors(const std::vector<std::vector<int>>& vertices, T v[][2]) const;
+  template <typename F=double> void simplex_vectors(const std::vector<std::vector<int>>& vertices, F v[][2]) const;
+  void simplex_vectors_fixed(const std::vector<std::vector<int>>& vertices, int64_t vf[][2]) const;
   virtual void simplex_scalars(const std::vector<std::vector<int>>& vertices, double values[]) const;
   virtual void simplex_jacobians(const std::vector<std::vector<int>>& vertices, 
       double Js[][2][2]) const;
+
+  void derive_vector(const field_data_snapshot_t& s, size_t k, double v[]) const;
 };
 
 
 ////////////////////
-inline void critical_point_tracker_2d_regular::finalize()
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::finalize()
 {
   double max_accumulated_kernel_time;
   diy::mpi::reduce(comm, accumulated_kernel_time, max_accumulated_kernel_time, get_root_proc(), diy::mpi::maximum<double>());
   if (comm.rank() == get_root_proc())
-    fprintf(stderr, "max_accumulated_kernel_time=%f\n", accumulated_kernel_time);
+    fprintf(stderr, "max_accumulated_kernel_time=%f\n", max_accumulated_kernel_time);
+  print_cell_culling_statistics();
 
   if (enable_streaming_trajectories) {
     // done
+  } else if (is_spilling()) {
+    trace_spilled_critical_points();
   } else {
     // fprintf(stderr, "rank=%d, root=%d, #cp=%zu\n", comm.rank(), get_root_proc(), discrete_critical_points.size());
+    load_stored_critical_points();
     diy::mpi::gather(comm, discrete_critical_points, discrete_critical_points, get_root_proc());
 
     if (comm.rank() == get_root_proc()) {
       fprintf(stderr, "finalizing...\n");
-      traced_critical_points.add( trace_critical_points_offline<element_t>(discrete_critical_points, 
-          [&](element_t f) {
-            std::set<element_t> neighbors;
-            const auto cells = f.side_of(m);
-            for (const auto c : cells) {
-              const auto elements = c.sides(m);
-              for (const auto f1 : elements)
-                neighbors.insert(f1);
-            }
-            return neighbors;
-#if 0
-            std::set<element_t> strict_neighbors;
-            if (discrete_critical_points.find(f) != discrete_critical_points.end()) {
-              for (const auto neighbor : neighbors) {
-                if (discrete_critical_points.find(neighbor) != discrete_critical_points.end()) {
-                  if (discrete_critical_points.at(neighbor).type == discrete_critical_points.at(f).type)
-                    strict_neighbors.insert(neighbor);
-                }
-              }
-            }
-
-            fprintf(stderr, "size_strict_neighbors=%ld\n", strict_neighbors.size());
-            return strict_neighbors;
-#endif
-      }));
+      this->trace_discrete_critical_points();
 
       // trace_intersections();
       // trace_connected_components();
     }
   }
+  this->store_trajectory_segments(); // w/o streaming
   
-  if (enable_discarding_interval_points)
+  if (enable_discarding_interval_points) {
     traced_critical_points.foreach([](feature_curve_t& traj) {
       traj.discard_interval_points();
     });
+    this->compact_trajectories.discard_interval_points(); // if compact
+  }
 
   update_traj_statistics();
 }
 
-inline void critical_point_tracker_2d_regular::reset()
-{
-  current_timestep = 0;
-
-  field_data_snapshots.clear();
-  discrete_critical_points.clear();
-  traced_critical_points.clear();
-
-  critical_point_tracker::reset();
-}
-
-inline void critical_point_tracker_2d_regular::push_scalar_field_snapshot(const ndarray<double>& s)
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::push_scalar_field(const ndarray<T>& s)
 {
   field_data_snapshot_t snapshot;
   
   snapshot.scalar = s;
-  if (vector_field_source == SOURCE_DERIVED) {
+  if (vector_field_source == SOURCE_DERIVED && !use_lazy_derivatives()) {
     snapshot.vector = gradient2D(s);
     if (jacobian_field_source == SOURCE_DERIVED)
-      snapshot.jacobian = jacobian2D<double, true>(snapshot.vector);
+      snapshot.jacobian = jacobian2D<T, true>(snapshot.vector);
   }
 
   field_data_snapshots.emplace_back( snapshot );
 }
 
-inline void critical_point_tracker_2d_regular::push_vector_field_snapshot(const ndarray<double>& v)
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::push_vector_field(const ndarray<T>& v)
 {
   field_data_snapshot_t snapshot;
  
@@ -227,25 +325,36 @@ inline void critical_point_tracker_2d_regular::push_vector_field_snapshot(const
   field_data_snapshots.emplace_back( snapshot );
 }
 
-inline void critical_point_tracker_2d_regular::update_timestep()
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::update_timestep()
 {
   if (comm.rank() == 0) fprintf(stderr, "current_timestep=%d\n", current_timestep);
+  update_blocks();
+  update_lazy_cache_stamp();
 
 #ifndef FTK_HAVE_GMP
   update_vector_field_scaling_factor();
+#else
+  if (xl == FTK_XL_CUDA) // gmp is not available in the cuda kernels
+    update_vector_field_scaling_factor();
 #endif
 
   typedef std::chrono::high_resolution_clock clock_type;
   auto t0 = clock_type::now();
+  instrumentation::scoped_timer timer(instr, "update_timestep");
 
   // scan 2-simplices
   // fprintf(stderr, "tracking 2D critical points...\n");
-  auto func2 = [=](element_t e) {
+  size_t npoints = 0, ninserts = 0; // guarded by mutex
+  auto func2 = [=, &npoints, &ninserts](element_t e) {
       feature_point_t cp;
       if (check_simplex(e, cp)) {
         std::lock_guard<std::mutex> guard(mutex);
+        npoints ++;
         if (filter_critical_point_type(cp)) {
+          ninserts ++;
           discrete_critical_points[e] = cp;
+          stage_critical_point(cp);
           // std::cerr << "tag=" << cp.tag << ", " << e << "\t" << element_t(m, 2, cp.tag) << std::endl;
           // assert(element_t(m, 2, cp.tag) == e);
         }
@@ -253,7 +362,7 @@ inline void critical_point_tracker_2d_regular::update_timestep()
   };
 
   auto grow = [&]() {
-    trace_critical_points_online<element_t>(
+    this->template trace_critical_points_online<element_t>(
         traced_critical_points, 
         discrete_critical_points, 
         [&](element_t f) {
@@ -289,22 +398,43 @@ inline void critical_point_tracker_2d_regular::update_timestep()
   };
 
   if (xl == FTK_XL_NONE) {
-    element_for_ordinal(2, func2);
+    if (enable_cell_culling) {
+      instrumentation::scoped_timer timer(instr, "update_cell_sign_masks");
+#if FTK_HAVE_GMP
+      update_cell_sign_masks(0); // exact signs
+#else
+      update_cell_sign_masks(vector_field_scaling_factor); // signs after quantization
+#endif
+    }
+
+    {
+      instrumentation::scoped_timer timer(instr, "scan_ordinal");
+      element_for_culled(true, 2, func2);
+    }
     if (field_data_snapshots.size() >= 2) { // interval
-      element_for_interval(2, func2);
+      {
+        instrumentation::scoped_timer timer(instr, "scan_interval");
+        element_for_culled(false, 2, func2);
+      }
 
-      if (enable_streaming_trajectories)
+      if (enable_streaming_trajectories) {
+        instrumentation::scoped_timer timer(instr, "trace_online");
         grow();
+      }
     }
+    instr.add("points_detected", npoints);
+    instr.add("map_inserts", ninserts);
   } else { //  if (xl == FTK_XL_CUDA) {
+    // the lattices of the flat-index kernels; vertex indices of the domain 
+    // are the same as those of the spacetime mesh for the robust test
     ftk::lattice domain3({
           domain.start(0), 
           domain.start(1), 
-          0
+          static_cast<size_t>(start_timestep)
         }, {
-          domain.size(0)-1,
-          domain.size(1)-1,
-          std::numeric_limits<int>::max()
+          domain.size(0),
+          domain.size(1),
+          static_cast<size_t>(std::numeric_limits<int>::max() - start_timestep)
         });
 
     ftk::lattice ordinal_core({
@@ -328,78 +458,112 @@ inline void critical_point_tracker_2d_regular::update_timestep()
           1
         });
 
-    ftk::lattice ext({0, 0}, 
+    ftk::lattice ext({local_array_domain.start(0), local_array_domain.start(1)}, 
         {field_data_snapshots[0].vector.dim(1), 
         field_data_snapshots[0].vector.dim(2)});
+
+    auto ptr = [](const ndarray<T>& a) { return a.empty() ? NULL : a.data(); };
     
-    // ordinal
-    auto results = extract_cp2dt_xl_wrapper(
-        xl,
-        ELEMENT_SCOPE_ORDINAL, 
-        current_timestep, 
-        domain3,
-        ordinal_core,
-        ext,
-        field_data_snapshots[0].vector.data(),
-        NULL, // V[0].data(),
-        field_data_snapshots[0].jacobian.data(),
-        NULL, // gradV[0].data(),
-        field_data_snapshots[0].scalar.data(),
-        NULL, // scalar[0].data(),
-        use_explicit_coords, 
-        coords.data()
-      );
-    
-    fprintf(stderr, "ordinal_results#=%zu\n", results.size());
-    for (auto lcp : results) {
-      feature_point_t cp(lcp);
-      element_t e(3, 2);
-      e.from_work_index(m, cp.tag, ordinal_core, ELEMENT_SCOPE_ORDINAL);
-      cp.tag = e.to_integer(m);
-      cp.ordinal = true;
-      cp.timestep = current_timestep;
-      discrete_critical_points[e] = cp;
+    // the kernels take exactly two components; extra channels are dropped
+    ndarray<T> compact_vectors[2];
+    const T *V[2] = {NULL, NULL};
+    for (size_t i = 0; i < std::min(field_data_snapshots.size(), size_t(2)); i ++) {
+      const auto &v = field_data_snapshots[i].vector;
+      if (v.dim(0) == 2) V[i] = ptr(v);
+      else {
+        compact_vectors[i] = v.slice({0, 0, 0}, {2, v.dim(1), v.dim(2)});
+        V[i] = compact_vectors[i].data();
+      }
     }
 
-    if (field_data_snapshots.size() >= 2) { // interval
-      fprintf(stderr, "processing interval %d, %d\n", current_timestep, current_timestep+1);
-      auto results = extract_cp2dt_xl_wrapper(
-          xl,
-          ELEMENT_SCOPE_INTERVAL, 
-          current_timestep,
-          domain3, 
-          interval_core,
-          ext,
-          field_data_snapshots[0].vector.data(), // current
-          field_data_snapshots[1].vector.data(), // next
-          field_data_snapshots[0].jacobian.data(), 
-          field_data_snapshots[1].jacobian.data(),
-          field_data_snapshots[0].scalar.data(),
-          field_data_snapshots[1].scalar.data(),
-          use_explicit_coords, 
-          coords.data()
-        );
-      fprintf(stderr, "interal_results#=%zu\n", results.size());
+    auto insert = [&](const std::vector<feature_point_lite_t>& results, const lattice& core, int scope) {
       for (auto lcp : results) {
         feature_point_t cp(lcp);
         element_t e(3, 2);
-        e.from_work_index(m, cp.tag, interval_core, ELEMENT_SCOPE_INTERVAL);
+        e.from_work_index(m, cp.tag, core, scope);
         cp.tag = e.to_integer(m);
-        cp.ordinal = false;
+        cp.ordinal = scope == ELEMENT_SCOPE_ORDINAL;
         cp.timestep = current_timestep;
-        discrete_critical_points[e] = cp;
+        npoints ++;
+        if (filter_critical_point_type(cp)) {
+          ninserts ++;
+          discrete_critical_points[e] = cp;
+          stage_critical_point(cp);
+        }
+      }
+    };
+    
+    // ordinal
+    {
+      instrumentation::scoped_timer timer(instr, "scan_ordinal");
+      auto results = extract_cp2dt_xl_wrapper(
+          xl,
+          ELEMENT_SCOPE_ORDINAL, 
+          current_timestep, 
+          domain3,
+          ordinal_core,
+          ext,
+          V[0],
+          NULL, // V[0].data(),
+          ptr(field_data_snapshots[0].jacobian),
+          NULL, // gradV[0].data(),
+          ptr(field_data_snapshots[0].scalar),
+          NULL, // scalar[0].data(),
+          use_explicit_coords, 
+          coords.data(),
+          vector_field_scaling_factor, 
+          is_jacobian_field_symmetric,
+          thread_backend, nthreads,
+          &this->nsimplices_scanned
+        );
+      insert(results, ordinal_core, ELEMENT_SCOPE_ORDINAL);
+    }
+
+    if (field_data_snapshots.size() >= 2) { // interval
+      {
+        instrumentation::scoped_timer timer(instr, "scan_interval");
+        auto results = extract_cp2dt_xl_wrapper(
+            xl,
+            ELEMENT_SCOPE_INTERVAL, 
+            current_timestep,
+            domain3, 
+            interval_core,
+            ext,
+            V[0], // current
+            V[1], // next
+            ptr(field_data_snapshots[0].jacobian), 
+            ptr(field_data_snapshots[1].jacobian),
+            ptr(field_data_snapshots[0].scalar),
+            ptr(field_data_snapshots[1].scalar),
+            use_explicit_coords, 
+            coords.data(),
+            vector_field_scaling_factor, 
+            is_jacobian_field_symmetric,
+            thread_backend, nthreads,
+            &this->nsimplices_scanned
+          );
+        insert(results, interval_core, ELEMENT_SCOPE_INTERVAL);
       }
       
-      if (enable_streaming_trajectories)
+      if (enable_streaming_trajectories) {
+        instrumentation::scoped_timer timer(instr, "trace_online");
         grow();
+      }
     }
+    instr.add("points_detected", npoints);
+    instr.add("map_inserts", ninserts);
   }
 
   auto t1 = clock_type::now();
   accumulated_kernel_time += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+
+  store_critical_points();
+  evict_stored_critical_points();
+  spill_discrete_critical_points();
 }
 
-inline void critical_point_tracker_2d_regular::trace_intersections()
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::trace_intersections()
 {
   // scan 3-simplices to get connected components
   union_find<element_t> uf;
@@ -424,7 +588,8 @@ inline void critical_point_tracker_2d_regular::trace_intersections()
   uf.get_sets(connected_components);
 }
 
-inline void critical_point_tracker_2d_regular::trace_connected_components()
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::trace_connected_components()
 {
   // Convert connected components to geometries
   auto neighbors = [&](element_t f) {
@@ -438,27 +603,38 @@ inline void critical_point_tracker_2d_regular::trace_connected_components()
     return neighbors;
   };
 
-  std::set<element_t> elements;
+  std::vector<element_t> elements;
   for (const auto &kv : discrete_critical_points)
-    elements.insert(kv.first);
-  connected_components = extract_connected_components<element_t, std::set<element_t>>(
-      neighbors, elements);
-
-  for (const auto &component : connected_components) {
-    // std::vector<std::vector<double>> mycurves;
-    auto linear_graphs = ftk::connected_component_to_linear_components<element_t>(component, neighbors);
-    for (int j = 0; j < linear_graphs.size(); j ++) {
+    elements.push_back(kv.first);
+
+  std::vector<std::vector<int>> table;
+  const auto components = extract_connected_components_parallel<element_t>(
+      elements, neighbors, table, thread_backend, nthreads, enable_set_affinity);
+
+  std::vector<char> visited(elements.size(), 0);
+  std::vector<std::vector<std::vector<int>>> linear_graphs(components.size());
+  parallel_for(components.size(), [&](int i) {
+    linear_graphs[i] = ftk::connected_component_to_linear_components<int>(components[i], table, visited);
+  }, thread_backend, nthreads, enable_set_affinity);
+
+  connected_components.clear();
+  for (size_t i = 0; i < components.size(); i ++) {
+    std::set<element_t> component;
+    for (const auto j : components[i])
+      component.insert(elements[j]);
+    connected_components.push_back(component);
+
+    for (const auto &linear_graph : linear_graphs[i]) {
       feature_curve_t traj; 
-      for (int k = 0; k < linear_graphs[j].size(); k ++)
-        traj.push_back(discrete_critical_points[linear_graphs[j][k]]);
+      for (const auto j : linear_graph)
+        traj.push_back(discrete_critical_points[elements[j]]);
       traced_critical_points.add(traj);
-      // const auto subtrajs = traj.to_consistent_sub_traj();
-      // traced_critical_points.insert(traced_critical_points.end(), subtrajs.begin(), subtrajs.end());
     }
   }
 }
 
-inline void critical_point_tracker_2d_regular::simplex_coordinates(
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::simplex_coordinates(
     const std::vector<std::vector<int>>& vertices, double X[][3]) const
 {
   if (use_explicit_coords) {
@@ -475,46 +651,101 @@ inline void critical_point_tracker_2d_regular::simplex_coordinates(
 }
 
 template <typename T>
-inline void critical_point_tracker_2d_regular::simplex_vectors(
-    const std::vector<std::vector<int>>& vertices, T v[][2]) const
+template <typename F>
+inline void critical_point_tracker_2d_regular<T>::simplex_vectors(
+    const std::vector<std::vector<int>>& vertices, F v[][2]) const
 {
   for (int i = 0; i < vertices.size(); i ++) {
     const int iv = vertices[i][2] == current_timestep ? 0 : 1;
-    for (int j = 0; j < 2; j ++)
-      v[i][j] = field_data_snapshots[iv].vector(j, 
-          vertices[i][0] - local_array_domain.start(0), 
-          vertices[i][1] - local_array_domain.start(1));
+    const auto &s = field_data_snapshots[iv];
+    const int x = vertices[i][0] - snapshot_start(iv, 0), 
+              y = vertices[i][1] - snapshot_start(iv, 1);
+    if (is_lazy(s)) {
+      double w[2];
+      lazy_vector(iv, vertices[i][2], x + y * s.scalar.dim(0), w);
+      for (int j = 0; j < 2; j ++)
+        v[i][j] = w[j];
+    } else {
+      for (int j = 0; j < 2; j ++)
+        v[i][j] = s.vector(j, x, y);
+    }
   }
 }
 
-inline void critical_point_tracker_2d_regular::simplex_scalars(
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::simplex_vectors_fixed(
+    const std::vector<std::vector<int>>& vertices, int64_t vf[][2]) const
+{
+  for (int i = 0; i < vertices.size(); i ++) {
+    const int iv = vertices[i][2] == current_timestep ? 0 : 1;
+    const size_t k = (vertices[i][0] - snapshot_start(iv, 0)) 
+      + (vertices[i][1] - snapshot_start(iv, 1)) * snapshot_dim(iv, 0);
+    if (is_lazy(field_data_snapshots[iv])) {
+      double w[2];
+      lazy_vector(iv, vertices[i][2], k, w);
+      for (int j = 0; j < 2; j ++)
+        vf[i][j] = fixed_point(w[j], vector_field_scaling_factor);
+    } else {
+      for (int j = 0; j < 2; j ++)
+        vf[i][j] = fixed_vector(iv, j, k);
+    }
+  }
+}
+
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::simplex_scalars(
     const std::vector<std::vector<int>>& vertices, double values[]) const
 {
   for (int i = 0; i < vertices.size(); i ++) {
     const int iv = vertices[i][2] == current_timestep ? 0 : 1;
     values[i] = field_data_snapshots[iv].scalar(
-        vertices[i][0] - local_array_domain.start(0), 
-        vertices[i][1] - local_array_domain.start(1));
+        vertices[i][0] - snapshot_start(iv, 0), 
+        vertices[i][1] - snapshot_start(iv, 1));
   }
 }
 
-inline void critical_point_tracker_2d_regular::simplex_jacobians(
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::simplex_jacobians(
     const std::vector<std::vector<int>>& vertices, 
     double Js[][2][2]) const
 {
   for (int i = 0; i < vertices.size(); i ++) {
     const int iv = vertices[i][2] == current_timestep ? 0 : 1;
-    for (int j = 0; j < 2; j ++) {
-      for (int k = 0; k < 2; k ++) {
-        Js[i][j][k] = field_data_snapshots[iv].jacobian(k, j, 
-            vertices[i][0] - local_array_domain.start(0), 
-            vertices[i][1] - local_array_domain.start(1));
-      }
+    const auto &s = field_data_snapshots[iv];
+    const int x = vertices[i][0] - snapshot_start(iv, 0), 
+              y = vertices[i][1] - snapshot_start(iv, 1);
+    if (is_lazy(s)) { // same as jacobian2D<T, true>(gradient2D(scalar))
+      const auto grad = [&](int c, int x, int y) {
+        T g[2];
+        gradient2D_stencil(s.scalar, x, y, g);
+        return g[c];
+      };
+      T H[2][2];
+      jacobian2D_stencil(grad, s.scalar.dim(0), s.scalar.dim(1), x, y, H);
+      Js[i][0][0] = H[0][0];
+      Js[i][1][1] = H[1][1];
+      Js[i][0][1] = Js[i][1][0] = (H[0][1] + H[1][0]) * 0.5;
+    } else {
+      for (int j = 0; j < 2; j ++)
+        for (int k = 0; k < 2; k ++)
+          Js[i][j][k] = s.jacobian(k, j, x, y);
     }
   }
 }
 
-inline bool critical_point_tracker_2d_regular::check_simplex(
+template <typename T>
+inline void critical_point_tracker_2d_regular<T>::derive_vector(
+    const field_data_snapshot_t& s, size_t k, double v[]) const
+{
+  const size_t DW = s.scalar.dim(0);
+  T g[2];
+  gradient2D_stencil(s.scalar, k % DW, k / DW, g);
+  for (int j = 0; j < 2; j ++)
+    v[j] = g[j];
+}
+
+template <typename T>
+inline bool critical_point_tracker_2d_regular<T>::check_simplex(
     const simplicial_regular_mesh_element& e,
     feature_point_t& cp)
 {
@@ -536,16 +767,14 @@ inline bool critical_point_tracker_2d_regular::check_simplex(
       else vf[i][j] = v[i][j];
     }
 #else
-  // typedef fixed_point<> fp_t;
-  const double factor = 1.0 / vector_field_resolution;
-  // fprintf(stderr, "factor=%f\n", factor);
-  int64_t vf[3][2];
   for (int i = 0; i < 3; i ++)
     for (int j = 0; j < 2; j ++) {
       const double x = v[i][j];
       if (std::isnan(x) || std::isinf(x)) return false;
-      else vf[i][j] = v[i][j] * vector_field_scaling_factor;
     }
+  
+  int64_t vf[3][2]; // quantized in update_vector_field_scaling_factor()
+  simplex_vectors_fixed(vertices, vf);
 #endif
 
   // robust critical point test
@@ -577,6 +806,7 @@ inline bool critical_point_tracker_2d_regular::check_simplex(
     simplex_scalars(vertices, values);
     cp.scalar[0] = lerp_s2(values, mu);
   }
+  this->template lerp_attached_scalars<3>(vertices, mu, cp);
 
   double J[2][2] = {0}; // jacobian
   if (jacobian_field_source != SOURCE_NONE) { // lerp jacobian
@@ -49,7 +49,7 @@ struct critical_point_tracker_2d_unstructured : public critical_point_tracker, p
   
   int cpdims() const { return 2; }
 
-  void initialize() {}
+  void initialize() {initialize_number_of_threads();}
   void finalize();
   void reset() {}
 
@@ -57,6 +57,19 @@ struct critical_point_tracker_2d_unstructured : public critical_point_tracker, p
 
   void push_scalar_field_snapshot(const ndarray<double>&) {} // TODO
   void push_vector_field_snapshot(const ndarray<double>&) {} // TODO
+  void push_field_data_snapshot(const ndarray<double>& scalar, const ndarray<double>& vector, const ndarray<double>& jacobian) {
+    field_data_snapshot_t snapshot;
+    snapshot.scalar = scalar;
+    snapshot.vector = vector;
+    snapshot.jacobian = jacobian;
+    field_data_snapshots.emplace_back(snapshot);
+  }
+  bool pop_field_data_snapshot() {
+    if (field_data_snapshots.empty()) return false;
+    field_data_snapshots.pop_front();
+    return true;
+  }
+  size_t get_number_of_field_data_snapshots() const {return field_data_snapshots.size();}
 
 public:
   std::vector<feature_point_t> get_critical_points() const;
@@ -74,6 +87,9 @@ protected:
   ) const;
 
 protected:
+  typedef critical_point_field_data_snapshot<double> field_data_snapshot_t;
+  std::deque<field_data_snapshot_t> field_data_snapshots;
+
   std::map<int, feature_point_t> discrete_critical_points;
   // std::vector<std::vector<critical_point_t>> traced_critical_points;
 };
@@ -119,10 +135,12 @@ inline bool critical_point_tracker_2d_unstructured::check_simplex(int i, feature
     for (int j = 0; j < 2; j ++)
       Vf[k][j] = V[k][j];
 #else
-  int64_t Vf[3][2];
-  for (int k = 0; k < 3; k ++) 
+  int64_t Vf[3][2]; // quantized in update_vector_field_scaling_factor()
+  for (int k = 0; k < 3; k ++) {
+    const int iv = m.flat_vertex_time(tri[k]) == current_timestep ? 0 : 1;
     for (int j = 0; j < 2; j ++)
-      Vf[k][j] = V[k][j] * vector_field_scaling_factor;
+      Vf[k][j] = field_data_snapshots[iv].fixed_vector(j, m.flat_vertex_id(tri[k]));
+  }
 #endif
    
   bool succ = ftk::robust_critical_point_in_simplex2(Vf, tri);
@@ -169,7 +187,8 @@ inline void critical_point_tracker_2d_unstructured::update_timestep()
   if (comm.rank() == 0) fprintf(stderr, "current_timestep=%d\n", current_timestep);
 
 #ifndef FTK_HAVE_GMP
-  update_vector_field_scaling_factor();
+  update_vector_field_scaling_factor(field_data_snapshots, 
+      [](const field_data_snapshot_t& s) { return s.vector.resolution(); });
 #endif
   
   auto func = [&](int i) {
@@ -185,6 +204,7 @@ inline void critical_point_tracker_2d_unstructured::update_timestep()
         // if (discrete_critical_points.find(i) != discrete_critical_points.end())
         //   fprintf(stderr, "FATAL: overwritting cp!!\n");
         discrete_critical_points[i] = cp;
+        stage_critical_point(cp);
       }
     }
   };
@@ -212,6 +232,8 @@ inline void critical_point_tracker_2d_unstructured::update_timestep()
         [](unsigned long long i) {return  i;}
     );
   }
+
+  store_critical_points();
 }
 
 inline void critical_point_tracker_2d_unstructured::finalize()
@@ -255,6 +277,8 @@ inline void critical_point_tracker_2d_unstructured::finalize()
     fprintf(stderr, "np=%zu, nc=%zu\n", discrete_critical_points.size(), traced_critical_points.size());
   }
   
+  store_trajectory_segments(); // w/o streaming
+
   if (enable_discarding_interval_points)
     traced_critical_points.foreach([](feature_curve_t& traj) {
       traj.discard_interval_points();
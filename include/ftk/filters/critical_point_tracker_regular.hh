@@ -3,41 +3,561 @@
 
 #include <ftk/ndarray.hh>
 #include <ftk/mesh/lattice_partitioner.hh>
+#include <ftk/features/feature_point_lite.hh>
 #include <ftk/filters/critical_point_tracker.hh>
 #include <ftk/filters/regular_tracker.hh>
 #include <ftk/utils/gather.hh>
+#include <ftk/utils/external_merge.hh>
+#include <atomic>
 
 namespace ftk {
 
-// this is an abstract class, not for users
+// this is an abstract class, not for users.  Field data are kept in the 
+// value type T, e.g. float for single-precision inputs
+template <typename T=double>
 struct critical_point_tracker_regular : public critical_point_tracker, public regular_tracker {
   critical_point_tracker_regular(diy::mpi::communicator comm, int nd) : critical_point_tracker(comm), regular_tracker(comm, nd), tracker(comm) {}
   virtual ~critical_point_tracker_regular() {}
 
+  typedef T value_type;
+
+  void reset(); // also removes spilled runs
+
 protected:
   typedef simplicial_regular_mesh_element element_t;
+  typedef critical_point_field_data_snapshot<T> field_data_snapshot_t;
   
+  std::deque<field_data_snapshot_t> field_data_snapshots;
   std::map<element_t, feature_point_t> discrete_critical_points;
   std::vector<std::set<element_t>> connected_components;
 
+public: // inputs, converted to T once
+  using critical_point_tracker::push_field_data_snapshot;
+  using critical_point_tracker::push_scalar_field_snapshot;
+  using critical_point_tracker::push_vector_field_snapshot;
+
+  void push_field_data_snapshot(const ndarray<double>& s, const ndarray<double>& v, const ndarray<double>& j) { push_field_data(s, v, j); }
+  void push_field_data_snapshot(const ndarray<float>& s, const ndarray<float>& v, const ndarray<float>& j) { push_field_data(s, v, j); }
+  void push_scalar_field_snapshot(const ndarray<double>& s) { push_scalar_field(ndarray<T>(s)); }
+  void push_scalar_field_snapshot(const ndarray<float>& s) { push_scalar_field(ndarray<T>(s)); }
+  void push_vector_field_snapshot(const ndarray<double>& v) { push_vector_field(ndarray<T>(v)); }
+  void push_vector_field_snapshot(const ndarray<float>& v) { push_vector_field(ndarray<T>(v)); }
+
+  bool pop_field_data_snapshot();
+  size_t get_number_of_field_data_snapshots() const {return field_data_snapshots.size();}
+  double get_last_snapshot_vector_resolution() const {return snapshot_vector_resolution(field_data_snapshots.back());}
+
+public: // checkpoint and restart; quantized vectors and sign masks are derived again
+  void save_checkpoint(diy::BinaryBuffer&) const;
+  void load_checkpoint(diy::BinaryBuffer&);
+
+protected:
+  template <typename T1> void push_field_data(const ndarray<T1>& s, const ndarray<T1>& v, const ndarray<T1>& j);
+  virtual void push_scalar_field(const ndarray<T>&) = 0; // derives vectors/jacobians if needed
+  virtual void push_vector_field(const ndarray<T>&) = 0;
+
+  void update_vector_field_scaling_factor() { // also quantizes snapshots
+    critical_point_tracker::update_vector_field_scaling_factor(field_data_snapshots, 
+        [this](const field_data_snapshot_t& s) { return snapshot_vector_resolution(s); });
+  }
+  int64_t fixed_vector(int iv, int j, size_t k) const { return field_data_snapshots[iv].fixed_vector(j, k); }
+
 public: // cp io
   const std::map<element_t, feature_point_t>& get_discrete_critical_points() const {return discrete_critical_points;}
 
+  // traces the discrete critical points of this process into trajectories, 
+  // w/o communication; used by finalize() after gathering the points, and by 
+  // time-parallel tracking for each time interval
+  void trace_discrete_critical_points();
+
   std::vector<feature_point_t> get_critical_points() const;
   void put_critical_points(const std::vector<feature_point_t>&);
+
+public: // out-of-core discrete critical points
+  // W/o streaming trajectories, discrete critical points are kept until 
+  // finalize().  With a spill directory, the points are written as runs 
+  // sorted by tags to scratch files in the directory whenever their estimated
+  // memory footprint exceeds the budget.  Runs hold feature_point_lite_t 
+  // records; timesteps and ordinal flags are given by the tags.  finalize()
+  // gathers the names of the runs of all processes, so the directory must be
+  // shared by the processes; the root proc then merges the runs in tag order
+  // twice, first for the tags to be connected and then for the points to be
+  // placed in their trajectories, w/o holding the merged points otherwise.
+  void set_spill_directory(const std::string& path) { spill_directory = path; }
+  void set_spill_memory_budget(size_t bytes) { spill_memory_budget = bytes; }
+  bool is_spilling() const { return !spill_directory.empty() && !enable_streaming_trajectories; }
+  size_t get_number_of_spilled_runs() const { return spill_runs.size(); }
+
+protected:
+  size_t discrete_critical_points_footprint() const; // estimated bytes
+  void spill_discrete_critical_points(bool force = false); // writes a run if over the budget (or forced)
+  void trace_spilled_critical_points(); // merges and traces on the root proc; used by finalize()
+
+  std::string spill_directory;
+  size_t spill_memory_budget = size_t(1) << 30;
+  std::vector<std::string> spill_runs; // ftk-spill-<rank>-<run> in the spill directory
+
+protected: // discrete critical points evicted to the store
+  void evict_stored_critical_points(); // after store_critical_points(), if evicting w/o streaming or spilling
+  void load_stored_critical_points(); // of this process, before tracing in finalize()
+
+public: // cell culling
+  void set_enable_cell_culling(bool b) { enable_cell_culling = b; }
+
+public: // lazy derivatives
+  void set_enable_lazy_derivatives(bool b) { enable_lazy_derivatives = b; }
+
+protected: // over-decomposition
+  // With more blocks than processes, update_blocks() rebalances the blocks 
+  // for the next timestep and crops the arrays of snapshots that are not 
+  // cropped yet to the blocks of this process in the current and the next 
+  // timesteps; update_timestep() calls it before scanning.  The vector 
+  // resolution is measured before cropping, such that all processes quantize 
+  // vectors identically.
+  void update_blocks();
+  void crop_field_data_snapshot(field_data_snapshot_t& s, const lattice& box) const;
+  static ndarray<T> crop_array(const ndarray<T>& a, const lattice& ext, const lattice& box);
+
+  int snapshot_start(int iv, int d) const { // lower corner of the arrays of a snapshot in the grid
+    const auto &o = field_data_snapshots[iv].origin;
+    return o.empty() ? local_array_domain.start(d) : o[d];
+  }
+
+public: // attached variables
+  // Other variables, e.g. the untracked arrays of a group stream, are 
+  // interpolated at the critical points and attached as scalar components 
+  // after the tracked scalar.  The arrays are {ncomponents, spatial dims} and
+  // are pushed after the field data of the same timestep.  Only used w/o 
+  // accelerators, which do not report barycentric coordinates.
+  void set_attached_scalar_components(const std::vector<std::string>& names);
+  void push_attached_scalars_snapshot(const ndarray<double>& a) { push_attached_scalars(ndarray<T>(a)); }
+  void push_attached_scalars_snapshot(const ndarray<float>& a) { push_attached_scalars(ndarray<T>(a)); }
+
+protected:
+  void push_attached_scalars(const ndarray<T>&);
+  template <int N> // N = nd+1 vertices of a simplex
+  void lerp_attached_scalars(const std::vector<std::vector<int>>& vertices, const double mu[N], feature_point_t& cp) const;
+
+protected: 
+  // A cell cannot contain critical points if a vector component has the 
+  // same strict sign on all corners of the cell.  Bit 2j (or 2j+1) of the 
+  // mask is set if the j-th component is positive (or negative) on all 
+  // corners.  Signs are those of the fixed-point vectors of the robust test 
+  // (factor > 0), or of the exact values (factor = 0, w/ gmp), such that the 
+  // test agrees with the robust critical point test.
+  void update_cell_sign_masks(uint64_t factor);
+  static void reduce_cell_sign_mask(const std::vector<size_t>& dims, std::vector<uint8_t>& mask); // from vertices to cells
+  uint8_t cell_sign_mask(int iv, const std::vector<int>& corner) const;
+
+  // element_for with cells skipped based on the sign masks
+  void element_for_culled(bool ordinal, int k, std::function<void(element_t)> f);
+
+  void print_cell_culling_statistics() const;
+
+protected: 
+  // With lazy derivatives, the gradient and jacobian of scalar inputs are 
+  // not materialized; instead, they are evaluated from the stencils of the 
+  // scalar field (see ndarray/grad.hh) when a simplex is checked.  Vectors 
+  // of vertices are shared by many simplices and are thus kept in a small 
+  // direct-mapped per-thread cache.  Only used w/o accelerators.
+  bool use_lazy_derivatives() const;
+  static bool is_lazy(const field_data_snapshot_t& s) { return s.vector.empty() && !s.scalar.empty(); }
+  virtual void derive_vector(const field_data_snapshot_t& s, size_t k, double v[]) const {} // of the k-th vertex, evaluated in T
+  void lazy_vector(int iv, int t, size_t k, double v[]) const; // cached derive_vector 
+  double snapshot_vector_resolution(const field_data_snapshot_t& s) const;
+
+  size_t snapshot_dim(int iv, int i) const { // spatial extent of the arrays of a snapshot
+    const auto &s = field_data_snapshots[iv];
+    return is_lazy(s) ? s.scalar.dim(i) : s.vector.dim(i+1);
+  }
+  void update_lazy_cache_stamp();
+
+protected:
+  bool enable_cell_culling = true;
+  size_t ncells_visited = 0, ncells_culled = 0;
+
+  bool enable_lazy_derivatives = false;
+  uint64_t lazy_cache_stamp = 0;
 };
 
 /////
 ////
-inline std::vector<feature_point_t> critical_point_tracker_regular::get_critical_points() const
+template <typename T>
+template <typename T1>
+inline void critical_point_tracker_regular<T>::push_field_data(
+    const ndarray<T1>& scalar, const ndarray<T1>& vector, const ndarray<T1>& jacobian)
+{
+  field_data_snapshot_t snapshot;
+  snapshot.scalar = scalar;
+  snapshot.vector = vector;
+  snapshot.jacobian = jacobian;
+
+  field_data_snapshots.emplace_back(snapshot);
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::set_attached_scalar_components(const std::vector<std::string>& names)
+{
+  if (names.size() + 1 > FTK_CP_MAX_NUM_VARS)
+    fatal("too many attached variables; increase FTK_CP_MAX_NUM_VARS");
+  
+  std::vector<std::string> components = {scalar_components.front()};
+  components.insert(components.end(), names.begin(), names.end());
+  set_scalar_components(components);
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::push_attached_scalars(const ndarray<T>& a)
+{
+  if (field_data_snapshots.empty())
+    fatal("attached variables must be pushed after the field data");
+  if (a.dim(0) + 1 != scalar_components.size())
+    fatal("inconsistent number of attached variables");
+  field_data_snapshots.back().attached = a;
+}
+
+template <typename T>
+template <int N>
+inline void critical_point_tracker_regular<T>::lerp_attached_scalars(
+    const std::vector<std::vector<int>>& vertices, const double mu[N], feature_point_t& cp) const
+{
+  const auto &a0 = field_data_snapshots[0].attached;
+  if (a0.empty()) return;
+
+  const int nd = N - 1;
+  size_t idx[N];
+  const ndarray<T> *arrays[N];
+  for (int i = 0; i < N; i ++) {
+    const int iv = vertices[i][nd] == current_timestep ? 0 : 1;
+    const auto &s = field_data_snapshots[iv];
+    arrays[i] = &s.attached;
+
+    size_t k = 0; // spatial index in the local array
+    for (int j = nd - 1; j >= 0; j --)
+      k = k * s.attached.dim(j+1) + (vertices[i][j] - snapshot_start(iv, j));
+    idx[i] = k * s.attached.dim(0);
+  }
+
+  for (size_t c = 0; c < a0.dim(0); c ++) {
+    double value = 0;
+    for (int i = 0; i < N; i ++)
+      value += mu[i] * (*arrays[i])[idx[i] + c];
+    cp.scalar[c+1] = value;
+  }
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::update_blocks()
+{
+  if (block_cores.empty()) return;
+
+  instrumentation::scoped_timer timer(instr, "update_blocks");
+  balance_blocks(current_timestep + 1);
+  for (size_t i = 0; i < field_data_snapshots.size(); i ++)
+    if (field_data_snapshots[i].origin.empty())
+      crop_field_data_snapshot(field_data_snapshots[i], 
+          block_array_domain(current_timestep, current_timestep + i));
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::crop_field_data_snapshot(field_data_snapshot_t& s, const lattice& box) const
+{
+  if (s.vector_resolution < 0) // of the whole arrays
+    s.vector_resolution = snapshot_vector_resolution(s);
+
+  s.scalar = crop_array(s.scalar, local_array_domain, box);
+  s.vector = crop_array(s.vector, local_array_domain, box);
+  s.jacobian = crop_array(s.jacobian, local_array_domain, box);
+  s.attached = crop_array(s.attached, local_array_domain, box);
+  s.vector_fixed.clear(); s.vector_fixed_factor = 0; // derived from the whole arrays
+  s.cell_sign_mask.clear();
+  
+  s.origin.resize(box.nd());
+  for (int d = 0; d < box.nd(); d ++)
+    s.origin[d] = box.start(d);
+}
+
+template <typename T>
+inline ndarray<T> critical_point_tracker_regular<T>::crop_array(const ndarray<T>& a, const lattice& ext, const lattice& box)
+{
+  if (a.empty()) return a;
+
+  // components are the leading dimensions; rows of the first spatial 
+  // dimension are contiguous
+  const int nd = box.nd(), ncd = a.nd() - nd;
+  std::vector<size_t> shape(a.shape().begin(), a.shape().begin() + ncd);
+  size_t nc = 1;
+  for (const auto n : shape) nc *= n;
+  for (int d = 0; d < nd; d ++)
+    shape.push_back(box.size(d));
+
+  ndarray<T> b(shape);
+  b.set_multicomponents(ncd);
+  const size_t row = nc * box.size(0), nrows = box.n() / box.size(0);
+  for (size_t r = 0; r < nrows; r ++) {
+    size_t src = (box.start(0) - ext.start(0)) * nc, stride = nc * a.dim(ncd), q = r;
+    for (int d = 1; d < nd; d ++) {
+      src += (box.start(d) - ext.start(d) + q % box.size(d)) * stride;
+      q /= box.size(d);
+      stride *= a.dim(ncd + d);
+    }
+    std::copy(a.data() + src, a.data() + src + row, b.data() + r * row);
+  }
+  return b;
+}
+
+template <typename T>
+void critical_point_tracker_regular<T>::save_checkpoint(diy::BinaryBuffer& bb) const
+{
+  critical_point_tracker::save_checkpoint(bb);
+
+  diy::save(bb, sizeof(T));
+  diy::save(bb, field_data_snapshots.size());
+  for (const auto &s : field_data_snapshots) {
+    diy::save(bb, s.scalar);
+    diy::save(bb, s.vector);
+    diy::save(bb, s.jacobian);
+    diy::save(bb, s.attached);
+    diy::save(bb, s.origin);
+  }
+  diy::save(bb, discrete_critical_points);
+  diy::save(bb, spill_runs); // the runs are kept on disk until finalize()
+  diy::save(bb, ncells_visited);
+  diy::save(bb, ncells_culled);
+  diy::save(bb, block_owners); // the cropped arrays cover the blocks assigned so far
+}
+
+template <typename T>
+void critical_point_tracker_regular<T>::load_checkpoint(diy::BinaryBuffer& bb)
+{
+  critical_point_tracker::load_checkpoint(bb);
+
+  size_t sizeof_value_type, n;
+  diy::load(bb, sizeof_value_type);
+  if (sizeof_value_type != sizeof(T))
+    fatal("the checkpoint was written with a different value type");
+
+  diy::load(bb, n);
+  field_data_snapshots.clear();
+  field_data_snapshots.resize(n);
+  for (auto &s : field_data_snapshots) {
+    diy::load(bb, s.scalar);
+    diy::load(bb, s.vector);
+    diy::load(bb, s.jacobian);
+    diy::load(bb, s.attached);
+    diy::load(bb, s.origin);
+  }
+  discrete_critical_points.clear();
+  diy::load(bb, discrete_critical_points);
+  diy::load(bb, spill_runs);
+  diy::load(bb, ncells_visited);
+  diy::load(bb, ncells_culled);
+  diy::load(bb, block_owners);
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::reset()
+{
+  current_timestep = 0;
+
+  field_data_snapshots.clear();
+  discrete_critical_points.clear();
+
+  external_merge<feature_point_lite_t>::remove_runs(spill_runs);
+  spill_runs.clear();
+
+  critical_point_tracker::reset();
+}
+
+template <typename T>
+inline bool critical_point_tracker_regular<T>::pop_field_data_snapshot()
+{
+  if (field_data_snapshots.size() > 0) {
+    field_data_snapshots.pop_front();
+    return true;
+  } else return false;
+}
+
+template <typename T>
+inline std::vector<feature_point_t> critical_point_tracker_regular<T>::get_critical_points() const
 {
   std::vector<feature_point_t> results;
+  if (is_spilling()) { // the spilled points are only kept in their trajectories
+    for (const auto &kv : traced_critical_points)
+      results.insert(results.end(), kv.second.begin(), kv.second.end());
+    for (size_t k = 0; k < this->compact_trajectories.size(); k ++)
+      results.push_back(this->compact_trajectories.point(k));
+  }
   for (const auto &kv : discrete_critical_points) 
     results.push_back(kv.second);
   return results;
 }
 
-inline void critical_point_tracker_regular::put_critical_points(const std::vector<feature_point_t>& data) 
+template <typename T>
+inline size_t critical_point_tracker_regular<T>::discrete_critical_points_footprint() const
+{
+  // map node (incl. tree pointers and allocator overhead) and the corner of each element
+  const size_t bytes_per_point = sizeof(typename std::map<element_t, feature_point_t>::value_type) 
+    + 4 * sizeof(void*) + m.nd() * sizeof(int) + 2 * sizeof(void*);
+  return discrete_critical_points.size() * bytes_per_point;
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::evict_stored_critical_points()
+{
+  if (is_evicting_stored_features() && !enable_streaming_trajectories && !is_spilling())
+    discrete_critical_points.clear();
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::load_stored_critical_points()
+{
+  if (!is_evicting_stored_features() || enable_streaming_trajectories || is_spilling()) return;
+
+  instrumentation::scoped_timer timer(instr, "load_stored");
+  for (const auto &k : store->feature_keys("critical_points", start_timestep, current_timestep)) {
+    std::string type;
+    int t, b;
+    std::vector<feature_point_t> points;
+    if (storage::parse_feature_key(k, type, t, b) && b == comm.rank() && store->get_obj(k, points))
+      put_critical_points(points);
+  }
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::spill_discrete_critical_points(bool force)
+{
+  if (!is_spilling() || discrete_critical_points.empty()) return;
+  if (!force && discrete_critical_points_footprint() < spill_memory_budget) return;
+
+  instrumentation::scoped_timer timer(instr, "spill");
+
+  std::vector<feature_point_lite_t> run;
+  run.reserve(discrete_critical_points.size());
+  for (const auto &kv : discrete_critical_points) { // already sorted by elements, not by tags
+    const auto &cp = kv.second;
+    feature_point_lite_t r;
+    for (int k = 0; k < 3; k ++)
+      r.x[k] = cp.x[k];
+    r.t = cp.t;
+    r.cond = cp.cond;
+    for (int k = 0; k < FTK_CP_MAX_NUM_VARS; k ++)
+      r.scalar[k] = cp.scalar[k];
+    r.type = cp.type;
+    r.tag = cp.tag;
+    run.push_back(r);
+  }
+  std::sort(run.begin(), run.end(), [](const feature_point_lite_t& a, const feature_point_lite_t& b) {
+    return a.tag < b.tag;
+  });
+
+  char filename[64];
+  snprintf(filename, sizeof(filename), "/ftk-spill-%d-%zu", comm.rank(), spill_runs.size());
+  const std::string path = spill_directory + filename;
+  if (!external_merge<feature_point_lite_t>::write_run(path, run))
+    fatal("unable to write " + path);
+
+  spill_runs.push_back(path);
+  discrete_critical_points.clear();
+  instr.add("points_spilled", run.size());
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::trace_spilled_critical_points()
+{
+  spill_discrete_critical_points(true);
+
+  // runs of all processes, in the order of ranks
+  std::map<int, std::vector<std::string>> runs;
+  runs[comm.rank()].swap(spill_runs);
+  diy::mpi::gather(comm, runs, runs, get_root_proc());
+  if (comm.rank() != get_root_proc()) return;
+
+  std::vector<std::string> filenames;
+  for (const auto &kv : runs)
+    filenames.insert(filenames.end(), kv.second.begin(), kv.second.end());
+  auto less = [](const feature_point_lite_t& a, const feature_point_lite_t& b) { return a.tag < b.tag; };
+
+  // pass 1: distinct tags in order.  A tag appears in multiple runs only if 
+  // its timestep was recomputed after a restart (or it is in the ghost layers 
+  // of multiple processes); the last record is kept in pass 2.
+  std::vector<unsigned long long> tags;
+  external_merge<feature_point_lite_t>::merge(filenames, less, [&](const feature_point_lite_t& r) {
+    if (tags.empty() || tags.back() != r.tag) tags.push_back(r.tag);
+  });
+  fprintf(stderr, "finalizing %zu spilled critical points...\n", tags.size());
+
+  std::vector<bool> loops;
+  const auto linear_graphs = nodes_to_linear_components_parallel<unsigned long long>(
+      tags, [&](unsigned long long tag) {
+        std::set<unsigned long long> neighbors;
+        const element_t f(m, this->cpdims(), tag);
+        const auto cells = f.side_of(m);
+        for (const auto c : cells) {
+          const auto elements = c.sides(m);
+          for (const auto f1 : elements)
+            neighbors.insert(f1.to_integer(m));
+        }
+        return neighbors;
+      }, loops, thread_backend, nthreads, enable_set_affinity, 
+      [&](int i) {return tags[i];});
+
+  // slot of each point (by the order of tags) in the trajectories
+  std::vector<feature_curve_t> trajs(linear_graphs.size());
+  std::vector<std::pair<uint32_t, uint32_t>> slots(tags.size());
+  for (size_t j = 0; j < linear_graphs.size(); j ++) {
+    trajs[j].loop = loops[j];
+    trajs[j].resize(linear_graphs[j].size());
+    for (size_t k = 0; k < linear_graphs[j].size(); k ++)
+      slots[linear_graphs[j][k]] = std::make_pair(j, k);
+  }
+  std::vector<unsigned long long>().swap(tags);
+
+  // pass 2: points to their slots
+  size_t i = 0;
+  unsigned long long last_tag = 0;
+  external_merge<feature_point_lite_t>::merge(filenames, less, [&](const feature_point_lite_t& r) {
+    if (i > 0 && r.tag == last_tag) i --; // overwrites the previous record of the tag
+    last_tag = r.tag;
+
+    feature_point_t cp(r);
+    const element_t e(m, this->cpdims(), r.tag);
+    cp.timestep = e.corner.back();
+    cp.ordinal = e.is_ordinal(m);
+    trajs[slots[i].first][slots[i].second] = cp;
+    i ++;
+  });
+  external_merge<feature_point_lite_t>::remove_runs(filenames);
+
+  for (auto &traj : trajs) { // curve by curve w/o a full copy
+    traced_critical_points.add(traj);
+    feature_curve_t().swap(traj);
+  }
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::trace_discrete_critical_points()
+{
+  auto neighbors = [&](element_t f) {
+    std::set<element_t> neighbors;
+    const auto cells = f.side_of(m);
+    for (const auto c : cells) {
+      const auto elements = c.sides(m);
+      for (const auto f1 : elements)
+        neighbors.insert(f1);
+    }
+    return neighbors;
+  };
+
+  if (this->is_compact()) {
+    this->compact_traced_critical_points();
+    this->template trace_critical_points_offline<element_t, double>(discrete_critical_points, neighbors, this->compact_trajectories);
+  } else
+    traced_critical_points.add( this->template trace_critical_points_offline<element_t>(discrete_critical_points, neighbors) );
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::put_critical_points(const std::vector<feature_point_t>& data) 
 {
   for (const auto& cp : data) {
     element_t e(m, cpdims(), cp.tag);
@@ -45,6 +565,205 @@ inline void critical_point_tracker_regular::put_critical_points(const std::vecto
   }
 }
 
+template <typename T>
+inline void critical_point_tracker_regular<T>::reduce_cell_sign_mask(
+    const std::vector<size_t>& dims, std::vector<uint8_t>& mask)
+{
+  // cell-wise signs, by and-ing along each axis separately.  The mask of 
+  // the cell is stored at its lower corner; cells on the upper boundaries 
+  // do not exist and are never culled
+  const int nd = dims.size();
+  const size_t n = mask.size();
+  size_t stride = 1;
+  for (int a = 0; a < nd; a ++) {
+    const size_t na = dims[a], nouter = n / (stride * na);
+    for (size_t o = 0; o < nouter; o ++) {
+      for (size_t k = 0; k < na; k ++) {
+        uint8_t *q = &mask[(o * na + k) * stride];
+        if (k + 1 < na) 
+          for (size_t i = 0; i < stride; i ++) 
+            q[i] &= q[i + stride];
+        else 
+          for (size_t i = 0; i < stride; i ++)
+            q[i] = 0;
+      }
+    }
+    stride *= na;
+  }
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::update_cell_sign_masks(uint64_t factor)
+{
+  for (auto &s : field_data_snapshots) {
+    if (!s.cell_sign_mask.empty() && s.cell_sign_mask_factor == factor) continue;
+
+    const int ncomps = cpdims();
+    std::vector<size_t> dims(ncomps);
+    size_t n = 1;
+    for (int i = 0; i < ncomps; i ++) {
+      dims[i] = is_lazy(s) ? s.scalar.dim(i) : s.vector.dim(i+1);
+      n *= dims[i];
+    }
+    
+    // vertex-wise signs; non-finite values have no bits set
+    auto &mask = s.cell_sign_mask;
+    mask.assign(n, 0);
+    if (factor > 0 && s.vector_fixed_factor == factor && s.vector_fixed_n == n) {
+      // scan over the components of the fixed-point vectors (SoA)
+      for (int j = 0; j < ncomps; j ++) {
+        const int64_t *q = &s.vector_fixed[j * n];
+        const int bp = 2*j, bn = 2*j + 1;
+        for (size_t k = 0; k < n; k ++)
+          mask[k] |= ((q[k] > 0) << bp) | ((q[k] < 0) << bn);
+      }
+    } else { // lazy derivatives or exact signs
+      const T *p = s.vector.data();
+      for (size_t k = 0; k < n; k ++) {
+        double v[4];
+        if (is_lazy(s)) derive_vector(s, k, v);
+        else 
+          for (int j = 0; j < ncomps; j ++)
+            v[j] = p[k*ncomps + j];
+
+        uint8_t b = 0;
+        for (int j = 0; j < ncomps; j ++) {
+          const double x = factor > 0 ? fixed_point(v[j], factor) : v[j];
+          b |= ((x > 0) << (2*j)) | ((x < 0) << (2*j+1));
+        }
+        mask[k] = b;
+      }
+    }
+
+    reduce_cell_sign_mask(dims, mask);
+    s.cell_sign_mask_factor = factor;
+  }
+}
+
+template <typename T>
+inline uint8_t critical_point_tracker_regular<T>::cell_sign_mask(int iv, const std::vector<int>& corner) const
+{
+  size_t idx = 0, stride = 1;
+  for (int i = 0; i < cpdims(); i ++) {
+    const int x = corner[i] - snapshot_start(iv, i);
+    const size_t n = snapshot_dim(iv, i);
+    if (x < 0 || x >= n) return 0;
+    idx += x * stride;
+    stride *= n;
+  }
+  return field_data_snapshots[iv].cell_sign_mask[idx];
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::element_for_culled(
+    bool ordinal, int k, std::function<void(element_t)> f)
+{
+  if (!enable_cell_culling) {
+    element_for(ordinal, k, f);
+    return;
+  }
+
+  std::atomic<size_t> nvisited(0), nculled(0); // of this call; added to the totals once
+  element_for(ordinal, k, 
+      [&](const std::vector<int>& corner) {
+        nvisited.fetch_add(1, std::memory_order_relaxed);
+        uint8_t mask = cell_sign_mask(0, corner);
+        if (!ordinal) mask &= cell_sign_mask(1, corner);
+        if (mask) nculled.fetch_add(1, std::memory_order_relaxed);
+        return mask == 0;
+      }, f);
+
+  ncells_visited += nvisited;
+  ncells_culled += nculled;
+
+  const int scope = ordinal ? ELEMENT_SCOPE_ORDINAL : ELEMENT_SCOPE_INTERVAL;
+  instr.add("cells_visited", nvisited);
+  instr.add("cells_culled", nculled);
+  instr.add("simplices_culled", nculled * m.ntypes(k, scope));
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::print_cell_culling_statistics() const
+{
+  if (!enable_cell_culling) return;
+
+  size_t nvisited = 0, nculled = 0;
+  diy::mpi::reduce(comm, ncells_visited, nvisited, get_root_proc(), std::plus<size_t>());
+  diy::mpi::reduce(comm, ncells_culled, nculled, get_root_proc(), std::plus<size_t>());
+  if (comm.rank() == get_root_proc())
+    fprintf(stderr, "cells_visited=%zu, cells_culled=%zu, cell_skip_ratio=%f\n", 
+        nvisited, nculled, nvisited ? (double)nculled / nvisited : 0.0);
+}
+
+template <typename T>
+inline bool critical_point_tracker_regular<T>::use_lazy_derivatives() const
+{
+  if (!enable_lazy_derivatives || vector_field_source != SOURCE_DERIVED) return false;
+  if (xl != FTK_XL_NONE) {
+    static bool warned = false;
+    if (!warned) {
+      warn("lazy derivatives are not supported with accelerators, ignoring");
+      warned = true;
+    }
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::update_lazy_cache_stamp()
+{
+  // unique across trackers, so that stale entries of per-thread caches never match
+  static std::atomic<uint64_t> stamp(0);
+  lazy_cache_stamp = ++ stamp;
+}
+
+template <typename T>
+inline void critical_point_tracker_regular<T>::lazy_vector(int iv, int t, size_t k, double v[]) const
+{
+  // vertices of a cell are mostly adjacent in k; both timesteps of 
+  // interval cells map to different slots
+  struct cache_t {
+    enum { size = 512 };
+    uint64_t stamp[size] = {0};
+    size_t key[size];
+    double v[size][3];
+  };
+  static thread_local cache_t cache;
+
+  const size_t key = (k << 1) | (t & 1), h = key & (cache_t::size - 1);
+  const int nc = cpdims();
+  if (cache.stamp[h] == lazy_cache_stamp && cache.key[h] == key) {
+    for (int j = 0; j < nc; j ++) 
+      v[j] = cache.v[h][j];
+    return;
+  }
+
+  derive_vector(field_data_snapshots[iv], k, v);
+  cache.stamp[h] = lazy_cache_stamp;
+  cache.key[h] = key;
+  for (int j = 0; j < nc; j ++) 
+    cache.v[h][j] = v[j];
+}
+
+template <typename T>
+inline double critical_point_tracker_regular<T>::snapshot_vector_resolution(const field_data_snapshot_t& s) const
+{
+  if (!is_lazy(s)) return s.vector.resolution();
+
+  // same as the resolution of the materialized gradient
+  double r = std::numeric_limits<double>::max();
+  const int nc = cpdims();
+  for (size_t k = 0; k < s.scalar.nelem(); k ++) {
+    double v[3];
+    derive_vector(s, k, v);
+    for (int j = 0; j < nc; j ++)
+      if (v[j] != 0.0)
+        r = std::min(r, std::abs(v[j]));
+  }
+  return r;
+}
+
 }
 
 #endif
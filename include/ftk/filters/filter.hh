@@ -3,6 +3,7 @@
 
 #include <ftk/config.hh>
 #include <ftk/object.hh>
+#include <ftk/utils/instrumentation.hh>
 #include <ftk/external/cxxopts.hpp>
 #include <thread>
 #include <mutex>
@@ -12,15 +13,14 @@
 namespace ftk {
 
 struct filter : public object {
-  filter(diy::mpi::communicator comm) : object(comm) {
-    nthreads = default_nthreads();
-  }
+  filter(diy::mpi::communicator comm) : object(comm) {}
 
   virtual void update() = 0;
   virtual void reset() {};
 
   void use_thread_backend(const std::string& backend);
   void use_thread_backend(int i) { thread_backend = i; }
+  int get_thread_backend() const { return thread_backend; }
 
   void use_accelerator(const std::string& acc);
   void use_accelerator(int i) {
@@ -33,12 +33,9 @@ struct filter : public object {
 #endif
   }
 
-  int default_nthreads() const {
-    if (comm.size() > 1) return 1; // use 1 thread per proc for mpi runs
-    else return std::thread::hardware_concurrency(); 
-  }
+  int default_nthreads() const;
   
-  void set_number_of_threads(int n) {nthreads = n;}
+  void set_number_of_threads(int n) {nthreads = std::max(0, n);} // 0 for the default, resolved by initialize()
   int get_number_of_threads() const {return nthreads;}
 
   void set_number_of_blocks(int n) {nblocks = n; fprintf(stderr, "setting nb=%d\n", n);}
@@ -52,18 +49,65 @@ struct filter : public object {
 
   void set_device_buffer_size(int mb) { device_buffer_size_in_mb = mb; }
 
+  instrumentation& get_instrumentation() {return instr;} // timers and counters
+  const instrumentation& get_instrumentation() const {return instr;}
+
+protected:
+  void initialize_number_of_threads() {if (nthreads == 0) nthreads = default_nthreads();} // called by initialize()
+
 protected:
   int xl = FTK_XL_NONE, thread_backend = FTK_THREAD_PTHREAD;
-  int nthreads = 1, nblocks = 0;
+  int nthreads = 0, nblocks = 0;
   bool enable_set_affinity = false; // true;
 
   std::vector<int> device_ids;
   int device_buffer_size_in_mb = 512;
 
+  instrumentation instr;
+
   std::mutex mutex;
 };
 
 ////
+inline int filter::default_nthreads() const
+{
+  // cpus available to the process; processes on the same node may be bound
+  // to disjoint cpus (e.g. one per numa domain) by the launcher, or share the
+  // cpus of the node or of a cpuset (e.g. a container)
+  const int ncpus = available_cpus();
+  if (comm.size() == 1) return ncpus;
+
+#if FTK_HAVE_MPI
+  // The union of the affinity masks of the processes on this node.  The 
+  // split is computed once per process, by the first filter that is 
+  // initialized w/ the default number of threads on multiple processes, and 
+  // is collective over the communicator of that filter.
+  static const int n = [&]() {
+    MPI_Comm local_comm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, comm.rank(), MPI_INFO_NULL, &local_comm);
+    diy::mpi::communicator local(local_comm, true);
+
+    std::vector<std::vector<int>> masks;
+    diy::mpi::all_gather(local, affinity_cpus(), masks);
+
+    std::set<int> cpus;
+    size_t nmasked = 0;
+    for (const auto &mask : masks) {
+      cpus.insert(mask.begin(), mask.end());
+      nmasked += mask.size();
+    }
+
+    if (nmasked == cpus.size()) // disjoint masks
+      return ncpus;
+    else // the cpus are shared by the processes on this node
+      return std::max(1, std::min(ncpus, static_cast<int>(cpus.size()) / local.size()));
+  }();
+  return n;
+#else
+  return 1;
+#endif
+}
+
 inline void filter::use_thread_backend(const std::string& str)
 {
   if (str == "openmp") use_thread_backend( FTK_THREAD_OPENMP );
@@ -75,6 +119,7 @@ inline void filter::use_accelerator(const std::string& acc)
 {
   if (acc == "cuda") use_accelerator(FTK_XL_CUDA);
   else if (acc == "sycl") use_accelerator(FTK_XL_SYCL);
+  else if (acc == "cpu") use_accelerator(FTK_XL_CPU);
   else use_accelerator(FTK_XL_NONE);
 }
 
@@ -8,8 +8,12 @@
 #include <ftk/mesh/simplicial_unstructured_2d_mesh.hh>
 #include <ftk/mesh/simplicial_unstructured_extruded_2d_mesh.hh>
 #include <ftk/ndarray/stream.hh>
+#include <ftk/ndarray/ndarray_group_stream.hh>
 #include <ftk/ndarray/writer.hh>
 #include <ftk/io/util.hh>
+#include <ftk/storage/storage.h>
+#include <atomic>
+#include <thread>
 
 namespace ftk {
 
@@ -29,24 +33,70 @@ struct json_interface : public object {
   //      xgc_blob_filament: 3D XGX blob filaments defined by local extrema
   //      xgc_blob_threshold: 3D XGC blob filaments defined by levelsets
   // - input, json, see ndarray/stream.hh for details
+  // - variable, string, optional: key of the tracked array if consuming a group stream; 
+  //   required unless the group has only one array
+  // - attached_variables, array of strings, optional: keys of the arrays of a group stream that 
+  //   are interpolated at the critical points and attached as scalar components after the 
+  //   tracked scalar; by default all other arrays of the group.  Attached arrays must have the 
+  //   same dimensions as the tracked array (regular grids, w/o accelerators and time parallelism)
   // // - writeback, json, optional: write input data back to files; see ndarray/writer.hh for details
   // - archive, json, optional:
   //    - discrete, string, optional: file name to load/store discrete feature points w/o tracking
-  //    - traced, string, optional: file name to load/store traced features
+  //    - traced, string, optional: file name to load/store traced features; indexed files (*.ftkc) 
+  //      are only partially read for sliced and intercepted outputs
   // - output, json, required:
   //    - type, string, by default "traced": intersections, traced, sliced, or intercepted
-  //    - format, string, by default "auto": auto, text, json, vtp, vtu, ply
+  //    - format, string, by default "auto": auto, text, json, vtp, vtu, ply, indexed (*.ftkc, traced only;
+  //      with streaming trajectories, completed trajectories are appended during the run w/o 
+  //      post-processing other than duration pruning)
   //    - pattern, string, required: e.g. "surface.vtp", "sliced-%04d.vtp"
   // - threshold, number, by default 0: threshold for some trackers, e.g. contour trackers
-  // - accelerator, string, by default "none": none, cuda, or hipsycl
+  // - accelerator, string, by default "none": none, cuda, hipsycl, or cpu (the flat-index 
+  //   kernels of the gpu extractors, vectorized and threaded on cpus; regular grids only)
   // - thread_model, string by default "pthread": pthread, openmp, or tbb
+  // - traversal, string, by default "row_major": row_major or morton (tiles of cells in z-order, 
+  //   all simplices of a cell together); order of simplex sweeps on regular grids
   // - nblocks, int, by default 0: number of blocks; 0 will be replaced by the number of processes
-  // - nthreads, int, by default 0: number of threads; 0 will replaced by the max available number of CPUs
+  //   more blocks than processes are balanced across processes by the costs measured so far, 
+  //   one timestep ahead; each process keeps only the arrays of its blocks (w/ ghost layers)
+  // - nthreads, int, by default 0: number of threads per process; 0 will be replaced by the number of 
+  //   CPUs available to the process (affinity mask and cgroup quota); if the affinity masks of the 
+  //   processes on a node overlap, their union is divided by the number of processes on the node
   // - enable_streaming, bool, by default false
+  // - ntime_intervals, int, by default 1: time-parallel tracking (regular grids only) if greater 
+  //   than 1; timesteps are split into intervals that share their boundary timesteps, and the 
+  //   intervals are tracked concurrently by processes and thread groups before being stitched; 
+  //   the quantization for robust detection is fixed by the vector resolution of the first timestep
+  //   unless vector_field_resolution is given
+  // - vector_field_resolution, number, optional: fixes the vector resolution, and thus the 
+  //   quantization, for robust detection of critical points; by default derived from the 
+  //   snapshots seen so far
   // - enable_discarding_interval_points, bool, by default false
   // - enable_fast_detection, bool, by default true
   // - enable_deriving_velocities, bool, by default false
   // - enable_post_processing, bool, by default true
+  // - enable_compact_trajectories, bool, by default false: keeps trajectories in a columnar store 
+  //   (see feature_point_store.hh) instead of feature curves; post-processing is then limited to 
+  //   duration pruning and statistics
+  // - instrumentation_output, string, optional: JSON file of the timers and counters of the 
+  //   tracker, aggregated over threads and processes
+  // - trace_output, string, optional: Chrome trace-event file of the timed phases of the tracker
+  // - checkpoint, string, optional: prefix of the checkpoint files of the tracker state (two 
+  //   alternating files per process, suffixed by the rank if there are multiple processes and 
+  //   by .0/.1); critical points on regular grids only
+  // - checkpoint_interval, int, by default 0: checkpoint every n timesteps in the background; 0 disables
+  // - resume, bool, by default false: resume from the latest checkpoint written by all processes, 
+  //   if exists
+  // - storage, string, optional: key-value store to which results are written incrementally 
+  //   (one store per process, suffixed by the rank if there are multiple processes); see the 
+  //   keys in critical_point_tracker.hh.  Stored features are evicted from memory, except for
+  //   trajectories completed while streaming if they are also written to the output
+  // - storage_backend, string, by default "native": native, leveldb, or rocksdb
+  // - spill_directory, string, optional: scratch directory to which discrete critical points are 
+  //   written in sorted runs if exceeding the memory budget, and merged in the end (regular grids 
+  //   w/o streaming trajectories only); the directory must be shared by all processes, as the 
+  //   root proc merges the runs of all processes into the trajectories
+  // - spill_memory_budget, number, by default 1024: memory budget (in MB) of discrete critical points
   // - xgc, json, optional: XGC-specific options
   //    - format, string, by default auto: auto, h5, or bp
   //    - path, string, optional: XGC data path, which contains xgc.mesh, xgc.bfield, units.m, 
@@ -65,6 +115,16 @@ struct json_interface : public object {
   void consume(ndarray_stream<> &stream, 
       diy::mpi::communicator comm = diy::mpi::communicator()/*MPI_COMM_WORLD*/);
 
+  // single-precision inputs are tracked in float32 end to end (regular grids only)
+  void consume(ndarray_stream<float> &stream, 
+      diy::mpi::communicator comm = diy::mpi::communicator()/*MPI_COMM_WORLD*/);
+
+  // the tracker is driven by the timestep callback of the group; the tracked 
+  // variable and the attached variables are read, each in its own layout
+  template <typename T>
+  void consume(ndarray_group_stream<T> &stream, 
+      diy::mpi::communicator comm = diy::mpi::communicator()/*MPI_COMM_WORLD*/);
+
   void post_process();
   void xgc_post_process();
 
@@ -74,10 +134,23 @@ struct json_interface : public object {
 
   json get_json() const {return j;}
 
+  // wall time (in seconds) of the phases of the last consume()
+  json get_timings() const {return {{"t_init", t_init}, {"t_compute", t_compute}, {"t_finalize", t_finalize}};}
+
 private:
   void configure_tracker_general(diy::mpi::communicator comm);
-  void consume_regular(ndarray_stream<> &stream, diy::mpi::communicator comm);
+  void configure_critical_point_tracker(std::shared_ptr<critical_point_tracker> t, diy::mpi::communicator comm);
+  template <typename T> std::shared_ptr<critical_point_tracker_regular<T>> make_regular_tracker(
+      const ndarray_stream<T> &stream, diy::mpi::communicator comm);
+  template <typename T> void consume_regular(ndarray_stream<T> &stream, diy::mpi::communicator comm, 
+      ndarray_group_stream<T> *group = NULL); // if given, the group drives the tracker
+  template <typename T> static ndarray<T> gather_attached_variables(const ndarray_group& g,
+      const std::vector<std::string>& keys, const std::vector<size_t>& ncomponents, 
+      const std::vector<size_t>& dims);
+  template <typename T> void consume_regular_time_parallel(ndarray_stream<T> &stream, diy::mpi::communicator comm);
   void consume_xgc(ndarray_stream<> &stream, diy::mpi::communicator comm);
+  void write_instrumentation(diy::mpi::communicator comm) const;
+  void read_archived_traced_critical_points(const std::string& filename);
 
   void write_sliced_results(int k);
   void write_intercepted_results(int k, int nt);
@@ -86,6 +159,8 @@ private:
   std::shared_ptr<critical_point_tracker> tracker;
   json j, js; // config
 
+  double t_init = 0, t_compute = 0, t_finalize = 0;
+
   static bool ends_with(std::string const & value, std::string const & ending) {
     if (ending.size() > value.size()) return false;
     return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
@@ -125,15 +200,23 @@ void json_interface::configure(const json& j0)
   };
 
   add_boolean_option("enable_robust_detection", true);
+  add_boolean_option("enable_cell_culling", true);
+  add_boolean_option("enable_lazy_derivatives", false);
   add_boolean_option("enable_post_processing", true);
+  add_boolean_option("enable_compact_trajectories", false);
   add_boolean_option("enable_streaming_trajectories", false);
   add_boolean_option("enable_discarding_interval_points", false);
   add_boolean_option("enable_discarding_degenerate_points", false);
   add_boolean_option("enable_ignoring_degenerate_points", false);
   add_boolean_option("enable_timing", false);
+  add_boolean_option("resume", false);
 
   add_number_option("duration_pruning_threshold", 0);
   add_number_option("nblocks", 1);
+  add_number_option("checkpoint_interval", 0);
+  add_number_option("ntime_intervals", 1);
+  if (j["ntime_intervals"] > 1 && (j["enable_streaming_trajectories"] == true || j["checkpoint_interval"] > 0 || j["resume"] == true))
+    fatal("time-parallel tracking does not support streaming trajectories or checkpoints");
   
   /// application specific
   if (j.contains("xgc")) {
@@ -175,6 +258,30 @@ void json_interface::configure(const json& j0)
   add_string_option(j, "output", false);
 
   add_string_option(j, "accelerator", false);
+  add_string_option(j, "traversal", false);
+  add_string_option(j, "variable", false);
+  if (j.contains("attached_variables")) {
+    if (!j["attached_variables"].is_array())
+      fatal("invalid attached_variables");
+    for (const auto &v : j["attached_variables"])
+      if (!v.is_string()) fatal("invalid attached_variables");
+  }
+  if (j.contains("traversal") && j["traversal"] != "row_major" && j["traversal"] != "morton")
+    fatal("invalid traversal");
+
+  add_string_option(j, "instrumentation_output", false);
+  add_string_option(j, "trace_output", false);
+  add_string_option(j, "checkpoint", false);
+  if ((j["checkpoint_interval"] > 0 || j["resume"] == true) && !j.contains("checkpoint"))
+    fatal("missing checkpoint");
+  add_string_option(j, "storage", false);
+  if (j.contains("storage") && !j.contains("storage_backend"))
+    j["storage_backend"] = "native";
+  add_string_option(j, "storage_backend", false);
+  add_string_option(j, "spill_directory", false);
+  add_number_option("spill_memory_budget", 1024);
+  if (j.contains("spill_directory") && (j["enable_streaming_trajectories"] == true || j["ntime_intervals"] > 1))
+    fatal("spilling does not support streaming trajectories or time-parallel tracking");
 
   // output type
   static const std::set<std::string> valid_output_types = {
@@ -199,7 +306,7 @@ void json_interface::configure(const json& j0)
   //   j["enable_streaming_trajectories"] = true;
 
   // output format
-  static const std::set<std::string> valid_output_formats = {"text", "vtp", "json"}; // , "binary"};
+  static const std::set<std::string> valid_output_formats = {"text", "vtp", "json", "indexed"}; // , "binary"};
   bool output_format_determined = false;
   
   if (j.contains("output_format")) {
@@ -218,6 +325,7 @@ void json_interface::configure(const json& j0)
       if (ends_with(j["output"], "vtp")) j["output_format"] = "vtp";
       else if (ends_with(j["output"], "txt")) j["output_format"] = "text";
       else if (ends_with(j["output"], "json")) j["output_format"] = "json";
+      else if (ends_with(j["output"], "ftkc")) j["output_format"] = "indexed";
       else j["output_format"] = "binary";
     }
   }
@@ -277,48 +385,75 @@ void json_interface::configure(const json& j0)
 
 void json_interface::configure_tracker_general(diy::mpi::communicator comm)
 {
-  tracker->set_communicator(comm);
-  tracker->set_root_proc(j["root_proc"]);
+  configure_critical_point_tracker(tracker, comm);
+
+  if (j.contains("instrumentation_output") || j.contains("trace_output"))
+    tracker->get_instrumentation().set_enabled(true);
+
+  if (j.contains("storage")) {
+    std::string dbname = j["storage"];
+    if (comm.size() > 1) dbname += "." + std::to_string(comm.rank());
+    auto store = make_storage(j["storage_backend"]);
+    if (!store->open(dbname))
+      fatal("unable to open storage " + dbname);
+    tracker->set_storage(store);
+    tracker->set_enable_evicting_stored_features(
+        !(j["enable_streaming_trajectories"] == true && j.contains("output")));
+  }
+}
+
+void json_interface::configure_critical_point_tracker(std::shared_ptr<critical_point_tracker> t, diy::mpi::communicator comm)
+{
+  t->set_communicator(comm);
+  t->set_root_proc(j["root_proc"]);
  
   if (j.contains("nthreads") && j["nthreads"].is_number())
-    tracker->set_number_of_threads(j["nthreads"]);
+    t->set_number_of_threads(j["nthreads"]); // 0 is resolved by initialize()
 
   if (j.contains("accelerator")) {
     if (j["accelerator"] == "cuda")
-      tracker->use_accelerator( FTK_XL_CUDA );
+      t->use_accelerator( FTK_XL_CUDA );
     else if (j["accelerator"] == "sycl")
-      tracker->use_accelerator( FTK_XL_SYCL );
+      t->use_accelerator( FTK_XL_SYCL );
+    else if (j["accelerator"] == "cpu")
+      t->use_accelerator( FTK_XL_CPU );
     else 
       fatal(FTK_ERR_ACCELERATOR_UNSUPPORTED);
   }
 
   if (j.contains("thread_backend")) {
     std::string backend = j["thread_backend"];
-    tracker->use_thread_backend( backend );
+    t->use_thread_backend( backend );
   }
 
   if (j.contains("nblocks"))
-    tracker->set_number_of_blocks(j["nblocks"]);
+    t->set_number_of_blocks(j["nblocks"]);
 
-  tracker->set_input_array_partial(false); // input data are not distributed
+  t->set_input_array_partial(false); // input data are not distributed
 
   // if (use_type_filter)
-  //   tracker->set_type_filter(type_filter);
+  //   t->set_type_filter(type_filter);
 
   if (j.contains("enable_robust_detection"))
-    tracker->set_enable_robust_detection( j["enable_robust_detection"].get<bool>() );
+    t->set_enable_robust_detection( j["enable_robust_detection"].get<bool>() );
+
+  if (j.contains("vector_field_resolution"))
+    t->set_fixed_vector_field_resolution( j["vector_field_resolution"].get<double>() );
 
   if (j["enable_streaming_trajectories"] == true)
-    tracker->set_enable_streaming_trajectories(true);
+    t->set_enable_streaming_trajectories(true);
 
   if (j["enable_discarding_interval_points"] == true)
-    tracker->set_enable_discarding_interval_points(true);
+    t->set_enable_discarding_interval_points(true);
+
+  if (j["enable_compact_trajectories"] == true)
+    t->set_enable_compact_trajectories(true);
 
   if (j["enable_discarding_degenerate_points"] == true)
-    tracker->set_enable_discarding_degenerate_points(true);
+    t->set_enable_discarding_degenerate_points(true);
 
   if (j["enable_ignoring_degenerate_points"] == true)
-    tracker->set_enable_ignoring_degenerate_points(true);
+    t->set_enable_ignoring_degenerate_points(true);
 
   if (j.contains("type_filter")) {
     const std::string str = j["type_filter"];
@@ -331,7 +466,7 @@ void json_interface::configure_tracker_general(diy::mpi::communicator comm)
       type_filter |= ftk::CRITICAL_POINT_2D_SADDLE;
 
     if (type_filter)
-      tracker->set_type_filter(type_filter);
+      t->set_type_filter(type_filter);
   }
 }
 
@@ -345,6 +480,93 @@ void json_interface::consume(ndarray_stream<> &stream, diy::mpi::communicator co
     consume_xgc(stream, comm);
   else 
     consume_regular(stream, comm);
+
+  write_instrumentation(comm);
+}
+
+void json_interface::consume(ndarray_stream<float> &stream, diy::mpi::communicator comm)
+{
+  if (j.is_null())
+    configure(j); // make default options
+
+  if (j.contains("xgc"))
+    fatal("single-precision inputs are not supported for xgc");
+  else 
+    consume_regular(stream, comm);
+
+  write_instrumentation(comm);
+}
+
+template <typename T>
+void json_interface::consume(ndarray_group_stream<T> &stream, diy::mpi::communicator comm)
+{
+  if (j.is_null())
+    configure(j); // make default options
+
+  if (j.contains("xgc"))
+    fatal("group streams are not supported for xgc");
+
+  const auto keys = stream.keys();
+  if (!j.contains("variable") && keys.size() > 1)
+    fatal("missing variable");
+  const std::string key = j.contains("variable") ? j["variable"].get<std::string>() : keys.front();
+
+  std::vector<std::string> requested_keys = {key};
+  if (j.contains("attached_variables")) {
+    for (const auto &v : j["attached_variables"])
+      requested_keys.push_back(v.get<std::string>());
+  } else {
+    for (const auto &k : keys)
+      if (k != key) requested_keys.push_back(k);
+  }
+  stream.set_requested_keys(requested_keys);
+
+  consume_regular(*stream.get_stream(key), comm, &stream);
+  write_instrumentation(comm);
+}
+
+template <typename T>
+ndarray<T> json_interface::gather_attached_variables(const ndarray_group& g, 
+    const std::vector<std::string>& keys, const std::vector<size_t>& ncomponents, 
+    const std::vector<size_t>& dims)
+{
+  // interleaved components of all attached arrays, {total ncomponents, spatial dims}
+  std::vector<size_t> shape = dims;
+  shape.insert(shape.begin(), std::accumulate(ncomponents.begin(), ncomponents.end(), size_t(0)));
+  ndarray<T> a(shape);
+  
+  const size_t n = a.nelem() / shape[0];
+  for (size_t i = 0, c = 0; i < keys.size(); i ++) {
+    const auto &array = g.get<T>(keys[i]);
+    const size_t nc = ncomponents[i];
+    if (array.nelem() != n * nc)
+      fatal("attached variable " + keys[i] + " does not match the dimensions of the tracked variable");
+    for (size_t k = 0; k < n; k ++)
+      for (size_t j = 0; j < nc; j ++)
+        a[k * shape[0] + c + j] = array[k * nc + j];
+    c += nc;
+  }
+  return a;
+}
+
+void json_interface::read_archived_traced_critical_points(const std::string& filename)
+{
+  if (ends_with(filename, "json")) tracker->read_traced_critical_points_json(filename);
+  else if (ends_with(filename, "ftkc")) {
+    if (j["output_type"] == "sliced" || j["output_type"] == "intercepted")
+      tracker->open_traced_critical_points_indexed(filename); // only read what is sliced or intercepted
+    else 
+      tracker->read_traced_critical_points_indexed(filename);
+  } else tracker->read_traced_critical_points_binary(filename);
+}
+
+void json_interface::write_instrumentation(diy::mpi::communicator comm) const
+{
+  const auto &instr = tracker->get_instrumentation();
+  if (j.contains("instrumentation_output"))
+    instr.write_json(comm, j["instrumentation_output"], j["root_proc"]);
+  if (j.contains("trace_output"))
+    instr.write_chrome_trace(comm, j["trace_output"], j["root_proc"]);
 }
 
 void json_interface::consume_xgc(ndarray_stream<> &stream, diy::mpi::communicator comm)
@@ -379,8 +601,7 @@ void json_interface::consume_xgc(ndarray_stream<> &stream, diy::mpi::communicato
   if (j.contains("archived_traced_critical_points_filename")) {
     fprintf(stderr, "reading archived traced critical points...\n");
     const std::string filename = j["archived_traced_critical_points_filename"];
-    if (ends_with(filename, "json")) tracker->read_traced_critical_points_json(filename);
-    else tracker->read_traced_critical_points_binary(filename);
+    read_archived_traced_critical_points(filename);
     // fprintf(stderr, "done reading.\n");
     return;
   } else if (j.contains("archived_discrete_critical_points_filename")) {
@@ -448,6 +669,9 @@ void json_interface::consume_xgc(ndarray_stream<> &stream, diy::mpi::communicato
     }
   });
 
+  stream.use_thread_backend( tracker->get_thread_backend() ); // for spatial smoothing
+  stream.set_number_of_threads( tracker->get_number_of_threads() );
+  stream.set_instrumentation( &tracker->get_instrumentation() );
   stream.start();
   stream.finish();
   tracker->finalize();
@@ -475,24 +699,23 @@ void json_interface::write_intercepted_results(int k, int nt)
   }
 }
 
-void json_interface::consume_regular(ndarray_stream<> &stream, diy::mpi::communicator comm)
+template <typename T>
+std::shared_ptr<critical_point_tracker_regular<T>> json_interface::make_regular_tracker(
+    const ndarray_stream<T> &stream, diy::mpi::communicator comm)
 {
-  auto t0 = clock_type::now();
-
-  const auto js = stream.get_json();
+  const json js = stream.get_json();
   const size_t nd = stream.n_dimensions(),
                DW = js["dimensions"][0], 
                DH = js["dimensions"].size() > 1 ? js["dimensions"][1].get<int>() : 0,
-               DD = js["dimensions"].size() > 2 ? js["dimensions"][2].get<int>() : 0,
-               DT = js["n_timesteps"];
+               DD = js["dimensions"].size() > 2 ? js["dimensions"][2].get<int>() : 0;
   const size_t nv = stream.n_components();
 
-  std::shared_ptr<critical_point_tracker_regular> rtracker;
+  std::shared_ptr<critical_point_tracker_regular<T>> rtracker;
   if (nd == 2) {
-    rtracker.reset(new critical_point_tracker_2d_regular(comm));
+    rtracker.reset(new critical_point_tracker_2d_regular<T>(comm));
     rtracker->set_array_domain(ftk::lattice({0, 0}, {DW, DH}));
   } else {
-    rtracker.reset(new critical_point_tracker_3d_regular(comm));
+    rtracker.reset(new critical_point_tracker_3d_regular<T>(comm));
     rtracker->set_array_domain(ftk::lattice({0, 0, 0}, {DW, DH, DD}));
   }
 
@@ -519,16 +742,67 @@ void json_interface::consume_regular(ndarray_stream<> &stream, diy::mpi::communi
     }
     fprintf(stderr, "treating input data as vector field.\n");
   }
+  if (j.contains("enable_cell_culling"))
+    rtracker->set_enable_cell_culling( j["enable_cell_culling"].get<bool>() );
+  if (j.contains("enable_lazy_derivatives"))
+    rtracker->set_enable_lazy_derivatives( j["enable_lazy_derivatives"].get<bool>() );
+  if (j.contains("traversal"))
+    rtracker->use_traversal( j["traversal"].get<std::string>() );
+
+  return rtracker;
+}
+
+template <typename T>
+void json_interface::consume_regular(ndarray_stream<T> &stream, diy::mpi::communicator comm, 
+    ndarray_group_stream<T> *group)
+{
+  auto t0 = clock_type::now();
+
+  const json js = stream.get_json();
+  const size_t DT = group ? group->n_timesteps() : js["n_timesteps"].get<size_t>();
+  const size_t nv = stream.n_components();
+
+  auto rtracker = make_regular_tracker(stream, comm);
   tracker = rtracker;
   
   configure_tracker_general(comm);
+
+  // the first requested array of a group is tracked, and the others are attached
+  std::vector<std::string> attached_keys, attached_names;
+  std::vector<size_t> attached_ncomponents;
+  if (group) {
+    const auto &keys = group->get_requested_keys();
+    attached_keys.assign(keys.begin() + 1, keys.end());
+    for (const auto &key : attached_keys) {
+      const size_t nc = group->get_stream(key)->n_components();
+      attached_ncomponents.push_back(nc);
+      if (nc == 1) attached_names.push_back(key);
+      else for (size_t c = 0; c < nc; c ++)
+        attached_names.push_back(key + "_" + std::to_string(c));
+    }
+
+    if (j["resume"] == true)
+      fatal("resuming is not supported for group streams");
+    if (!attached_keys.empty()) {
+      if (j.contains("accelerator") && j["accelerator"] != "none")
+        fatal("attached variables are not supported with accelerators");
+      if (j["ntime_intervals"] > 1)
+        fatal("attached variables are not supported in time-parallel tracking");
+      rtracker->set_attached_scalar_components(attached_names);
+    }
+  }
+  if (j.contains("spill_directory")) {
+    rtracker->set_spill_directory(j["spill_directory"]);
+    rtracker->set_spill_memory_budget(j["spill_memory_budget"].get<double>() * 1024 * 1024);
+  }
   tracker->initialize();
+  if (comm.size() > 1 && comm.rank() == 0 && j["enable_timing"])
+    fprintf(stderr, "nprocs=%d, nthreads=%d per process\n", comm.size(), tracker->get_number_of_threads());
  
   if (j.contains("archived_traced_critical_points_filename")) {
     fprintf(stderr, "reading archived traced critical points...\n");
     const std::string filename = j["archived_traced_critical_points_filename"];
-    if (ends_with(filename, "json")) tracker->read_traced_critical_points_json(filename);
-    else tracker->read_traced_critical_points_binary(filename);
+    read_archived_traced_critical_points(filename);
     // fprintf(stderr, "done reading.\n");
     return;
   } else if (j.contains("archived_discrete_critical_points_filename")) {
@@ -539,7 +813,13 @@ void json_interface::consume_regular(ndarray_stream<> &stream, diy::mpi::communi
     return;
   }
 
-  auto push_timestep = [&](const ftk::ndarray<double>& field_data) {
+  if (j["ntime_intervals"] > 1) {
+    t_init = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - t0).count() * 1e-9;
+    consume_regular_time_parallel(stream, comm);
+    return;
+  }
+
+  auto push_timestep = [&](const ftk::ndarray<T>& field_data) {
     if (nv == 1) { // scalar field
 #if 0
       if (spatial_smoothing) {
@@ -555,34 +835,263 @@ void json_interface::consume_regular(ndarray_stream<> &stream, diy::mpi::communi
       tracker->push_vector_field_snapshot(field_data);
   };
 
-  stream.set_callback([&](int k, const ftk::ndarray<double> &field_data) {
-    push_timestep(field_data);
+  if (j["resume"] == true) {
+    if (tracker->read_checkpoint(j["checkpoint"])) {
+      const int k = tracker->get_current_timestep();
+      if (comm.rank() == 0) fprintf(stderr, "resuming from timestep %d\n", k+1);
+      stream.set_start_timestep(k+1);
+    } else if (comm.rank() == 0)
+      fprintf(stderr, "checkpoint not found; starting from the first timestep\n");
+  }
+  const int checkpoint_interval = j["checkpoint_interval"];
+
+  std::vector<size_t> dims;
+  for (const auto &d : js["dimensions"])
+    dims.push_back(d.template get<size_t>());
+
+  auto step = [&](int k) {
     if (k != 0) tracker->advance_timestep();
     if (k == DT-1) tracker->update_timestep();
     
     if (k>0 && j.contains("output") && j["output_type"] == "sliced" && j["enable_streaming_trajectories"] == true)
       write_sliced_results(k-1);
-  });
+
+    if (checkpoint_interval > 0 && (k+1) % checkpoint_interval == 0)
+      tracker->write_checkpoint(j["checkpoint"]);
+  };
+
+  // completed trajectories are streamed to indexed outputs
+  if (j["enable_streaming_trajectories"] == true && j.contains("output") && j["output_type"] == "traced" 
+      && j["output_format"] == "indexed" && checkpoint_interval == 0 && j["resume"] == false) {
+    std::function<bool(const feature_curve_t&)> filter;
+    const double threshold = j["duration_pruning_threshold"];
+    if (j["enable_post_processing"] == true && threshold > 0)
+      filter = [threshold](const feature_curve_t& traj) { return traj.tmax - traj.tmin >= threshold; };
+    tracker->stream_traced_critical_points_indexed(j["output"], filter);
+  }
 
   auto t1 = clock_type::now();
 
-  stream.start();
-  stream.finish();
+  if (group) {
+    const std::string key = group->get_requested_keys().front();
+    group->set_callback([&](int k, const ndarray_group& g) {
+      push_timestep(g.get<T>(key));
+      if (!attached_keys.empty())
+        rtracker->push_attached_scalars_snapshot(
+            gather_attached_variables<T>(g, attached_keys, attached_ncomponents, dims));
+      step(k);
+    });
+
+    for (const auto &key : group->get_requested_keys()) { // for spatial smoothing
+      group->get_stream(key)->use_thread_backend( tracker->get_thread_backend() );
+      group->get_stream(key)->set_number_of_threads( tracker->get_number_of_threads() );
+    }
+    group->set_instrumentation( &tracker->get_instrumentation() );
+    group->start();
+    group->finish();
+  } else {
+    stream.set_callback([&](int k, const ftk::ndarray<T> &field_data) {
+      push_timestep(field_data);
+      step(k);
+    });
+
+    stream.use_thread_backend( tracker->get_thread_backend() ); // for spatial smoothing
+    stream.set_number_of_threads( tracker->get_number_of_threads() );
+    stream.set_instrumentation( &tracker->get_instrumentation() );
+    stream.start();
+    stream.finish();
+  }
+  tracker->wait_for_checkpoint();
 
   auto t2 = clock_type::now();
   
-  tracker->finalize();
+  {
+    instrumentation::scoped_timer timer(tracker->get_instrumentation(), "finalize");
+    tracker->finalize();
+  }
   auto t3 = clock_type::now();
 
-  if (comm.rank() == 0 && j["enable_timing"]) {
-    float t_init = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9,
-          t_compute = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() * 1e-9,
-          t_finalize = std::chrono::duration_cast<std::chrono::nanoseconds>(t3 - t2).count() * 1e-9;
+  t_init = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+  t_compute = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() * 1e-9;
+  t_finalize = std::chrono::duration_cast<std::chrono::nanoseconds>(t3 - t2).count() * 1e-9;
+  if (comm.rank() == 0 && j["enable_timing"]) 
     fprintf(stderr, "t_init=%f, t_compute=%f, t_finalize=%f\n", t_init, t_compute, t_finalize);
-  }
   // delete tracker;
 }
 
+template <typename T>
+void json_interface::consume_regular_time_parallel(ndarray_stream<T> &stream, diy::mpi::communicator comm)
+{
+  auto t1 = clock_type::now();
+
+  const json js = stream.get_json();
+  const int DT = js["n_timesteps"];
+  const size_t nv = stream.n_components();
+  if (js.contains("temporal-smoothing-kernel"))
+    fatal("time-parallel tracking does not support temporal smoothing");
+
+  // interval i covers timesteps [bounds[i], bounds[i+1]]; ordinal critical 
+  // points on the shared timesteps are detected in both adjacent intervals
+  const int nintervals = std::max(1, std::min(j["ntime_intervals"].get<int>(), DT-1));
+  std::vector<int> bounds(nintervals + 1);
+  for (int i = 0; i <= nintervals; i ++)
+    bounds[i] = static_cast<int>(static_cast<int64_t>(i) * (DT-1) / nintervals);
+
+  std::vector<int> intervals; // assigned to this process
+  for (int i = comm.rank(); i < nintervals; i += comm.size())
+    intervals.push_back(i);
+
+  // intervals of the process are tracked by thread groups that share the threads
+  const int nthreads = tracker->get_number_of_threads();
+  int ngroups = std::max(1, std::min(static_cast<int>(intervals.size()), nthreads));
+#if FTK_HAVE_MPI
+  int threading = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&threading);
+  if (threading < MPI_THREAD_MULTIPLE && ngroups > 1) {
+    if (comm.rank() == 0)
+      warn("MPI_THREAD_MULTIPLE not provided; time intervals are tracked by one thread group");
+    ngroups = 1; // interval trackers call mpi on their own communicators
+  }
+#endif
+  // interval trackers do not communicate, but call collectives on their 
+  // communicators; each thread group thus has its own duplicate
+  diy::mpi::communicator self = comm.split(comm.rank());
+  std::vector<diy::mpi::communicator> group_comms(ngroups);
+  for (auto &c : group_comms)
+    c.duplicate(self);
+  if (comm.rank() == 0)
+    fprintf(stderr, "time-parallel tracking: nintervals=%d, ngroups=%d\n", nintervals, ngroups);
+
+  // thread groups smooth their timesteps concurrently
+  stream.use_thread_backend( tracker->get_thread_backend() );
+  stream.set_number_of_threads( std::max(1, nthreads / ngroups) );
+
+  std::map<int, feature_curve_set_t> fragments; // by interval
+  std::map<int, std::vector<int>> loops; // ids of looped fragments by interval, which are not serialized with the curves
+  std::map<unsigned long long, feature_point_t> points; // by tag
+  const bool keep_points = j["output_type"] == "discrete";
+  std::mutex mutex, io_mutex;
+
+  ndarray<T> first_array; // read for the resolution; reused by the first interval
+  auto read_timestep = [&](int k) {
+    ndarray<T> array;
+    if (k == 0 && !first_array.empty()) {
+      std::swap(array, first_array);
+      return array;
+    }
+    {
+      std::unique_lock<std::mutex> lock(io_mutex, std::defer_lock);
+      if (!stream.is_thread_safe()) lock.lock();
+      array = stream.request_timestep(k);
+    }
+    if (array.empty())
+      fatal("unable to read timestep " + std::to_string(k));
+    if (stream.has_spatial_filters())
+      stream.apply_spatial_filters(array);
+    return array;
+  };
+
+  // The serial tracker derives the quantization for robust detection from 
+  // the snapshots seen so far.  Here, the vector resolution is taken from the 
+  // first timestep of the first interval (unless given) and fixed in all 
+  // interval trackers, so the timesteps shared by adjacent intervals are 
+  // quantized identically.
+  double resolution = j.value("vector_field_resolution", 0.0);
+  if (resolution <= 0 && comm.rank() == 0) {
+    auto t = make_regular_tracker(stream, self);
+    configure_critical_point_tracker(t, self);
+    t->initialize();
+    first_array = read_timestep(0);
+    if (nv == 1) t->push_scalar_field_snapshot(first_array);
+    else t->push_vector_field_snapshot(first_array);
+    resolution = t->get_last_snapshot_vector_resolution();
+  }
+  diy::mpi::broadcast(comm, resolution, 0);
+
+  auto track_interval = [&](int i, diy::mpi::communicator c) {
+    auto t = make_regular_tracker(stream, c);
+    configure_critical_point_tracker(t, c);
+    t->set_number_of_threads(std::max(1, nthreads / ngroups));
+    t->set_enable_compact_trajectories(false); // fragments are stitched as curves
+    t->initialize();
+    t->set_current_timestep(bounds[i]);
+    t->set_fixed_vector_field_resolution(resolution);
+
+    for (int k = bounds[i]; k <= bounds[i+1]; k ++) {
+      const ndarray<T> array = read_timestep(k);
+      if (nv == 1) t->push_scalar_field_snapshot(array);
+      else t->push_vector_field_snapshot(array);
+
+      if (k != bounds[i]) t->advance_timestep();
+      if (k == bounds[i+1]) t->update_timestep();
+    }
+    t->trace_discrete_critical_points();
+
+    std::lock_guard<std::mutex> guard(mutex);
+    fragments[i] = t->get_traced_critical_points();
+    for (const auto &kv : fragments[i])
+      if (kv.second.loop) loops[i].push_back(kv.first);
+    if (keep_points)
+      for (const auto &kv : t->get_discrete_critical_points())
+        points[kv.second.tag] = kv.second;
+  };
+
+  if (ngroups == 1) { // in the main thread
+    for (const auto i : intervals)
+      track_interval(i, group_comms[0]);
+  } else {
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int g = 0; g < ngroups; g ++)
+      workers.push_back(std::thread([&, g]() {
+        for (size_t l = next ++; l < intervals.size(); l = next ++)
+          track_interval(intervals[l], group_comms[g]);
+      }));
+    for (auto &w : workers)
+      w.join();
+  }
+
+  auto t2 = clock_type::now();
+
+  // stitching; discrete points are only kept for discrete outputs
+  {
+    instrumentation::scoped_timer timer(tracker->get_instrumentation(), "finalize");
+    diy::mpi::gather(comm, fragments, fragments, tracker->get_root_proc());
+    diy::mpi::gather(comm, loops, loops, tracker->get_root_proc());
+    if (keep_points)
+      diy::mpi::gather(comm, points, points, tracker->get_root_proc());
+
+    if (tracker->is_root_proc()) {
+      for (const auto &kv : loops)
+        for (const auto id : kv.second) {
+          auto range = fragments[kv.first].equal_range(id);
+          for (auto it = range.first; it != range.second; it ++)
+            it->second.loop = true;
+        }
+
+      std::vector<feature_curve_set_t> sets;
+      for (const auto &kv : fragments)
+        sets.push_back(kv.second);
+      fragments.clear();
+      tracker->stitch_traced_critical_points(sets, bounds);
+
+      std::vector<feature_point_t> cps;
+      for (const auto &kv : points)
+        cps.push_back(kv.second);
+      tracker->put_critical_points(cps);
+
+      tracker->update_traj_statistics();
+    }
+  }
+  tracker->set_current_timestep(DT-1);
+  auto t3 = clock_type::now();
+
+  t_compute = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() * 1e-9;
+  t_finalize = std::chrono::duration_cast<std::chrono::nanoseconds>(t3 - t2).count() * 1e-9;
+  if (comm.rank() == 0 && j["enable_timing"]) 
+    fprintf(stderr, "t_init=%f, t_compute=%f, t_finalize=%f\n", t_init, t_compute, t_finalize);
+}
+
 void json_interface::xgc_post_process()
 {
   fprintf(stderr, "post processing for xgc...\n");
@@ -616,6 +1125,19 @@ void json_interface::xgc_post_process()
 
 void json_interface::post_process()
 {
+  if (tracker->is_compact() || tracker->is_streaming_indexed()) { // curves are not edited
+    if (j["duration_pruning_threshold"] > 0) {
+      const double threshold = j["duration_pruning_threshold"];
+      tracker->select_trajectories([&](const feature_curve_t& traj) {
+        return traj.tmax - traj.tmin >= threshold;
+      }, [&](const feature_curve_file_entry_t& e) {
+        return e.tmax - e.tmin >= threshold;
+      });
+    }
+    tracker->update_traj_statistics();
+    return;
+  }
+
   auto &trajs = tracker->get_traced_critical_points();
 
   trajs.foreach([](ftk::feature_curve_t& t) {
@@ -677,6 +1199,7 @@ void json_interface::write()
       if (j["output_format"] == "vtp") tracker->write_traced_critical_points_vtk(j["output"]);
       else if (j["output_format"] == "text") tracker->write_traced_critical_points_text(j["output"]);
       else if (j["output_format"] == "json") tracker->write_traced_critical_points_json(j["output"]);
+      else if (j["output_format"] == "indexed") tracker->write_traced_critical_points_indexed(j["output"]);
       else tracker->write_traced_critical_points_binary(j["output"]);
     } else if (j["output_type"] == "discrete") {
       fprintf(stderr, "writing discrete critical points..\n");
@@ -686,6 +1209,8 @@ void json_interface::write()
       else tracker->write_critical_points_binary(j["output"]);
     }
   }
+
+  tracker->store_traced_critical_points();
 }
 
 }
@@ -6,6 +6,9 @@
 #include <ftk/filters/tracker.hh>
 #include <ftk/external/diy/master.hpp>
 #include <ftk/external/diy/decomposition.hpp>
+#include <algorithm>
+#include <numeric>
+#include <map>
 
 namespace ftk {
 
@@ -22,8 +25,15 @@ public:
 
   void set_coordinates(const ndarray<double>& coords_) {coords = coords_; use_explicit_coords = true;}
 
+  // order of simplex sweeps, see simplicial_regular_mesh::set_traversal()
+  void set_traversal(int t) {m.set_traversal(t);}
+  void use_traversal(const std::string& str) {set_traversal(str == "morton" ? ELEMENT_TRAVERSAL_MORTON : ELEMENT_TRAVERSAL_ROW_MAJOR);}
+
   void initialize();
 
+  size_t get_number_of_scanned_simplices() const {return nsimplices_scanned;} // incl. skipped ones
+  size_t get_number_of_local_blocks() const;
+
 protected:
   struct block_t {
     int gid;
@@ -40,12 +50,43 @@ protected:
   bool use_explicit_coords = false;
   ndarray<double> coords;
 
+  size_t nsimplices_scanned = 0;
+
+protected: // over-decomposition
+  // If the number of blocks exceeds the number of processes, the domain is 
+  // decomposed into nblocks blocks, and the blocks are assigned to processes
+  // by the cost (wall time) measured so far, largest first to the least 
+  // loaded process.  The blocks of a process are scanned one after another,
+  // each with all threads.  Only used w/o accelerators if the input arrays 
+  // are not distributed, such that each process can crop the arrays of a 
+  // timestep to its blocks (see block_array_domain) w/o migrating data.
+  // initialize() assigns blocks by their sizes; trackers that rebalance call
+  // balance_blocks(t+1), a collective, before scanning timestep t, such that
+  // the arrays of timestep t+1 can be cropped to the blocks of both t and t+1.
+  std::vector<lattice> block_cores;
+  std::map<int, std::vector<int>> block_owners; // assignments by the timesteps from which they are effective
+  std::vector<double> block_costs; // of the blocks of this process since the last balancing
+
+  void balance_blocks(int t);
+  const std::vector<int>& get_block_owners(int t) const; // the assignment effective in timestep t
+  lattice block_array_domain(int t0, int t1) const; // blocks of this process in t0 or t1, w/ ghosts
+
 protected: // internal use
   template <typename I=int> void simplex_indices(const std::vector<std::vector<int>>& vertices, I indices[]) const;
 
   void element_for_ordinal(int k, std::function<void(element_t)> f) { element_for(true, k, f); }
   void element_for_interval(int k, std::function<void(element_t)> f) { element_for(false, k, f); }
   void element_for(bool ordinal, int k, std::function<void(element_t)> f);
+  
+  // same as above, but skipping all k-simplices of a cell if cell_filter returns false
+  void element_for(bool ordinal, int k, 
+      std::function<bool(const std::vector<int>&)> cell_filter,
+      std::function<void(element_t)> f);
+
+private:
+  void element_for_blocks(bool ordinal, int k, 
+      std::function<bool(const std::vector<int>&)> cell_filter, // may be empty
+      std::function<void(element_t)> f);
 };
 
 /////////////////////////////
@@ -58,6 +99,7 @@ inline void regular_tracker::initialize()
   fprintf(stderr, "interval 1-simplices:\n");
   m.print_unit_simplices(1, ELEMENT_SCOPE_INTERVAL);
 #endif
+  initialize_number_of_threads();
 
   // initialize spacetime mesh
   {
@@ -81,50 +123,28 @@ inline void regular_tracker::initialize()
     for (int i = 0; i < domain.nd(); i ++)
       ghost.push_back(2);
     
-    partitioner.partition(comm.size(), {}, ghost);
+    block_cores.clear();
+    block_owners.clear();
+    if (nblocks > comm.size() && xl == FTK_XL_NONE && !is_input_array_partial) {
+      partitioner.partition(nblocks, {}, ghost);
+      for (size_t i = 0; i < partitioner.np(); i ++)
+        block_cores.push_back(partitioner.get_core(i));
+      block_costs.assign(block_cores.size(), 0.0);
+      balance_blocks(start_timestep); // by sizes
+
+      local_domain = domain; // blocks may be assigned to any process
+      local_array_domain = array_domain; // until arrays are cropped
+    } else {
+      partitioner.partition(comm.size(), {}, ghost);
 
-    local_domain = partitioner.get_core(comm.rank());
-    local_array_domain = partitioner.get_ext(comm.rank());
+      local_domain = partitioner.get_core(comm.rank());
+      local_array_domain = partitioner.get_ext(comm.rank());
+    }
   }
 
   if (!is_input_array_partial)
     local_array_domain = array_domain;
 
-#if 0 // experimental code to use DIY for multi-block handling
-  // iniitalize partitions
-  diy::RoundRobinAssigner assigner(comm.size(), nblocks);
-  
-  typedef diy::DiscreteBounds Bounds; 
-  typedef diy::RegularGridLink RGLink;
-
-  const int nd = m.nd() - 1;
-  std::vector<bool> share_face, wrap;
-  std::vector<int> ghosts(nd), divs;
-
-  for (int i = 0; i < nd; i ++)
-    ghosts[i] = 2;
-  
-  diy::RegularDecomposer<Bounds> decomposer(
-      nd, domain.to_diy_bounds(), nblocks, 
-      share_face, wrap, ghosts, divs);
-  decomposer.decompose(comm.rank(), assigner, 
-    [&](int gid, const Bounds &core, const Bounds &bounds, const Bounds&, const RGLink &link) {
-      block_t *b = new block_t;
-      RGLink *l = new RGLink(link);
-
-      b->gid = gid;
-      b->local_domain = core;
-      b->local_array_domain = bounds;
-
-      master.add(gid, b, l);
-    });
-
-  master.foreach([&](block_t *b, const diy::Master::ProxyWithLink&) {
-    // fprintf(stderr, "hello %d\n", b->gid);
-    // std::cerr << b->local_domain << std::endl;
-    // std::cerr << b->local_array_domain << std::endl;
-  });
-#endif
 }
 
 template <typename I>
@@ -135,8 +155,118 @@ inline void regular_tracker::simplex_indices(
     indices[i] = m.get_lattice().to_integer(vertices[i]);
 }
 
+inline size_t regular_tracker::get_number_of_local_blocks() const
+{
+  if (block_cores.empty()) return 1;
+  const auto &owners = get_block_owners(current_timestep);
+  return std::count(owners.begin(), owners.end(), comm.rank());
+}
+
+inline const std::vector<int>& regular_tracker::get_block_owners(int t) const
+{
+  auto it = block_owners.upper_bound(t);
+  if (it == block_owners.begin())
+    fatal("blocks not assigned for the timestep");
+  return (-- it)->second;
+}
+
+inline lattice regular_tracker::block_array_domain(int t0, int t1) const
+{
+  // vertices of the cells of a core extend one layer beyond the core, and 
+  // lazy derivatives need two more layers for the stencils of jacobians
+  const int nghosts = 3;
+  const auto &owners0 = get_block_owners(t0), &owners1 = get_block_owners(t1);
+
+  const int nd = array_domain.nd();
+  std::vector<int> lo(nd, std::numeric_limits<int>::max()), 
+                   hi(nd, std::numeric_limits<int>::lowest());
+  for (size_t i = 0; i < block_cores.size(); i ++) {
+    if (owners0[i] != comm.rank() && owners1[i] != comm.rank()) continue;
+    for (int d = 0; d < nd; d ++) {
+      lo[d] = std::min(lo[d], int(block_cores[i].start(d)) - nghosts);
+      hi[d] = std::max(hi[d], int(block_cores[i].upper_bound(d)) + nghosts);
+    }
+  }
+
+  std::vector<size_t> st(nd), sz(nd);
+  for (int d = 0; d < nd; d ++) {
+    if (lo[d] > hi[d]) return array_domain; // w/o blocks, which does not happen w/ more blocks than processes
+    const int l = std::max(lo[d], int(array_domain.start(d))), 
+              u = std::min(hi[d], int(array_domain.upper_bound(d)));
+    st[d] = l;
+    sz[d] = u - l + 1;
+  }
+  return lattice(st, sz);
+}
+
+inline void regular_tracker::balance_blocks(int t)
+{
+  // each block is measured by its owner only
+  std::vector<double> costs;
+  diy::mpi::all_reduce(comm, block_costs, costs, std::plus<double>());
+
+  // w/o measurements (the first timestep), the costs are given by block sizes
+  if (std::accumulate(costs.begin(), costs.end(), 0.0) == 0.0)
+    for (size_t i = 0; i < block_cores.size(); i ++)
+      costs[i] = block_cores[i].n();
+
+  std::vector<size_t> order(block_cores.size());
+  for (size_t i = 0; i < order.size(); i ++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {return costs[i] > costs[j];});
+
+  std::vector<int> owners(block_cores.size());
+  std::vector<double> loads(comm.size(), 0.0);
+  for (const auto i : order) {
+    const int r = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    owners[i] = r;
+    loads[r] += costs[i];
+  }
+  block_owners[t] = owners;
+  std::fill(block_costs.begin(), block_costs.end(), 0.0);
+
+  // assignments before the current timestep are no longer needed
+  while (block_owners.size() > 1 && std::next(block_owners.begin())->first <= current_timestep)
+    block_owners.erase(block_owners.begin());
+
+  instr.add("blocks", std::count(owners.begin(), owners.end(), comm.rank()));
+}
+
+inline void regular_tracker::element_for_blocks(bool ordinal, int k, 
+    std::function<bool(const std::vector<int>&)> cell_filter,
+    std::function<void(element_t)> f)
+{
+  const auto &owners = get_block_owners(current_timestep);
+  const int scope = ordinal ? ELEMENT_SCOPE_ORDINAL : ELEMENT_SCOPE_INTERVAL;
+  for (size_t i = 0; i < block_cores.size(); i ++) {
+    if (owners[i] != comm.rank()) continue;
+
+    auto st = block_cores[i].starts(), sz = block_cores[i].sizes();
+    st.push_back(current_timestep);
+    sz.push_back(1);
+    lattice block_spacetime_domain(st, sz);
+
+    nsimplices_scanned += block_spacetime_domain.n() * m.ntypes(k, scope);
+    instr.add("simplices_scanned", block_spacetime_domain.n() * m.ntypes(k, scope));
+
+    const double t0 = instrumentation::now();
+    if (cell_filter)
+      m.element_for(k, block_spacetime_domain, scope, 
+          cell_filter, f, xl, nthreads, enable_set_affinity);
+    else 
+      m.element_for(k, block_spacetime_domain, scope, 
+          f, xl, nthreads, enable_set_affinity);
+    block_costs[i] += instrumentation::now() - t0;
+  }
+}
+
 inline void regular_tracker::element_for(bool ordinal, int k, std::function<void(element_t)> f) 
 {
+  if (!block_cores.empty()) {
+    element_for_blocks(ordinal, k, nullptr, f);
+    return;
+  }
+
   auto st = local_domain.starts(), sz = local_domain.sizes();
   st.push_back(current_timestep);
   sz.push_back(1);
@@ -144,11 +274,37 @@ inline void regular_tracker::element_for(bool ordinal, int k, std::function<void
   lattice local_spacetime_domain(st, sz);
   // std::cerr << local_spacetime_domain << std::endl;
 
-  m.element_for(k, local_spacetime_domain, 
-      ordinal ? ELEMENT_SCOPE_ORDINAL : ELEMENT_SCOPE_INTERVAL, 
+  const int scope = ordinal ? ELEMENT_SCOPE_ORDINAL : ELEMENT_SCOPE_INTERVAL;
+  nsimplices_scanned += local_spacetime_domain.n() * m.ntypes(k, scope);
+  instr.add("simplices_scanned", local_spacetime_domain.n() * m.ntypes(k, scope));
+
+  m.element_for(k, local_spacetime_domain, scope, 
       f, xl, nthreads, enable_set_affinity);
 }
 
+inline void regular_tracker::element_for(bool ordinal, int k, 
+    std::function<bool(const std::vector<int>&)> cell_filter,
+    std::function<void(element_t)> f)
+{
+  if (!block_cores.empty()) {
+    element_for_blocks(ordinal, k, cell_filter, f);
+    return;
+  }
+
+  auto st = local_domain.starts(), sz = local_domain.sizes();
+  st.push_back(current_timestep);
+  sz.push_back(1);
+
+  lattice local_spacetime_domain(st, sz);
+  
+  const int scope = ordinal ? ELEMENT_SCOPE_ORDINAL : ELEMENT_SCOPE_INTERVAL;
+  nsimplices_scanned += local_spacetime_domain.n() * m.ntypes(k, scope);
+  instr.add("simplices_scanned", local_spacetime_domain.n() * m.ntypes(k, scope));
+
+  m.element_for(k, local_spacetime_domain, scope, 
+      cell_filter, f, xl, nthreads, enable_set_affinity);
+}
+
 }
 
 
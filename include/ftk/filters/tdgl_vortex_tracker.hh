@@ -30,6 +30,8 @@ public:
 
 public:
   bool pop_field_data_snapshot();
+  
+  // only rho and phi are kept; they are derived from re and im if not given
   void push_field_data_snapshot(
       const tdgl_metadata_t &meta,
       const ndarray<float> &rho, 
@@ -37,11 +39,21 @@ public:
       const ndarray<float> &re, 
       const ndarray<float> &im 
   );
+  void push_field_data_snapshot(
+      const tdgl_metadata_t &meta,
+      const ndarray<float> &rho, 
+      const ndarray<float> &phi) { push_field_data_snapshot(meta, rho, phi, ndarray<float>(), ndarray<float>()); }
   
 protected:
   struct field_data_snapshot_t {
     tdgl_metadata_t meta;
-    ndarray<float> rho, phi, re, im;
+    ndarray<float> rho, phi;
+
+    float re(size_t i) const { return rho[i] * cos(phi[i]); } // derived on demand
+    float im(size_t i) const { return rho[i] * sin(phi[i]); }
+
+    // magnetic potential at vertices (3 per vertex), see tdgl_vortex_tracker_3d_regular
+    std::vector<float> potential;
   };
   std::deque<field_data_snapshot_t> field_data_snapshots;
 };
@@ -74,10 +86,18 @@ inline void tdgl_vortex_tracker::push_field_data_snapshot(
 {
   field_data_snapshot_t snapshot;
   snapshot.meta = meta;
-  snapshot.rho = rho;
-  snapshot.phi = phi;
-  snapshot.re = re;
-  snapshot.im = im;
+  if (!rho.empty() && !phi.empty()) {
+    snapshot.rho = rho;
+    snapshot.phi = phi;
+  } else if (!re.empty() && !im.empty()) {
+    snapshot.rho.reshape(re);
+    snapshot.phi.reshape(re);
+    for (size_t i = 0; i < re.nelem(); i ++) {
+      snapshot.rho[i] = std::sqrt(re[i] * re[i] + im[i] * im[i]);
+      snapshot.phi[i] = std::atan2(im[i], re[i]);
+    }
+  } else 
+    fatal("missing rho/phi or re/im in tdgl field data");
 
   field_data_snapshots.emplace_back(snapshot);
 }
@@ -63,13 +63,19 @@ protected:
   void simplex_values(
       const std::vector<std::vector<int>>& vertices,
       float X[][4],
-      float A[][3], 
-      float rho[], float phi[],
-      float re[], float im[]);
+      float rho[], float phi[]);
+
+  // The gauge-invariant phase shift along an edge is computed from the phases
+  // and magnetic potentials at its ends; the potential is computed once per 
+  // vertex of each snapshot and reused by all edges incident to the vertex.
+  // The shift is always evaluated from the lower to the higher vertex, such 
+  // that the shift of the reversed edge is exactly its negation.
+  void update_magnetic_potentials();
+  float edge_phase_shift(const std::vector<int>& v0, const std::vector<int>& v1) const;
 
   void magnetic_potential(const tdgl_metadata_t& m, const float X[3], float A[3]) const;
 
-  static float line_integral(float X0[], float X1[], float A0[], float A1[]);
+  static float line_integral(const float X0[], const float X1[], const float A0[], const float A1[]);
 
   // template <typename T> inline static T mod2pi(T x) { T y = fmod(x, 2*M_PI); if (y<0) y+= 2*M_PI; return y; }
   // template <typename T> static T mod2pi1(T x) { return mod2pi(x + M_PI) - M_PI; }
@@ -82,7 +88,7 @@ inline void tdgl_vortex_tracker_3d_regular::finalize()
   double max_accumulated_kernel_time;
   diy::mpi::reduce(comm, accumulated_kernel_time, max_accumulated_kernel_time, get_root_proc(), diy::mpi::maximum<double>());
   if (comm.rank() == get_root_proc())
-    fprintf(stderr, "max_accumulated_kernel_time=%f\n", accumulated_kernel_time);
+    fprintf(stderr, "max_accumulated_kernel_time=%f\n", max_accumulated_kernel_time);
   
   diy::mpi::gather(comm, intersections, intersections, get_root_proc());
   diy::mpi::gather(comm, related_cells, related_cells, get_root_proc());
@@ -169,18 +175,16 @@ inline bool tdgl_vortex_tracker_3d_regular::check_simplex(
   if (!e.valid(m)) return false; // check if the 2-simplex is valid
   const auto &vertices = e.vertices(m); // obtain the vertices of the simplex
 
-  float X[3][4], // coordinates
-        A[3][3]; // averaged magnetic potential
-  float rho[3], phi[3], re[3], im[3]; // values
-  simplex_values(vertices, X, A, rho, phi, re, im);
+  float X[3][4]; // coordinates
+  float rho[3], phi[3]; // values
+  simplex_values(vertices, X, rho, phi);
   // fprintf(stderr, "rho=%f, %f, %f, phi=%f, %f, %f\n", rho[0], rho[1], rho[2], phi[0], phi[1], phi[2]);
 
   // compute contour integral
   float delta[3], phase_shift = 0;
   for (int i = 0; i < 3; i ++) { // ignoring quasi periodical boundary conditions
     int j = (i+1) % 3;
-    float li = line_integral(X[i], X[j], A[i], A[j]);
-    delta[i] = mod2pi1( phi[j] - phi[i] - li ); // gauge transformation
+    delta[i] = edge_phase_shift(vertices[i], vertices[j]); // gauge transformation
     phase_shift -= delta[i];
   }
 
@@ -229,6 +233,7 @@ inline void tdgl_vortex_tracker_3d_regular::update_timestep()
   
   typedef std::chrono::high_resolution_clock clock_type;
   auto t0 = clock_type::now();
+  instrumentation::scoped_timer timer(instr, "update_timestep");
 
   auto get_relatetd_cels = [&](element_t e) {
     std::set<element_t> my_related_cells;
@@ -366,6 +371,7 @@ inline void tdgl_vortex_tracker_3d_regular::update_timestep()
     fatal("FTK not compiled with CUDA.");
 #endif
   } else {
+    update_magnetic_potentials();
     element_for_ordinal(2, func);
     if (field_data_snapshots.size() >= 2) 
       element_for_interval(2, func);
@@ -378,9 +384,7 @@ inline void tdgl_vortex_tracker_3d_regular::update_timestep()
 inline void tdgl_vortex_tracker_3d_regular::simplex_values(
       const std::vector<std::vector<int>>& vertices,
       float X[][4],
-      float A[][3],
-      float rho[], float phi[],
-      float re[], float im[])
+      float rho[], float phi[])
 {
   for (int i = 0; i < vertices.size(); i ++) {
     const int iv = vertices[i][3] == current_timestep ? 0 : 1;
@@ -392,18 +396,71 @@ inline void tdgl_vortex_tracker_3d_regular::simplex_values(
           vertices[i][2] - local_array_domain.start(2)}));
     rho[i] = f.rho[idx];
     phi[i] = f.phi[idx];
-    re[i] = f.re[idx];
-    im[i] = f.im[idx];
     
     for (int j = 0; j < 3; j ++)
       X[i][j] = vertices[i][j] * f.meta.cell_lengths[j] + f.meta.origins[j];
     X[i][3] = vertices[i][3];
-      
-    magnetic_potential(f.meta, X[i], A[i]);
   }
 }
+
+inline void tdgl_vortex_tracker_3d_regular::update_magnetic_potentials()
+{
+  instrumentation::scoped_timer timer(instr, "update_magnetic_potentials");
+
+  // potentials are computed once per snapshot and reused in the next timestep
+  for (auto i = 0; i < std::min(field_data_snapshots.size(), size_t(2)); i ++) {
+    auto &f = field_data_snapshots[i];
+    if (!f.potential.empty()) continue;
+
+    const int d0 = f.rho.dim(0), d1 = f.rho.dim(1), d2 = f.rho.dim(2);
+    const int st[3] = {
+      static_cast<int>(local_array_domain.start(0)), 
+      static_cast<int>(local_array_domain.start(1)), 
+      static_cast<int>(local_array_domain.start(2))};
+    f.potential.resize(f.rho.nelem() * 3);
+
+    parallel_for(d2, [&](int z) {
+      for (int y = 0; y < d1; y ++)
+        for (int x = 0; x < d0; x ++) {
+          const int v[3] = {x + st[0], y + st[1], z + st[2]};
+          float X[3];
+          for (int j = 0; j < 3; j ++)
+            X[j] = v[j] * f.meta.cell_lengths[j] + f.meta.origins[j];
+          magnetic_potential(f.meta, X, &f.potential[(x + size_t(d0) * (y + size_t(d1) * z)) * 3]);
+        }
+    }, get_thread_backend(), nthreads, enable_set_affinity);
+  }
+}
+
+inline float tdgl_vortex_tracker_3d_regular::edge_phase_shift(
+    const std::vector<int>& v0, const std::vector<int>& v1) const
+{
+  // vertices of a simplex are ordered componentwise in the triangulation
+  bool forward = true;
+  for (int j = 0; j < 4; j ++)
+    if (v1[j] < v0[j]) forward = false;
+  const std::vector<int>* ends[2] = {forward ? &v0 : &v1, forward ? &v1 : &v0}; // lo, hi
+
+  float X[2][3], phi[2];
+  const float *A[2];
+  for (int i = 0; i < 2; i ++) {
+    const auto &v = *ends[i];
+    const auto &f = field_data_snapshots[v[3] == current_timestep ? 0 : 1];
+    const size_t k = f.rho.index(std::vector<size_t>({
+          v[0] - local_array_domain.start(0), 
+          v[1] - local_array_domain.start(1), 
+          v[2] - local_array_domain.start(2)}));
+    for (int j = 0; j < 3; j ++)
+      X[i][j] = v[j] * f.meta.cell_lengths[j] + f.meta.origins[j];
+    A[i] = &f.potential[k * 3];
+    phi[i] = f.phi[k];
+  }
+  
+  const float raw = phi[1] - phi[0] - line_integral(X[0], X[1], A[0], A[1]);
+  return mod2pi1(forward ? raw : -raw);
+}
   
-inline float tdgl_vortex_tracker_3d_regular::line_integral(float X0[], float X1[], float A0[], float A1[])
+inline float tdgl_vortex_tracker_3d_regular::line_integral(const float X0[], const float X1[], const float A0[], const float A1[])
 {
   float dX[3] = {X1[0] - X0[0], X1[1] - X0[1], X1[2] - X0[2]};
   float A[3]  = {A0[0] + A1[0], A0[1] + A1[1], A0[2] + A1[2]};
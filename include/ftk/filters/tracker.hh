@@ -4,6 +4,7 @@
 #include <ftk/config.hh>
 #include <ftk/ndarray/field_data_snapshot.hh>
 #include <ftk/filters/filter.hh>
+#include <ftk/utils/checkpoint.hh>
 #include <ftk/external/diy/master.hpp>
 
 namespace ftk {
@@ -34,6 +35,8 @@ struct tracker : public filter
   
   virtual void set_current_timestep(int t) {current_timestep = t;}
   int get_current_timestep() const {return current_timestep;}
+
+  double get_accumulated_kernel_time() const {return accumulated_kernel_time;}
  
   void set_input_array_partial(bool b) {is_input_array_partial = b;}
   void set_use_default_domain_partition(bool b) {use_default_domain_partition = true;}
@@ -47,6 +50,24 @@ public:
   virtual bool advance_timestep() = 0;
   virtual void update_timestep() = 0;
 
+public: // checkpoint and restart; the state is taken after advance_timestep(), so
+  // that the tracking resumes with the timestep after get_current_timestep().
+  // Checkpoints are numbered by epochs and alternate between two files per 
+  // process; an epoch is reused only after all processes have written the 
+  // next one, so that a crash at any time leaves an epoch that every process
+  // has written.  Both functions are collective.
+  void write_checkpoint(const std::string& filename); // asynchronous
+  bool read_checkpoint(const std::string& filename); // false if any process has no checkpoint
+  void wait_for_checkpoint() { ckpt.wait(); }
+
+  virtual void save_checkpoint(diy::BinaryBuffer&) const { fatal("checkpointing not supported by the tracker"); }
+  virtual void load_checkpoint(diy::BinaryBuffer&) { fatal("checkpointing not supported by the tracker"); }
+
+  std::string checkpoint_filename(const std::string& filename, int epoch) const { // of this process
+    return (comm.size() > 1 ? filename + "." + std::to_string(comm.rank()) : filename) 
+      + "." + std::to_string(epoch % 2);
+  }
+
 protected:
   std::deque<field_data_snapshot> snapshots;
 
@@ -65,8 +86,70 @@ protected:
 
 protected: // benchmark
   double accumulated_kernel_time = 0.0;
+
+protected:
+  checkpointer ckpt;
+  int checkpoint_epoch = 0; // of the next checkpoint
 };
 
+////////
+inline void tracker::write_checkpoint(const std::string& filename)
+{
+  instrumentation::scoped_timer timer(instr, "checkpoint");
+
+  // the file of the new epoch holds the epoch before the previous one, which
+  // may be overwritten only if all processes have written the previous epoch;
+  // otherwise the previous epoch is overwritten instead
+  if (checkpoint_epoch > 0) {
+    int succ = ckpt.wait(), all_succ = 0;
+    diy::mpi::all_reduce(comm, succ, all_succ, diy::mpi::minimum<int>());
+    if (!all_succ) checkpoint_epoch --;
+  }
+
+  std::string buf;
+  diy::StringBuffer bb(buf);
+  diy::save(bb, comm.size());
+  diy::save(bb, checkpoint_epoch);
+  save_checkpoint(bb);
+
+  ckpt.write_async(checkpoint_filename(filename, checkpoint_epoch), std::move(buf));
+  checkpoint_epoch ++;
+}
+
+inline bool tracker::read_checkpoint(const std::string& filename)
+{
+  // the latest epoch written by all processes
+  std::string bufs[2];
+  int epochs[2] = {-1, -1}, latest = -1, epoch = -1;
+  for (int i = 0; i < 2; i ++) {
+    if (!checkpointer::read(checkpoint_filename(filename, i), bufs[i]))
+      continue;
+
+    diy::StringBuffer bb(bufs[i]);
+    int np;
+    diy::load(bb, np);
+    if (np != comm.size())
+      fatal("the checkpoint was written with a different number of processes");
+    diy::load(bb, epochs[i]);
+    latest = std::max(latest, epochs[i]);
+  }
+  diy::mpi::all_reduce(comm, latest, epoch, diy::mpi::minimum<int>());
+  if (epoch < 0) 
+    return false; // all processes start from scratch
+
+  std::string &buf = bufs[epoch % 2];
+  if (epochs[epoch % 2] != epoch)
+    fatal("inconsistent checkpoints across processes");
+
+  diy::StringBuffer bb(buf);
+  int np;
+  diy::load(bb, np);
+  diy::load(bb, epoch);
+  load_checkpoint(bb);
+  checkpoint_epoch = epoch + 1;
+  return true;
+}
+
 ////////
 inline int tracker::str2tracker(const std::string& s) 
 {
@@ -86,6 +169,8 @@ inline int tracker::str2tracker(const std::string& s)
     return TRACKER_LEVY_DEGANI_SEGINER;
   else if (s == "cc" || s == "connected_component" || s == "connected_components")
     return TRACKER_CONNECTED_COMPONENTS;
+  else if (s == "threshold")
+    return TRACKER_THRESHOLD;
   else if (s == "xgc_blob_filament" || s == "xgc-blob-filament")
     return TRACKER_XGC_BLOB_FILAMENT;
   else if (s == "xgc_blob_threshold" || s == "xgc-blob-threshold")
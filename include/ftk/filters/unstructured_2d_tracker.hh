@@ -14,7 +14,7 @@ struct unstructured_2d_tracker : public virtual tracker {
   virtual ~unstructured_2d_tracker() {}
 
 public:
-  void initialize() {}
+  void initialize() {initialize_number_of_threads();}
 
 protected:
   const simplicial_unstructured_extruded_2d_mesh<> m;
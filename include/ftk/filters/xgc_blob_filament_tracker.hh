@@ -154,9 +154,11 @@ xgc_blob_filament_tracker::~xgc_blob_filament_tracker()
 inline void xgc_blob_filament_tracker::update_vector_field_scaling_factor(int minbits, int maxbits)
 {
   // vector_field_resolution = std::numeric_limits<double>::max();
-  for (const auto &s : field_data_snapshots) {
+  for (auto &s : field_data_snapshots) {
     // vector_field_resolution = std::min(vector_field_resolution, s.vector.resolution());
-    vector_field_maxabs = std::max(vector_field_maxabs, s.vector.maxabs());
+    if (s.vector_maxabs < 0)
+      s.vector_maxabs = s.vector.maxabs();
+    vector_field_maxabs = std::max(vector_field_maxabs, s.vector_maxabs);
   }
 
   vector_field_scaling_factor = std::exp2(-std::ceil(std::log2(vector_field_maxabs)) + 60); // 20 bits
@@ -179,6 +181,8 @@ inline void xgc_blob_filament_tracker::update_vector_field_scaling_factor(int mi
 
 inline void xgc_blob_filament_tracker::initialize()
 {
+  initialize_number_of_threads();
+
 #if FTK_HAVE_CUDA
   if (xl == FTK_XL_CUDA) {
     int device = device_ids.empty() ? 0 : device_ids[0];
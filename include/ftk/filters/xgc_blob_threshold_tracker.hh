@@ -22,7 +22,7 @@ struct xgc_blob_threshold_tracker : public xgc_tracker {
 
   int cpdims() const { return 0; }
   
-  void initialize() {}
+  void initialize() {initialize_number_of_threads();}
   void update() {}
   void finalize();
 
@@ -46,6 +46,7 @@ public:
 protected:
   struct field_data_snapshot_t {
     ndarray<double> scalar, vector, jacobian;
+    double vector_maxabs = -1; // cached vector.maxabs(); negative if not computed yet
   };
   std::deque<field_data_snapshot_t> field_data_snapshots;
 
@@ -2,97 +2,66 @@
 #define _FTK_CC2CURVE_HH
 
 #include <ftk/algorithms/cca.hh>
-#include <list>
+#include <ftk/basic/concurrent_union_find.hh>
+#include <ftk/object.hh>
+#include <algorithm>
+#include <deque>
 #include <set>
 
 namespace ftk {
 
-template <typename NodeType>
-std::vector<std::vector<NodeType>> connected_component_to_linear_components(
-    const std::set<NodeType>& connected_component,
-    const std::function<std::set<NodeType>(NodeType)>& neighbors)
+template <typename I>
+bool is_loop(const std::vector<I>& linear_graph, const std::vector<std::vector<I>>& neighbors) // w/ neighbor table
 {
-  std::vector<std::vector<NodeType>> linear_components;
-  if (connected_component.empty())
-    return linear_components;
+  if (linear_graph.size() <= 1) return false;
+  const auto &front_neighbors = neighbors[linear_graph.front()];
+  return std::binary_search(front_neighbors.begin(), front_neighbors.end(), linear_graph.back());
+}
 
-  std::set<NodeType> ordinary_nodes, special_nodes;
-  for (const auto node : connected_component) {
-    std::vector<NodeType> valid_neighbors;
-    for (const auto neighbor : neighbors(node))
-      if (neighbor != node && connected_component.find(neighbor) != connected_component.end())
-        valid_neighbors.push_back(neighbor);
+// Linear graphs of a connected component, given the neighbor table of the 
+// nodes (indices, sorted, excluding the node itself).  All neighbors of a 
+// node are assumed to be in the same component.  Nodes with more than two 
+// neighbors are special and do not belong to any linear graph.  The visited 
+// flags may be shared by disjoint components processed concurrently.
+template <typename I>
+std::vector<std::vector<I>> connected_component_to_linear_components(
+    const std::vector<I>& connected_component, // sorted
+    const std::vector<std::vector<I>>& neighbors,
+    std::vector<char>& visited)
+{
+  auto special = [&](I node) {return neighbors[node].size() > 2;};
 
-    if (valid_neighbors.size() > 2) {
-      // std::cerr << "deg=" << valid_neighbors.size() << "," << node << std::endl;
-      special_nodes.insert(node);
-    }
-    else ordinary_nodes.insert(node);
-  }
+  // each unvisited ordinary node seeds the linear graph through it, and is 
+  // the smallest node of the graph as nodes are visited in order
+  std::vector<std::vector<I>> linear_components;
+  for (const auto seed : connected_component) {
+    if (special(seed) || visited[seed]) continue;
 
-  // connected components of ordinary nodes
-  auto cc = extract_connected_components<NodeType, std::set<NodeType>>(
-      [connected_component, neighbors, special_nodes](NodeType node) { // neighbor function
-        auto my_neighbors = neighbors(node);
-        for (auto it = my_neighbors.begin(); it != my_neighbors.end(); ) 
-          if (connected_component.find(*it) == connected_component.end() 
-              || special_nodes.find(*it) != special_nodes.end())
-            it = my_neighbors.erase(it);
-          else it ++;
-        return my_neighbors;
-      }, ordinary_nodes);
-
-  // sort the linear graphs
-  // fprintf(stderr, "#nodes=%lu, #linear graphs=%lu\n", connected_component.size(), cc.size());
-  for (auto &c : cc) {
-    std::list<NodeType> trace;
-    std::set<NodeType> visited;
-
-    const size_t cs = c.size();
-
-    auto seed = *c.begin();
-    visited.insert(seed);
+    std::deque<I> trace;
+    visited[seed] = 1;
     trace.push_back(seed);
-    // c.erase(c.begin());
-
-    // fprintf(stderr, "#node=%lu\n", c.size());
-    // std::cerr << "seed: " << seed << std::endl;
 
-    std::set<NodeType> seed_neighbors; 
-    for (auto my_neighbor : neighbors(seed))
-      if (my_neighbor != seed && ordinary_nodes.find(my_neighbor) != ordinary_nodes.end())
-        seed_neighbors.insert(my_neighbor);
-    // if (seed_neighbors.size() > 2) 
-    //   fprintf(stderr, "ERROR: #sn=%zu\n", seed_neighbors.size());
+    std::vector<I> seed_neighbors;
+    for (const auto neighbor : neighbors[seed])
+      if (!special(neighbor))
+        seed_neighbors.push_back(neighbor);
 
     for (int dir = 0; dir < 2; dir ++) {
       if (seed_neighbors.size() == 0) break;
 
-      NodeType current = dir == 0 ? (*seed_neighbors.begin()) : (*seed_neighbors.rbegin());
-      // bool first_iteration = true;
-      // fprintf(stderr, "dir=%d\n", dir);
+      I current = dir == 0 ? seed_neighbors.front() : seed_neighbors.back();
       while (1) {
-        // if (first_iteration) first_iteration = false;
-        // else {
-        // }
-       
-        if (visited.find(current) == visited.end()) {
+        if (!visited[current]) {
           if (dir == 0) trace.push_back(current);
-          else (trace.push_front(current));
-          visited.insert(current);
+          else trace.push_front(current);
+          visited[current] = 1;
         }
-        // c.erase(current);
 
         bool found_next = false;
-        for (auto my_neighbor : neighbors(current)) {
-          if (my_neighbor != current && 
-              c.find(my_neighbor) != c.end() && 
-              // connected_component.find(my_neighbor) != connected_component.end() &&
-              // special_nodes.find(my_neighbor) != special_nodes.end() && // TODO: handle special nodes
-              visited.find(my_neighbor) == visited.end()) 
-          {
+        for (const auto neighbor : neighbors[current]) {
+          if (!special(neighbor) && !visited[neighbor]) {
             found_next = true;
-            current = my_neighbor;
+            current = neighbor;
             break;
           }
         }
@@ -100,13 +69,147 @@ std::vector<std::vector<NodeType>> connected_component_to_linear_components(
       }
       if (seed_neighbors.size() == 1) break; // only one direction available
     }
-    // fprintf(stderr, "trace.size=%lu\n", trace.size());
 
-    if (trace.size() != c.size())
-       fprintf(stderr, "ERROR: trace.size=%zu, c.size=%zu\n", trace.size(), cs);
-    linear_components.push_back(std::vector<NodeType>({trace.begin(), trace.end()}));
+    linear_components.push_back(std::vector<I>(trace.begin(), trace.end()));
   }
+
+  return linear_components;
+}
+
+template <typename NodeType>
+std::vector<std::vector<NodeType>> connected_component_to_linear_components(
+    const std::set<NodeType>& connected_component,
+    const std::function<std::set<NodeType>(NodeType)>& neighbors)
+{
+  std::vector<std::vector<NodeType>> linear_components;
+  if (connected_component.empty())
+    return linear_components;
+
+  // neighbor table of the component, evaluated once per node
+  const std::vector<NodeType> nodes(connected_component.begin(), connected_component.end());
+  std::vector<std::vector<int>> table(nodes.size());
+  for (size_t i = 0; i < nodes.size(); i ++)
+    for (const auto neighbor : neighbors(nodes[i])) {
+      const auto it = std::lower_bound(nodes.begin(), nodes.end(), neighbor);
+      if (it != nodes.end() && *it == neighbor && neighbor != nodes[i])
+        table[i].push_back(it - nodes.begin());
+    }
+
+  std::vector<int> component(nodes.size());
+  for (size_t i = 0; i < nodes.size(); i ++)
+    component[i] = i;
+  std::vector<char> visited(nodes.size(), 0);
+
+  for (const auto &lc : connected_component_to_linear_components<int>(component, table, visited)) {
+    std::vector<NodeType> linear_component;
+    for (const auto i : lc)
+      linear_component.push_back(nodes[i]);
+    linear_components.push_back(linear_component);
+  }
+  
+  return linear_components;
+}
+
+// Connected components of the nodes (sorted and unique) and the neighbor 
+// table (see above) used to find them.  The neighbors of all nodes are 
+// evaluated concurrently and the components are found with a concurrent 
+// union-find; each component is given by node indices in ascending order, 
+// and components are sorted by their smallest nodes.
+template <typename NodeType>
+std::vector<std::vector<int>> extract_connected_components_parallel(
+    const std::vector<NodeType>& nodes,
+    const std::function<std::set<NodeType>(NodeType)>& neighbors,
+    std::vector<std::vector<int>>& table,
+    int thread_backend, int nthreads, bool affinity)
+{
+  const int n = nodes.size();
+  table.clear();
+  table.resize(n);
   
+  object::parallel_for(n, [&](int i) {
+    for (const auto &neighbor : neighbors(nodes[i])) {
+      const auto it = std::lower_bound(nodes.begin(), nodes.end(), neighbor);
+      if (it != nodes.end() && *it == neighbor && neighbor != nodes[i])
+        table[i].push_back(it - nodes.begin());
+    }
+  }, thread_backend, nthreads, affinity);
+
+  concurrent_union_find<int> uf(n);
+  object::parallel_for(n, [&](int i) {
+    for (const auto j : table[i])
+      uf.unite(i, j);
+  }, thread_backend, nthreads, affinity);
+
+  // roots are the smallest nodes of the components
+  std::vector<int> component_id(n, -1);
+  std::vector<std::vector<int>> components;
+  for (int i = 0; i < n; i ++) {
+    const int r = uf.find(i);
+    if (r == i) {
+      component_id[i] = components.size();
+      components.push_back(std::vector<int>());
+    }
+    components[component_id[r]].push_back(i);
+  }
+
+  return components;
+}
+
+// Orients a linear graph to start from the end w/ the smaller key, or 
+// rotates a loop to start from its smallest key and continue to the smaller 
+// of the two neighbors; keys are unique (e.g. tags), so that the result does 
+// not depend on the order in which nodes are given.
+template <typename I, typename Key>
+void canonicalize_linear_component(std::vector<I>& linear_graph, bool loop, const Key& key)
+{
+  if (linear_graph.size() <= 1) return;
+  if (loop) {
+    auto first = std::min_element(linear_graph.begin(), linear_graph.end(), 
+        [&](I a, I b) {return key(a) < key(b);});
+    std::rotate(linear_graph.begin(), first, linear_graph.end());
+    if (key(linear_graph.back()) < key(linear_graph[1]))
+      std::reverse(linear_graph.begin() + 1, linear_graph.end());
+  } else if (key(linear_graph.back()) < key(linear_graph.front()))
+    std::reverse(linear_graph.begin(), linear_graph.end());
+}
+
+// Linear graphs of all nodes with one task per connected component; the 
+// results are node indices, ordered by component, and loops[i] tells if 
+// the i-th linear graph is a loop.  If key (unique per node) is given, 
+// linear graphs are canonicalized, so results do not depend on node order.
+template <typename NodeType>
+std::vector<std::vector<int>> nodes_to_linear_components_parallel(
+    const std::vector<NodeType>& nodes,
+    const std::function<std::set<NodeType>(NodeType)>& neighbors,
+    std::vector<bool>& loops,
+    int thread_backend, int nthreads, bool affinity,
+    const std::function<unsigned long long(int)>& key = nullptr)
+{
+  std::vector<std::vector<int>> table;
+  const auto components = extract_connected_components_parallel<NodeType>(
+      nodes, neighbors, table, thread_backend, nthreads, affinity);
+
+  std::vector<char> visited(nodes.size(), 0);
+  std::vector<std::vector<std::vector<int>>> component_linear_components(components.size());
+  std::vector<std::vector<bool>> component_loops(components.size());
+  object::parallel_for(components.size(), [&](int i) {
+    component_linear_components[i] = connected_component_to_linear_components<int>(
+        components[i], table, visited);
+    for (auto &lc : component_linear_components[i]) {
+      component_loops[i].push_back(is_loop(lc, table));
+      if (key)
+        canonicalize_linear_component(lc, component_loops[i].back(), key);
+    }
+  }, thread_backend, nthreads, affinity);
+
+  std::vector<std::vector<int>> linear_components;
+  loops.clear();
+  for (size_t i = 0; i < components.size(); i ++)
+    for (size_t j = 0; j < component_linear_components[i].size(); j ++) {
+      loops.push_back(component_loops[i][j]);
+      linear_components.push_back(std::move(component_linear_components[i][j]));
+    }
+
   return linear_components;
 }
 
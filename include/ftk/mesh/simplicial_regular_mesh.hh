@@ -15,6 +15,10 @@
 #include <cassert>
 #include <iterator>
 #include <functional>
+#include <map>
+#include <array>
+#include <memory>
+#include <mutex>
 #include <ftk/object.hh>
 #include <ftk/mesh/lattice.hh>
 #include <ftk/external/diy/serialization.hpp>
@@ -35,6 +39,11 @@ enum {
   ELEMENT_SCOPE_INTERVAL = 2
 };
 
+enum { // order in which element_for visits cells
+  ELEMENT_TRAVERSAL_ROW_MAJOR = 0,
+  ELEMENT_TRAVERSAL_MORTON = 1 // tiles of cells in parallel, cells in z-order within a tile
+};
+
 struct simplicial_regular_mesh;
 
 struct simplicial_regular_mesh_element {
@@ -88,6 +97,31 @@ struct simplicial_regular_mesh_element {
 };
 
 
+// Unit-simplex tables of the subdivided unit n-cube.  The tables depend only
+// on the dimensionality; they are built once on first use and shared by all
+// meshes of the same dimensionality.
+struct simplicial_regular_mesh_tables {
+  std::vector<int> ntypes, ntypes_ordinal, ntypes_interval; // number of types for k-simplex
+
+  // list of k-simplices types; each simplex contains k vertices
+  // unit_simplices[d][type] retunrs d+1 vertices that build up the simplex
+  std::vector<std::vector<std::vector<std::vector<int>>>> unit_simplices;
+
+  std::vector<std::vector<int>> unit_ordinal_simplex_types, 
+                                unit_interval_simplex_types;
+  
+  std::vector<std::vector<bool>> is_unit_simplex_type_ordinal;
+  
+  // (dim,type) --> vector of (type,offset)
+  std::vector<std::vector<std::vector<std::tuple<int, std::vector<int>>>>> unit_simplex_sides;
+  std::vector<std::vector<std::vector<std::tuple<int, std::vector<int>>>>> unit_simplex_side_of;
+
+  // flat vertex offsets, unit_simplex_offsets[d][scope] is an array of 
+  // ntypes(d, scope) x (d+1) x n ints, in the same layout as the tables of 
+  // the flat-index kernels
+  std::vector<std::array<std::vector<int>, 3>> unit_simplex_offsets;
+};
+
 struct simplicial_regular_mesh : public object {
   friend class simplicial_regular_mesh_element;
   typedef simplicial_regular_mesh_element iterator;
@@ -132,7 +166,10 @@ struct simplicial_regular_mesh : public object {
   size_t n_interval(int d) const;
 
   // Returns d+1 vertices that build up the d-dimensional simplex of the given type
-  std::vector<std::vector<int>> unit_simplex(int d, int t) const {return unit_simplices[d][t];}
+  const std::vector<std::vector<int>>& unit_simplex(int d, int t) const {return tables_->unit_simplices[d][t];}
+
+  // Flat vertex offsets of d-simplices in the given scope, (type, vertex, dim) in the row-major order
+  const int* unit_simplex_offsets(int d, int scope = ELEMENT_SCOPE_ALL) const {return tables_->unit_simplex_offsets[d][scope].data();}
 
   void get_lb_ub(std::vector<int>& lb, std::vector<int>& ub) {lb = lb_; ub = ub_;}
   template <typename I=int> void set_lb_ub(const std::vector<I>& lb, const std::vector<I>& ub);
@@ -145,6 +182,13 @@ struct simplicial_regular_mesh : public object {
 
   const lattice& get_lattice() const {return lattice_; }
 
+  // The row-major traversal maps each work index to one simplex, and threads 
+  // take strided work indices.  The morton traversal hands each thread whole 
+  // tiles of cells, visits cells of a tile in z-order, and visits all 
+  // simplices of a cell together, such that vertex data are loaded once per tile.
+  void set_traversal(int t) {traversal_ = t;}
+  int get_traversal() const {return traversal_;}
+
   iterator element_begin(int d, int scope = ELEMENT_SCOPE_ALL);
   iterator element_end(int d, int scope = ELEMENT_SCOPE_ALL);
 
@@ -172,6 +216,16 @@ struct simplicial_regular_mesh : public object {
       int nthreads=std::thread::hardware_concurrency(), 
       bool affinity = false) const;
 
+  // Cell-wise iteration: the cell filter is evaluated once per cell (given the
+  // corner of the cell), and all d-simplices of the cell are skipped if the
+  // filter returns false.
+  void element_for(int d, const lattice& subdomain, int scope,
+      std::function<bool(const std::vector<int>&)> cell_filter,
+      std::function<void(simplicial_regular_mesh_element)> f,
+      int accelerator = FTK_XL_NONE,
+      int nthreads=std::thread::hardware_concurrency(),
+      bool affinity = false) const;
+
 #if 0
 public: // partitioning
   void partition(int np, std::vector<std::tuple<simplicial_regular_mesh, simplicial_regular_mesh>>& partitions);  
@@ -212,30 +266,29 @@ private: // initialization functions
   // Enumerate all element that contains the specific type of k-simplex
   std::vector<std::tuple<int, std::vector<int>>> enumerate_unit_simplex_side_of(int k, int type);
 
-  void derive_ordinal_and_interval_simplices();
+  void derive_ordinal_and_interval_simplices(simplicial_regular_mesh_tables&) const;
+  void derive_unit_simplex_offsets(simplicial_regular_mesh_tables&) const;
+
+  // types of d-simplices in the given scope
+  std::vector<int> scope_types(int d, int scope) const;
+
+  // iterate cells (corners) of the lattice in the morton traversal
+  void cell_for_morton(const lattice& l, 
+      std::function<void(const std::vector<int>&)> f,
+      int accelerator, int nthreads, bool affinity) const;
 
   // bool is_simplex_identical(const std::vector<std::string>&, const std::vector<std::string>&) const;
 
 private:
   const int nd_;
   std::vector<int> lb_, ub_; // lower and upper bounds of each dimension
-  std::vector<int> ntypes_, ntypes_ordinal_, ntypes_interval_; // number of types for k-simplex
   std::vector<int> dimprod_;
 
   struct lattice lattice_; 
 
-  // list of k-simplices types; each simplex contains k vertices
-  // unit_simplices[d][type] retunrs d+1 vertices that build up the simplex
-  std::vector<std::vector<std::vector<std::vector<int>>>> unit_simplices;
+  std::shared_ptr<const simplicial_regular_mesh_tables> tables_;
 
-  std::vector<std::vector<int>> unit_ordinal_simplex_types, 
-                                unit_interval_simplex_types;
-  
-  std::vector<std::vector<bool>> is_unit_simplex_type_ordinal;
-  
-  // (dim,type) --> vector of (type,offset)
-  std::vector<std::vector<std::vector<std::tuple<int, std::vector<int>>>>> unit_simplex_sides;
-  std::vector<std::vector<std::vector<std::tuple<int, std::vector<int>>>>> unit_simplex_side_of;
+  int traversal_ = ELEMENT_TRAVERSAL_ROW_MAJOR;
 };
 
 
@@ -313,15 +366,13 @@ inline bool simplicial_regular_mesh_element::valid(const simplicial_regular_mesh
 
 inline std::vector<std::vector<int> > simplicial_regular_mesh_element::vertices(const simplicial_regular_mesh& m) const
 {
-  std::vector<std::vector<int>> vertices;
+  const int nd = m.nd();
+  const int *offsets = m.unit_simplex_offsets(dim) + type * (dim+1) * nd;
 
-  const auto unit_vertices = m.unit_simplex(dim, type);
-  vertices.resize(unit_vertices.size());
-  for (size_t i = 0; i < unit_vertices.size(); i ++) {
-    for (int j = 0; j < m.nd(); j ++) {
-      vertices[i].push_back(corner[j] + unit_vertices[i][j]);
-    }
-  }
+  std::vector<std::vector<int>> vertices(dim+1, std::vector<int>(nd));
+  for (int i = 0; i <= dim; i ++)
+    for (int j = 0; j < nd; j ++)
+      vertices[i][j] = corner[j] + offsets[i*nd + j];
 
   return vertices;
 }
@@ -423,8 +474,8 @@ inline void simplicial_regular_mesh_element::from_work_index(const simplicial_re
   const auto itype = i % m.ntypes(dim, scope);
   auto ii = i / m.ntypes(dim, scope);
  
-  if (scope == ELEMENT_SCOPE_ORDINAL) type = m.unit_ordinal_simplex_types[dim][itype];
-  else if (scope == ELEMENT_SCOPE_INTERVAL) type = m.unit_interval_simplex_types[dim][itype];
+  if (scope == ELEMENT_SCOPE_ORDINAL) type = m.tables_->unit_ordinal_simplex_types[dim][itype];
+  else if (scope == ELEMENT_SCOPE_INTERVAL) type = m.tables_->unit_interval_simplex_types[dim][itype];
   else type = itype;
 
   corner = l.from_integer(ii);
@@ -511,7 +562,7 @@ void simplicial_regular_mesh_element::from_index(const std::tuple<std::array<int
 
 inline std::vector<simplicial_regular_mesh_element> simplicial_regular_mesh_element::sides(const simplicial_regular_mesh& m) const
 {
-  const auto &unit_simplex_sides = m.unit_simplex_sides[dim][type];
+  const auto &unit_simplex_sides = m.tables_->unit_simplex_sides[dim][type];
   std::vector<simplicial_regular_mesh_element> sides;
 
   for (auto s : unit_simplex_sides) {
@@ -527,7 +578,7 @@ inline std::vector<simplicial_regular_mesh_element> simplicial_regular_mesh_elem
 
 inline std::vector<simplicial_regular_mesh_element> simplicial_regular_mesh_element::side_of(const simplicial_regular_mesh& m) const
 {
-  const auto &unit_simplex_side_of = m.unit_simplex_side_of[dim][type];
+  const auto &unit_simplex_side_of = m.tables_->unit_simplex_side_of[dim][type];
   std::vector<simplicial_regular_mesh_element> side_of;
 
   for (auto s : unit_simplex_side_of) {
@@ -543,7 +594,7 @@ inline std::vector<simplicial_regular_mesh_element> simplicial_regular_mesh_elem
 
 inline bool simplicial_regular_mesh_element::is_ordinal(const simplicial_regular_mesh& m) const
 {
-  return m.is_unit_simplex_type_ordinal[dim][type];
+  return m.tables_->is_unit_simplex_type_ordinal[dim][type];
 }
 
 /////
@@ -551,9 +602,9 @@ inline bool simplicial_regular_mesh_element::is_ordinal(const simplicial_regular
 inline int simplicial_regular_mesh::ntypes(int d, int scope) const 
 {
   switch (scope) {
-  case ELEMENT_SCOPE_ALL: return ntypes_.at(d);
-  case ELEMENT_SCOPE_ORDINAL: return ntypes_ordinal_.at(d);
-  case ELEMENT_SCOPE_INTERVAL: return ntypes_interval_.at(d);
+  case ELEMENT_SCOPE_ALL: return tables_->ntypes.at(d);
+  case ELEMENT_SCOPE_ORDINAL: return tables_->ntypes_ordinal.at(d);
+  case ELEMENT_SCOPE_INTERVAL: return tables_->ntypes_interval.at(d);
   default: return 0;
   }
 }
@@ -705,8 +756,8 @@ inline std::vector<std::tuple<int, std::vector<int>>> simplicial_regular_mesh::e
 
   std::set<std::tuple<int, std::vector<int>>> mysides;
 
-  auto simplex = unit_simplices[k][type]; 
-  const auto k_minums_one_simplices = unit_simplices[k-1]; 
+  auto simplex = tables_->unit_simplices[k][type]; 
+  const auto &k_minums_one_simplices = tables_->unit_simplices[k-1]; 
     
   do {
     std::vector<std::vector<int>> side = simplex;
@@ -737,7 +788,7 @@ inline std::vector<std::tuple<int, std::vector<int>>> simplicial_regular_mesh::e
   return sides;
 }
 
-inline void simplicial_regular_mesh::derive_ordinal_and_interval_simplices()
+inline void simplicial_regular_mesh::derive_ordinal_and_interval_simplices(simplicial_regular_mesh_tables& tables) const
 {
   for (int d = 0; d < nd()+1; d ++) {
     std::vector<int> ordinal_simplex_types, interval_simplex_types;
@@ -748,7 +799,7 @@ inline void simplicial_regular_mesh::derive_ordinal_and_interval_simplices()
       is_type_ordinal.push_back(true);
     } else {
       for (int t = 0; t < ntypes(d); t ++) {
-        const auto simplex = unit_simplices[d][t];
+        const auto &simplex = tables.unit_simplices[d][t];
         int time = 0;
         for (int i = 0; i < simplex.size(); i ++) {
           time = time + simplex[i][nd()-1];
@@ -763,11 +814,28 @@ inline void simplicial_regular_mesh::derive_ordinal_and_interval_simplices()
       }
     }
 
-    unit_ordinal_simplex_types.push_back(ordinal_simplex_types);
-    unit_interval_simplex_types.push_back(interval_simplex_types);
-    ntypes_ordinal_.push_back(ordinal_simplex_types.size());
-    ntypes_interval_.push_back(interval_simplex_types.size());
-    is_unit_simplex_type_ordinal.push_back(is_type_ordinal);
+    tables.unit_ordinal_simplex_types.push_back(ordinal_simplex_types);
+    tables.unit_interval_simplex_types.push_back(interval_simplex_types);
+    tables.ntypes_ordinal.push_back(ordinal_simplex_types.size());
+    tables.ntypes_interval.push_back(interval_simplex_types.size());
+    tables.is_unit_simplex_type_ordinal.push_back(is_type_ordinal);
+  }
+}
+
+inline void simplicial_regular_mesh::derive_unit_simplex_offsets(simplicial_regular_mesh_tables& tables) const
+{
+  tables.unit_simplex_offsets.resize(nd()+1);
+  for (int d = 0; d <= nd(); d ++) {
+    for (int scope = ELEMENT_SCOPE_ALL; scope <= ELEMENT_SCOPE_INTERVAL; scope ++) {
+      std::vector<int> &offsets = tables.unit_simplex_offsets[d][scope];
+      for (int t = 0; t < ntypes(d); t ++) {
+        if (scope == ELEMENT_SCOPE_ORDINAL && !tables.is_unit_simplex_type_ordinal[d][t]) continue;
+        else if (scope == ELEMENT_SCOPE_INTERVAL && tables.is_unit_simplex_type_ordinal[d][t]) continue;
+
+        for (const auto &vertex : tables.unit_simplices[d][t])
+          offsets.insert(offsets.end(), vertex.begin(), vertex.end());
+      }
+    }
   }
 }
 
@@ -806,12 +874,12 @@ inline void simplicial_regular_mesh::partition(int np, const std::vector<size_t>
 
 inline void simplicial_regular_mesh::print_unit_simplices(int d, int scope) const
 {
-  const auto &simplices = unit_simplices[d];
+  const auto &simplices = tables_->unit_simplices[d];
   for (int i = 0; i < simplices.size(); i ++) {
     bool b;
     if (scope == ELEMENT_SCOPE_ALL) b = true;
-    else if (scope == ELEMENT_SCOPE_ORDINAL) b = is_unit_simplex_type_ordinal[d][i];
-    else b = !is_unit_simplex_type_ordinal[d][i];
+    else if (scope == ELEMENT_SCOPE_ORDINAL) b = tables_->is_unit_simplex_type_ordinal[d][i];
+    else b = !tables_->is_unit_simplex_type_ordinal[d][i];
 
     if (b) {
       const auto &simplex = simplices[i];
@@ -831,40 +899,49 @@ inline void simplicial_regular_mesh::print_unit_simplices(int d, int scope) cons
 
 inline void simplicial_regular_mesh::initialize_subdivision()
 {
+  static std::mutex tables_mutex;
+  static std::map<int, std::shared_ptr<const simplicial_regular_mesh_tables>> cached_tables; // by nd
+
+  std::lock_guard<std::mutex> guard(tables_mutex);
+  const auto it = cached_tables.find(nd());
+  if (it != cached_tables.end()) {
+    tables_ = it->second;
+    return;
+  }
+
   if (is_root_proc())
     fprintf(stderr, "initializing %d-dimensional mesh...\n", nd());
 
-  ntypes_.resize(nd() + 1);
-  unit_simplices.resize(nd() + 1);
+  // the enumerations below look up the tables being built through the mesh
+  auto tables = std::make_shared<simplicial_regular_mesh_tables>();
+  tables_ = tables;
+
+  tables->ntypes.resize(nd() + 1);
+  tables->unit_simplices.resize(nd() + 1);
 
   for (int k = 0; k <= nd(); k ++) {
-    unit_simplices[k] = enumerate_unit_simplices(nd(), k);
-    ntypes_[k] = unit_simplices[k].size();
-#if 0
-    for (const auto s : unit_simplices[k]) {
-      for (const auto v : s)
-        std::cerr << v << " ";
-      std::cerr << std::endl;
-    }
-#endif
+    tables->unit_simplices[k] = enumerate_unit_simplices(nd(), k);
+    tables->ntypes[k] = tables->unit_simplices[k].size();
   }
 
-  unit_simplex_sides.resize(nd()+1);
+  derive_ordinal_and_interval_simplices(*tables);
+  derive_unit_simplex_offsets(*tables);
+
+  tables->unit_simplex_sides.resize(nd()+1);
   for (int dim = 0; dim <= nd(); dim ++) {
-    unit_simplex_sides[dim].resize(ntypes(dim));
+    tables->unit_simplex_sides[dim].resize(ntypes(dim));
     for (int type = 0; type < ntypes(dim); type ++) 
-      unit_simplex_sides[dim][type] = enumerate_unit_simplex_sides(dim, type);
+      tables->unit_simplex_sides[dim][type] = enumerate_unit_simplex_sides(dim, type);
   }
 
-  unit_simplex_side_of.resize(nd()+1);
+  tables->unit_simplex_side_of.resize(nd()+1);
   for (int dim = 0; dim <= nd(); dim ++) {
-    unit_simplex_side_of[dim].resize(ntypes(dim));
+    tables->unit_simplex_side_of[dim].resize(ntypes(dim));
     for (int type = 0; type < ntypes(dim); type ++) 
-      unit_simplex_side_of[dim][type] = enumerate_unit_simplex_side_of(dim, type);
+      tables->unit_simplex_side_of[dim][type] = enumerate_unit_simplex_side_of(dim, type);
   }
-  // enumerate_unit_simplex_side_of(0, 0);
 
-  derive_ordinal_and_interval_simplices();
+  cached_tables[nd()] = tables;
 }
 
 template <typename I>
@@ -968,6 +1045,74 @@ inline void simplicial_regular_mesh::element_for_interval(
       accelerator, nthreads, affinity);
 }
 
+inline std::vector<int> simplicial_regular_mesh::scope_types(int d, int scope) const
+{
+  std::vector<int> types;
+  if (scope == ELEMENT_SCOPE_ORDINAL) types = tables_->unit_ordinal_simplex_types[d];
+  else if (scope == ELEMENT_SCOPE_INTERVAL) types = tables_->unit_interval_simplex_types[d];
+  else {
+    types.resize(ntypes(d));
+    std::iota(types.begin(), types.end(), 0);
+  }
+  return types;
+}
+
+inline void simplicial_regular_mesh::cell_for_morton(const lattice& l, 
+    std::function<void(const std::vector<int>&)> f,
+    int accelerator, int nthreads, bool affinity) const
+{
+  const int tile_bits = 3; // tiles of 8 cells along each dimension
+  const int tile_size = 1 << tile_bits;
+
+  // dimensions w/ a single cell (e.g. time) are not tiled
+  std::vector<int> dims;
+  for (size_t i = 0; i < l.nd(); i ++)
+    if (l.size(i) > 1) dims.push_back(i);
+  const int k = dims.size();
+
+  std::vector<size_t> ntiles(k);
+  size_t n = 1;
+  for (int i = 0; i < k; i ++) {
+    ntiles[i] = (l.size(dims[i]) + tile_size - 1) / tile_size;
+    n *= ntiles[i];
+  }
+
+  // z-order offsets of cells in a tile, interleaving bits of the tiled dimensions
+  const int ncells = 1 << (tile_bits * k);
+  std::vector<int> offsets(ncells * k, 0);
+  for (int z = 0; z < ncells; z ++)
+    for (int b = 0; b < tile_bits; b ++)
+      for (int i = 0; i < k; i ++)
+        offsets[z*k + i] |= ((z >> (b*k + i)) & 1) << b;
+
+  auto lambda = [=](int j) {
+    std::vector<int> corner(l.nd()), origin(k);
+    for (size_t i = 0; i < l.nd(); i ++)
+      corner[i] = l.start(i);
+
+    size_t tile = j;
+    for (int i = 0; i < k; i ++) {
+      origin[i] = (tile % ntiles[i]) * tile_size;
+      tile /= ntiles[i];
+    }
+
+    for (int z = 0; z < ncells; z ++) {
+      bool inside = true;
+      for (int i = 0; i < k; i ++) {
+        const int x = origin[i] + offsets[z*k + i];
+        if (x >= (int)l.size(dims[i])) {
+          inside = false;
+          break;
+        }
+        corner[dims[i]] = l.start(dims[i]) + x;
+      }
+      if (inside) f(corner);
+    }
+  };
+
+  parallel_for(n, lambda, accelerator, nthreads, affinity);
+}
+
 inline void simplicial_regular_mesh::element_for(
     int d, const lattice& l, int scope, 
     std::function<void(simplicial_regular_mesh_element)> f,
@@ -975,6 +1120,15 @@ inline void simplicial_regular_mesh::element_for(
 {
   // std::cerr << "element_for, d=" << d << ", scope=" << scope << ", lattice=" <<  l << std::endl;
 
+  if (traversal_ == ELEMENT_TRAVERSAL_MORTON) {
+    const std::vector<int> types = scope_types(d, scope);
+    cell_for_morton(l, [&](const std::vector<int>& corner) {
+      for (const auto type : types)
+        f(simplicial_regular_mesh_element(corner, d, type));
+    }, accelerator, nthreads, affinity);
+    return;
+  }
+
   auto lambda = [=](size_t j) {
     simplicial_regular_mesh_element e(*this, d, j, l, scope);
     f(e);
@@ -985,6 +1139,28 @@ inline void simplicial_regular_mesh::element_for(
   parallel_for(ntasks, lambda, accelerator, nthreads, affinity);
 }
 
+inline void simplicial_regular_mesh::element_for(
+    int d, const lattice& l, int scope,
+    std::function<bool(const std::vector<int>&)> cell_filter,
+    std::function<void(simplicial_regular_mesh_element)> f,
+    int accelerator, int nthreads, bool affinity) const
+{
+  const std::vector<int> types = scope_types(d, scope);
+
+  auto cell = [&](const std::vector<int>& corner) {
+    if (!cell_filter(corner)) return;
+
+    for (const auto type : types)
+      f(simplicial_regular_mesh_element(corner, d, type));
+  };
+
+  if (traversal_ == ELEMENT_TRAVERSAL_MORTON)
+    cell_for_morton(l, cell, accelerator, nthreads, affinity);
+  else 
+    parallel_for(l.n(), [&](int j) { cell(l.from_integer(j)); }, 
+        accelerator, nthreads, affinity);
+}
+
 }
 
 
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <string>
 #include <ftk/ndarray.hh>
+#include <ftk/object.hh>
 
 namespace ftk {
 
@@ -210,14 +211,162 @@ ndarray<T> conv3D_gaussian(
   return res;
 }
 
+// Separable convolution: the same 1D kernel is applied along each spatial 
+// dimension in turn, with zero padding as in conv2D/conv3D.  Component 
+// dimensions of multicomponent arrays (see ndarray_base::multicomponents) 
+// are not convolved.  Each pass is a sequence of axpy's over contiguous 
+// ranges, which are vectorized by the compiler, and the passes are 
+// parallelized over rows/slabs with the given thread backend.
+template <typename T>
+void conv1D_pass(const T *in, T *out, 
+    size_t ninner, size_t nin, size_t nout, size_t nouter, // in: ninner x nin x nouter
+    const std::vector<T>& kernel, size_t padding, 
+    int thread_backend, int nthreads)
+{
+  const int ksize = kernel.size();
+  size_t chunk = 4096; // inner elements per task
+  if (nouter > 0 && nouter < (size_t)std::max(1, nthreads)) { // too few rows to occupy the threads, e.g. the last pass of 2D arrays
+    const size_t nsplits = (std::max(1, nthreads) + nouter - 1) / nouter;
+    chunk = std::min(chunk, std::max<size_t>(256, (ninner + nsplits - 1) / nsplits));
+  }
+
+  // the range of outputs x for which input x - padding + k is valid
+  const auto range = [&](int k, size_t &x0, size_t &x1) {
+    x0 = std::max<long>(0, (long)padding - k);
+    x1 = std::max<long>(x0, std::min<long>(nout, (long)nin + (long)padding - k));
+  };
+
+  if (ninner < chunk) { // one task per row; (x, inner) is flattened 
+    object::parallel_for(nouter, [&](int o) {
+      const T *p = in + o * nin * ninner;
+      T *q = out + o * nout * ninner;
+      std::fill(q, q + nout * ninner, T(0));
+      for (int k = 0; k < ksize; k ++) {
+        size_t x0, x1;
+        range(k, x0, x1);
+        const T w = kernel[k];
+        const T *pk = p + ((long)x0 - (long)padding + k) * ninner;
+        T *qk = q + x0 * ninner;
+        const size_t n = (x1 - x0) * ninner;
+        for (size_t i = 0; i < n; i ++)
+          qk[i] += w * pk[i];
+      }
+    }, thread_backend, nthreads, false);
+  } else { // one task per chunk of inner elements of a row
+    const size_t nchunks = (ninner + chunk - 1) / chunk;
+    object::parallel_for(nouter * nchunks, [&](int task) {
+      const size_t o = task / nchunks, 
+                   i0 = (task % nchunks) * chunk, 
+                   i1 = std::min(ninner, i0 + chunk);
+      const T *p = in + o * nin * ninner;
+      T *q = out + o * nout * ninner;
+      for (size_t x = 0; x < nout; x ++)
+        std::fill(q + x * ninner + i0, q + x * ninner + i1, T(0));
+      for (int k = 0; k < ksize; k ++) {
+        size_t x0, x1;
+        range(k, x0, x1);
+        const T w = kernel[k];
+        for (size_t x = x0; x < x1; x ++) {
+          const T *px = p + (x - padding + k) * ninner;
+          T *qx = q + x * ninner;
+          for (size_t i = i0; i < i1; i ++)
+            qx[i] += w * px[i];
+        }
+      }
+    }, thread_backend, nthreads, false);
+  }
+}
+
+template <typename T>
+void conv_separable(const ndarray<T> &data, const std::vector<T> &kernel, 
+    ndarray<T> &result, // may not alias data
+    size_t padding = 0, 
+    int thread_backend = FTK_THREAD_PTHREAD, 
+    int nthreads = std::thread::hardware_concurrency())
+{
+  const int nd = data.nd(), ncd = data.multicomponents(), 
+            nsd = nd - ncd; // number of spatial dimensions
+  if (nsd <= 0) { result = data; return; }
+
+  std::vector<size_t> dims = data.shape();
+  ndarray<T> buffer; 
+  const T *in = data.data();
+
+  // ping-pong between result and buffer, so that the last pass writes to result
+  for (int a = ncd; a < nd; a ++) {
+    const size_t nin = dims[a], 
+                 nout = nin + padding * 2 - kernel.size() + 1;
+    size_t ninner = 1, nouter = 1;
+    for (int i = 0; i < a; i ++) ninner *= dims[i];
+    for (int i = a + 1; i < nd; i ++) nouter *= dims[i];
+    dims[a] = nout;
+
+    ndarray<T> &target = ((nd - 1 - a) % 2 == 0) ? result : buffer;
+    target.reshape(dims);
+    conv1D_pass(in, target.data(), ninner, nin, nout, nouter, 
+        kernel, padding, thread_backend, nthreads);
+    in = target.data();
+  }
+  result.set_multicomponents(ncd);
+}
+
+// Gaussian smoothing w/ separable convolutions; same as conv2D_gaussian/
+// conv3D_gaussian up to rounding, including the normalization by the 
+// kernel volume in conv2D/conv3D
+template <typename T>
+void conv_gaussian_separable(const ndarray<T> &data, ndarray<T> &result, 
+    T sigma, size_t ksize = 5, size_t padding = 0, 
+    int thread_backend = FTK_THREAD_PTHREAD, 
+    int nthreads = std::thread::hardware_concurrency())
+{
+  auto kernel = gaussian_kernel(sigma, ksize);
+  for (auto &w : kernel)
+    w /= ksize;
+  conv_separable(data, kernel, result, padding, thread_backend, nthreads);
+}
+
+// in-place Gaussian smoothing with a normalized kernel, using one scratch 
+// array; the size of the kernel needs to be odd
+template <typename T>
+void smooth_gaussian(ndarray<T> &data, T sigma, size_t ksize = 5, 
+    int thread_backend = FTK_THREAD_PTHREAD, 
+    int nthreads = std::thread::hardware_concurrency())
+{
+  if (ksize % 2 == 0) 
+    fatal("the size of the smoothing kernel must be odd for in-place smoothing");
+
+  const int nd = data.nd(), ncd = data.multicomponents();
+  const auto kernel = gaussian_kernel(sigma, ksize);
+  const auto &dims = data.shape();
+  
+  ndarray<T> scratch(dims);
+  scratch.set_multicomponents(ncd);
+  T *in = data.data(), *out = scratch.data();
+
+  for (int a = ncd; a < nd; a ++) {
+    size_t ninner = 1, nouter = 1;
+    for (int i = 0; i < a; i ++) ninner *= dims[i];
+    for (int i = a + 1; i < nd; i ++) nouter *= dims[i];
+    
+    conv1D_pass(in, out, ninner, dims[a], dims[a], nouter, 
+        kernel, ksize/2, thread_backend, nthreads);
+    std::swap(in, out);
+  }
+
+  if (in != data.data()) 
+    data.swap(scratch);
+}
+
 template <typename T>
 ndarray<T> conv_gaussian(
     const ndarray<T> &data, T sigma,
-    size_t ksize=5, size_t padding=0)
+    size_t ksize=5, size_t padding=0, 
+    int thread_backend = FTK_THREAD_PTHREAD, 
+    int nthreads = std::thread::hardware_concurrency())
 {
-  if (data.nd() == 2) return conv2D_gaussian<T>(data, sigma, ksize, ksize, padding);
-  else if (data.nd() == 3) return conv3D_gaussian<T>(data, sigma, ksize, ksize, ksize, padding);
-  else return ndarray<T>();
+  ndarray<T> result;
+  conv_gaussian_separable(data, result, sigma, ksize, padding, thread_backend, nthreads);
+  return result;
 }
 
 }  // namespace ftk
@@ -6,26 +6,88 @@
 
 namespace ftk {
 
-// derive 2D gradients for 2D scalar field
+// Per-point stencils of the derived fields below.  They are also used by
+// trackers that evaluate derivatives on the fly instead of materializing
+// the derived arrays; results are bitwise identical to the arrays.
+
+// gradient of a 2D scalar field at (i, j), with clamped boundaries
 template <typename T>
-ndarray<T> gradient2D(const ndarray<T>& scalar)
+inline void gradient2D_stencil(const ndarray<T>& scalar, int i, int j, T g[2])
 {
   const int DW = scalar.dim(0), DH = scalar.dim(1);
-  ndarray<T> grad;
-  grad.reshape(2, DW, DH); 
-
   const auto f = [&](int i, int j) {
     i = std::min(std::max(0, i), DW-1);
     j = std::min(std::max(0, j), DH-1);
     return scalar(i, j);
   };
 
+  g[0] = (f(i+1, j) - f(i-1, j)) * (DW-1);
+  g[1] = (f(i, j+1) - f(i, j-1)) * (DH-1);
+}
+
+// (non-symmetrized) jacobian of a 2D vector field at (i, j), with clamped
+// boundaries; vec(c, i, j) returns the c-th component at (i, j)
+template <typename T, typename F>
+inline void jacobian2D_stencil(const F& vec, int DW, int DH, int i, int j, T H[2][2])
+{
+  const auto f = [&](int c, int i, int j) {
+    i = std::min(std::max(0, i), DW-1);
+    j = std::min(std::max(0, j), DH-1);
+    return vec(c, i, j);
+  };
+
+  H[0][0] = (f(0, i+1, j) - f(0, i-1, j)) * (DW-1);
+  H[0][1] = (f(0, i, j+1) - f(0, i, j-1)) * (DH-1);
+  H[1][0] = (f(1, i+1, j) - f(1, i-1, j)) * (DW-1);
+  H[1][1] = (f(1, i, j+1) - f(1, i, j-1)) * (DH-1);
+}
+
+// gradient of a 3D scalar field at (i, j, k); zero on the boundary
+template <typename T>
+inline void gradient3D_stencil(const ndarray<T>& scalar, int i, int j, int k, T g[3])
+{
+  const int DW = scalar.dim(0), DH = scalar.dim(1), DD = scalar.dim(2);
+  if (i < 1 || i >= DW-1 || j < 1 || j >= DH-1 || k < 1 || k >= DD-1) {
+    g[0] = g[1] = g[2] = T(0);
+    return;
+  }
+
+  g[0] = 0.5 * (scalar(i+1, j, k) - scalar(i-1, j, k));
+  g[1] = 0.5 * (scalar(i, j+1, k) - scalar(i, j-1, k));
+  g[2] = 0.5 * (scalar(i, j, k+1) - scalar(i, j, k-1));
+}
+
+// jacobian of a 3D vector field at (i, j, k); zero within b of the boundary;
+// V(c, i, j, k) returns the c-th component at (i, j, k)
+template <typename T, typename F>
+inline void jacobian3D_stencil(const F& V, int DW, int DH, int DD, int i, int j, int k, T J[3][3], int b = 2)
+{
+  if (i < b || i >= DW-b || j < b || j >= DH-b || k < b || k >= DD-b) {
+    for (int r = 0; r < 3; r ++)
+      for (int c = 0; c < 3; c ++)
+        J[r][c] = T(0);
+    return;
+  }
+
+  for (int r = 0; r < 3; r ++) {
+    J[r][0] = 0.5 * (V(r, i+1, j, k) - V(r, i-1, j, k));
+    J[r][1] = 0.5 * (V(r, i, j+1, k) - V(r, i, j-1, k));
+    J[r][2] = 0.5 * (V(r, i, j, k+1) - V(r, i, j, k-1));
+  }
+}
+
+// derive 2D gradients for 2D scalar field
+template <typename T>
+ndarray<T> gradient2D(const ndarray<T>& scalar)
+{
+  const int DW = scalar.dim(0), DH = scalar.dim(1);
+  ndarray<T> grad;
+  grad.reshape(2, DW, DH); 
+
 #pragma omp parallel for collapse(2)
   for (int j = 0; j < DH; j ++) {
-    for (int i = 0; i < DW; i ++) {
-      auto dfdx = grad(0, i, j) = (f(i+1, j) - f(i-1, j)) * (DW-1);
-      auto dfdy = grad(1, i, j) = (f(i, j+1) - f(i, j-1)) * (DH-1);
-    }
+    for (int i = 0; i < DW; i ++)
+      gradient2D_stencil(scalar, i, j, &grad(0, i, j));
   }
   return grad;
 }
@@ -58,27 +120,22 @@ ndarray<T> jacobian2D(const ndarray<T>& vec)
   ndarray<T> grad;
   grad.reshape(2, 2, DW, DH);
   
-  const auto f = [&](int c, int i, int j) {
-    i = std::min(std::max(0, i), DW-1);
-    j = std::min(std::max(0, j), DH-1);
-    return vec(c, i, j);
-  };
+  const auto f = [&](int c, int i, int j) { return vec(c, i, j); };
 
 #pragma omp parallel for collapse(2)
   for (int j = 0; j < DH; j ++) {
     for (int i = 0; i < DW; i ++) {
-      const T H00 = f(0, i+1, j) - f(0, i-1, j) * (DW-1),
-              H01 = f(0, i, j+1) - f(0, i, j-1) * (DH-1),
-              H10 = f(1, i+1, j) - f(1, i-1, j) * (DW-1), 
-              H11 = f(1, i, j+1) - f(1, i, j-1) * (DH-1);
+      T H[2][2];
+      jacobian2D_stencil(f, DW, DH, i, j, H);
+      const T H00 = H[0][0], H01 = H[0][1], H10 = H[1][0], H11 = H[1][1];
 
       grad(0, 0, i, j) = H00;
       grad(1, 1, i, j) = H11;
       if (symmetric)
         grad(0, 1, i, j) = grad(1, 0, i, j) = (H01 + H10) * 0.5;
       else {
-        grad(0, 1) = H01;
-        grad(1, 0) = H10;
+        grad(0, 1, i, j) = H01;
+        grad(1, 0, i, j) = H10;
       }
     }
   }
@@ -137,11 +194,8 @@ ndarray<T> gradient3D(const ndarray<T>& scalar)
 #pragma omp parallel for collapse(3)
   for (int k = 1; k < DD-1; k ++) {
     for (int j = 1; j < DH-1; j ++) {
-      for (int i = 1; i < DW-1; i ++) {
-        grad(0, i, j, k) = 0.5 * (scalar(i+1, j, k) - scalar(i-1, j, k));
-        grad(1, i, j, k) = 0.5 * (scalar(i, j+1, k) - scalar(i, j-1, k));
-        grad(2, i, j, k) = 0.5 * (scalar(i, j, k+1) - scalar(i, j, k-1));
-      }
+      for (int i = 1; i < DW-1; i ++)
+        gradient3D_stencil(scalar, i, j, k, &grad(0, i, j, k));
     }
   }
 
@@ -2,15 +2,53 @@
 #define _FTK_NDARRAY_GROUP_HH
 
 #include <ftk/ndarray.hh>
+#include <map>
+#include <memory>
 
 namespace ftk {
 
-struct ndarray_group : public std::map<std::string, ndarray_base> {
+// named arrays of one timestep, each in its own type and layout
+struct ndarray_group : public std::map<std::string, std::shared_ptr<ndarray_base>> {
   ndarray_group() {}
 
-  // template <typename ... Args> ndarray_group(Args&&... args);
+  bool has(const std::string& key) const { return find(key) != end(); }
+
+  template <typename T> void set(const std::string& key, const ndarray<T>& array);
+  template <typename T> void set(const std::string& key, ndarray<T>&& array);
+
+  // fatal if the key does not exist or the type does not match
+  template <typename T> std::shared_ptr<ndarray<T>> get_ptr(const std::string& key) const;
+  template <typename T> const ndarray<T>& get(const std::string& key) const { return *get_ptr<T>(key); }
 };
 
+/////
+template <typename T>
+inline void ndarray_group::set(const std::string& key, const ndarray<T>& array)
+{
+  (*this)[key] = std::make_shared<ndarray<T>>(array);
+}
+
+template <typename T>
+inline void ndarray_group::set(const std::string& key, ndarray<T>&& array)
+{
+  auto p = std::make_shared<ndarray<T>>();
+  p->swap(array);
+  (*this)[key] = p;
+}
+
+template <typename T>
+inline std::shared_ptr<ndarray<T>> ndarray_group::get_ptr(const std::string& key) const
+{
+  auto it = find(key);
+  if (it == end())
+    fatal("array " + key + " not found in the group");
+
+  auto p = std::dynamic_pointer_cast<ndarray<T>>(it->second);
+  if (!p)
+    fatal("array " + key + " does not have the requested type");
+  return p;
+}
+
 }
 
 #endif
@@ -1,38 +1,230 @@
 #ifndef _FTK_NDARRAY_GROUP_STREAM_HH
 #define _FTK_NDARRAY_GROUP_STREAM_HH
 
-#include <ftk/ndarray_group.hh>
+#include <ftk/ndarray/ndarray_group.hh>
+#include <ftk/ndarray/stream.hh>
+#include <future>
+#include <mutex>
 
 namespace ftk {
 
-// json config
-struct ndarray_group_stream {
-  // WIP: possible JSON specifications:
-  //  - key/value.  The array name (key) and specification of the array (value)
-  // required fields for value: 
-  //    - type, string.  Must be one of "synthetic" and "file".  This field may be ommited
-  //      if `format' is given.
-  //    - name (required if type is synthetic), string.  Must be one of the follows: "woven", 
-  //      "double_gyre", "merger_2d".
-  //   optional fields:
-  //    - filenames (required if type is file), string.  The list of filenames will be 
-  //      determined by glob(3)
-  //    - mesh_filename (required for unstructured mesh, must be in vtu format in the 
-  //      current version), string.
-  //    - format (required if type is file and format is float32/float64), string.  If not 
-  //      given, the format will be determined by the filename extension.  The value of this 
-  //      field must be one of the follows: vti, nc, h5, float32, float64.
-  //    - variables (required if format is nc/h5, optional for vti), array of strings.
-  //      - the number of components is the length of the array.
-  //      - if not given, the defaulat value is ["scalar"]
-  //    - components (to be determined), array of number of components per variable
-  //    - dimensions (required if format is floaot32/float64), array of integers, e.g.  
-  //      [width, height, depth]
-  //    - n_timesteps, integer.  The default is 32 for synthetic data; the number can be 
-  //      automatically derived from file; the number can be automatically derived from files
-  //    - perturbation, number.  Add gaussian perturbation to the data
+// Streams multiple named arrays timestep by timestep.  Each array is read by
+// its own ndarray_stream and delivered in its own layout, so that variables
+// are neither interleaved into one multicomponent array nor read if not
+// requested.  Arrays of a timestep are read concurrently, and the next
+// timestep is prefetched while the callback processes the current one.
+template <typename T=double>
+struct ndarray_group_stream : public object {
+  ndarray_group_stream(diy::mpi::communicator comm = MPI_COMM_WORLD) : object(comm) {}
+
+  void configure(const json& j);
+  // JSON specifications: key/value pairs.  The key is the name of the array
+  // in the group, and the value is the specification of ndarray_stream, e.g.
+  //   {"temperature": {"type": "file", "format": "float32", "filenames": "t*.bin", "dimensions": [64, 64]},
+  //    "pressure": {"type": "file", "filenames": "data*.nc"}}
+  // If `variables' is not given in a file specification, the key is used as
+  // the variable name.  Temporal smoothing is not supported.
+
+  void set_input_source_json_file(const std::string& filename);
+  const json& get_json() const {return j;}
+
+  std::vector<std::string> keys() const; // all configured arrays
+  void set_requested_keys(const std::vector<std::string>& keys); // only these are read; all if empty
+  const std::vector<std::string>& get_requested_keys() const {return requested_keys;}
+
+  std::shared_ptr<ndarray_stream<T>> get_stream(const std::string& key) const;
+  size_t n_timesteps() const; // the minimum over the requested arrays
+
+  void set_callback(std::function<void(int, const ndarray_group&)> f) {callback = f;}
+  void set_prefetch(bool b) {prefetch = b;}
+  void set_instrumentation(instrumentation *p) {instr = p;}
+
+  void start();
+  void finish() {}
+
+  // reads the requested arrays of the k-th timestep; empty if any stream is exhausted
+  ndarray_group request_timestep(int k);
+
+protected:
+  ndarray<T> request_array(const std::string& key, int k);
+  static std::mutex& library_mutex() { static std::mutex m; return m; }
+
+protected:
+  json j;
+  std::map<std::string, std::shared_ptr<ndarray_stream<T>>> streams;
+  std::vector<std::string> requested_keys;
+
+  std::function<void(int, const ndarray_group&)> callback;
+  bool prefetch = true;
+
+  instrumentation *instr = NULL;
 };
 
+/////
+template <typename T>
+void ndarray_group_stream<T>::configure(const json& j_)
+{
+  if (!j_.is_object() || j_.empty())
+    fatal("invalid group stream specification");
+
+  j = json::object();
+  streams.clear();
+  requested_keys.clear();
+
+  for (auto it = j_.begin(); it != j_.end(); it ++) {
+    json js = it.value();
+    if (!js.is_object())
+      fatal("invalid specification of array " + it.key());
+    if (js.contains("temporal-smoothing-kernel"))
+      fatal("temporal smoothing is not supported in group streams");
+
+    const bool is_file = js.contains("format") || (js.contains("type") && js["type"] == "file");
+    if (is_file && !js.contains("variables"))
+      js["variables"] = {it.key()};
+
+    std::shared_ptr<ndarray_stream<T>> stream(new ndarray_stream<T>(comm));
+    stream->configure(js);
+
+    streams[it.key()] = stream;
+    j[it.key()] = stream->get_json();
+    requested_keys.push_back(it.key());
+  }
+}
+
+template <typename T>
+void ndarray_group_stream<T>::set_input_source_json_file(const std::string& filename)
+{
+  std::ifstream f(filename);
+  if (!f.is_open())
+    fatal("unable to open " + filename);
+  configure(json::parse(f));
+}
+
+template <typename T>
+std::vector<std::string> ndarray_group_stream<T>::keys() const
+{
+  std::vector<std::string> results;
+  for (const auto &kv : streams)
+    results.push_back(kv.first);
+  return results;
+}
+
+template <typename T>
+void ndarray_group_stream<T>::set_requested_keys(const std::vector<std::string>& keys)
+{
+  if (keys.empty()) {
+    requested_keys = this->keys();
+    return;
+  }
+
+  for (const auto &key : keys)
+    if (streams.find(key) == streams.end())
+      fatal("array " + key + " not configured in the group stream");
+  requested_keys = keys;
+}
+
+template <typename T>
+std::shared_ptr<ndarray_stream<T>> ndarray_group_stream<T>::get_stream(const std::string& key) const
+{
+  auto it = streams.find(key);
+  if (it == streams.end())
+    fatal("array " + key + " not configured in the group stream");
+  return it->second;
+}
+
+template <typename T>
+size_t ndarray_group_stream<T>::n_timesteps() const
+{
+  size_t n = std::numeric_limits<size_t>::max();
+  for (const auto &key : requested_keys)
+    n = std::min(n, get_stream(key)->n_timesteps());
+  return n;
+}
+
+template <typename T>
+ndarray<T> ndarray_group_stream<T>::request_array(const std::string& key, int k)
+{
+  auto stream = get_stream(key);
+  const double t0 = instrumentation::now();
+
+  ndarray<T> array;
+  if (stream->is_thread_safe())
+    array = stream->request_timestep(k);
+  else {
+    std::lock_guard<std::mutex> guard(library_mutex());
+    array = stream->request_timestep(k);
+  }
+
+  if (instr) {
+    instr->add_time("read", t0, instrumentation::now() - t0);
+    if (stream->get_json()["type"] == "file")
+      instr->add("bytes_read", array.nelem() * sizeof(T));
+  }
+
+  if (!array.empty() && stream->has_spatial_filters())
+    stream->apply_spatial_filters(array);
+  return array;
+}
+
+template <typename T>
+ndarray_group ndarray_group_stream<T>::request_timestep(int k)
+{
+  const size_t n = requested_keys.size();
+  std::vector<ndarray<T>> arrays(n);
+
+  // one task per array; the first array is read by the calling thread
+  std::vector<std::future<void>> futures;
+  for (size_t i = 1; i < n; i ++)
+    futures.push_back(std::async(std::launch::async, [&, i]() {
+      arrays[i] = request_array(requested_keys[i], k);
+    }));
+  if (n > 0)
+    arrays[0] = request_array(requested_keys[0], k);
+  for (auto &f : futures)
+    f.get();
+
+  ndarray_group group;
+  for (size_t i = 0; i < n; i ++) {
+    if (arrays[i].empty()) return ndarray_group(); // exhausted
+    group.set(requested_keys[i], std::move(arrays[i]));
+  }
+  return group;
+}
+
+template <typename T>
+void ndarray_group_stream<T>::start()
+{
+  if (!callback)
+    fatal("callback function not set");
+
+  const size_t nt = n_timesteps();
+  std::future<ndarray_group> next;
+  if (nt > 0 && prefetch)
+    next = std::async(std::launch::async, [&]() { return request_timestep(0); });
+
+  for (size_t i = 0; i < nt; i ++) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ndarray_group group = prefetch ? next.get() : request_timestep(i);
+    if (group.empty()) {
+      fprintf(stderr, "got empty group; all files are read.\n");
+      break;
+    }
+
+    if (prefetch && i + 1 < nt)
+      next = std::async(std::launch::async, [&, i]() { return request_timestep(i + 1); });
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    callback(i, group);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    float t_io = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9,
+          t_compute = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() * 1e-9;
+    fprintf(stderr, "timestep=%zu, t_io=%f, t_compute=%f\n", i, t_io, t_compute);
+  }
+
+  if (next.valid()) next.wait(); // in case the loop breaks early
+}
+
 }
 
 #endif
@@ -8,6 +8,7 @@
 #include <ftk/ndarray/synthetic.hh>
 #include <ftk/filters/streaming_filter.hh>
 #include <ftk/external/json.hh>
+#include <ftk/utils/instrumentation.hh>
 
 namespace ftk {
 using nlohmann::json;
@@ -56,6 +57,16 @@ struct ndarray_stream : public object {
 
   void set_callback(std::function<void(int, const ndarray<T>&)> f) {callback = f;}
 
+  // start() begins with the given timestep, e.g. when resuming from a checkpoint
+  void set_start_timestep(int k) {start_timestep = k;}
+
+  // threading for spatial smoothing
+  void use_thread_backend(int i) {thread_backend = i;}
+  void set_number_of_threads(int n) {nthreads = n;}
+
+  // records the i/o time and bytes read, e.g. in the instrumentation of the consumer
+  void set_instrumentation(instrumentation *p) {instr = p;}
+
   size_t n_variables() const { return j["variables"].size(); }
   size_t n_components() const {
     size_t n = 0;
@@ -75,6 +86,17 @@ struct ndarray_stream : public object {
 
   std::vector<size_t> shape() const;
 
+  // reads the k-th timestep without smoothing, perturbation, or clamping; 
+  // returns an empty array if the files are exhausted
+  ndarray<T> request_timestep(int k);
+  
+  // spatial smoothing, perturbation, and clamping, in this order, if configured
+  bool has_spatial_filters() const;
+  void apply_spatial_filters(ndarray<T>& array) const;
+
+  // false if the underlying library may not be called concurrently (netcdf, hdf5, adios)
+  bool is_thread_safe() const;
+
 protected:
   ndarray<T> request_timestep_file(int k);
   ndarray<T> request_timestep_file_nc(int k);
@@ -94,6 +116,7 @@ protected:
   ndarray<T> request_timestep_synthetic_merger_2d(int k);
   ndarray<T> request_timestep_synthetic_volcano_2d(int k);
   ndarray<T> request_timestep_synthetic_tornado(int k);
+  ndarray<T> request_timestep_synthetic_abc_flow(int k);
 
   void modified_callback(int, const ndarray<T>&);
 
@@ -104,6 +127,12 @@ protected:
 
   streaming_filter<ndarray<T>, T> temporal_filter;
 
+  int thread_backend = FTK_THREAD_PTHREAD, 
+      nthreads = 1; // set by consumers, e.g. json_interface, to the threads of the tracker
+
+  instrumentation *instr = NULL;
+  int start_timestep = 0;
+
 protected: // adios2
 #if FTK_HAVE_ADIOS2
   adios2::ADIOS adios;
@@ -386,6 +415,10 @@ void ndarray_stream<T>::set_input_source_json(const json& j_)
           default_nd = 3;
           j["variables"] = {"u", "v", "w"};
           j["components"] = {1, 1, 1};
+        } else if (j["name"] == "abc_flow") { // steady
+          default_nd = 3;
+          j["variables"] = {"u", "v", "w"};
+          j["components"] = {1, 1, 1};
         } else {
           std::cerr << "synthetic case name: " << j["name"] << std::endl;
           fatal("synthetic case not available.");
@@ -775,6 +808,24 @@ std::vector<size_t> ndarray_stream<T>::shape() const
   return shape;
 }
 
+template <typename T>
+ndarray<T> ndarray_stream<T>::request_timestep(int k)
+{
+  if (j["type"] == "synthetic") 
+    return request_timestep_synthetic(k);
+  else if (j["type"] == "file")
+    return request_timestep_file(k);
+  else return ndarray<T>();
+}
+
+template <typename T>
+bool ndarray_stream<T>::is_thread_safe() const
+{
+  if (j["type"] == "synthetic") return true;
+  const std::string fmt = j["format"];
+  return fmt == "float32" || fmt == "float64" || fmt == "vti";
+}
+
 template <typename T>
 ndarray<T> ndarray_stream<T>::request_timestep_file(int k)
 {
@@ -1044,6 +1095,8 @@ ndarray<T> ndarray_stream<T>::request_timestep_synthetic(int k)
     return request_timestep_synthetic_volcano_2d(k);
   else if (j["name"] == "tornado")
     return request_timestep_synthetic_tornado(k);
+  else if (j["name"] == "abc_flow")
+    return request_timestep_synthetic_abc_flow(k);
   return ndarray<T>();
 }
 
@@ -1134,6 +1187,37 @@ ndarray<T> ndarray_stream<T>::request_timestep_synthetic_tornado(int k)
       k);
 }
 
+template <typename T>
+ndarray<T> ndarray_stream<T>::request_timestep_synthetic_abc_flow(int k) 
+{
+  return ftk::synthetic_abc_flow<T>(
+      j["dimensions"][0],
+      j["dimensions"][1],
+      j["dimensions"][2]);
+}
+
+template <typename T>
+bool ndarray_stream<T>::has_spatial_filters() const
+{
+  return j.contains("spatial-smoothing-kernel") || j.contains("perturbation") || j.contains("clamp");
+}
+
+template <typename T>
+void ndarray_stream<T>::apply_spatial_filters(ndarray<T>& array) const
+{
+  if (j.contains("spatial-smoothing-kernel")) {
+    const int ksize = j["spatial-smoothing-kernel-size"];
+    const T sigma = j["spatial-smoothing-kernel"];
+    array = conv_gaussian(array, sigma, ksize, ksize/2, thread_backend, nthreads);
+  }
+
+  if (j.contains("perturbation"))
+    array.perturb(j["perturbation"]);
+
+  if (j.contains("clamp"))
+    array.clamp(j["clamp"][0], j["clamp"][1]);
+}
+
 template <typename T>
 void ndarray_stream<T>::modified_callback(int k, const ndarray<T> &array)
 {
@@ -1143,32 +1227,13 @@ void ndarray_stream<T>::modified_callback(int k, const ndarray<T> &array)
     else
       callback(k, array);
   };
-   
-  auto f1 = [&](const ndarray<T> &array) { // handling clamp
-    if (j.contains("clamp")) {
-      auto array1 = array;
-      array1.clamp(j["clamp"][0], j["clamp"][1]);
-      f(array1);
-    } else 
-      f(array);
-  };
 
-  auto f2 = [&](const ndarray<T> &array) { // handling perturbation
-    if (j.contains("perturbation")) { 
-      auto array1 = array; 
-      array1.perturb(j["perturbation"]);
-      f1(array1);
-    } else 
-      f1(array);
-  };
-
-  if (j.contains("spatial-smoothing-kernel")) {
-    const int ksize = j["spatial-smoothing-kernel-size"];
-    const T sigma = j["spatial-smoothing-kernel"];
-    ndarray<T> array1 = conv_gaussian(array, sigma, ksize, ksize/2);
-    f2(array1);
-  } else
-    f2(array);
+  if (has_spatial_filters()) {
+    ndarray<T> array1 = array;
+    apply_spatial_filters(array1);
+    f(array1);
+  } else 
+    f(array);
 }
 
 template <typename T>
@@ -1178,26 +1243,28 @@ void ndarray_stream<T>::start()
     fatal("callback function not set");
 
   if (j.contains("temporal-smoothing-kernel")) {
+    if (start_timestep > 0)
+      fatal("cannot start from a later timestep with temporal smoothing");
     temporal_filter.set_gaussian_kernel(j["temporal-smoothing-kernel"], j["temporal-smoothing-kernel-size"]);
     temporal_filter.set_callback(callback);
   }
 
-  for (size_t i = 0; i < j["n_timesteps"]; i ++) {
+  for (size_t i = start_timestep; i < j["n_timesteps"]; i ++) {
     auto t0 = std::chrono::high_resolution_clock::now();
-    ndarray<T> array;
-    if (j["type"] == "synthetic") {
-      array = request_timestep_synthetic(i);
-      // fprintf(stderr, "requested data ncd=%zu, ncd1=%zu\n", array.multicomponents(), array1.multicomponents());
-    }
-    else if (j["type"] == "file") {
-      array = request_timestep_file(i);
-      if (array.empty()) {
-        fprintf(stderr, "got empty array; all files are read.\n"); 
-        break;
-      }
+    ndarray<T> array = request_timestep(i);
+    if (j["type"] == "file" && array.empty()) {
+      fprintf(stderr, "got empty array; all files are read.\n"); 
+      break;
     }
     auto t1 = std::chrono::high_resolution_clock::now();
 
+    if (instr) {
+      const double t_io = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+      instr->add_time("read", instrumentation::now() - t_io, t_io);
+      if (j["type"] == "file")
+        instr->add("bytes_read", array.nelem() * sizeof(T));
+    }
+
     modified_callback(i, array);
     auto t2 = std::chrono::high_resolution_clock::now();
 
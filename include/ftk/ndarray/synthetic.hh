@@ -146,7 +146,7 @@ std::array<T, 2> double_gyre(
     return  M_PI * A * cos(M_PI * f(x, t)) * sin(M_PI * y) * dfdx(x, t);
   };
 
-  return {u(x, y, t), v(x, y, t)};
+  return {static_cast<T>(u(x, y, t)), static_cast<T>(v(x, y, t))}; // M_PI promotes to double
 }
 
 template <typename T>
@@ -3,12 +3,168 @@
 
 #include <ftk/config.hh>
 #include <ftk/numeric/polynomial.hh>
+#include <ftk/numeric/quadratic_solver.hh>
+#include <ftk/numeric/cubic_solver.hh>
+#include <ftk/numeric/quartic_solver.hh>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
 
 namespace ftk {
 
+// Roots of polynomials; x[i] is the coefficient of the i-th power.
+// Polynomials of degree up to polynomial_solver_max_degree are solved with
+// solve_polynomial (below); MPSolve is used for higher degrees if available.
+// Roots lost by vanishing leading coefficients are given as NaNs.
 template <typename T>
 bool solve_polynomials(const T * x, int n, double * root_real, double * root_im);
 
+bool solve_polynomials_mpsolve(const double * x, int n, double * root_real, double * root_im); // false w/o MPSolve
+
+/////
+// Dependency-free solver for polynomials of degree up to 6: closed forms
+// for degrees up to four, and the Aberth-Ehrlich iteration above; all roots
+// are then polished with Newton's method on the original polynomial, and
+// roots with negligible imaginary parts are snapped to the real axis if the
+// residual does not grow.  Leading zero coefficients are dropped; returns
+// the number of roots, i.e. the actual degree.
+enum { polynomial_solver_max_degree = 6 };
+
+template <typename T>
+int solve_polynomial(const T P[], int n, std::complex<T> roots[]);
+
+// count polynomials of degree n, stored one after another (n+1 coefficients
+// each); roots of the i-th polynomial are roots[i*n], ..., roots[i*n+nroots[i]-1]
+template <typename T>
+void solve_polynomials_batch(const T P[], int n, size_t count, std::complex<T> roots[], int nroots[]);
+
+/////
+template <typename T>
+inline std::complex<T> polynomial_evaluate_complex(const T P[], int n, std::complex<T> z, std::complex<T>& dp)
+{
+  std::complex<T> p(P[n]);
+  dp = std::complex<T>(0);
+  for (int i = n-1; i >= 0; i --) { // horner
+    dp = dp * z + p;
+    p = p * z + P[i];
+  }
+  return p;
+}
+
+template <typename T>
+inline void polish_polynomial_root(const T P[], int n, std::complex<T>& z, int niters = 3)
+{
+  std::complex<T> p, dp;
+  p = polynomial_evaluate_complex(P, n, z, dp);
+  T r = std::norm(p); // squared residual
+  for (int iter = 0; iter < niters && r > 0; iter ++) {
+    if (dp == std::complex<T>(0)) break;
+    const std::complex<T> z1 = z - p / dp;
+    std::complex<T> dp1;
+    const std::complex<T> p1 = polynomial_evaluate_complex(P, n, z1, dp1);
+    const T r1 = std::norm(p1);
+    if (!(r1 < r)) break; // also stops on nans
+    z = z1; p = p1; dp = dp1; r = r1;
+  }
+
+  // snap to the real axis
+  if (z.imag() != T(0) && std::abs(z.imag()) <= 64 * std::numeric_limits<T>::epsilon() * std::max(T(1), std::abs(z.real()))) {
+    std::complex<T> dp1;
+    if (std::norm(polynomial_evaluate_complex(P, n, std::complex<T>(z.real()), dp1)) <= r)
+      z = std::complex<T>(z.real());
+  }
+}
+
+template <typename T>
+inline bool solve_polynomial_aberth(const T P[], int n, std::complex<T> z[], int max_iters = 100)
+{
+  // initial guesses on a circle w/ radius by the geometric mean of the roots,
+  // bounded by the cauchy bound, w/ an offset angle to avoid symmetries
+  T bound = 0;
+  for (int i = 0; i < n; i ++)
+    bound = std::max(bound, std::abs(P[i] / P[n]));
+  T radius = P[0] != T(0) ? std::pow(std::abs(P[0] / P[n]), T(1) / n) : T(1);
+  radius = std::min(radius, bound + 1);
+  for (int i = 0; i < n; i ++)
+    z[i] = std::polar(radius, T(2 * M_PI) * i / n + T(0.4));
+
+  // roots are frozen once converged; the rest is left to polishing
+  const T tol = 16 * std::numeric_limits<T>::epsilon();
+  bool converged[polynomial_solver_max_degree] = {false};
+  for (int iter = 0; iter < max_iters; iter ++) {
+    int nconverged = 0;
+    for (int k = 0; k < n; k ++) {
+      if (converged[k]) {nconverged ++; continue;}
+
+      std::complex<T> dp;
+      const std::complex<T> p = polynomial_evaluate_complex(P, n, z[k], dp);
+      if (p == std::complex<T>(0)) {converged[k] = true; continue;}
+
+      const std::complex<T> ratio = p / dp;
+      std::complex<T> sum(0);
+      for (int j = 0; j < n; j ++)
+        if (j != k) sum += T(1) / (z[k] - z[j]);
+      const std::complex<T> w = ratio / (T(1) - ratio * sum);
+      if (!std::isfinite(w.real()) || !std::isfinite(w.imag())) continue;
+
+      z[k] -= w;
+      if (std::norm(w) <= tol * tol * std::max(T(1), std::norm(z[k])))
+        converged[k] = true;
+    }
+    if (nconverged == n) return true;
+  }
+  return false;
+}
+
+template <typename T>
+inline int solve_polynomial(const T P0[], int n, std::complex<T> roots[])
+{
+  while (n > 0 && P0[n] == T(0)) n --;
+  if (n <= 0) return 0;
+  if (n > polynomial_solver_max_degree) return -1;
+
+  // zero roots
+  int nz = 0;
+  while (P0[nz] == T(0)) roots[nz ++] = std::complex<T>(0);
+  const T *P = P0 + nz;
+  const int m = n - nz;
+
+  std::complex<T> *z = roots + nz;
+  bool finite = true;
+  if (m == 1)
+    z[0] = -P[0] / P[1];
+  else if (m == 2) {
+    // numerically stable quadratic formula
+    const std::complex<T> delta = std::sqrt(std::complex<T>(P[1]*P[1] - 4*P[2]*P[0]));
+    const std::complex<T> q = T(-0.5) * (P[1] >= 0 ? T(P[1]) + delta : T(P[1]) - delta);
+    z[0] = q / P[2];
+    z[1] = P[0] / q;
+  } else if (m == 3)
+    solve_cubic(P, z);
+  else if (m == 4)
+    quartic_solve(P[3]/P[4], P[2]/P[4], P[1]/P[4], P[0]/P[4], z);
+
+  for (int i = 0; i < m; i ++)
+    if (!std::isfinite(z[i].real()) || !std::isfinite(z[i].imag()))
+      finite = false;
+  if (m > 4 || !finite) // degenerate closed forms (e.g. multiple roots) fall back to aberth
+    solve_polynomial_aberth(P, m, z);
+
+  if (m > 1)
+    for (int i = 0; i < m; i ++)
+      polish_polynomial_root(P, m, z[i]);
+
+  return n;
+}
+
+template <typename T>
+inline void solve_polynomials_batch(const T P[], int n, size_t count, std::complex<T> roots[], int nroots[])
+{
+  for (size_t i = 0; i < count; i ++)
+    nroots[i] = solve_polynomial(P + i * (n+1), n, roots + i * n);
+}
+
 }
 
 #endif
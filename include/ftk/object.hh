@@ -8,6 +8,9 @@
 #include <set>
 #include <functional>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <ftk/config.hh>
 #include <ftk/error.hh>
 #include <ftk/external/diy/mpi.hpp>
@@ -32,6 +35,7 @@ enum { // thread backend
 enum { 
   FTK_XL_NONE = 0,
   FTK_XL_SYCL = 2,
+  FTK_XL_CPU = 3, // flat-index kernels of the gpu extractors, on cpus
   FTK_XL_CUDA = 4,
   FTK_XL_KOKKOS_CUDA = 5
 };
@@ -45,8 +49,55 @@ struct object {
   int get_root_proc() const {return root_proc;}
   bool is_root_proc() const {return root_proc == comm.rank();}
 
-  static void set_affinity(int cpu) {
+  // cpus in the affinity mask of the process, as of the first call
+  static const std::vector<int>& affinity_cpus() {
+    static const std::vector<int> cpus = []() {
+      std::vector<int> cpus;
 #if !defined(_MSC_VER) && !defined(__APPLE__)
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0)
+        for (int i = 0; i < CPU_SETSIZE; i ++)
+          if (CPU_ISSET(i, &cpu_set))
+            cpus.push_back(i);
+#endif
+      if (cpus.empty())
+        for (int i = 0; i < std::max(1u, std::thread::hardware_concurrency()); i ++)
+          cpus.push_back(i);
+      return cpus;
+    }();
+    return cpus;
+  }
+
+  // number of cpus the process may use, by the affinity mask and the cgroup cpu quota
+  static int available_cpus() {
+    int n = affinity_cpus().size();
+    double quota = -1, period = -1;
+    FILE *fp = fopen("/sys/fs/cgroup/cpu.max", "r"); // cgroup v2: "max 100000" or "<quota> <period>"
+    if (fp) {
+      char str[64];
+      if (fscanf(fp, "%63s %lf", str, &period) == 2 && std::string(str) != "max")
+        quota = atof(str);
+      fclose(fp);
+    } else if ((fp = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r"))) { // cgroup v1; -1 if unlimited
+      if (fscanf(fp, "%lf", &quota) != 1) quota = -1;
+      fclose(fp);
+      if ((fp = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r"))) {
+        if (fscanf(fp, "%lf", &period) != 1) period = -1;
+        fclose(fp);
+      }
+    }
+    if (quota > 0 && period > 0)
+      n = std::min(n, std::max(1, static_cast<int>(std::ceil(quota / period))));
+    return n;
+  }
+
+  // pins the calling thread to the i-th cpu of the affinity mask
+  static void set_affinity(int i) {
+#if !defined(_MSC_VER) && !defined(__APPLE__)
+    const auto &cpus = affinity_cpus();
+    const int cpu = cpus[i % cpus.size()];
+
     cpu_set_t cpu_set;
     CPU_ZERO(&cpu_set);
     CPU_SET(cpu, &cpu_set);
@@ -63,7 +114,8 @@ struct object {
       bool affinity = true)
   {
     if (thread_backend == FTK_THREAD_PTHREAD) {
-      nthreads = std::min(ntasks, nthreads);
+      nthreads = std::max(1, std::min(ntasks, nthreads));
+      if (affinity) affinity_cpus(); // the mask before any thread is pinned
 
       std::vector<std::thread> workers;
       for (auto i = 1; i < nthreads; i ++) {
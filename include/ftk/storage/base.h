@@ -2,12 +2,19 @@
 #define _FTK_STORAGE
 
 #include <iostream>
+#include <vector>
+#include <cstdio>
 #include "ftk/external/json.hh"
+#include "ftk/utils/serialization.hh"
 
 namespace ftk {
 
+// Key-value store of features.  Values are binary (diy-serialized) by
+// default; features are keyed by feature type, timestep, and block (see
+// feature_key), so that keys of the same type sort by time and a time
+// range can be retrieved by a prefix scan.
 class storage {
-public: 
+public:
   virtual ~storage() {}
 
   virtual bool open(void*) {return false;}
@@ -15,16 +22,89 @@ public:
   virtual void close() = 0;
 
   virtual void put(const std::string& key, const std::string& val) = 0;
+  virtual void put_batch(const std::vector<std::pair<std::string, std::string>>& kvs) {
+    for (const auto &kv : kvs) put(kv.first, kv.second);
+  }
+  virtual void flush() {} // makes previous puts visible to readers
+
   void put_json(const std::string& key, const nlohmann::json& j) {put(key, j.dump());}
   template <typename T> void put_obj(const std::string& key, const T& val) {
+    std::string buf;
+    diy::serializeToString(val, buf);
+    put(key, buf);
+  }
+  template <typename T> void put_obj_json(const std::string& key, const T& val) {
     nlohmann::json j;
     nlohmann::adl_serializer<T>::to_json(j, val);
     put(key, j.dump());
-  } 
+  }
+
+  virtual std::string get(const std::string& key) = 0; // empty if the key does not exist
+  virtual bool has(const std::string& key) {return !get(key).empty();}
+  template <typename T> bool get_obj(const std::string& key, T& val) {
+    if (!has(key)) return false;
+    diy::unserializeFromString(get(key), val);
+    return true;
+  }
+
+  virtual std::vector<std::string> keys(const std::string& prefix = "") = 0; // sorted keys with the prefix
+
+public: // feature keys
+  static std::string feature_key(const std::string& type, int timestep, int block);
+  static std::string feature_prefix(const std::string& type) {return type + "/";}
+  static std::string feature_prefix(const std::string& type, int timestep);
+  static bool parse_feature_key(const std::string& key, std::string& type, int& timestep, int& block);
 
-  virtual std::string get(const std::string& key) = 0;
+  std::vector<std::string> feature_keys(const std::string& type, int t0, int t1); // keys in timesteps [t0, t1]
+
+protected:
+  // timesteps are biased by 2^31 to unsigned integers, such that the fixed-width 
+  // decimal keys of negative timesteps sort before those of non-negative ones
+  static unsigned int biased_timestep(int t) {return static_cast<unsigned int>(t) ^ 0x80000000u;}
 };
 
+/////
+inline std::string storage::feature_key(const std::string& type, int timestep, int block)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%010u/%06d", biased_timestep(timestep), block); // fixed width, sorted by time
+  return feature_prefix(type) + buf;
+}
+
+inline std::string storage::feature_prefix(const std::string& type, int timestep)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%010u/", biased_timestep(timestep));
+  return feature_prefix(type) + buf;
+}
+
+inline bool storage::parse_feature_key(const std::string& key, std::string& type, int& timestep, int& block)
+{
+  const size_t p1 = key.rfind('/');
+  if (p1 == std::string::npos || p1 == 0) return false;
+  const size_t p0 = key.rfind('/', p1-1);
+  if (p0 == std::string::npos) return false;
+
+  type = key.substr(0, p0);
+  unsigned int t;
+  if (sscanf(key.c_str() + p0 + 1, "%u", &t) != 1 || sscanf(key.c_str() + p1 + 1, "%d", &block) != 1)
+    return false;
+  timestep = static_cast<int>(t ^ 0x80000000u);
+  return true;
+}
+
+inline std::vector<std::string> storage::feature_keys(const std::string& type, int t0, int t1)
+{
+  std::vector<std::string> results;
+  for (const auto &k : keys(feature_prefix(type))) {
+    std::string tp;
+    int t, b;
+    if (parse_feature_key(k, tp, t, b) && tp == type && t >= t0 && t <= t1)
+      results.push_back(k);
+  }
+  return results;
+}
+
 }
 
 #endif
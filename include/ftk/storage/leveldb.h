@@ -2,7 +2,9 @@
 #define _FTK_LEVELDB_STORAGE
 
 #include "ftk/storage/base.h"
+#include <memory>
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 namespace ftk {
 
@@ -37,6 +39,26 @@ public:
     return val;
   }
 
+  void put_batch(const std::vector<std::pair<std::string, std::string>>& kvs) {
+    leveldb::WriteBatch batch;
+    for (const auto &kv : kvs)
+      batch.Put(kv.first, kv.second);
+    _db->Write(leveldb::WriteOptions(), &batch);
+  }
+
+  bool has(const std::string& key) {
+    std::string val;
+    return _db->Get(leveldb::ReadOptions(), key, &val).ok();
+  }
+
+  std::vector<std::string> keys(const std::string& prefix) {
+    std::vector<std::string> results;
+    std::unique_ptr<leveldb::Iterator> it(_db->NewIterator(leveldb::ReadOptions()));
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next())
+      results.push_back(it->key().ToString());
+    return results;
+  }
+
 private:
   leveldb::DB *_db;
   bool _external_db = false;
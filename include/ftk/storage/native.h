@@ -2,30 +2,235 @@
 #define _FTK_DIR_STORAGE
 
 #include "ftk/storage/base.h"
+#include "ftk/error.hh"
 #include <sys/stat.h>
 #include <errno.h>
+#include <unistd.h>
+#include <cstring>
+#include <map>
+#include <set>
+#include <mutex>
 
 namespace ftk {
 
-class storage_native: public storage {
-public: 
-  bool open(const std::string& dbname) {
+// Log-structured store without external dependencies.  The database is a
+// directory with an append-only log of records (key length, value length,
+// key, value); the index of the latest record of each key is kept in memory
+// and rebuilt by scanning the log when opened.  Puts are buffered and
+// appended in batches, either once the batch exceeds the batch size or on
+// flush().  A reader (opened read-only, e.g. by another process while the
+// job is running) picks up newly appended records on each query; incomplete
+// records at the end of the log are ignored by readers and truncated when a
+// writer opens the log.  Only one writer is supported.
+class storage_native : public storage {
+public:
+  storage_native() {}
+  ~storage_native() { close(); }
+
+  void set_read_only(bool b) {read_only = b;} // before open
+  void set_batch_size(size_t bytes) {batch_size = bytes;}
+
+  bool open(const std::string& dbname);
+  void close();
+
+  void put(const std::string& key, const std::string& val);
+  void put_batch(const std::vector<std::pair<std::string, std::string>>& kvs);
+  void flush();
+
+  std::string get(const std::string& key);
+  bool has(const std::string& key);
+  std::vector<std::string> keys(const std::string& prefix = "");
+
+  size_t size() {std::lock_guard<std::mutex> guard(mutex); refresh(); return index.size();} // number of keys, excluding buffered puts
+
+protected:
+  void append(const std::string& key, const std::string& val); // w/o lock
+  void write_batch(); // w/o lock
+  void refresh(); // scans records appended since the last scan; w/o lock
+
+  static const char* magic() {return "FTKKVLOG";}
+
+private:
+  bool read_only = false;
+  size_t batch_size = 4 * 1024 * 1024;
+
+  FILE *fp = NULL;
+  uint64_t scanned = 0; // end of the last complete record
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>> index; // key -> offset and size of the value in the log
+  std::map<std::string, std::pair<uint64_t, uint64_t>> pending; // key -> offset and size of the value in the batch
+  std::string batch; // buffered puts, in the format of the log
+
+  std::mutex mutex;
+};
+
+/////
+inline bool storage_native::open(const std::string& dbname)
+{
+  close();
+
+  if (!read_only && mkdir(dbname.c_str(), 0755) != 0 && errno != EEXIST) {
+    warn("unable to create " + dbname + ": " + strerror(errno));
     return false;
   }
 
-  void close() {
+  const std::string filename = dbname + "/log";
+  fp = fopen(filename.c_str(), read_only ? "rb" : "a+b");
+  if (!fp) return false;
+
+  struct stat st;
+  fstat(fileno(fp), &st);
+  if (st.st_size == 0 && !read_only) {
+    fwrite(magic(), 1, 8, fp);
+    fflush(fp);
+  } else {
+    char m[8];
+    fseeko(fp, 0, SEEK_SET);
+    if (fread(m, 1, 8, fp) != 8 || memcmp(m, magic(), 8) != 0) {
+      if (!read_only || st.st_size > 0) // an empty log may be created later by the writer
+        warn("invalid storage " + dbname);
+      fclose(fp); fp = NULL;
+      return false;
+    }
   }
 
-  void put(const std::string& key, const std::string& val) {
+  scanned = 8;
+  index.clear();
+  refresh();
+
+  if (!read_only) {
+    fstat(fileno(fp), &st);
+    if (static_cast<uint64_t>(st.st_size) > scanned) { // left by an interrupted writer
+      fflush(fp);
+      if (ftruncate(fileno(fp), scanned) != 0)
+        warn("unable to truncate " + filename);
+    }
   }
+  return true;
+}
+
+inline void storage_native::close()
+{
+  if (!fp) return;
+  flush();
+  fclose(fp);
+  fp = NULL;
+  index.clear();
+}
+
+inline void storage_native::append(const std::string& key, const std::string& val)
+{
+  if (read_only) fatal("unable to write read-only storage");
+  if (!fp) fatal("storage not open");
+
+  const uint32_t nk = key.size();
+  const uint64_t nv = val.size();
+  batch.append(reinterpret_cast<const char*>(&nk), sizeof(nk));
+  batch.append(reinterpret_cast<const char*>(&nv), sizeof(nv));
+  batch.append(key);
+  pending[key] = std::make_pair(batch.size(), nv);
+  batch.append(val);
+
+  if (batch.size() >= batch_size)
+    write_batch();
+}
+
+inline void storage_native::write_batch()
+{
+  if (batch.empty()) return;
 
-  std::string get(const std::string& key) {
-    std::string val;
-    return val;
+  fseeko(fp, 0, SEEK_END);
+  if (fwrite(batch.data(), 1, batch.size(), fp) != batch.size())
+    fatal("unable to write storage");
+  fflush(fp);
+
+  batch.clear();
+  pending.clear();
+  refresh();
+}
+
+inline void storage_native::refresh()
+{
+  struct stat st;
+  if (!fp || fstat(fileno(fp), &st) != 0) return;
+  const uint64_t size = st.st_size;
+  if (size <= scanned) return;
+
+  fseeko(fp, scanned, SEEK_SET);
+  while (scanned + sizeof(uint32_t) + sizeof(uint64_t) <= size) {
+    uint32_t nk;
+    uint64_t nv;
+    if (fread(&nk, sizeof(nk), 1, fp) != 1 || fread(&nv, sizeof(nv), 1, fp) != 1)
+      break;
+
+    const uint64_t offset = scanned + sizeof(nk) + sizeof(nv);
+    if (offset + nk + nv > size) break; // incomplete
+
+    std::string key(nk, '\0');
+    if (nk > 0 && fread(&key[0], 1, nk, fp) != nk) break;
+    index[key] = std::make_pair(offset + nk, nv);
+
+    scanned = offset + nk + nv;
+    fseeko(fp, scanned, SEEK_SET);
   }
+}
 
-private:
-};
+inline void storage_native::put(const std::string& key, const std::string& val)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  append(key, val);
+}
+
+inline void storage_native::put_batch(const std::vector<std::pair<std::string, std::string>>& kvs)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  for (const auto &kv : kvs)
+    append(kv.first, kv.second);
+}
+
+inline void storage_native::flush()
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (fp && !read_only) write_batch();
+}
+
+inline std::string storage_native::get(const std::string& key)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+
+  auto it = pending.find(key);
+  if (it != pending.end()) return batch.substr(it->second.first, it->second.second);
+
+  if (read_only) refresh();
+  auto jt = index.find(key);
+  if (jt == index.end()) return std::string();
+
+  std::string val(jt->second.second, '\0');
+  fseeko(fp, jt->second.first, SEEK_SET);
+  if (val.size() > 0 && fread(&val[0], 1, val.size(), fp) != val.size())
+    fatal("unable to read storage");
+  return val;
+}
+
+inline bool storage_native::has(const std::string& key)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (read_only) refresh();
+  return pending.find(key) != pending.end() || index.find(key) != index.end();
+}
+
+inline std::vector<std::string> storage_native::keys(const std::string& prefix)
+{
+  std::lock_guard<std::mutex> guard(mutex);
+  if (read_only) refresh();
+
+  std::set<std::string> results;
+  for (auto it = index.lower_bound(prefix); it != index.end() && it->first.compare(0, prefix.size(), prefix) == 0; it ++)
+    results.insert(it->first);
+  for (auto it = pending.lower_bound(prefix); it != pending.end() && it->first.compare(0, prefix.size(), prefix) == 0; it ++)
+    results.insert(it->first);
+  return std::vector<std::string>(results.begin(), results.end());
+}
 
 }
 
@@ -0,0 +1,37 @@
+#ifndef _FTK_STORAGE_FACTORY
+#define _FTK_STORAGE_FACTORY
+
+#include <ftk/config.hh>
+#include "ftk/storage/native.h"
+#if FTK_HAVE_LEVELDB
+#include "ftk/storage/leveldb.h"
+#endif
+#if FTK_HAVE_ROCKSDB
+#include "ftk/storage/rocksdb.h"
+#endif
+#include <memory>
+
+namespace ftk {
+
+// creates a storage of the given backend: native, leveldb, or rocksdb
+inline std::shared_ptr<storage> make_storage(const std::string& backend)
+{
+  if (backend == "native")
+    return std::make_shared<storage_native>();
+#if FTK_HAVE_LEVELDB
+  else if (backend == "leveldb")
+    return std::make_shared<storage_leveldb>();
+#endif
+#if FTK_HAVE_ROCKSDB
+  else if (backend == "rocksdb")
+    return std::make_shared<storage_rocksdb>();
+#endif
+  else {
+    fatal("unsupported storage backend " + backend);
+    return nullptr;
+  }
+}
+
+}
+
+#endif
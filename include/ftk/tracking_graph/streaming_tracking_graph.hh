@@ -2,33 +2,306 @@
 #define _FTK_STREAMING_TRACKING_GRAPH_HH
 
 #include <ftk/tracking_graph/tracking_graph.hh>
+#include <ftk/external/json.hh>
+#include <ftk/error.hh>
 
 namespace ftk {
 
+// Tracking graph that is built, labeled, and analyzed one timestep at a time.
+// Nodes of the current timestep and edges from the previous timestep are
+// added before advance_timestep(), which assigns global labels to the nodes
+// and detects events in the last interval; nodes of the previous timestep 
+// that first appear in add_edge() are labeled (and born) there.  A node continues the global label
+// of its predecessor if the edge is the only link of both nodes, otherwise a
+// new label is born.  Only a sliding window of the most recent timesteps is
+// kept in memory; older timesteps are appended to the flush file (if given)
+// as one JSON object per line with the nodes, global labels, edges to the
+// next timestep, and events of the interval that begins with the timestep.
+// All public functions lock the graph, and the callbacks are invoked after
+// the lock is released, so that they may query the graph.
 template <class TimeIndexType=size_t, class LabelIdType=size_t, class GlobalLabelIdType=size_t, class WeightType=int>
-class streaming_tracking_graph : public tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType> {
+class streaming_tracking_graph {
 public:
-  streaming_tracking_graph();
+  typedef Event<TimeIndexType, LabelIdType> event_t;
+
+  streaming_tracking_graph(size_t window_size = 2) { set_window_size(window_size); }
+  ~streaming_tracking_graph() { finish(); }
+
+  void set_window_size(size_t w); // number of timesteps kept in memory, at least 2
+  size_t get_window_size() const {return window_size;}
+
+  void set_flush_filename(const std::string& filename);
+  void set_event_callback(std::function<void(const event_t&)> f) {event_callback = f;}
+  void set_label_callback(std::function<void(TimeIndexType, LabelIdType, GlobalLabelIdType)> f) {label_callback = f;}
+
+  TimeIndexType get_current_timestep() const {std::unique_lock<std::mutex> lock(mutex); return current_timestep;}
 
   void add_node(LabelIdType); // add a node for the current timestep
   void add_edge(LabelIdType prev, LabelIdType curr); // add an edge between previous timestep and the current timestep
   void advance_timestep(); // advance timestep, update global labels, and detect events
+  void finish(); // flushes all timesteps in the window
+
+  // only available for timesteps in the window
+  bool has_node(TimeIndexType t, LabelIdType l) const;
+  bool has_global_label(TimeIndexType t, LabelIdType l) const;
+  GlobalLabelIdType get_global_label(TimeIndexType t, LabelIdType l) const;
+  std::vector<event_t> get_events(TimeIndexType t0) const; // events in interval (t0, t0+1)
+
+  std::vector<TimeIndexType> get_timesteps() const; // timesteps in the window
+  size_t get_number_of_flushed_timesteps() const {std::unique_lock<std::mutex> lock(mutex); return n_flushed_timesteps;}
+  size_t get_number_of_global_labels() const {std::unique_lock<std::mutex> lock(mutex); return global_label_counter;}
+
+protected:
+  typedef std::pair<TimeIndexType, LabelIdType> Node;
+
+  // the caller holds the mutex
+  std::vector<event_t> detect_events(TimeIndexType t0, TimeIndexType t1); // returns the new events
+  void flush_timestep(TimeIndexType t);
+
+protected:
+  size_t window_size = 2;
+  TimeIndexType current_timestep = 0;
+
+  std::map<TimeIndexType, std::set<Node> > nodes;
+  std::map<Node, std::set<Node> > left_links, right_links;
+  std::map<Node, GlobalLabelIdType> nodeToGlobalLabelMap;
+  std::map<TimeIndexType, std::vector<event_t> > events;
+
+  GlobalLabelIdType global_label_counter = 0;
+  size_t n_flushed_timesteps = 0;
+
+  std::function<void(const event_t&)> event_callback;
+  std::function<void(TimeIndexType, LabelIdType, GlobalLabelIdType)> label_callback;
+
+  std::ofstream ofs;
+  mutable std::mutex mutex;
 };
 
 ////////////////////////////////////////////
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::set_window_size(size_t w)
+{
+  if (w < 2)
+    fatal("the window of the streaming tracking graph needs at least two timesteps");
+  window_size = w;
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::set_flush_filename(const std::string& filename)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (ofs.is_open()) ofs.close();
+  ofs.open(filename.c_str(), std::ios::out | std::ios::trunc);
+  if (!ofs.is_open())
+    fatal("unable to open " + filename + " for flushing the tracking graph");
+}
 
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::add_node(LabelIdType l)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  nodes[current_timestep].insert(std::make_pair(current_timestep, l));
+}
 
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::add_edge(LabelIdType l0, LabelIdType l1)
+{
+  TimeIndexType t0 = 0;
+  GlobalLabelIdType label = 0;
+  event_t birth;
+  bool late = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (current_timestep == 0) return; // no previous timestep
 
+    t0 = current_timestep - 1;
+    auto n0 = std::make_pair(t0, l0);
+    auto n1 = std::make_pair(current_timestep, l1);
+
+    nodes[t0].insert(n0);
+    nodes[current_timestep].insert(n1);
+
+    left_links[n1].insert(n0);
+    right_links[n0].insert(n1);
+
+    // a node that first appears here was not labeled when t0 was advanced; 
+    // it has no predecessors, so it is labeled as a birth in (t0-1, t0)
+    if (nodeToGlobalLabelMap.find(n0) == nodeToGlobalLabelMap.end()) {
+      late = true;
+      label = nodeToGlobalLabelMap[n0] = ++ global_label_counter;
+      if (t0 > 0) {
+        birth.interval = std::make_pair(t0-1, t0);
+        birth.rhs.insert(l0);
+        events[t0-1].push_back(birth);
+      }
+    }
+  }
+
+  if (late) {
+    if (label_callback) label_callback(t0, l0, label);
+    if (t0 > 0 && event_callback) event_callback(birth);
+  }
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::advance_timestep()
+{
+  TimeIndexType t = 0;
+  std::vector<std::pair<LabelIdType, GlobalLabelIdType> > labels;
+  std::vector<event_t> new_events;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    t = current_timestep;
+
+    // global labels
+    for (const auto &n : nodes[t]) {
+      GlobalLabelIdType label;
+      auto it = left_links.find(n);
+      if (it != left_links.end() && it->second.size() == 1
+          && right_links[*it->second.begin()].size() == 1
+          && nodeToGlobalLabelMap.find(*it->second.begin()) != nodeToGlobalLabelMap.end())
+        label = nodeToGlobalLabelMap[*it->second.begin()];
+      else
+        label = ++ global_label_counter;
+
+      nodeToGlobalLabelMap[n] = label;
+      labels.push_back(std::make_pair(n.second, label));
+    }
+
+    // events
+    if (t > 0)
+      new_events = detect_events(t-1, t);
+
+    // sliding window
+    while (!nodes.empty() && nodes.begin()->first + window_size <= t)
+      flush_timestep(nodes.begin()->first);
+
+    current_timestep ++;
+  }
+
+  if (label_callback)
+    for (const auto &l : labels)
+      label_callback(t, l.first, l.second);
+  if (event_callback)
+    for (const auto &e : new_events)
+      event_callback(e);
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+std::vector<Event<TimeIndexType, LabelIdType> > streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::detect_events(TimeIndexType t0, TimeIndexType t1)
+{
+  // same as tracking_graph::detect_events
+  std::set<Node> intervalNodes;
+  for (auto n : nodes[t0]) intervalNodes.insert(n);
+  for (auto n : nodes[t1]) intervalNodes.insert(n);
+
+  auto intervalNeighbors = [this, t0](Node n) {
+    if (n.first == t0) return right_links[n];
+    else return left_links[n];
+  };
+
+  std::vector<event_t> new_events;
+  auto components = extract_connected_components<Node, std::set<Node> >(intervalNeighbors, intervalNodes);
+  for (auto component : components) {
+    if (component.size() != 2) {
+      event_t e;
+      e.interval = std::make_pair(t0, t1);
+      for (auto n : component) {
+        if (n.first == t0) e.lhs.insert(n.second);
+        else e.rhs.insert(n.second);
+      }
+      events[t0].push_back(e);
+      new_events.push_back(e);
+    }
+  }
+  return new_events;
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::flush_timestep(TimeIndexType t)
+{
+  auto it = nodes.find(t);
+  if (it == nodes.end()) return;
+
+  nlohmann::json j, jnodes = nlohmann::json::array(), jedges = nlohmann::json::array();
+  for (const auto &n : it->second) {
+    jnodes.push_back({n.second, nodeToGlobalLabelMap[n]});
+    for (const auto &n1 : right_links[n])
+      jedges.push_back({n.second, n1.second});
+
+    nodeToGlobalLabelMap.erase(n);
+    left_links.erase(n);
+    right_links.erase(n);
+  }
+
+  if (ofs.is_open()) {
+    j["timestep"] = t;
+    j["nodes"] = jnodes; // local and global labels
+    j["edges"] = jedges; // to the next timestep
+    j["events"] = events[t];
+    ofs << j.dump() << std::endl;
+  }
+
+  nodes.erase(it);
+  events.erase(t);
+  n_flushed_timesteps ++;
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+void streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::finish()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  // timesteps that are not advanced yet are discarded
+  while (!nodes.empty() && nodes.begin()->first < current_timestep)
+    flush_timestep(nodes.begin()->first);
+  if (ofs.is_open()) ofs.flush();
+}
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+bool streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::has_node(TimeIndexType t, LabelIdType l) const
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = nodes.find(t);
+  return it != nodes.end() && it->second.find(std::make_pair(t, l)) != it->second.end();
+}
 
-////////////////////////////////////////////
 template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
-void tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::add_node(LabelIdType l) const 
+bool streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::has_global_label(TimeIndexType t, LabelIdType l) const
 {
+  std::unique_lock<std::mutex> lock(mutex);
+  return nodeToGlobalLabelMap.find(std::make_pair(t, l)) != nodeToGlobalLabelMap.end();
 }
 
 template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
-void tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::add_edge(LabelIdType l) const 
+GlobalLabelIdType streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::get_global_label(TimeIndexType t, LabelIdType l) const
 {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = nodeToGlobalLabelMap.find(std::make_pair(t, l));
+  if (it != nodeToGlobalLabelMap.end())
+    return it->second;
+  else
+    return GlobalLabelIdType(-1);
 }
 
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+std::vector<Event<TimeIndexType, LabelIdType> > streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::get_events(TimeIndexType t0) const
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = events.find(t0);
+  if (it != events.end()) return it->second;
+  else return std::vector<event_t>();
 }
+
+template <class TimeIndexType, class LabelIdType, class GlobalLabelIdType, class WeightType>
+std::vector<TimeIndexType> streaming_tracking_graph<TimeIndexType, LabelIdType, GlobalLabelIdType, WeightType>::get_timesteps() const
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  std::vector<TimeIndexType> timesteps;
+  for (const auto &kv : nodes)
+    timesteps.push_back(kv.first);
+  return timesteps;
+}
+
+}
+
+#endif
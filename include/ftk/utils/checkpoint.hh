@@ -0,0 +1,108 @@
+#ifndef _FTK_CHECKPOINT_HH
+#define _FTK_CHECKPOINT_HH
+
+#include <ftk/config.hh>
+#include <ftk/utils/serialization.hh>
+#include <ftk/error.hh>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+
+namespace ftk {
+
+// Checkpoint files written by a background thread.  The state is serialized
+// into a memory buffer by the caller, so that it is consistent with the
+// timestep being checkpointed, and the buffer is then written to a temporary
+// file that replaces the checkpoint once complete; a crash during writing
+// leaves the previous checkpoint intact.  At most one write is in flight: a
+// new checkpoint waits for the previous write to finish.
+struct checkpointer {
+  checkpointer() {}
+  ~checkpointer() { wait(); }
+
+  void write_async(const std::string& filename, std::string&& buf);
+  bool wait(); // waits for the pending write, if any; false if the last write failed
+
+  static bool exists(const std::string& filename);
+  static bool read(const std::string& filename, std::string& buf); // false if the file does not exist or is incomplete
+
+protected:
+  static bool write(const std::string& filename, const std::string& buf);
+
+  static const char* magic() { return "FTKCKPT1"; }
+
+protected:
+  std::future<bool> pending;
+  bool succeeded = true; // the last write
+};
+
+/////
+inline bool checkpointer::wait()
+{
+  if (pending.valid())
+    succeeded = pending.get();
+  return succeeded;
+}
+
+inline void checkpointer::write_async(const std::string& filename, std::string&& buf)
+{
+  wait();
+
+  auto p = std::make_shared<std::string>();
+  p->swap(buf);
+  pending = std::async(std::launch::async, [filename, p]() {
+    return write(filename, *p);
+  });
+}
+
+inline bool checkpointer::write(const std::string& filename, const std::string& buf)
+{
+  // magic | size | payload
+  const std::string tmp = filename + ".tmp";
+  FILE *fp = fopen(tmp.c_str(), "wb");
+  if (!fp) {
+    warn("unable to open " + tmp + " for checkpointing");
+    return false;
+  }
+
+  const uint64_t n = buf.size();
+  bool succ = fwrite(magic(), 1, 8, fp) == 8
+    && fwrite(&n, sizeof(n), 1, fp) == 1
+    && fwrite(buf.data(), 1, n, fp) == n;
+  succ = (fclose(fp) == 0) && succ;
+
+  if (!succ || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+    warn("unable to write checkpoint " + filename);
+    return false;
+  }
+  return true;
+}
+
+inline bool checkpointer::exists(const std::string& filename)
+{
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (fp) fclose(fp);
+  return fp != NULL;
+}
+
+inline bool checkpointer::read(const std::string& filename, std::string& buf)
+{
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (!fp) return false;
+
+  char m[8];
+  uint64_t n = 0;
+  bool succ = fread(m, 1, 8, fp) == 8 && memcmp(m, magic(), 8) == 0
+    && fread(&n, sizeof(n), 1, fp) == 1;
+  if (succ) {
+    buf.resize(n);
+    succ = fread(&buf[0], 1, n, fp) == n;
+  }
+  fclose(fp);
+  return succ;
+}
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef _FTK_EXTERNAL_MERGE_HH
+#define _FTK_EXTERNAL_MERGE_HH
+
+#include <ftk/config.hh>
+#include <ftk/error.hh>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace ftk {
+
+// Sorted runs of fixed-size records in scratch files and their k-way merge,
+// for data that do not fit in memory.  Records are written as raw bytes and
+// are only meant to be read back by the same executable.
+template <typename T>
+struct external_merge {
+  // writes records (already sorted) to a run file; returns false on failure
+  static bool write_run(const std::string& filename, const std::vector<T>& records);
+
+  // calls f for all records of the runs in the order given by less; records
+  // in the same run are assumed to be sorted
+  template <typename Less, typename F>
+  static void merge(const std::vector<std::string>& filenames, Less less, F f);
+
+  static void remove_runs(const std::vector<std::string>& filenames);
+
+protected:
+  static const char* magic() {return "FTKRUN01";}
+
+  struct reader {
+    bool open(const std::string& filename); // false if the run is missing or invalid
+    ~reader() {if (fp) fclose(fp);}
+
+    bool next(); // advances to the next record; false at the end of the run
+    const T& record() const {return buf[pos];}
+
+    FILE *fp = NULL;
+    std::vector<T> buf;
+    size_t pos = 0, n = 0;
+  };
+};
+
+/////
+template <typename T>
+inline bool external_merge<T>::write_run(const std::string& filename, const std::vector<T>& records)
+{
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (!fp) return false;
+
+  const uint64_t size = sizeof(T);
+  bool succ = fwrite(magic(), 1, 8, fp) == 8
+    && fwrite(&size, sizeof(size), 1, fp) == 1
+    && fwrite(records.data(), sizeof(T), records.size(), fp) == records.size();
+  return (fclose(fp) == 0) && succ;
+}
+
+template <typename T>
+inline bool external_merge<T>::reader::open(const std::string& filename)
+{
+  fp = fopen(filename.c_str(), "rb");
+  if (!fp) return false;
+
+  char m[8];
+  uint64_t size = 0;
+  if (fread(m, 1, 8, fp) != 8 || memcmp(m, magic(), 8) != 0
+      || fread(&size, sizeof(size), 1, fp) != 1 || size != sizeof(T))
+    return false;
+
+  buf.resize(std::max(size_t(1), (size_t(1) << 20) / sizeof(T))); // ~1 MB buffer per run
+  return true;
+}
+
+template <typename T>
+inline bool external_merge<T>::reader::next()
+{
+  if (n > 0 && ++ pos < n) return true;
+
+  n = fread(buf.data(), sizeof(T), buf.size(), fp);
+  pos = 0;
+  return n > 0;
+}
+
+template <typename T>
+template <typename Less, typename F>
+inline void external_merge<T>::merge(const std::vector<std::string>& filenames, Less less, F f)
+{
+  std::vector<std::unique_ptr<reader>> readers;
+  for (const auto &filename : filenames) {
+    std::unique_ptr<reader> r(new reader);
+    if (!r->open(filename))
+      fatal("unable to read run " + filename);
+    if (r->next()) // non-empty
+      readers.push_back(std::move(r));
+  }
+
+  // heap of readers by their current records; ties broken by the run order
+  auto greater = [&](size_t i, size_t j) {
+    if (less(readers[j]->record(), readers[i]->record())) return true;
+    else if (less(readers[i]->record(), readers[j]->record())) return false;
+    else return i > j;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+  for (size_t i = 0; i < readers.size(); i ++)
+    heap.push(i);
+
+  while (!heap.empty()) {
+    const size_t i = heap.top();
+    heap.pop();
+
+    f(readers[i]->record());
+    if (readers[i]->next())
+      heap.push(i);
+  }
+}
+
+template <typename T>
+inline void external_merge<T>::remove_runs(const std::vector<std::string>& filenames)
+{
+  for (const auto &filename : filenames)
+    std::remove(filename.c_str());
+}
+
+}
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef _FTK_INSTRUMENTATION_HH
+#define _FTK_INSTRUMENTATION_HH
+
+#include <ftk/config.hh>
+#include <ftk/error.hh>
+#include <ftk/external/diy/mpi.hpp>
+#include <ftk/external/json.hh>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ftk {
+
+using nlohmann::json;
+
+// Named scoped timers and counters for the hot paths of filters.  Each
+// thread records into its own slot, so recording does not contend across
+// threads; slots are merged when reported, and the reports are aggregated
+// over MPI ranks with min/max/mean.  Timer scopes are also kept as events
+// that can be exported in the Chrome trace-event format (chrome://tracing
+// or ui.perfetto.dev).  A slot lookup costs a map search, so counters in
+// per-simplex loops should be accumulated locally and added once per loop.
+struct instrumentation {
+  instrumentation();
+  ~instrumentation();
+
+  void set_enabled(bool b) {enabled = b;}
+  bool is_enabled() const {return enabled;}
+
+  void add(const std::string& counter, uint64_t n = 1);
+  void add_time(const std::string& timer, double start, double duration); // in seconds since epoch()
+
+  struct scoped_timer {
+    scoped_timer(instrumentation& instr_, const std::string& name_) :
+      instr(instr_), name(name_), start(instr_.enabled ? now() : 0.0) {}
+    ~scoped_timer() { if (instr.enabled) instr.add_time(name, start, now() - start); }
+  private:
+    instrumentation& instr;
+    const std::string name;
+    const double start;
+  };
+
+  // collective; the results are only valid on the root proc
+  json report(diy::mpi::communicator comm, int root = 0) const;
+  void write_json(diy::mpi::communicator comm, const std::string& filename, int root = 0) const;
+  void write_chrome_trace(diy::mpi::communicator comm, const std::string& filename, int root = 0) const;
+
+  void clear();
+
+  static double now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch()).count() * 1e-9;
+  }
+
+protected:
+  struct event_t {
+    std::string name;
+    double start, duration;
+  };
+
+  struct slot_t {
+    int tid;
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, std::pair<uint64_t, double>> timers; // count and accumulated time
+    std::vector<event_t> events;
+  };
+
+  slot_t& local_slot();
+  static std::map<uint64_t, slot_t*>& thread_cache(); // slots of the calling thread by instance id
+  json local_report() const;
+  static void gather_strings(diy::mpi::communicator comm, const std::string& in, std::vector<std::string>& out, int root);
+
+  static std::chrono::steady_clock::time_point epoch() {
+    static const auto t0 = std::chrono::steady_clock::now();
+    return t0;
+  }
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> counter(0);
+    return counter ++;
+  }
+  static std::mutex& live_ids_mutex() {
+    static std::mutex *m = new std::mutex; // never destroyed, for instances destroyed at exit
+    return *m;
+  }
+  static std::set<uint64_t>& live_ids() { // ids of instances not destroyed yet
+    static std::set<uint64_t> *ids = new std::set<uint64_t>;
+    return *ids;
+  }
+
+protected:
+  bool enabled = false;
+  const uint64_t id; // distinguishes instances in thread-local slot caches; never reused
+
+  mutable std::mutex slots_mutex;
+  std::list<slot_t> slots; // addresses are stable
+  size_t max_events_per_thread = 1 << 20;
+};
+
+/////
+inline instrumentation::instrumentation() : id(next_id())
+{
+  epoch();
+  std::lock_guard<std::mutex> guard(live_ids_mutex());
+  live_ids().insert(id);
+}
+
+inline instrumentation::~instrumentation()
+{
+  {
+    std::lock_guard<std::mutex> guard(live_ids_mutex());
+    live_ids().erase(id);
+  }
+  // entries of other threads are dropped in their next local_slot() miss
+  thread_cache().erase(id);
+}
+
+inline std::map<uint64_t, instrumentation::slot_t*>& instrumentation::thread_cache()
+{
+  thread_local std::map<uint64_t, slot_t*> cache;
+  return cache;
+}
+
+inline instrumentation::slot_t& instrumentation::local_slot()
+{
+  auto &cache = thread_cache();
+  auto it = cache.find(id);
+  if (it != cache.end()) return *it->second;
+
+  { // a miss happens once per thread and instance; drop entries of destroyed instances
+    std::lock_guard<std::mutex> guard(live_ids_mutex());
+    const auto &ids = live_ids();
+    for (auto jt = cache.begin(); jt != cache.end(); )
+      if (ids.count(jt->first)) jt ++;
+      else jt = cache.erase(jt);
+  }
+
+  std::lock_guard<std::mutex> guard(slots_mutex);
+  slots.emplace_back();
+  slots.back().tid = slots.size() - 1;
+  cache[id] = &slots.back();
+  return slots.back();
+}
+
+inline void instrumentation::add(const std::string& counter, uint64_t n)
+{
+  if (!enabled) return;
+  local_slot().counters[counter] += n;
+}
+
+inline void instrumentation::add_time(const std::string& timer, double start, double duration)
+{
+  if (!enabled) return;
+  auto &s = local_slot();
+  auto &t = s.timers[timer];
+  t.first ++;
+  t.second += duration;
+  if (s.events.size() < max_events_per_thread)
+    s.events.push_back({timer, start, duration});
+}
+
+inline void instrumentation::clear()
+{
+  std::lock_guard<std::mutex> guard(slots_mutex);
+  for (auto &s : slots) {
+    s.counters.clear();
+    s.timers.clear();
+    s.events.clear();
+  }
+}
+
+inline json instrumentation::local_report() const
+{
+  // per-proc values are sums over threads; thread_min/thread_max are taken
+  // over the threads that recorded the timer/counter
+  json j;
+  j["timers"] = json::object();
+  j["counters"] = json::object();
+
+  std::lock_guard<std::mutex> guard(slots_mutex);
+  for (const auto &s : slots) {
+    for (const auto &kv : s.timers) {
+      json &t = j["timers"][kv.first];
+      if (t.is_null()) t = {{"count", 0}, {"time", 0.0},
+        {"thread_min", std::numeric_limits<double>::max()}, {"thread_max", 0.0}};
+      t["count"] = t["count"].get<uint64_t>() + kv.second.first;
+      t["time"] = t["time"].get<double>() + kv.second.second;
+      t["thread_min"] = std::min(t["thread_min"].get<double>(), kv.second.second);
+      t["thread_max"] = std::max(t["thread_max"].get<double>(), kv.second.second);
+    }
+    for (const auto &kv : s.counters) {
+      json &c = j["counters"][kv.first];
+      if (c.is_null()) c = {{"value", 0},
+        {"thread_min", std::numeric_limits<uint64_t>::max()}, {"thread_max", 0}};
+      c["value"] = c["value"].get<uint64_t>() + kv.second;
+      c["thread_min"] = std::min(c["thread_min"].get<uint64_t>(), kv.second);
+      c["thread_max"] = std::max(c["thread_max"].get<uint64_t>(), kv.second);
+    }
+  }
+  return j;
+}
+
+inline void instrumentation::gather_strings(diy::mpi::communicator comm,
+    const std::string& in, std::vector<std::string>& out, int root)
+{
+  std::vector<char> buf(in.begin(), in.end());
+  buf.push_back('\0'); // never empty
+  std::vector<std::vector<char>> bufs;
+  diy::mpi::gather(comm, buf, bufs, root);
+
+  out.clear();
+  if (comm.rank() == root)
+    for (const auto &b : bufs)
+      out.push_back(std::string(b.data()));
+}
+
+inline json instrumentation::report(diy::mpi::communicator comm, int root) const
+{
+  std::vector<std::string> strs;
+  gather_strings(comm, local_report().dump(), strs, root);
+  if (comm.rank() != root) return json();
+
+  std::vector<json> locals;
+  for (const auto &s : strs)
+    locals.push_back(json::parse(s));
+  const int np = locals.size();
+
+  // min/max/mean over procs; procs that did not record a name count as zero
+  auto aggregate = [&](const std::string& category, const std::string& key) {
+    json results = json::object();
+    std::set<std::string> names;
+    for (const auto &l : locals)
+      for (auto it = l[category].begin(); it != l[category].end(); it ++)
+        names.insert(it.key());
+
+    for (const auto &name : names) {
+      double sum = 0, min = std::numeric_limits<double>::max(), max = 0;
+      json tmin, tmax;
+      uint64_t count = 0;
+      for (const auto &l : locals) {
+        const json &r = l[category].contains(name) ? l[category][name] : json();
+        const double x = r.is_null() ? 0.0 : r[key].get<double>();
+        sum += x;
+        min = std::min(min, x);
+        max = std::max(max, x);
+        if (r.is_null()) continue;
+        if (r.contains("count")) count += r["count"].get<uint64_t>();
+        if (tmin.is_null() || r["thread_min"] < tmin) tmin = r["thread_min"];
+        if (tmax.is_null() || r["thread_max"] > tmax) tmax = r["thread_max"];
+      }
+
+      json &x = results[name];
+      if (category == "timers") {
+        x["count"] = count;
+        x["total"] = sum;
+        x["min"] = min;
+        x["max"] = max;
+      } else {
+        x["total"] = static_cast<uint64_t>(sum);
+        x["min"] = static_cast<uint64_t>(min);
+        x["max"] = static_cast<uint64_t>(max);
+      }
+      x["mean"] = sum / np;
+      x["thread_min"] = tmin;
+      x["thread_max"] = tmax;
+    }
+    return results;
+  };
+
+  json j;
+  j["nprocs"] = np;
+  j["timers"] = aggregate("timers", "time");
+  j["counters"] = aggregate("counters", "value");
+  return j;
+}
+
+inline void instrumentation::write_json(diy::mpi::communicator comm, const std::string& filename, int root) const
+{
+  const json j = report(comm, root);
+  if (comm.rank() != root) return;
+
+  std::ofstream f(filename);
+  if (!f.is_open()) {
+    warn("unable to open " + filename + " for writing instrumentation results");
+    return;
+  }
+  f << j.dump(2) << std::endl;
+}
+
+inline void instrumentation::write_chrome_trace(diy::mpi::communicator comm, const std::string& filename, int root) const
+{
+  // complete events ("X") with timestamps in microseconds; pid is the rank
+  json events = json::array();
+  {
+    std::lock_guard<std::mutex> guard(slots_mutex);
+    for (const auto &s : slots)
+      for (const auto &e : s.events)
+        events.push_back({
+          {"name", e.name}, {"ph", "X"},
+          {"ts", e.start * 1e6}, {"dur", e.duration * 1e6},
+          {"pid", comm.rank()}, {"tid", s.tid}
+        });
+  }
+
+  std::vector<std::string> strs;
+  gather_strings(comm, events.dump(), strs, root);
+  if (comm.rank() != root) return;
+
+  json j;
+  j["traceEvents"] = json::array();
+  for (const auto &s : strs)
+    for (const auto &e : json::parse(s))
+      j["traceEvents"].push_back(e);
+  j["displayTimeUnit"] = "ms";
+
+  std::ofstream f(filename);
+  if (!f.is_open()) {
+    warn("unable to open " + filename + " for writing the trace");
+    return;
+  }
+  f << j.dump() << std::endl;
+}
+
+}
+
+#endif
@@ -47,7 +47,7 @@ private:
   int currentTimestep;
   int inputDataComponents;
   
-  ftk::critical_point_tracker_2d_regular tracker; 
+  ftk::critical_point_tracker_2d_regular<> tracker; 
 };
 
 #endif
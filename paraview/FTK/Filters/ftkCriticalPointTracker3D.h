@@ -43,7 +43,7 @@ private:
   int currentTimestep;
   int inputDataComponents;
   
-  ftk::critical_point_tracker_3d_regular tracker; 
+  ftk::critical_point_tracker_3d_regular<> tracker; 
 };
 
 #endif
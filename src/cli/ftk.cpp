@@ -32,9 +32,9 @@ std::string output_pattern, output_type, output_format;
 std::string mesh_filename;
 std::string archived_intersections_filename, // archived_discrete_critical_points_filename,
   archived_traced_filename; // archived_traced_critical_points_filename;
-std::string thread_backend, accelerator;
+std::string thread_backend, accelerator, traversal;
 std::string type_filter_str;
-int nthreads = std::thread::hardware_concurrency();
+int nthreads = 0; // per process; 0 for the cpus available to the process
 bool affinity = false;
 bool verbose = false, timing = false, help = false;
 int nblocks; 
@@ -42,8 +42,18 @@ bool enable_streaming_trajectories = false,
      enable_discarding_interval_points = false,
      enable_deriving_velocities = false,
      disable_robust_detection = false,
+     disable_cell_culling = false,
+     enable_lazy_derivatives = false,
      disable_post_processing = false;
 int intercept_length = 2;
+std::string instrumentation_filename, trace_filename;
+std::string checkpoint_filename;
+int checkpoint_interval = 0;
+bool resume = false;
+std::string storage_dbname, storage_backend;
+int ntime_intervals = 1;
+std::string spill_directory;
+double spill_memory_budget = 1024;
 double duration_pruning_threshold = 0.0;
 
 size_t ntimesteps = 0;
@@ -51,6 +61,7 @@ std::vector<std::string> input_filenames;
 
 // contour/levelset specific
 double threshold = 0.0;
+int tracking_graph_window = 0; // streaming tracking graph if nonzero
 
 // adios2 specific
 std::string adios_config_file;
@@ -86,6 +97,11 @@ std::shared_ptr<tdgl_vortex_tracker_3d_regular> tracker_tdgl;
 std::shared_ptr<critical_line_tracker_3d_regular> tracker_critical_line;
 std::shared_ptr<threshold_tracker<>> tracker_threshold;
 std::shared_ptr<ndarray_stream<>> stream;
+std::shared_ptr<ndarray_stream<float>> stream_single; // for single-precision critical point tracking
+bool single_precision = false;
+std::shared_ptr<ndarray_group_stream<>> stream_group; // for critical point tracking w/ attached variables
+std::string input_group_filename, tracked_variable, attached_variables;
+bool attach = false; // if the attached variables are given
 
 nlohmann::json j_input, j_tracker;
 
@@ -128,7 +144,8 @@ static const std::string
 
 static const std::set<std::string>
         set_valid_thread_backend({str_none, "pthread", "openmp", "tbb"}),
-        set_valid_accelerator({str_none, "cuda", "sycl"}),
+        set_valid_accelerator({str_none, "cuda", "sycl", "cpu"}),
+        set_valid_traversal({"row_major", "morton"}),
         set_valid_input_format({str_auto, str_float32, str_float64, str_netcdf, str_hdf5, str_vti, str_adios2}),
         set_valid_input_dimension({str_auto, str_two, str_three});
 
@@ -138,6 +155,21 @@ static void fatal(const cxxopts::Options &options, const std::string& str) {
   exit(1);
 };
 
+static void enable_instrumentation(ftk::filter& f)
+{
+  if (instrumentation_filename.empty() && trace_filename.empty()) return;
+  f.get_instrumentation().set_enabled(true);
+  if (stream) stream->set_instrumentation(&f.get_instrumentation());
+}
+
+static void write_instrumentation(const ftk::filter& f, diy::mpi::communicator comm)
+{
+  if (!instrumentation_filename.empty())
+    f.get_instrumentation().write_json(comm, instrumentation_filename);
+  if (!trace_filename.empty())
+    f.get_instrumentation().write_chrome_trace(comm, trace_filename);
+}
+
 static void initialize_critical_point_tracker(diy::mpi::communicator comm)
 {
   j_tracker["output"] = output_pattern;
@@ -148,7 +180,27 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
   j_tracker["nthreads"] = nthreads;
   j_tracker["enable_timing"] = timing;
 
+  if (!instrumentation_filename.empty())
+    j_tracker["instrumentation_output"] = instrumentation_filename;
+  if (!trace_filename.empty())
+    j_tracker["trace_output"] = trace_filename;
+
+  if (!checkpoint_filename.empty())
+    j_tracker["checkpoint"] = checkpoint_filename;
+  j_tracker["checkpoint_interval"] = checkpoint_interval;
+  j_tracker["resume"] = resume;
+
+  if (!storage_dbname.empty()) {
+    j_tracker["storage"] = storage_dbname;
+    j_tracker["storage_backend"] = storage_backend;
+  }
+
   j_tracker["nblocks"] = std::max(comm.size(), nblocks);
+  j_tracker["ntime_intervals"] = ntime_intervals;
+  if (!spill_directory.empty()) {
+    j_tracker["spill_directory"] = spill_directory;
+    j_tracker["spill_memory_budget"] = spill_memory_budget;
+  }
 
   if (accelerator != str_none)
     j_tracker["accelerator"] = accelerator;
@@ -156,6 +208,8 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
   if (thread_backend != str_none)
     j_tracker["thread_backend"] = thread_backend;
 
+  j_tracker["traversal"] = traversal;
+
   if (archived_intersections_filename.size() > 0)
     j_tracker["archived_discrete_critical_points_filename"] = archived_intersections_filename;
   
@@ -174,6 +228,12 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
   if (disable_robust_detection)
     j_tracker["enable_robust_detection"] = false;
 
+  if (disable_cell_culling)
+    j_tracker["enable_cell_culling"] = false;
+
+  if (enable_lazy_derivatives)
+    j_tracker["enable_lazy_derivatives"] = true;
+
   if (duration_pruning_threshold > 0)
     j_tracker["duration_pruning_threshold"] = duration_pruning_threshold;
 
@@ -181,6 +241,12 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
 
   j_tracker["type_filter"] = type_filter_str;
 
+  if (!tracked_variable.empty())
+    j_tracker["variable"] = tracked_variable;
+  if (attach)
+    j_tracker["attached_variables"] = attached_variables.empty() ? 
+      std::vector<std::string>() : split(attached_variables, ",");
+
   if (xgc_mesh_filename.size() > 0) {
     nlohmann::json jx;
     jx["mesh_filename"] = xgc_mesh_filename;
@@ -198,7 +264,7 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
 
   if (comm.rank() == 0) {
     // fprintf(stderr, "SUMMARY\n=============\n");
-    std::cerr << "input=" << std::setw(2) << stream->get_json() << std::endl;
+    std::cerr << "input=" << std::setw(2) << (stream_group ? stream_group->get_json() : stream->get_json()) << std::endl;
     std::cerr << "config=" << std::setw(2) << wrapper->get_json() << std::endl;
     // fprintf(stderr, "=============\n");
   }
@@ -210,7 +276,9 @@ static void initialize_critical_point_tracker(diy::mpi::communicator comm)
 
 static void execute_critical_point_tracker(diy::mpi::communicator comm)
 {
-  wrapper->consume(*stream, comm);
+  if (stream_group) wrapper->consume(*stream_group, comm);
+  else if (stream_single) wrapper->consume(*stream_single, comm);
+  else wrapper->consume(*stream, comm);
  
   if (!disable_post_processing)
      wrapper->post_process();
@@ -248,6 +316,7 @@ void initialize_contour_tracker(diy::mpi::communicator comm)
 
 void execute_contour_tracker(diy::mpi::communicator comm)
 {
+  enable_instrumentation(*tracker_contour);
   tracker_contour->initialize();
   stream->set_callback([&](int k, const ndarray<double> &field_data) {
     tracker_contour->push_field_data_snapshot(field_data);
@@ -258,6 +327,7 @@ void execute_contour_tracker(diy::mpi::communicator comm)
   stream->start();
   stream->finish();
   tracker_contour->finalize();
+  write_instrumentation(*tracker_contour, comm);
 
   if (output_type == "intersections") {
     tracker_contour->write_intersections_vtp(output_pattern);
@@ -276,6 +346,15 @@ void initialize_threshold_tracker(diy::mpi::communicator comm)
 void execute_threshold_tracker(diy::mpi::communicator comm)
 {
   tracker_threshold->set_threshold( threshold );
+  if (tracking_graph_window > 0) {
+    tracker_threshold->enable_streaming_tracking_graph(tracking_graph_window, output_pattern);
+    if (verbose) // events are also written to the output with their timesteps
+      tracker_threshold->get_streaming_tracking_graph().set_event_callback(
+          [&](const Event<size_t, size_t>& e) {
+            const nlohmann::json j = e;
+            fprintf(stderr, "event=%s\n", j.dump().c_str());
+          });
+  }
 
   stream->set_callback([&](int k, ftk::ndarray<double> field_data) {
     fprintf(stderr, "current_timestep=%d\n", k);
@@ -287,8 +366,10 @@ void execute_threshold_tracker(diy::mpi::communicator comm)
   stream->finish();
   tracker_threshold->finalize();
 
-  const auto &tg = tracker_threshold->get_tracking_graph();
-  tg.generate_dot_file("dot"); // TODO
+  if (!tracker_threshold->is_streaming()) {
+    const auto &tg = tracker_threshold->get_tracking_graph();
+    tg.generate_dot_file("dot"); // TODO
+  }
 }
 
 void initialize_xgc(diy::mpi::communicator comm)
@@ -539,6 +620,7 @@ void initialize_critical_line_tracker(diy::mpi::communicator comm)
 
 void execute_critical_line_tracker(diy::mpi::communicator comm)
 {
+  enable_instrumentation(*tracker_critical_line);
   tracker_critical_line->initialize();
   stream->set_callback([&](int k, const ndarray<double> &field_data) {
     tracker_critical_line->push_field_data_snapshot(field_data);
@@ -553,6 +635,7 @@ void execute_critical_line_tracker(diy::mpi::communicator comm)
     tracker_critical_line->write_intersections(output_pattern);
   
   tracker_critical_line->finalize();
+  write_instrumentation(*tracker_critical_line, comm);
   if (output_type == "sliced")
     tracker_critical_line->write_sliced(output_pattern);
   else if (output_type == "traced")
@@ -596,6 +679,7 @@ void initialize_tdgl_tracker(diy::mpi::communicator comm)
 
 void execute_tdgl_tracker(diy::mpi::communicator comm)
 {
+  enable_instrumentation(*tracker_tdgl);
   tracker_tdgl->initialize();
 
   if (!archived_intersections_filename.empty()) {
@@ -615,6 +699,7 @@ void execute_tdgl_tracker(diy::mpi::communicator comm)
       if (k == ntimesteps - 1) tracker_tdgl->update_timestep();
     }
     tracker_tdgl->finalize();
+    write_instrumentation(*tracker_tdgl, comm);
   }
 
   if (output_type == "intersections")
@@ -703,6 +788,12 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
     ("d,depth", "Depth (valid only for 3D regular grid data)", cxxopts::value<size_t>())
     ("n,timesteps", "Number of timesteps", cxxopts::value<size_t>(ntimesteps))
     ("var", "Variable name(s), e.g. `scalar', `u,v,w'.  Valid only for NetCDF, HDF5, and VTK.", cxxopts::value<std::string>())
+    ("input-group", "JSON specification of a group of named arrays (see ndarray_group_stream.hh); shadows other input arguments (critical point tracking on regular grids only)",
+     cxxopts::value<std::string>(input_group_filename))
+    ("tracked-var", "Key of the tracked array in the group; required unless the group has only one array",
+     cxxopts::value<std::string>(tracked_variable))
+    ("attach", "Keys of the arrays in the group attached to critical points as scalars, e.g. `pressure,density'; by default all other arrays",
+     cxxopts::value<std::string>(attached_variables))
     ("adios-config", "ADIOS2 config file", cxxopts::value<std::string>(adios_config_file))
     ("adios-name", "ADIOS2 I/O name", cxxopts::value<std::string>(adios_name))
     ("temporal-smoothing-kernel", "Temporal smoothing kernel bandwidth", cxxopts::value<double>())
@@ -711,8 +802,10 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
     ("spatial-smoothing-kernel-size", "Spatial smoothing kernel size", cxxopts::value<size_t>())
     ("perturbation", "Gaussian perturbation sigma", cxxopts::value<double>())
     ("threshold", "Threshold", cxxopts::value<double>(threshold))
+    ("tracking-graph-window", "Threshold tracking: label and detect events every timestep, keeping the given number of timesteps in memory and writing older ones to the output as JSON lines",
+     cxxopts::value<int>(tracking_graph_window))
     ("m,mesh", "Input mesh file (will shadow arguments including width, height, depth)", cxxopts::value<std::string>())
-    ("nblocks", "Number of total blocks", cxxopts::value<int>(nblocks))
+    ("nblocks", "Number of total blocks (load balanced between timesteps if more than processes)", cxxopts::value<int>(nblocks))
     // ("archived-discrete-critical-points", "Archived discrete critical points", cxxopts::value<std::string>(archived_discrete_critical_points_filename))
     ("archived-intersections", "Archived discrete intersections", cxxopts::value<std::string>(archived_intersections_filename))
     ("archived-traced", "Archived traced results", cxxopts::value<std::string>(archived_traced_filename))
@@ -733,7 +826,7 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
      cxxopts::value<std::string>(output_pattern))
     ("output-type", "Output type {discrete|traced|sliced|intercepted}, by default traced", 
      cxxopts::value<std::string>(output_type)->default_value("traced"))
-    ("output-format", "Output format {text|vtp|vtu|ply}.  The default behavior is to automatically determine format by filename", 
+    ("output-format", "Output format {text|vtp|vtu|ply|indexed}.  The default behavior is to automatically determine format by filename", 
      cxxopts::value<std::string>(output_format)->default_value(str_auto))
     ("intercept-length", "Length of intercepted outputs", 
      cxxopts::value<int>(intercept_length)->default_value("2"))
@@ -741,13 +834,35 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
      cxxopts::value<std::string>(type_filter_str))
     ("thread-backend", "Thread backends {pthread|openmp|tbb}",
      cxxopts::value<std::string>(thread_backend)->default_value(str_none))
+    ("traversal", "Order of simplex sweeps on regular grids {row_major|morton}; morton visits tiles of cells in z-order",
+     cxxopts::value<std::string>(traversal)->default_value("row_major"))
     ("affinity", "Enable thread affinity", 
      cxxopts::value<bool>(affinity))
-    ("nthreads", "Number of threads", 
-     cxxopts::value<int>(nthreads))
+    ("nthreads", "Number of threads per process; 0 for the CPUs available to the process (affinity mask and cgroup quota)", 
+     cxxopts::value<int>(nthreads)->default_value("0"))
     ("timing", "Enable timing", 
      cxxopts::value<bool>(timing))
-    ("a,accelerator", "Accelerator {none|cuda} (experimental)",
+    ("instrumentation", "Write timers and counters (aggregated over threads and processes) to a JSON file",
+     cxxopts::value<std::string>(instrumentation_filename))
+    ("trace", "Write timed phases to a Chrome trace-event file (chrome://tracing or ui.perfetto.dev)",
+     cxxopts::value<std::string>(trace_filename))
+    ("checkpoint", "Checkpoint file of the tracker state (critical point tracking on regular grids only)",
+     cxxopts::value<std::string>(checkpoint_filename))
+    ("checkpoint-interval", "Checkpoint every n timesteps in the background; 0 disables checkpointing",
+     cxxopts::value<int>(checkpoint_interval)->default_value("0"))
+    ("resume", "Resume from the checkpoint, if exists",
+     cxxopts::value<bool>(resume))
+    ("storage", "Write results incrementally to a key-value store (critical point tracking only)",
+     cxxopts::value<std::string>(storage_dbname))
+    ("storage-backend", "Storage backend {native|leveldb|rocksdb}",
+     cxxopts::value<std::string>(storage_backend)->default_value("native"))
+    ("time-intervals", "Number of time intervals tracked in parallel by processes and threads (critical point tracking on regular grids only)",
+     cxxopts::value<int>(ntime_intervals)->default_value("1"))
+    ("spill-dir", "Scratch directory to which discrete critical points are spilled if exceeding the memory budget (critical point tracking on regular grids only)",
+     cxxopts::value<std::string>(spill_directory))
+    ("spill-memory-budget", "Memory budget (in MB) of discrete critical points before spilling",
+     cxxopts::value<double>(spill_memory_budget)->default_value("1024"))
+    ("a,accelerator", "Accelerator {none|cuda|cpu} (experimental); cpu runs the flat-index gpu kernels on cpus",
      cxxopts::value<std::string>(accelerator)->default_value(str_none))
     ("device", "Device ID(s)", 
      cxxopts::value<std::string>(device_ids)->default_value("0"))
@@ -761,6 +876,12 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
      cxxopts::value<bool>(enable_deriving_velocities))
     ("no-robust-detection", "Disable robust detection (faster than robust detection)",
      cxxopts::value<bool>(disable_robust_detection))
+    ("no-cell-culling", "Disable skipping cells with uniform vector component signs",
+     cxxopts::value<bool>(disable_cell_culling))
+    ("lazy-derivatives", "Evaluate gradients and jacobians of scalar fields on the fly instead of storing them",
+     cxxopts::value<bool>(enable_lazy_derivatives))
+    ("single-precision", "Read and track critical points in float32 instead of float64 (regular grids only)",
+     cxxopts::value<bool>(single_precision))
     ("no-post-processing", "Disable post-processing",
      cxxopts::value<bool>(disable_post_processing))
     ("duration-pruning", "Prune trajectories below certain duration", 
@@ -773,6 +894,9 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
   if (set_valid_accelerator.find(accelerator) == set_valid_accelerator.end())
     fatal(options, "invalid '--accelerator'");
 
+  if (set_valid_traversal.find(traversal) == set_valid_traversal.end())
+    fatal(options, "invalid '--traversal'");
+
   if (output_pattern.empty())
     fatal(options, "Missing '--output'.");
 
@@ -784,10 +908,28 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
   }
   
   ttype = tracker::str2tracker(feature);
-  if (ttype != TRACKER_TDGL_VORTEX) { // TDGL uses a different reader for now
+  attach = results.count("attach");
+  if (!input_group_filename.empty()) {
+    if (ttype != TRACKER_CRITICAL_POINT)
+      fatal(options, "'--input-group' is only supported for critical point tracking");
+    if (single_precision)
+      fatal(options, "'--single-precision' is not supported with '--input-group'");
+    stream_group.reset(new ndarray_group_stream<>(comm));
+    stream_group->set_input_source_json_file(input_group_filename);
+  } else if (ttype != TRACKER_TDGL_VORTEX) { // TDGL uses a different reader for now
     j_input = args_to_input_stream_json(results);
     stream->set_input_source_json(j_input);
   }
+
+  if (single_precision) {
+    if (ttype != TRACKER_CRITICAL_POINT)
+      fatal(options, "'--single-precision' is only supported for critical point tracking");
+    if (results.count("adios-config"))
+      stream_single.reset(new ndarray_stream<float>(adios_config_file, adios_name, comm));
+    else 
+      stream_single.reset(new ndarray_stream<float>(comm));
+    stream_single->set_input_source_json(j_input);
+  }
   
   if (results.count("xgc-smoothing-kernel-size") || results.count("xgc-smoothing-kernel-file"))
     xgc_use_smoothing_kernel = true;
@@ -804,6 +946,8 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
     initialize_xgc_blob_filament_tracker(comm);
   else if (ttype == TRACKER_XGC_BLOB_THRESHOLD)
     initialize_xgc_blob_threshold_tracker(comm);
+  else if (ttype == TRACKER_CONNECTED_COMPONENTS || ttype == TRACKER_THRESHOLD)
+    initialize_threshold_tracker(comm);
   else 
     fatal(options, "missing or invalid '--feature'");
 
@@ -812,7 +956,7 @@ int parse_arguments(int argc, char **argv, diy::mpi::communicator comm)
 
 int main(int argc, char **argv)
 {
-  diy::mpi::environment env(argc, argv);
+  diy::mpi::environment env(argc, argv, MPI_THREAD_MULTIPLE); // for concurrent time intervals
   diy::mpi::communicator wcomm; // world
   diy::mpi::communicator comm = wcomm.split(wcomm, 20 /* a magic number as color */);
  
@@ -826,6 +970,8 @@ int main(int argc, char **argv)
     execute_contour_tracker(comm);
   else if (ttype == TRACKER_TDGL_VORTEX)
     execute_tdgl_tracker(comm);
+  else if (ttype == TRACKER_CONNECTED_COMPONENTS || ttype == TRACKER_THRESHOLD)
+    execute_threshold_tracker(comm);
 
   return 0;
 }
@@ -0,0 +1,248 @@
+#ifndef _FTK_CRITICAL_POINT_TRACER_REGULAR_CUH
+#define _FTK_CRITICAL_POINT_TRACER_REGULAR_CUH
+
+#include <ftk/numeric/inverse_linear_interpolation_solver.hh>
+#include <ftk/numeric/linear_interpolation.hh>
+#include <ftk/numeric/clamp.hh>
+#include <ftk/numeric/symmetric_matrix.hh>
+#include <ftk/numeric/critical_point_type.hh>
+#include <ftk/numeric/critical_point_test.hh>
+#include <ftk/config.hh>
+#include "common.cuh"
+#include <cmath>
+
+#if FTK_HAVE_GMP && !defined(__CUDACC__)
+#define FTK_CP2T_EXACT_SIGNS 1
+#include <gmpxx.h>
+#endif
+
+// Simplex tests of the flat-index critical point extractors, shared by the
+// cuda kernels and the cpu sweeps.  Vectors are quantized by fixed_factor
+// for the robust test, the same way as critical_point_tracker::fixed_point;
+// simplices w/ non-finite vectors are rejected.  W/ gmp, the 2D test on cpus
+// takes exact signs, the same way as critical_point_tracker_2d_regular.
+
+__device__ __host__
+inline bool isfinite_lite(double x)
+{
+#ifdef __CUDACC__
+  return isfinite(x);
+#else
+  return std::isfinite(x);
+#endif
+}
+
+template <typename F>
+__device__ __host__
+inline long long fixed_point_lite(F x, double fixed_factor)
+{
+  // non-finite values are rejected by the tests anyways
+  return isfinite_lite(x) ? static_cast<long long>(static_cast<double>(x) * fixed_factor) : 0;
+}
+
+template <int scope, typename F> // F is the value type of inputs
+__device__ __host__
+bool check_simplex_cp2t(
+    int current_timestep,
+    const lattice3_t& domain,
+    const lattice3_t& core,
+    const lattice2_t& ext,
+    const element32_t& e,
+    const F *V[2], // current and next timesteps
+    const F *gradV[2], // jacobians
+    const F *scalar[2], // scalars
+    bool use_explicit_coords,
+    const double *coords, // coordinates of vertices
+    double fixed_factor,
+    bool symmetric_jacobian,
+    cp_t &cp)
+{
+  // const int last_timestep = current_timestep - 1;
+  // if (scope == scope_interval && e.corner[2] != current_timestep) // last_timestep)
+  if (e.corner[2] != current_timestep) // last_timestep)
+    return false;
+
+  int vertices[3][3], indices[3];
+  size_t local_indices[3];
+  for (int i = 0; i < 3; i ++) {
+    for (int j = 0; j < 3; j ++) {
+      vertices[i][j] = e.corner[j]
+        + unit_simplex_offset_3_2<scope>(e.type, i, j);
+      if (vertices[i][j] < domain.st[j] ||
+           vertices[i][j] > domain.st[j] + domain.sz[j] - 1)
+      // if (vertices[i][j] < core.st[j] ||
+      //     vertices[i][j] > core.st[j] + core.sz[j] - 1)
+        return false;
+    }
+    indices[i] = domain.to_index(vertices[i]);
+    local_indices[i] = ext.to_index(vertices[i]);
+  }
+
+  double v[3][2];
+#if FTK_CP2T_EXACT_SIGNS
+  mpf_class vf[3][2];
+#else
+  long long vf[3][2];
+#endif
+  for (int i = 0; i < 3; i ++) {
+    // size_t k = ext.to_index(vertices[i]);
+    const size_t k = local_indices[i];
+    for (int j = 0; j < 2; j ++) {
+      v[i][j] = V[unit_simplex_offset_3_2<scope>(e.type, i, 2/*time dimension id*/)][k*2+j];
+      if (!isfinite_lite(v[i][j])) return false;
+#if FTK_CP2T_EXACT_SIGNS
+      vf[i][j] = v[i][j];
+#else
+      vf[i][j] = fixed_point_lite(v[i][j], fixed_factor);
+#endif
+    }
+  }
+
+  bool succ = ftk::robust_critical_point_in_simplex2(vf, indices);
+  if (succ) {
+    // inverse interpolation
+    double mu[3];
+    double cond;
+    bool succ2 = ftk::inverse_lerp_s2v2(v, mu, &cond);
+    if (!succ2) ftk::clamp_barycentric<3>(mu);
+
+    // linear jacobian interpolation
+    double J[2][2] = {0};
+    if (gradV[0]) { // have given jacobian
+      double Js[3][2][2];
+      for (int i = 0; i < 3; i ++) {
+        // size_t ii = ext.to_index(vertices[i]);
+        const size_t ii = local_indices[i];
+        const int t = unit_simplex_offset_3_2<scope>(e.type, i, 2);
+        for (int j = 0; j < 2; j ++)
+          for (int k = 0; k < 2; k ++)
+            Js[i][j][k] = gradV[t][ii*4 + j*2 + k];
+      }
+      ftk::lerp_s2m2x2(Js, mu, J);
+      ftk::make_symmetric2x2(J);
+    }
+    cp.type = ftk::critical_point_type_2d(J, symmetric_jacobian);
+
+    // scalar interpolation
+    if (scalar[0]) { // have given scalar
+      double values[3];
+      for (int i = 0; i < 3; i ++) {
+        // const size_t ii = ext.to_index(vertices[i]);
+        const size_t ii = local_indices[i];
+        const int t = unit_simplex_offset_3_2<scope>(e.type, i, 2);
+        values[i] = scalar[t][ii];
+      }
+      cp.scalar[0] = ftk::lerp_s2(values, mu);
+      // if (abs(cp.scalar) < 0.02) return false; // threshold
+    }
+
+    double X[3][3], x[3];
+    for (int i = 0; i < 3; i ++) {
+      for (int j = 0; j < 2; j ++)
+        X[i][j] = use_explicit_coords ? coords[j + local_indices[i]*2] : vertices[i][j];
+      X[i][2] = vertices[i][2];
+    }
+    ftk::lerp_s2v3(X, mu, x);
+    cp.x[0] = x[0];
+    cp.x[1] = x[1];
+    cp.t = x[2];
+    cp.cond = cond;
+
+    return true;
+  } else
+    return false;
+}
+
+template <int scope, typename F> // F is the value type of inputs
+__device__ __host__
+bool check_simplex_cp3t(
+    int current_timestep,
+    const lattice4_t& domain,
+    const lattice4_t& core,
+    const lattice3_t& ext, // array dimension
+    const element43_t& e,
+    const F *V[2], // current and next timesteps
+    const F *gradV[2], // jacobians
+    const F *scalar[2], // scalars
+    double fixed_factor,
+    bool symmetric_jacobian,
+    cp_t &cp)
+{
+  // const int last_timestep = current_timestep - 1;
+  // if (scope == scope_interval && e.corner[3] != last_timestep)
+  if (e.corner[3] != current_timestep)
+    return false;
+
+  int vertices[4][4], indices[4];
+  size_t local_indices[4];
+  for (int i = 0; i < 4; i ++) {
+    for (int j = 0; j < 4; j ++) {
+      vertices[i][j] = e.corner[j]
+        + unit_simplex_offset_4_3<scope>(e.type, i, j);
+      if (vertices[i][j] < domain.st[j] ||
+          vertices[i][j] > domain.st[j] + domain.sz[j] - 1)
+        return false;
+    }
+    indices[i] = domain.to_index(vertices[i]);
+    local_indices[i] = ext.to_index(vertices[i]);
+  }
+
+  double v[4][3];
+  long long vf[4][3];
+  for (int i = 0; i < 4; i ++) {
+    const size_t k = local_indices[i]; // k = ext.to_index(vertices[i]);
+    for (int j = 0; j < 3; j ++) {
+      v[i][j] = V[unit_simplex_offset_4_3<scope>(e.type, i, 3)][k*3+j]; // V has three channels
+      if (!isfinite_lite(v[i][j])) return false;
+      vf[i][j] = fixed_point_lite(v[i][j], fixed_factor);
+    }
+  }
+
+  bool succ = ftk::robust_critical_point_in_simplex3(vf, indices);
+  if (!succ) return false;
+
+  double mu[4], cond;
+  ftk::inverse_lerp_s3v3(v, mu, &cond); //, 0.0);
+  ftk::clamp_barycentric<4>(mu);
+
+  // linear jacobian interpolation
+  double J[3][3] = {0};
+  if (gradV[0]) { // have given jacobian
+    double Js[4][3][3];
+    for (int i = 0; i < 4; i ++) {
+      size_t ii = local_indices[i]; // ext.to_index(vertices[i]);
+      int t = unit_simplex_offset_4_3<scope>(e.type, i, 3);
+      for (int j = 0; j < 3; j ++)
+        for (int k = 0; k < 3; k ++)
+          Js[i][j][k] = gradV[t][ii*9 + j*3 + k];
+    }
+    ftk::lerp_s3m3x3(Js, mu, J);
+    if (symmetric_jacobian) ftk::make_symmetric3x3(J);
+  }
+  cp.type = ftk::critical_point_type_3d(J, symmetric_jacobian);
+
+  // scalar interpolation
+  if (scalar[0]) { // have given scalar
+    double values[4];
+    for (int i = 0; i < 4; i ++) {
+      size_t ii = local_indices[i]; // ext.to_index(vertices[i]);
+      int t = unit_simplex_offset_4_3<scope>(e.type, i, 3);
+      values[i] = scalar[t][ii];
+    }
+    cp.scalar[0] = ftk::lerp_s3(values, mu);
+  }
+
+  double X[4][4], x[4];
+  for (int i = 0; i < 4; i ++)
+    for (int j = 0; j < 4; j ++)
+      X[i][j] = vertices[i][j];
+  ftk::lerp_s3v4(X, mu, x);
+  cp.x[0] = x[0];
+  cp.x[1] = x[1];
+  cp.x[2] = x[2];
+  cp.t = x[3];
+  cp.cond = cond;
+  return true;
+}
+
+#endif
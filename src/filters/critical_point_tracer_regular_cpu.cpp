@@ -0,0 +1,302 @@
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <ftk/config.hh>
+#include <ftk/object.hh>
+#include <ftk/mesh/lattice.hh>
+#include "critical_point_tracer_regular.cuh"
+
+// CPU counterparts of the flat-index cuda extractors: the same simplex tests
+// and lite outputs (tags are work indices), swept row by row w/ threads.
+// Within a segment of a row, the simplices of one type are prefiltered by the
+// signs of the quantized vectors (exact ones in 2D w/ gmp) in a vectorizable 
+// loop, and only candidates go through the robust test.
+
+template <int nd/*spacetime dims*/, int scope> struct unit_simplices_lite;
+
+template <int scope> struct unit_simplices_lite<3, scope> { // 2-simplices in 3D spacetime
+  static int ntypes() { return ntypes_3_2<scope>(); }
+  static int offset(int type, int i, int j) { return unit_simplex_offset_3_2<scope>(type, i, j); }
+};
+
+template <int scope> struct unit_simplices_lite<4, scope> { // 3-simplices in 4D spacetime
+  static int ntypes() { return ntypes_4_3<scope>(); }
+  static int offset(int type, int i, int j) { return unit_simplex_offset_4_3<scope>(type, i, j); }
+};
+
+// mask[k] is false if a component of the quantized (or exact) vectors is 
+// nonzero w/ the same sign on all vertices, which excludes zeros by the robust test
+template <int nv/*vertices*/, int nc/*components*/, bool exact, typename F>
+static void sign_prefilter(const F *p[nv], int n, double fixed_factor, unsigned char *mask)
+{
+#pragma omp simd
+  for (int k = 0; k < n; k ++) {
+    bool candidate = true;
+    for (int j = 0; j < nc; j ++) {
+      bool nonpositive = false, nonnegative = false;
+      for (int i = 0; i < nv; i ++) {
+        const F x = p[i][k*nc + j];
+        const long long q = fixed_point_lite(x, fixed_factor); // the same integers as the robust test
+        const int sign = exact ? (x > 0) - (x < 0) : (q > 0) - (q < 0);
+        nonpositive |= sign <= 0;
+        nonnegative |= sign >= 0;
+      }
+      candidate &= nonpositive & nonnegative;
+    }
+    mask[k] = candidate;
+  }
+}
+
+template <int nd, int scope, bool exact/*signs*/, typename F, typename Check>
+static std::vector<cp_t> sweep_simplices_cpu(
+    int current_timestep,
+    const lite_lattice_t<nd>& domain,
+    const lite_lattice_t<nd>& core,
+    const lite_lattice_t<nd-1>& ext, // array dimensions
+    const F *V[2],
+    double fixed_factor,
+    int thread_backend, int nthreads,
+    size_t *nsimplices, // incremented by the number of simplices scanned, incl. skipped ones
+    Check check)
+{
+  typedef unit_simplices_lite<nd, scope> simplices_t;
+  const int nv = nd, nc = nd - 1; // vertices of a simplex and components of vectors
+  const int ntypes = simplices_t::ntypes();
+
+  const int segment_size = 4096;
+  const int nsegments = (core.sz[0] + segment_size - 1) / segment_size;
+  const size_t nrows = core.n() / core.sz[0];
+  std::vector<std::vector<cp_t>> results(nrows * nsegments);
+  std::atomic<size_t> nscanned(0);
+
+  ftk::object::parallel_for(results.size(), [&](int task) {
+    int corner[nd];
+    core.from_index(static_cast<size_t>(task / nsegments) * core.sz[0], corner);
+    const int x0 = corner[0] + (task % nsegments) * segment_size,
+              x1 = std::min(x0 + segment_size, core.st[0] + core.sz[0]);
+    if (corner[nd-1] != current_timestep) return;
+    nscanned += static_cast<size_t>(x1 - x0) * ntypes;
+
+    std::vector<unsigned char> mask(x1 - x0);
+    for (int type = 0; type < ntypes; type ++) {
+      // cells whose vertices of the type are in both the domain and the array
+      int xa = x0, xb = x1;
+      bool valid = true;
+      for (int i = 0; i < nv; i ++) {
+        const int dx = simplices_t::offset(type, i, 0);
+        xa = std::max(xa, std::max(domain.st[0], ext.st[0]) - dx);
+        xb = std::min(xb, std::min(domain.st[0] + domain.sz[0], ext.st[0] + ext.sz[0]) - dx);
+        for (int j = 1; j < nd; j ++) {
+          const int x = corner[j] + simplices_t::offset(type, i, j);
+          valid = valid && x >= domain.st[j] && x - domain.st[j] < domain.sz[j];
+          if (j < nd - 1)
+            valid = valid && x >= ext.st[j] && x - ext.st[j] < ext.sz[j];
+        }
+        valid = valid && V[simplices_t::offset(type, i, nd-1)];
+      }
+      if (!valid || xa >= xb) continue;
+
+      const F *p[nv];
+      for (int i = 0; i < nv; i ++) {
+        int vertex[nd-1];
+        for (int j = 0; j < nd - 1; j ++)
+          vertex[j] = corner[j] + simplices_t::offset(type, i, j);
+        vertex[0] = xa + simplices_t::offset(type, i, 0);
+        p[i] = V[simplices_t::offset(type, i, nd-1)] + nc * ext.to_index(vertex);
+      }
+      sign_prefilter<nv, nc, exact>(p, xb - xa, fixed_factor, mask.data());
+
+      lite_element_t<nd> e;
+      for (int j = 0; j < nd; j ++)
+        e.corner[j] = corner[j];
+      e.type = type;
+      for (int x = xa; x < xb; x ++) {
+        if (!mask[x - xa]) continue;
+        e.corner[0] = x;
+
+        cp_t cp;
+        if (check(e, cp)) {
+          cp.tag = core.to_index(e.corner) * ntypes + type;
+          results[task].push_back(cp);
+        }
+      }
+    }
+  }, thread_backend, nthreads, false);
+  if (nsimplices) *nsimplices += nscanned;
+
+  std::vector<cp_t> cps;
+  for (const auto &r : results)
+    cps.insert(cps.end(), r.begin(), r.end());
+  std::sort(cps.begin(), cps.end(), [](const cp_t& a, const cp_t& b) {return a.tag < b.tag;});
+  return cps;
+}
+
+template <int scope, typename F>
+static std::vector<cp_t> extract_cp2dt_cpu_scope(
+    int current_timestep,
+    const lattice3_t& domain,
+    const lattice3_t& core,
+    const lattice2_t& ext,
+    const F *Vc, const F *Vn,
+    const F *Jc, const F *Jn,
+    const F *Sc, const F *Sn,
+    bool use_explicit_coords,
+    const double *coords,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  const F *V[2] = {Vc, Vn}, *J[2] = {Jc, Jn}, *S[2] = {Sc, Sn};
+#if FTK_CP2T_EXACT_SIGNS
+  const bool exact = true;
+#else
+  const bool exact = false;
+#endif
+  return sweep_simplices_cpu<3, scope, exact, F>(current_timestep, domain, core, ext,
+      V, fixed_factor, thread_backend, nthreads, nsimplices,
+      [&](const element32_t& e, cp_t& cp) {
+        return check_simplex_cp2t<scope, F>(current_timestep, domain, core, ext, e, V, J, S,
+            use_explicit_coords, coords, fixed_factor, symmetric_jacobian, cp);
+      });
+}
+
+template <typename F>
+static std::vector<cp_t> extract_cp2dt_cpu_(
+    int scope,
+    int current_timestep,
+    const ftk::lattice& domain,
+    const ftk::lattice& core,
+    const ftk::lattice& ext,
+    const F *Vc, const F *Vn,
+    const F *Jc, const F *Jn,
+    const F *Sc, const F *Sn,
+    bool use_explicit_coords,
+    const double *coords,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  lattice3_t D(domain);
+  lattice3_t C(core);
+  lattice2_t E(ext);
+
+  if (scope == scope_interval)
+    return extract_cp2dt_cpu_scope<scope_interval, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords,
+        fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  else if (scope == scope_ordinal)
+    return extract_cp2dt_cpu_scope<scope_ordinal, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords,
+        fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  else
+    return extract_cp2dt_cpu_scope<scope_all, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords,
+        fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
+
+std::vector<cp_t>
+extract_cp2dt_cpu(
+    int scope, int current_timestep,
+    const ftk::lattice& domain, const ftk::lattice& core, const ftk::lattice& ext,
+    const double *Vc, const double *Vn,
+    const double *Jc, const double *Jn,
+    const double *Sc, const double *Sn,
+    bool use_explicit_coords, const double *coords,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  return extract_cp2dt_cpu_<double>(scope, current_timestep, domain, core, ext,
+      Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords,
+      fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
+
+std::vector<cp_t>
+extract_cp2dt_cpu(
+    int scope, int current_timestep,
+    const ftk::lattice& domain, const ftk::lattice& core, const ftk::lattice& ext,
+    const float *Vc, const float *Vn,
+    const float *Jc, const float *Jn,
+    const float *Sc, const float *Sn,
+    bool use_explicit_coords, const double *coords,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  return extract_cp2dt_cpu_<float>(scope, current_timestep, domain, core, ext,
+      Vc, Vn, Jc, Jn, Sc, Sn, use_explicit_coords, coords,
+      fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
+
+template <int scope, typename F>
+static std::vector<cp_t> extract_cp3dt_cpu_scope(
+    int current_timestep,
+    const lattice4_t& domain,
+    const lattice4_t& core,
+    const lattice3_t& ext,
+    const F *Vc, const F *Vn,
+    const F *Jc, const F *Jn,
+    const F *Sc, const F *Sn,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  const F *V[2] = {Vc, Vn}, *J[2] = {Jc, Jn}, *S[2] = {Sc, Sn};
+  return sweep_simplices_cpu<4, scope, false, F>(current_timestep, domain, core, ext,
+      V, fixed_factor, thread_backend, nthreads, nsimplices,
+      [&](const element43_t& e, cp_t& cp) {
+        return check_simplex_cp3t<scope, F>(current_timestep, domain, core, ext, e, V, J, S,
+            fixed_factor, symmetric_jacobian, cp);
+      });
+}
+
+template <typename F>
+static std::vector<cp_t> extract_cp3dt_cpu_(
+    int scope,
+    int current_timestep,
+    const ftk::lattice& domain,
+    const ftk::lattice& core,
+    const ftk::lattice& ext,
+    const F *Vc, const F *Vn,
+    const F *Jc, const F *Jn,
+    const F *Sc, const F *Sn,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  lattice4_t D(domain);
+  lattice4_t C(core);
+  lattice3_t E(ext);
+
+  if (scope == scope_interval)
+    return extract_cp3dt_cpu_scope<scope_interval, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  else if (scope == scope_ordinal)
+    return extract_cp3dt_cpu_scope<scope_ordinal, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+  else
+    return extract_cp3dt_cpu_scope<scope_all, F>(current_timestep, D, C, E,
+        Vc, Vn, Jc, Jn, Sc, Sn, fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
+
+std::vector<cp_t>
+extract_cp3dt_cpu(
+    int scope, int current_timestep,
+    const ftk::lattice& domain, const ftk::lattice& core, const ftk::lattice& ext,
+    const double *Vc, const double *Vn,
+    const double *Jc, const double *Jn,
+    const double *Sc, const double *Sn,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  return extract_cp3dt_cpu_<double>(scope, current_timestep, domain, core, ext,
+      Vc, Vn, Jc, Jn, Sc, Sn, fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
+
+std::vector<cp_t>
+extract_cp3dt_cpu(
+    int scope, int current_timestep,
+    const ftk::lattice& domain, const ftk::lattice& core, const ftk::lattice& ext,
+    const float *Vc, const float *Vn,
+    const float *Jc, const float *Jn,
+    const float *Sc, const float *Sn,
+    double fixed_factor, bool symmetric_jacobian,
+    int thread_backend, int nthreads, size_t *nsimplices)
+{
+  return extract_cp3dt_cpu_<float>(scope, current_timestep, domain, core, ext,
+      Vc, Vn, Jc, Jn, Sc, Sn, fixed_factor, symmetric_jacobian, thread_backend, nthreads, nsimplices);
+}
@@ -11,6 +11,25 @@ namespace ftk {
 
 template <>
 bool solve_polynomials(const double * x, int n, double * root_real, double * root_im)
+{
+  if (n <= polynomial_solver_max_degree) {
+    std::complex<double> roots[polynomial_solver_max_degree];
+    const int nroots = std::max(0, solve_polynomial(x, n, roots));
+    for (int i = 0; i < n; i ++) {
+      root_real[i] = i < nroots ? roots[i].real() : std::numeric_limits<double>::quiet_NaN();
+      root_im[i] = i < nroots ? roots[i].imag() : std::numeric_limits<double>::quiet_NaN();
+    }
+    return true;
+  } else if (solve_polynomials_mpsolve(x, n, root_real, root_im)) {
+    return true;
+  } else {
+    fprintf(stderr, "[ftk] FATAL: no polynomial solvers are linked for degree %d.\n", n);
+    assert(false);
+    return false;
+  }
+}
+
+bool solve_polynomials_mpsolve(const double * x, int n, double * root_real, double * root_im)
 {
 #if FTK_HAVE_MPSOLVE
 	mps_context * s = mps_context_new();
@@ -31,9 +50,7 @@ bool solve_polynomials(const double * x, int n, double * root_real, double * roo
 	if(poly) mps_monomial_poly_free(s, MPS_POLYNOMIAL(poly));
 	mps_context_free(s);
 	return true;
-#else 
-  fprintf(stderr, "[ftk] FATAL: no polynomial solvers are linked.\n");
-  assert(false);
+#else
   return false;
 #endif
 }
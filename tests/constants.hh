@@ -177,21 +177,38 @@ const json jw_moving_ramp_3d_vti = {
   {"variable", "scalar"}
 };
 
-static std::tuple<size_t, size_t> track_cp2d(const json jstream, const json jconfig = json())
+// consumes the stream w/ the given options; callers that inspect partial
+// results before post-processing pass post_process=false
+template <typename T=double, typename stream_type=ftk::ndarray_stream<T>> // value type of inputs
+static std::shared_ptr<ftk::json_interface> consume_stream(const json jstream, const json jconfig = json(), bool post_process = true)
 {
-  ftk::ndarray_stream<> stream;
+  stream_type stream;
   stream.configure(jstream);
 
-  ftk::json_interface consumer;
-  consumer.configure(jconfig);
-  consumer.consume(stream);
-  consumer.post_process();
-  consumer.write();
+  std::shared_ptr<ftk::json_interface> consumer(new ftk::json_interface);
+  consumer->configure(jconfig);
+  consumer->consume(stream);
+  if (post_process)
+    consumer->post_process();
+  return consumer;
+}
+
+template <typename T=double> // value type of inputs
+static std::tuple<size_t, size_t> track_cp2d(const json jstream, const json jconfig = json())
+{
+  auto consumer = consume_stream<T>(jstream, jconfig);
+  consumer->write();
     
-  auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker_2d_regular>( consumer.get_tracker() );
+  auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker_2d_regular<T>>( consumer->get_tracker() );
   auto trajs = tracker->get_traced_critical_points();
-  auto points = tracker->get_discrete_critical_points();
+  auto points = tracker->get_critical_points();
   return {trajs.size(), points.size()};
 }
 
+template <typename T=double> // value type of inputs
+static ftk::feature_curve_set_t track_cp_trajectories(const json jstream, const json jconfig = json())
+{
+  return consume_stream<T>(jstream, jconfig)->get_tracker()->get_traced_critical_points();
+}
+
 #endif
@@ -87,3 +87,72 @@ TEST_CASE("3D_conv_gaussian_test") {
   r.to_vector(res);
   REQUIRE(res == ans);
 }
+
+template <typename T>
+static void require_near(const ftk::ndarray<T>& a, const ftk::ndarray<T>& b)
+{
+  REQUIRE(a.shape() == b.shape());
+  for (size_t i = 0; i < a.nelem(); i ++)
+    REQUIRE(std::abs(a[i] - b[i]) < epsilon);
+}
+
+TEST_CASE("2D_conv_gaussian_separable_test") {
+  ftk::ndarray<double> d({17, 13});
+  d.perturb(1.0);
+  require_near(ftk::conv_gaussian(d, 1.5, 5, 2), ftk::conv2D_gaussian(d, 1.5, 5, 5, 2));
+  require_near(ftk::conv_gaussian(d, 1.0, 2, 0), ftk::conv2D_gaussian(d, 1.0, 2, 2, 0));
+}
+
+TEST_CASE("2D_conv_gaussian_separable_wide_test") {
+  // the last pass has one row, which is split into chunks of inner elements
+  ftk::ndarray<double> d({1000, 6});
+  d.perturb(1.0);
+  ftk::ndarray<double> r1, r4;
+  ftk::conv_gaussian_separable(d, r1, 1.0, 3, 1, ftk::FTK_THREAD_PTHREAD, 1);
+  ftk::conv_gaussian_separable(d, r4, 1.0, 3, 1, ftk::FTK_THREAD_PTHREAD, 4);
+  REQUIRE(r1.shape() == r4.shape());
+  for (size_t i = 0; i < r1.nelem(); i ++)
+    REQUIRE(r1[i] == r4[i]);
+  require_near(r4, ftk::conv2D_gaussian(d, 1.0, 3, 3, 1));
+}
+
+TEST_CASE("3D_conv_gaussian_separable_test") {
+  ftk::ndarray<double> d({9, 8, 7});
+  d.perturb(1.0);
+  require_near(ftk::conv_gaussian(d, 1.0, 3, 1), ftk::conv3D_gaussian(d, 1.0, 3, 3, 3, 1));
+  require_near(ftk::conv_gaussian(d, 2.0, 4, 1), ftk::conv3D_gaussian(d, 2.0, 4, 4, 4, 1));
+}
+
+TEST_CASE("conv_gaussian_multicomponent_test") {
+  ftk::ndarray<double> v({2, 11, 10}), v0({11, 10}), v1({11, 10});
+  v.set_multicomponents();
+  v.perturb(1.0);
+  for (int j = 0; j < 10; j ++)
+    for (int i = 0; i < 11; i ++) {
+      v0(i, j) = v(0, i, j);
+      v1(i, j) = v(1, i, j);
+    }
+
+  ftk::ndarray<double> r, r0, r1;
+  ftk::conv_gaussian_separable(v, r, 1.0, 3, 1);
+  ftk::conv_gaussian_separable(v0, r0, 1.0, 3, 1);
+  ftk::conv_gaussian_separable(v1, r1, 1.0, 3, 1);
+  REQUIRE(r.multicomponents() == 1);
+  REQUIRE(r.shape() == v.shape());
+  for (int j = 0; j < 10; j ++)
+    for (int i = 0; i < 11; i ++) {
+      REQUIRE(r(0, i, j) == r0(i, j));
+      REQUIRE(r(1, i, j) == r1(i, j));
+    }
+}
+
+TEST_CASE("smooth_gaussian_in_place_test") {
+  ftk::ndarray<double> d({9, 8, 7});
+  d.perturb(1.0);
+  auto r = ftk::conv_gaussian(d, 1.0, 3, 1);
+  for (size_t i = 0; i < r.nelem(); i ++)
+    r[i] *= 27; // conv_gaussian is also normalized by the kernel volume
+
+  ftk::smooth_gaussian(d, 1.0, 3);
+  require_near(d, r);
+}
@@ -58,7 +58,7 @@ TEST_CASE("critical_point_tracking_moving_extremum_2d_random_motion") {
     consumer.consume(stream);
 
     if (comm.rank() == root) {
-      auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker_2d_regular>( consumer.get_tracker() );
+      auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker_2d_regular<>>( consumer.get_tracker() );
       auto trajs = tracker->get_traced_critical_points();
      
       std::cerr << js << std::endl;
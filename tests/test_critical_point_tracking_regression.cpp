@@ -0,0 +1,241 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch.hh"
+#include "constants.hh"
+#include "main.hh" // defines FTK_TEST_CUDA
+#include <ftk/features/feature_curve_set_diff.hh>
+#include <ftk/filters/critical_point_tracker_2d_unstructured.hh>
+
+// Trajectories of optimized code paths (thread backends, accelerators,
+// over-decomposition, time parallelism, spilling) are compared with the
+// serial reference by tags: no topology or type changes are allowed, and
+// positions/times/scalars must agree within the tolerance of the path.
+// Only critical point trackers are covered: trackers of other features 
+// (contours, critical lines, vortices) output surfaces or volumes, for 
+// which there is no diff yet.
+
+using nlohmann::json;
+
+struct variant_t {
+  std::string name;
+  json config;
+  double tolerance;
+};
+
+static std::vector<variant_t> regular_variants()
+{
+  std::vector<variant_t> variants = {
+    {"pthread", {{"nthreads", 4}}, 0.0},
+    {"overdecomposition", {{"nblocks", 4}}, 0.0},
+    // time-parallel runs fix the quantization for robust detection, so they 
+    // are compared with a serial run of the same quantization
+    {"time_parallel", {{"ntime_intervals", 3}, {"vector_field_resolution", 1e-4}}, 0.0},
+    {"spill", {{"spill_directory", "."}, {"spill_memory_budget", 0.01}}, 0.0},
+    {"cpu_kernels", {{"accelerator", "cpu"}, {"nthreads", 4}}, 0.0},
+    {"morton", {{"traversal", "morton"}, {"nthreads", 4}}, 0.0}
+  };
+#if FTK_HAVE_OPENMP
+  variants.push_back({"openmp", {{"thread_backend", "openmp"}}, 0.0});
+#endif
+#if FTK_HAVE_TBB
+  variants.push_back({"tbb", {{"thread_backend", "tbb"}}, 0.0});
+#endif
+#if FTK_TEST_CUDA
+  variants.push_back({"cuda", {{"accelerator", "cuda"}}, 1e-6}); // single precision
+#endif
+#if FTK_HAVE_SYCL
+  variants.push_back({"sycl", {{"accelerator", "sycl"}}, 1e-6});
+#endif
+  return variants;
+}
+
+static void check(const std::string& name, const ftk::feature_curve_set_t& reference,
+    const ftk::feature_curve_set_t& trajs, const variant_t& v)
+{
+  const double tolerance = v.tolerance;
+  const auto diff = ftk::diff_feature_curve_sets(reference, trajs);
+  if (!diff.identical(tolerance)) {
+    std::cerr << name << ":" << std::endl;
+    diff.print(std::cerr);
+  }
+
+  INFO(name << ": " << diff.to_json());
+  REQUIRE(diff.ncurves[0] > 0);
+  REQUIRE(!diff.topology_changed());
+  REQUIRE(diff.ntype_changes == 0);
+  REQUIRE(diff.max_position_delta <= tolerance);
+  REQUIRE(diff.max_time_delta <= tolerance);
+  REQUIRE(diff.max_scalar_delta <= tolerance);
+}
+
+static void check_regular(const std::string& name, const json& jstream)
+{
+  diy::mpi::communicator world;
+  const auto reference = track_cp_trajectories(jstream, {{"nthreads", 1}});
+
+  for (const auto &v : regular_variants()) {
+    json jconfig = v.config;
+    if (!jconfig.contains("nthreads"))
+      jconfig["nthreads"] = 1;
+
+    const auto trajs = track_cp_trajectories(jstream, jconfig);
+    if (v.config.contains("vector_field_resolution")) {
+      const auto fixed_reference = track_cp_trajectories(jstream, {
+        {"nthreads", 1}, 
+        {"vector_field_resolution", v.config["vector_field_resolution"]}
+      });
+      if (world.rank() == 0)
+        check(name + "/" + v.name, fixed_reference, trajs, v);
+    } else if (world.rank() == 0)
+      check(name + "/" + v.name, reference, trajs, v);
+  }
+}
+
+TEST_CASE("feature_curve_set_diff") {
+  ftk::feature_curve_set_t s;
+  for (int i = 0; i < 2; i ++) {
+    ftk::feature_curve_t c;
+    for (int j = 0; j < 4; j ++) {
+      ftk::feature_point_t p;
+      p.x[0] = j; p.x[1] = i;
+      p.t = j;
+      p.tag = i * 4 + j;
+      p.type = 1;
+      c.push_back(p);
+    }
+    s.add(c);
+  }
+
+  auto d = ftk::diff_feature_curve_sets(s, s);
+  REQUIRE(d.identical());
+  REQUIRE(d.nmatched_curves == 2);
+
+  // relabeling and perturbation
+  ftk::feature_curve_set_t s1;
+  s1.add(s.find(1)->second, 5);
+  s1.add(s.find(0)->second, 7);
+  s1.find(5)->second[2].x[0] += 1e-3;
+  s1.find(7)->second[0].type = 2;
+  d = ftk::diff_feature_curve_sets(s, s1);
+  REQUIRE(!d.topology_changed());
+  REQUIRE(d.ntype_changes == 1);
+  REQUIRE(d.max_position_delta == Approx(1e-3));
+  REQUIRE(!d.identical(1e-2));
+
+  // split and missing point
+  ftk::feature_curve_set_t s2;
+  auto c = s.find(0)->second;
+  s2.add(ftk::feature_curve_t(c));
+  s2.begin()->second.resize(2);
+  c.erase(c.begin(), c.begin() + 3);
+  s2.add(c);
+  d = ftk::diff_feature_curve_sets(s, s2);
+  REQUIRE(d.topology_changed());
+  REQUIRE(d.nsplit_curves == 1);
+  REQUIRE(d.nmissing_points == 5);
+  REQUIRE(d.nextra_points == 0);
+
+  // merge
+  d = ftk::diff_feature_curve_sets(s2, s);
+  REQUIRE(d.nmerged_curves == 1);
+  REQUIRE(d.nextra_points == 5);
+}
+
+TEST_CASE("critical_point_tracking_regression_woven") {
+  check_regular("woven", js_woven_synthetic);
+}
+
+TEST_CASE("critical_point_tracking_regression_double_gyre") {
+  check_regular("double_gyre", js_double_gyre_synthetic);
+}
+
+TEST_CASE("critical_point_tracking_regression_merger_2d") {
+  check_regular("merger_2d", js_merger_2d_synthetic);
+}
+
+TEST_CASE("critical_point_tracking_regression_volcano_2d") {
+  check_regular("volcano_2d", js_volcano_2d_synthetic);
+}
+
+TEST_CASE("critical_point_tracking_regression_moving_extremum_2d") {
+  check_regular("moving_extremum_2d", js_moving_extremum_2d_synthetic);
+}
+
+TEST_CASE("critical_point_tracking_regression_moving_extremum_3d") {
+  check_regular("moving_extremum_3d", js_moving_extremum_3d_synthetic);
+}
+
+#if FTK_HAVE_VTK
+static std::vector<variant_t> unstructured_variants()
+{
+  std::vector<variant_t> variants = {
+    {"pthread", {{"nthreads", 4}}, 0.0}
+  };
+#if FTK_HAVE_OPENMP
+  variants.push_back({"openmp", {{"thread_backend", "openmp"}}, 0.0});
+#endif
+#if FTK_HAVE_TBB
+  variants.push_back({"tbb", {{"thread_backend", "tbb"}}, 0.0});
+#endif
+  return variants;
+}
+
+template <typename F> // f(mesh, tracker, timestep) pushes a snapshot to the tracker
+static ftk::feature_curve_set_t track_unstructured(const std::string& mesh_filename,
+    double kernel_size, const json& jconfig, F f)
+{
+  const int nt = 32;
+  diy::mpi::communicator world;
+
+  ftk::simplicial_unstructured_2d_mesh<> m;
+  m.from_vtk_unstructured_grid_file(mesh_filename);
+  if (kernel_size > 0)
+    m.build_smoothing_kernel(kernel_size);
+
+  ftk::critical_point_tracker_2d_unstructured tracker(world, m);
+  tracker.set_number_of_threads(jconfig.value("nthreads", 1));
+  if (jconfig.contains("thread_backend"))
+    tracker.use_thread_backend(jconfig["thread_backend"].get<std::string>());
+  tracker.initialize();
+
+  for (int i = 0; i < nt; i ++) {
+    f(m, tracker, i);
+    if (i != 0) tracker.advance_timestep();
+    else tracker.update_timestep();
+  }
+
+  tracker.finalize();
+  return tracker.get_traced_critical_points();
+}
+
+template <typename F>
+static void check_unstructured(const std::string& name, const std::string& mesh_filename, double kernel_size, F f)
+{
+  diy::mpi::communicator world;
+  const auto reference = track_unstructured(mesh_filename, kernel_size, {{"nthreads", 1}}, f);
+
+  for (const auto &v : unstructured_variants()) {
+    const auto trajs = track_unstructured(mesh_filename, kernel_size, v.config, f);
+    if (world.rank() == 0)
+      check(name + "/" + v.name, reference, trajs, v);
+  }
+}
+
+TEST_CASE("critical_point_tracking_regression_woven_unstructured") {
+  check_unstructured("woven_unstructured", "1x1.vtu", 0.045,
+    [](ftk::simplicial_unstructured_2d_mesh<>& m, ftk::critical_point_tracker_2d_unstructured& tracker, int i) {
+      auto data = ftk::synthetic_woven_2D_unstructured<double>(m.get_coords(), i*0.1, {0.5, 0.5}, 10.0);
+      ftk::ndarray<double> scalar, grad, J;
+      m.smooth_scalar_gradient_jacobian(data, scalar, grad, J);
+      scalar.reshape({1, scalar.dim(0)});
+      tracker.push_field_data_snapshot(scalar, grad, J);
+    });
+}
+
+TEST_CASE("critical_point_tracking_regression_double_gyre_unstructured") {
+  check_unstructured("double_gyre_unstructured", "2x1.vtu", 0.0,
+    [](ftk::simplicial_unstructured_2d_mesh<>& m, ftk::critical_point_tracker_2d_unstructured& tracker, int i) {
+      auto data = ftk::synthetic_double_gyre_unstructured<double>(m.get_coords(), static_cast<double>(i));
+      tracker.push_field_data_snapshot(ftk::ndarray<double>(), data, ftk::ndarray<double>());
+    });
+}
+#endif
@@ -2,11 +2,43 @@
 #include "catch.hh"
 #include "constants.hh"
 #include "main.hh"
+#include <ftk/features/feature_curve_set_diff.hh>
+#include <dirent.h>
 
 using nlohmann::json;
 
 const int woven_n_trajs = 56; // 48;
 
+static void remove_directory(const std::string& path) // recursively
+{
+  if (DIR *dir = opendir(path.c_str())) {
+    while (struct dirent *e = readdir(dir)) {
+      const std::string name(e->d_name);
+      if (name == "." || name == "..") continue;
+      else if (e->d_type == DT_DIR) remove_directory(path + "/" + name);
+      else std::remove((path + "/" + name).c_str());
+    }
+    closedir(dir);
+  }
+  rmdir(path.c_str());
+}
+
+// the trajectories w/ the given options match those w/ the default (or the 
+// reference) options by tags, within the tolerance of positions, times, and scalars
+template <typename T=double> // value type of inputs
+static void require_same_woven_trajectories(const json jconfig, double tolerance = 0, const json jreference = json())
+{
+  const auto reference = track_cp_trajectories(js_woven_synthetic, jreference);
+  const auto trajs = track_cp_trajectories<T>(js_woven_synthetic, jconfig);
+  diy::mpi::communicator world;
+  if (world.rank() == 0) {
+    const auto diff = ftk::diff_feature_curve_sets(reference, trajs);
+    INFO(diff.to_json());
+    REQUIRE(diff.ncurves[1] == woven_n_trajs);
+    REQUIRE(diff.identical(tolerance));
+  }
+}
+
 #if FTK_TEST_CUDA
 TEST_CASE("critical_point_tracking_cuda_woven_synthetic") {
   auto result = track_cp2d(js_woven_synthetic, {
@@ -25,6 +57,220 @@ TEST_CASE("critical_point_tracking_woven_synthetic") {
     REQUIRE(std::get<0>(result) == woven_n_trajs);
 }
 
+TEST_CASE("critical_point_tracking_woven_no_cell_culling") {
+  require_same_woven_trajectories({ // culling only skips cells w/o critical points
+    {"enable_cell_culling", false}
+  });
+}
+
+TEST_CASE("critical_point_tracking_woven_lazy_derivatives") {
+  require_same_woven_trajectories({
+    {"enable_lazy_derivatives", true}
+  });
+}
+
+TEST_CASE("critical_point_tracking_woven_single_precision") {
+  const auto reference = track_cp_trajectories(js_woven_synthetic);
+  const auto trajs = track_cp_trajectories<float>(js_woven_synthetic);
+  diy::mpi::communicator world;
+  if (world.rank() == 0) {
+    // rounded inputs may move a few points near cell boundaries to the 
+    // neighboring cells, but neither split nor merge trajectories
+    const auto diff = ftk::diff_feature_curve_sets(reference, trajs);
+    INFO(diff.to_json());
+    REQUIRE(diff.ncurves[1] == woven_n_trajs);
+    REQUIRE(diff.nsplit_curves + diff.nmerged_curves == 0);
+    REQUIRE(diff.nmissing_points + diff.nextra_points < diff.npoints[0] / 100);
+    REQUIRE(diff.ntype_changes == 0);
+    REQUIRE(diff.max_position_delta <= 1e-4);
+    REQUIRE(diff.max_time_delta <= 1e-4);
+    REQUIRE(diff.max_scalar_delta <= 1e-4);
+  }
+}
+
+TEST_CASE("critical_point_tracking_woven_instrumentation") {
+  char filename[] = "/tmp/woven.instrumentation.XXXXXX";
+  close(mkstemp(filename));
+  auto result = track_cp2d(js_woven_synthetic, {
+    {"instrumentation_output", filename}
+  });
+
+  diy::mpi::communicator world;
+  json j; // read and removed before any failed check
+  std::ifstream f(filename);
+  const bool written = f.peek() != EOF;
+  if (written && world.rank() == 0) f >> j;
+  f.close();
+  std::remove(filename);
+
+  if (world.rank() == 0) {
+    REQUIRE(written);
+
+    const auto &counters = j["counters"], &timers = j["timers"];
+    REQUIRE(counters["map_inserts"]["total"].get<size_t>() == std::get<1>(result));
+    REQUIRE(counters["simplices_culled"]["total"].get<size_t>() <= counters["simplices_scanned"]["total"].get<size_t>());
+    REQUIRE(timers["scan_interval"]["count"].get<int>() + 1 == timers["update_timestep"]["count"].get<int>());
+    REQUIRE(timers["update_timestep"]["max"].get<double>() >= timers["scan_interval"]["max"].get<double>());
+  }
+}
+
+TEST_CASE("critical_point_tracking_woven_checkpoint") {
+  const std::string filename = "woven.ckpt";
+  diy::mpi::communicator world;
+  ftk::critical_point_tracker_2d_regular<> tracker(world); // for the filenames of this process
+  const std::string epoch_filenames[2] = {
+    tracker.checkpoint_filename(filename, 0), 
+    tracker.checkpoint_filename(filename, 1)
+  };
+  for (const auto &f : epoch_filenames)
+    std::remove(f.c_str());
+
+  // epochs 0, 1, and 2 at timesteps 9, 19, and 29
+  auto result = track_cp2d(js_woven_synthetic, {
+    {"checkpoint", filename},
+    {"checkpoint_interval", 10}
+  });
+  REQUIRE(ftk::checkpointer::exists(epoch_filenames[0]));
+  REQUIRE(ftk::checkpointer::exists(epoch_filenames[1]));
+
+  // resumes after the last checkpoint (timestep 29) 
+  auto resumed_result = track_cp2d(js_woven_synthetic, {
+    {"checkpoint", filename},
+    {"resume", true}
+  });
+
+  // as if the root crashed before writing epoch 2, all processes resume 
+  // after timestep 19
+  if (world.rank() == 0)
+    std::remove(tracker.checkpoint_filename(filename, 2).c_str());
+  auto resumed_result1 = track_cp2d(js_woven_synthetic, {
+    {"checkpoint", filename},
+    {"resume", true}
+  });
+  
+  for (const auto &f : epoch_filenames)
+    std::remove(f.c_str());
+
+  if (world.rank() == 0) {
+    REQUIRE(std::get<0>(result) == woven_n_trajs);
+    REQUIRE(std::get<0>(resumed_result) == std::get<0>(result));
+    REQUIRE(std::get<1>(resumed_result) == std::get<1>(result));
+    REQUIRE(std::get<0>(resumed_result1) == std::get<0>(result));
+    REQUIRE(std::get<1>(resumed_result1) == std::get<1>(result));
+  }
+}
+
+TEST_CASE("critical_point_tracking_woven_time_parallel") {
+  // the quantization is fixed by the first timestep by default
+  const auto trajs = track_cp_trajectories(js_woven_synthetic, {
+    {"ntime_intervals", 5}
+  });
+  diy::mpi::communicator world;
+  if (world.rank() == 0)
+    REQUIRE(trajs.size() == woven_n_trajs);
+
+  // same as a serial run of the same quantization
+  require_same_woven_trajectories({
+    {"ntime_intervals", 5}, 
+    {"vector_field_resolution", 1e-4}
+  }, 0, {
+    {"vector_field_resolution", 1e-4}
+  });
+}
+
+TEST_CASE("critical_point_tracking_woven_overdecomposition") {
+  require_same_woven_trajectories({
+    {"nblocks", 8}
+  });
+}
+
+TEST_CASE("critical_point_tracking_woven_default_threads") {
+  auto consumer = consume_stream(js_woven_synthetic, {
+    {"nthreads", 0} // cpus available to the process
+  });
+
+  auto tracker = consumer->get_tracker();
+  REQUIRE(tracker->get_number_of_threads() >= 1);
+  REQUIRE(tracker->get_number_of_threads() <= ftk::object::available_cpus());
+  REQUIRE(ftk::object::available_cpus() <= ftk::object::affinity_cpus().size());
+  
+  diy::mpi::communicator world;
+  if (world.rank() == 0)
+    REQUIRE(tracker->get_traced_critical_points().size() == woven_n_trajs);
+}
+
+TEST_CASE("critical_point_tracking_woven_spill") {
+  require_same_woven_trajectories({
+    {"spill_directory", "."},
+    {"spill_memory_budget", 0.01} // MB; spills every timestep
+  });
+}
+
+TEST_CASE("critical_point_tracking_woven_spill_reset") {
+  diy::mpi::communicator world;
+  auto count_runs = [&]() { // spilled runs of this process in the cwd
+    const std::string prefix = "ftk-spill-" + std::to_string(world.rank()) + "-";
+    int n = 0;
+    DIR *dir = opendir(".");
+    while (struct dirent *e = readdir(dir))
+      if (std::string(e->d_name).compare(0, prefix.size(), prefix) == 0) n ++;
+    closedir(dir);
+    return n;
+  };
+
+  ftk::critical_point_tracker_2d_regular<> tracker(world);
+  tracker.set_array_domain(ftk::lattice({0, 0}, {woven_width, woven_height}));
+  tracker.set_domain(ftk::lattice({2, 2}, {woven_width-3, woven_height-3}));
+  tracker.set_scalar_field_source(ftk::SOURCE_GIVEN);
+  tracker.set_vector_field_source(ftk::SOURCE_DERIVED);
+  tracker.set_jacobian_field_source(ftk::SOURCE_DERIVED);
+  tracker.set_jacobian_symmetric(true);
+  tracker.set_spill_directory(".");
+  tracker.set_spill_memory_budget(0); // spills every timestep
+  tracker.initialize();
+
+  for (int i = 0; i < 4; i ++) {
+    tracker.push_scalar_field_snapshot(ftk::synthetic_woven_2D<double>(woven_width, woven_height, i*0.1));
+    if (i != 0) tracker.advance_timestep();
+  }
+  REQUIRE(tracker.get_number_of_spilled_runs() > 0);
+  REQUIRE(count_runs() == tracker.get_number_of_spilled_runs());
+
+  tracker.reset();
+  REQUIRE(tracker.get_number_of_spilled_runs() == 0);
+  REQUIRE(count_runs() == 0);
+}
+
+TEST_CASE("critical_point_tracking_woven_group_stream") {
+  auto consumer = consume_stream<double, ftk::ndarray_group_stream<>>({
+    {"woven", js_woven_synthetic},
+    {"tornado", js_tornado_synthetic} // not read
+  }, {{"variable", "woven"}, {"attached_variables", json::array()}});
+
+  diy::mpi::communicator world;
+  if (world.rank() == 0)
+    REQUIRE(consumer->get_tracker()->get_traced_critical_points().size() == woven_n_trajs);
+}
+
+TEST_CASE("critical_point_tracking_woven_group_stream_attached") {
+  auto consumer = consume_stream<double, ftk::ndarray_group_stream<>>({
+    {"woven", js_woven_synthetic},
+    {"copy", js_woven_synthetic} // attached
+  }, {{"variable", "woven"}});
+
+  diy::mpi::communicator world;
+  if (world.rank() != 0) return;
+
+  auto tracker = consumer->get_tracker();
+  REQUIRE(tracker->get_num_scalar_components() == 2);
+
+  const auto &trajs = tracker->get_traced_critical_points();
+  REQUIRE(trajs.size() == woven_n_trajs);
+  for (const auto &kv : trajs)
+    for (const auto &p : kv.second)
+      REQUIRE(p.scalar[1] == Approx(p.scalar[0]));
+}
+
 TEST_CASE("critical_point_tracking_woven_float64") {
   auto result = track_cp2d(js_woven_float64);
   diy::mpi::communicator world;
@@ -32,6 +278,299 @@ TEST_CASE("critical_point_tracking_woven_float64") {
     REQUIRE(std::get<0>(result) == woven_n_trajs);
 }
 
+TEST_CASE("critical_point_tracking_woven_feature_point_store") {
+  auto consumer = consume_stream(js_woven_synthetic);
+
+  diy::mpi::communicator world;
+  if (world.rank() != 0) return;
+
+  auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker>( consumer->get_tracker() );
+  const auto &trajs = tracker->get_traced_critical_points();
+  const std::vector<std::string> scalar_components = {"scalar"};
+
+  auto store = tracker->get_traced_critical_points_store();
+  REQUIRE(store.n_curves() == trajs.size());
+
+  // identical text outputs, also after recomputing statistics from columns
+  std::stringstream ss0, ss1;
+  trajs.write_text(ss0, 2, scalar_components);
+  store.update_statistics();
+  store.write_text(ss1, scalar_components);
+  REQUIRE(ss0.str() == ss1.str());
+
+  // binary round trip and slicing
+  const std::string filename = "woven.store.bin";
+  store.write_binary(filename);
+  ftk::feature_point_store_t<> store1;
+  store1.read_binary(filename);
+  std::remove(filename.c_str());
+  REQUIRE(store1.size() == store.size());
+  REQUIRE(store1.get_new_id() == store.get_new_id());
+
+  std::map<int, size_t> nsliced;
+  for (const auto &kv : trajs)
+    for (const auto &p : kv.second)
+      if (p.ordinal) nsliced[p.timestep] ++;
+  const auto sliced = store1.slice();
+  REQUIRE(sliced.size() == nsliced.size());
+  for (const auto &kv : sliced)
+    REQUIRE(kv.second.size() == nsliced[kv.first]);
+
+  // single precision
+  auto store32 = tracker->get_traced_critical_points_store<float>();
+  REQUIRE(store32.size() == store.size());
+  REQUIRE(store32.memory_usage() < store.memory_usage());
+  REQUIRE(store32.to_curve_set().size() == trajs.size());
+
+  // moving curves out of the tracker
+  auto store2 = tracker->release_traced_critical_points_store();
+  REQUIRE(trajs.empty());
+  std::stringstream ss2;
+  store2.write_text(ss2, scalar_components);
+  REQUIRE(ss2.str() == ss0.str());
+}
+
+TEST_CASE("critical_point_tracking_woven_compact_trajectories") {
+  auto consumer = consume_stream(js_woven_synthetic, json(), false);
+  auto consumer1 = consume_stream(js_woven_synthetic, {{"enable_compact_trajectories", true}}, false);
+
+  diy::mpi::communicator world;
+  if (world.rank() != 0) return;
+
+  auto tracker = consumer->get_tracker();
+  auto tracker1 = consumer1->get_tracker();
+  const auto &trajs = tracker->get_traced_critical_points();
+  const auto &store = tracker1->get_compact_traced_critical_points();
+  const std::vector<std::string> scalar_components = {"scalar"};
+  REQUIRE(tracker1->get_traced_critical_points().empty());
+  REQUIRE(store.n_curves() == trajs.size());
+
+  // traced and written w/o feature curves
+  const std::string filename = "woven.compact.txt";
+  std::stringstream ss0;
+  trajs.write_text(ss0, 2, scalar_components);
+  tracker1->write_traced_critical_points_text(filename);
+  std::ifstream in(filename);
+  std::stringstream ss1;
+  ss1 << in.rdbuf();
+  in.close();
+  std::remove(filename.c_str());
+  REQUIRE(ss0.str() == ss1.str());
+
+  tracker->slice_traced_critical_points();
+  tracker1->slice_traced_critical_points();
+  REQUIRE(tracker->get_sliced_critical_points().size() == tracker1->get_sliced_critical_points().size());
+  for (const auto &kv : tracker1->get_sliced_critical_points())
+    REQUIRE(kv.second.size() == tracker->get_sliced_critical_points().at(kv.first).size());
+
+  // selection on the store
+  auto longer = [](const ftk::feature_curve_t& traj) { return traj.tmax - traj.tmin > 5; };
+  tracker->select_trajectories(longer);
+  tracker1->select_trajectories(longer);
+  REQUIRE(store.n_curves() == trajs.size());
+}
+
+TEST_CASE("critical_point_tracking_woven_indexed_output") {
+  auto consumer = consume_stream(js_woven_synthetic);
+
+  diy::mpi::communicator world;
+  if (world.rank() != 0) return;
+
+  auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker>( consumer->get_tracker() );
+  const auto &trajs = tracker->get_traced_critical_points();
+  const std::string filename = "woven.ftkc";
+
+  // appended in two sessions with small chunks
+  {
+    ftk::feature_curve_file_writer writer;
+    writer.set_chunk_size(200);
+    writer.open(filename, 2, 1);
+    auto it = trajs.begin();
+    for (size_t i = 0; i < trajs.size() / 2; i ++, it ++)
+      writer.append(it->second, it->first);
+    writer.close();
+
+    // new chunks overwrite the index, which is written again by close()
+    writer.open(filename, 2, 1, true);
+    for (; it != trajs.end(); it ++)
+      writer.append(it->second, it->first);
+    writer.close();
+  }
+
+  ftk::feature_curve_file_reader reader(filename);
+  REQUIRE(reader.n_curves() == trajs.size());
+  REQUIRE(reader.get_chunks().size() > 2);
+
+  // random access by id
+  const auto &kv = *trajs.rbegin();
+  REQUIRE(reader.has(kv.first));
+  auto curve = reader.read(kv.first);
+  REQUIRE(curve.size() == kv.second.size());
+  REQUIRE(curve.back().t == kv.second.back().t);
+
+  std::stringstream ss0, ss1;
+  trajs.write_text(ss0, 2, {"scalar"});
+  reader.read_all().write_text(ss1, 2, {"scalar"});
+  REQUIRE(ss0.str() == ss1.str());
+
+  // queries only decode the chunks they need
+  const size_t n0 = reader.get_number_of_chunks_loaded();
+  auto intercepted = reader.intercept(10, 12);
+  REQUIRE(intercepted.size() == trajs.intercept(10, 12).size());
+  REQUIRE(reader.get_number_of_chunks_loaded() - n0 < reader.get_chunks().size());
+
+  size_t nsliced = 0;
+  for (const auto &kv : trajs)
+    for (const auto &p : kv.second)
+      if (p.ordinal && p.timestep == 10) nsliced ++;
+  REQUIRE(reader.slice(10).size() == nsliced);
+
+  // a tracker w/ the opened file slices, intercepts, and selects w/o reading all trajectories
+  ftk::critical_point_tracker_2d_regular<> tracker1(world);
+  tracker1.open_traced_critical_points_indexed(filename);
+  REQUIRE(tracker1.get_traced_critical_points().empty());
+  REQUIRE(tracker1.get_intercepted_critical_point(10, 12).size() == trajs.intercept(10, 12).size());
+  tracker1.slice_traced_critical_points();
+  REQUIRE(tracker1.get_sliced_critical_points().at(10).size() == nsliced);
+
+  auto long_lived = [](const ftk::feature_curve_t& traj) {return traj.tmax - traj.tmin > 5;};
+  size_t nselected = 0;
+  for (const auto &kv : trajs)
+    if (long_lived(kv.second)) nselected ++;
+  tracker1.select_trajectories(long_lived, [](const ftk::feature_curve_file_entry_t& e) {return e.tmax - e.tmin > 5;});
+  REQUIRE(tracker1.get_traced_critical_points().size() == nselected);
+
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("critical_point_tracking_woven_streamed_indexed") {
+  const std::string filename = "woven-streamed.ftkc";
+  const json jconfig = {{"enable_streaming_trajectories", true}};
+  auto reference = consume_stream(js_woven_synthetic, jconfig, false);
+
+  json jconfig1 = jconfig;
+  jconfig1["output"] = filename;
+  auto consumer = consume_stream(js_woven_synthetic, jconfig1, false);
+
+  diy::mpi::communicator world;
+  const size_t nremaining = consumer->get_tracker()->get_traced_critical_points().size();
+  consumer->write();
+  if (world.rank() != 0) return;
+
+  // completed trajectories were appended during the run and released
+  const auto &trajs = reference->get_tracker()->get_traced_critical_points();
+  REQUIRE(nremaining < trajs.size());
+
+  ftk::feature_curve_file_reader reader(filename);
+  REQUIRE(reader.n_curves() == trajs.size());
+  for (const auto &kv : trajs)
+    REQUIRE(reader.read(kv.first).size() == kv.second.size());
+
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("critical_point_tracking_woven_storage") {
+  const std::string dbname = "woven.kv";
+  diy::mpi::communicator world;
+  const std::string dbname1 = world.size() > 1 ? dbname + "." + std::to_string(world.rank()) : dbname; // one store per process
+  const bool root = world.rank() == 0;
+  remove_directory(dbname1);
+
+  auto consumer = consume_stream(js_woven_synthetic, {{"storage", dbname}}, false);
+
+  auto tracker = std::dynamic_pointer_cast<ftk::critical_point_tracker_2d_regular<double>>( consumer->get_tracker() );
+  const int nt = tracker->get_current_timestep() + 1;
+
+  // partial results are visible before the trajectories are written
+  ftk::storage_native reader;
+  reader.set_read_only(true);
+  REQUIRE(reader.open(dbname1));
+
+  const auto keys = reader.feature_keys("critical_points", 0, nt);
+  REQUIRE(keys.size() == nt);
+  size_t npoints = 0;
+  for (const auto &k : keys) {
+    std::vector<ftk::feature_point_t> points;
+    REQUIRE(reader.get_obj(k, points));
+    npoints += points.size();
+  }
+  size_t ntotal = 0; // of all processes, which are gathered to the root for tracing
+  diy::mpi::all_reduce(world, npoints, ntotal, std::plus<size_t>());
+  if (root)
+    REQUIRE(ntotal == tracker->get_discrete_critical_points().size()); // evicted and loaded back for tracing
+  REQUIRE(reader.keys("critical_point_trajectories/").empty());
+
+  size_t nsegments = 0;
+  for (const auto &k : reader.keys(ftk::storage::feature_prefix("critical_point_segments"))) {
+    ftk::feature_point_store_t<> segments;
+    REQUIRE(reader.get_obj(k, segments));
+    nsegments += segments.n_curves();
+  }
+  REQUIRE(nsegments == (root ? tracker->get_traced_critical_points().size() : 0)); // traced on the root
+
+  // keys of negative timesteps sort first
+  const auto k0 = ftk::storage::feature_key("critical_points", -1, 0), 
+             k1 = ftk::storage::feature_key("critical_points", 0, 0);
+  REQUIRE(k0 < k1);
+  std::string type;
+  int t, b;
+  REQUIRE(ftk::storage::parse_feature_key(k0, type, t, b));
+  REQUIRE((type == "critical_points" && t == -1 && b == 0));
+
+  consumer->post_process();
+  consumer->write();
+
+  size_t ntrajs = 0;
+  for (const auto &k : reader.keys(ftk::storage::feature_prefix("critical_point_trajectories"))) {
+    ftk::feature_point_store_t<> trajs;
+    REQUIRE(reader.get_obj(k, trajs));
+    ntrajs += trajs.n_curves();
+  }
+  REQUIRE(ntrajs == (root ? tracker->get_traced_critical_points().size() : 0));
+
+  remove_directory(dbname1);
+}
+
+TEST_CASE("critical_point_tracking_woven_storage_streaming") {
+  const std::string dbname = "woven-streaming.kv";
+  diy::mpi::communicator world;
+  const std::string dbname1 = world.size() > 1 ? dbname + "." + std::to_string(world.rank()) : dbname; // one store per process
+  remove_directory(dbname1);
+
+  const json jconfig = {{"enable_streaming_trajectories", true}};
+  const auto reference = track_cp_trajectories(js_woven_synthetic, jconfig);
+
+  json jconfig1 = jconfig;
+  jconfig1["storage"] = dbname;
+  auto consumer = consume_stream(js_woven_synthetic, jconfig1, false);
+  consumer->write();
+
+  // completed trajectories are evicted, and only kept as segments in the store
+  ftk::storage_native reader;
+  reader.set_read_only(true);
+  REQUIRE(reader.open(dbname1));
+
+  size_t nsegments = 0, ntrajs = 0;
+  for (const auto &k : reader.keys(ftk::storage::feature_prefix("critical_point_segments"))) {
+    ftk::feature_point_store_t<> segments;
+    REQUIRE(reader.get_obj(k, segments));
+    nsegments += segments.n_curves();
+  }
+  for (const auto &k : reader.keys(ftk::storage::feature_prefix("critical_point_trajectories"))) {
+    ftk::feature_point_store_t<> trajs;
+    REQUIRE(reader.get_obj(k, trajs));
+    ntrajs += trajs.n_curves();
+  }
+  if (world.rank() == 0) { // traced on the root
+    REQUIRE(nsegments > 0);
+    REQUIRE(consumer->get_tracker()->get_traced_critical_points().size() == ntrajs);
+    REQUIRE(nsegments + ntrajs == reference.size());
+  } else
+    REQUIRE(nsegments + ntrajs == 0);
+
+  remove_directory(dbname1);
+}
+
 #if FTK_HAVE_NETCDF
 TEST_CASE("critical_point_tracking_woven_nc") {
   auto result = track_cp2d(js_woven_nc_unlimited_time);
@@ -3,6 +3,7 @@
 #include "constants.hh"
 #include <ftk/ndarray/stream.hh>
 #include <ftk/ndarray/writer.hh>
+#include <ftk/ndarray/ndarray_group_stream.hh>
 
 bool write(const json& jstream, const json& jwriter)
 {
@@ -35,6 +36,33 @@ TEST_CASE("io_write_float32_moving_extremum_3d_synthetic") {
   CHECK(write(js_moving_extremum_3d_synthetic, jw_moving_extremum_3d_float32));
 }
 
+TEST_CASE("io_group_stream_woven") {
+  REQUIRE(write(js_woven_synthetic, jw_woven_float64));
+
+  ftk::ndarray_group_stream<> stream;
+  stream.configure({
+    {"scalar", js_woven_float64},
+    {"synthetic", js_woven_synthetic}, 
+    {"tornado", js_tornado_synthetic} // configured but never requested
+  });
+  stream.set_requested_keys({"scalar", "synthetic"});
+  REQUIRE(stream.get_json()["scalar"]["variables"][0] == "scalar");
+
+  int count = 0;
+  stream.set_callback([&](int k, const ftk::ndarray_group& group) {
+    REQUIRE(group.size() == 2);
+    const auto &a = group.get<double>("scalar"), 
+               &b = group.get<double>("synthetic");
+    REQUIRE(a.shape() == b.shape());
+    REQUIRE(a.std_vector() == b.std_vector());
+    count ++;
+  });
+  stream.start();
+  stream.finish();
+
+  CHECK(count == stream.n_timesteps());
+}
+
 #if FTK_HAVE_NETCDF
 TEST_CASE("io_write_nc_woven") {
   CHECK(write(js_woven_synthetic, jw_woven_nc_unlimited_time));
@@ -1,7 +1,116 @@
 #define CATCH_CONFIG_RUNNER
 #include "catch.hh"
 #include <ftk/mesh/simplicial_unstructured_extruded_3d_mesh.hh>
+#include <ftk/mesh/simplicial_regular_mesh.hh>
 #include <ftk/ndarray.hh>
+#include <ftk/ndarray/grad.hh>
+
+TEST_CASE("mesh_regular_unit_simplex_tables") {
+  ftk::simplicial_regular_mesh m(3), m1(3);
+  REQUIRE(&m.unit_simplex(2, 0) == &m1.unit_simplex(2, 0)); // shared across meshes
+
+  // the ordinal triangles in 3D spacetime, as in the tables of the flat-index kernels
+  const int ordinal_3_2[2][3][3] = {
+    {{0,0,0},{0,1,0},{1,1,0}},
+    {{0,0,0},{1,0,0},{1,1,0}}
+  };
+  REQUIRE(m.ntypes(2, ftk::ELEMENT_SCOPE_ORDINAL) == 2);
+  REQUIRE(std::equal(&ordinal_3_2[0][0][0], &ordinal_3_2[0][0][0] + 18,
+        m.unit_simplex_offsets(2, ftk::ELEMENT_SCOPE_ORDINAL)));
+
+  for (int nd = 2; nd <= 4; nd ++) {
+    ftk::simplicial_regular_mesh m2(nd);
+    for (int d = 0; d <= nd; d ++) {
+      REQUIRE(m2.ntypes(d) == m2.ntypes(d, ftk::ELEMENT_SCOPE_ORDINAL) + m2.ntypes(d, ftk::ELEMENT_SCOPE_INTERVAL));
+      const int *offsets = m2.unit_simplex_offsets(d);
+      for (int t = 0; t < m2.ntypes(d); t ++)
+        for (int i = 0; i <= d; i ++)
+          for (int j = 0; j < nd; j ++)
+            REQUIRE(offsets[(t*(d+1) + i)*nd + j] == m2.unit_simplex(d, t)[i][j]);
+    }
+  }
+}
+
+TEST_CASE("mesh_regular_morton_traversal") {
+  ftk::simplicial_regular_mesh m(4);
+  m.set_lb_ub({0, 0, 0, 0}, {20, 11, 9, 3});
+
+  // partial tiles, a single timestep, and a single cell
+  const std::vector<ftk::lattice> lattices = {
+    ftk::lattice({1, 2, 0, 1}, {19, 9, 9, 1}),
+    ftk::lattice({0, 0, 0, 0}, {10, 10, 10, 3}),
+    ftk::lattice({3, 3, 3, 2}, {1, 1, 1, 1})
+  };
+
+  for (const auto &l : lattices) {
+    for (int scope = ftk::ELEMENT_SCOPE_ALL; scope <= ftk::ELEMENT_SCOPE_INTERVAL; scope ++) {
+      std::vector<std::multiset<ftk::simplicial_regular_mesh_element>> visited(2);
+      std::mutex mutex;
+      for (int t = ftk::ELEMENT_TRAVERSAL_ROW_MAJOR; t <= ftk::ELEMENT_TRAVERSAL_MORTON; t ++) {
+        m.set_traversal(t);
+        m.element_for(3, l, scope, [&](ftk::simplicial_regular_mesh_element e) {
+          std::lock_guard<std::mutex> guard(mutex);
+          visited[t].insert(e);
+        }, ftk::FTK_THREAD_PTHREAD, 3);
+      }
+      REQUIRE(visited[0].size() == l.n() * m.ntypes(3, scope));
+      REQUIRE(visited[0] == visited[1]);
+    }
+  }
+}
+
+TEST_CASE("mesh_regular_jacobian2D_stencil") {
+  // the arrays of jacobian2D are the stencils at each vertex
+  const int DW = 5, DH = 4;
+  ftk::ndarray<double> v({2, DW, DH});
+  v.perturb(1.0);
+
+  const auto J = ftk::jacobian2D(v), Js = ftk::jacobian2D<double, true>(v);
+  const auto f = [&](int c, int i, int j) { return v(c, i, j); };
+  for (int j = 0; j < DH; j ++)
+    for (int i = 0; i < DW; i ++) {
+      double H[2][2];
+      ftk::jacobian2D_stencil(f, DW, DH, i, j, H);
+      for (int c = 0; c < 2; c ++)
+        for (int d = 0; d < 2; d ++)
+          REQUIRE(J(c, d, i, j) == H[c][d]);
+      REQUIRE(Js(0, 1, i, j) == (H[0][1] + H[1][0]) * 0.5);
+      REQUIRE(Js(1, 0, i, j) == Js(0, 1, i, j));
+    }
+}
+
+TEST_CASE("mesh_regular_jacobian2D_linear") {
+  // linear vector field (a0 i + b0 j, a1 i + b1 j); central differences 
+  // are scaled by the extent of the domain, the same as gradient2D
+  const int DW = 5, DH = 4;
+  const double a[2] = {1, -2}, b[2] = {3, 0.5};
+  ftk::ndarray<double> v({2, DW, DH});
+  for (int j = 0; j < DH; j ++)
+    for (int i = 0; i < DW; i ++)
+      for (int c = 0; c < 2; c ++)
+        v(c, i, j) = a[c] * i + b[c] * j;
+
+  const auto J = ftk::jacobian2D(v);
+  for (int j = 1; j < DH-1; j ++)
+    for (int i = 1; i < DW-1; i ++)
+      for (int c = 0; c < 2; c ++) {
+        REQUIRE(J(c, 0, i, j) == Approx(2 * a[c] * (DW-1)));
+        REQUIRE(J(c, 1, i, j) == Approx(2 * b[c] * (DH-1)));
+      }
+
+  ftk::ndarray<double> u({DW, DH});
+  for (int c = 0; c < 2; c ++) {
+    for (int j = 0; j < DH; j ++)
+      for (int i = 0; i < DW; i ++)
+        u(i, j) = v(c, i, j);
+    const auto g = ftk::gradient2D(u);
+    for (int j = 0; j < DH; j ++)
+      for (int i = 0; i < DW; i ++) {
+        REQUIRE(J(c, 0, i, j) == g(0, i, j));
+        REQUIRE(J(c, 1, i, j) == g(1, i, j));
+      }
+  }
+}
 
 #if FTK_HAVE_VTK
 TEST_CASE("mesh_extruded_3d_unstructured_pent_sides") {
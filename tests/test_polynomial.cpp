@@ -3,7 +3,9 @@
 #include <ftk/numeric/polynomial.hh>
 #include <ftk/numeric/quadratic_solver.hh>
 #include <ftk/numeric/cubic_solver.hh>
+#include <ftk/numeric/polynomial_solver.hh>
 #include <random>
+#include <algorithm>
 
 const int nruns = 1; // 00000;
 const double epsilon = 1e-10;
@@ -42,4 +44,63 @@ TEST_CASE("solve_cubic_real")
   }
 }
 
+TEST_CASE("solve_polynomial")
+{
+  for (int n = 1; n <= ftk::polynomial_solver_max_degree; n ++) {
+    // random polynomials
+    double P[ftk::polynomial_solver_max_degree+1];
+    std::complex<double> x[ftk::polynomial_solver_max_degree];
+    for (int run = 0; run < 100; run ++) {
+      for (int i = 0; i <= n; i ++)
+        P[i] = d(gen);
+      
+      REQUIRE(ftk::solve_polynomial(P, n, x) == n);
+      for (int i = 0; i < n; i ++) {
+        std::complex<double> dp;
+        const double scale = std::max(1.0, std::pow(std::abs(x[i]), n));
+        REQUIRE(std::abs(ftk::polynomial_evaluate_complex(P, n, x[i], dp)) / scale == Approx(0.0).margin(1e-8));
+      }
+    }
+  }
+
+  // (x-1)(x-2)...(x-6)
+  double P[7] = {1}, x0[6] = {1, 2, 3, 4, 5, 6};
+  for (int i = 0; i < 6; i ++) {
+    for (int j = i+1; j > 0; j --)
+      P[j] = P[j-1] - x0[i] * P[j];
+    P[0] = -x0[i] * P[0];
+  }
+  std::complex<double> x[6];
+  REQUIRE(ftk::solve_polynomial(P, 6, x) == 6);
+  std::sort(x, x+6, [](std::complex<double> a, std::complex<double> b) {return a.real() < b.real();});
+  for (int i = 0; i < 6; i ++) {
+    REQUIRE(x[i].real() == Approx(x0[i]).margin(epsilon));
+    REQUIRE(x[i].imag() == 0.0);
+  }
+
+  // vanishing leading coefficients and zero roots
+  const double Q[7] = {0, 2, 1, 0, 0, 0, 0}; // x^2 + 2x
+  REQUIRE(ftk::solve_polynomial(Q, 6, x) == 2);
+  REQUIRE(std::abs(x[0]) == 0.0);
+  REQUIRE(x[1].real() == Approx(-2.0).margin(epsilon));
+}
+
+TEST_CASE("solve_polynomials_batch")
+{
+  const int n = 6, count = 100;
+  std::vector<double> P(count * (n+1));
+  for (auto &p : P) p = d(gen);
+
+  std::vector<std::complex<double>> x(count * n);
+  std::vector<int> nroots(count);
+  ftk::solve_polynomials_batch(P.data(), n, count, x.data(), nroots.data());
+
+  for (int i = 0; i < count; i ++) {
+    std::complex<double> y[n];
+    REQUIRE(nroots[i] == ftk::solve_polynomial(&P[i*(n+1)], n, y));
+    for (int j = 0; j < nroots[i]; j ++)
+      REQUIRE(x[i*n+j] == y[j]);
+  }
+}
+
 #include "main.hh"
@@ -0,0 +1,155 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch.hh"
+#include <ftk/numeric/sign_det.hh>
+#include <ftk/numeric/sign_det_batch.hh>
+#include <ftk/numeric/critical_point_test.hh>
+#include <ftk/external/diy/mpi.hpp>
+#include <random>
+#include <chrono>
+
+const int nruns = 10000;
+
+// values in a small range to exercise the degenerate cases of SoS
+template <int n, int m, int k>
+static void random_simplices(std::mt19937& gen, long long range, long long X[m][k][n], int indices[m][n])
+{
+  std::uniform_int_distribution<long long> dist(-range, range);
+  std::uniform_int_distribution<int> idist(0, 2*m);
+  for (int l = 0; l < n; l ++) {
+    for (int i = 0; i < m; i ++) {
+      for (int j = 0; j < k; j ++)
+        X[i][j][l] = dist(gen);
+
+      bool unique;
+      do { // indices need to be distinct
+        indices[i][l] = idist(gen);
+        unique = true;
+        for (int i1 = 0; i1 < i; i1 ++)
+          if (indices[i1][l] == indices[i][l]) unique = false;
+      } while (!unique);
+    }
+  }
+}
+
+template <int n>
+static void test_batch2(std::mt19937& gen, long long range)
+{
+  long long X[3][2][n];
+  int indices[3][n], sigma[n], d[n];
+  bool cp[n];
+
+  random_simplices<n, 3, 2>(gen, range, X, indices);
+  ftk::robust_sign_det3_batch<n>(X, sigma);
+  ftk::positive2_batch<n>(X, indices, d);
+  ftk::robust_critical_point_in_simplex2_batch<n>(X, indices, cp);
+
+  for (int l = 0; l < n; l ++) {
+    long long Xl[3][2];
+    int il[3];
+    for (int i = 0; i < 3; i ++) {
+      il[i] = indices[i][l];
+      for (int j = 0; j < 2; j ++)
+        Xl[i][j] = X[i][j][l];
+    }
+
+    REQUIRE(sigma[l] == ftk::robust_sign_det3(Xl));
+    REQUIRE(d[l] == ftk::positive2(Xl, il));
+    REQUIRE(cp[l] == ftk::robust_critical_point_in_simplex2(Xl, il));
+  }
+}
+
+template <int n>
+static void test_batch3(std::mt19937& gen, long long range)
+{
+  long long X[4][3][n];
+  int indices[4][n], sigma[n], d[n];
+  bool cp[n];
+
+  random_simplices<n, 4, 3>(gen, range, X, indices);
+  ftk::robust_sign_det4_batch<n>(X, sigma);
+  ftk::positive3_batch<n>(X, indices, d);
+  ftk::robust_critical_point_in_simplex3_batch<n>(X, indices, cp);
+
+  for (int l = 0; l < n; l ++) {
+    long long Xl[4][3];
+    int il[4];
+    for (int i = 0; i < 4; i ++) {
+      il[i] = indices[i][l];
+      for (int j = 0; j < 3; j ++)
+        Xl[i][j] = X[i][j][l];
+    }
+
+    REQUIRE(sigma[l] == ftk::robust_sign_det4(Xl));
+    REQUIRE(d[l] == ftk::positive3(Xl, il));
+    REQUIRE(cp[l] == ftk::robust_critical_point_in_simplex3(Xl, il));
+  }
+}
+
+TEST_CASE("sign_det_batch2") {
+  std::mt19937 gen(0);
+  for (int run = 0; run < nruns; run ++) {
+    test_batch2<4>(gen, 1);
+    test_batch2<8>(gen, 2);
+    test_batch2<16>(gen, 1 << 20);
+  }
+}
+
+TEST_CASE("sign_det_batch3") {
+  std::mt19937 gen(1);
+  for (int run = 0; run < nruns; run ++) {
+    test_batch3<4>(gen, 1);
+    test_batch3<8>(gen, 2);
+    test_batch3<16>(gen, 1 << 20);
+  }
+}
+
+// microbenchmark; hidden by default, run with `test_sign_det "[benchmark]"`
+template <int n>
+static void benchmark_batch3(const char *name, bool batched)
+{
+  const int nbatches = 1 << 16;
+  std::mt19937 gen(2);
+  std::vector<long long> X(nbatches * 12 * n);
+  std::vector<int> indices(nbatches * 4 * n);
+  for (int b = 0; b < nbatches; b ++)
+    random_simplices<n, 4, 3>(gen, 1 << 20,
+        (long long (*)[3][n])&X[b * 12 * n], (int (*)[n])&indices[b * 4 * n]);
+
+  typedef std::chrono::high_resolution_clock clock_type;
+  auto t0 = clock_type::now();
+
+  size_t count = 0;
+  for (int b = 0; b < nbatches; b ++) {
+    const long long (*Xb)[3][n] = (const long long (*)[3][n])&X[b * 12 * n];
+    const int (*ib)[n] = (const int (*)[n])&indices[b * 4 * n];
+    if (batched) {
+      bool cp[n];
+      ftk::robust_critical_point_in_simplex3_batch<n>(Xb, ib, cp);
+      for (int l = 0; l < n; l ++) count += cp[l];
+    } else {
+      for (int l = 0; l < n; l ++) {
+        long long Xl[4][3];
+        int il[4];
+        for (int i = 0; i < 4; i ++) {
+          il[i] = ib[i][l];
+          for (int j = 0; j < 3; j ++)
+            Xl[i][j] = Xb[i][j][l];
+        }
+        count += ftk::robust_critical_point_in_simplex3(Xl, il);
+      }
+    }
+  }
+
+  auto t1 = clock_type::now();
+  const double t = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+  fprintf(stderr, "%s: %f simplices/s (single thread), #cp=%zu\n", name, nbatches * n / t, count);
+}
+
+TEST_CASE("sign_det_batch_benchmark", "[.][benchmark]") {
+  benchmark_batch3<16>("scalar", false);
+  benchmark_batch3<4>("batch4", true);
+  benchmark_batch3<8>("batch8", true);
+  benchmark_batch3<16>("batch16", true);
+}
+
+#include "main.hh"
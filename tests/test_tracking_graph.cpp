@@ -0,0 +1,112 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch.hh"
+#include <ftk/tracking_graph/tracking_graph.hh>
+#include <ftk/tracking_graph/streaming_tracking_graph.hh>
+#include <ftk/external/diy/mpi.hpp>
+#include <random>
+
+typedef ftk::Event<size_t, size_t> event_t;
+
+static std::set<std::string> event_strings(const std::vector<event_t>& events)
+{
+  std::set<std::string> results;
+  for (const auto &e : events) 
+    results.insert(nlohmann::json(e).dump());
+  return results;
+}
+
+TEST_CASE("streaming_tracking_graph_events") {
+  ftk::streaming_tracking_graph<> stg(2);
+
+  // t=0: 1, 2; t=1: 1 (merge of 1 and 2); t=2: 1, 2 (split of 1); t=3: 3 (births and deaths)
+  stg.add_node(1); stg.add_node(2);
+  stg.advance_timestep();
+  REQUIRE(stg.get_global_label(0, 1) != stg.get_global_label(0, 2));
+
+  stg.add_edge(1, 1); stg.add_edge(2, 1);
+  stg.advance_timestep();
+  REQUIRE(stg.get_events(0).size() == 1);
+  REQUIRE(stg.get_events(0)[0].type() == ftk::FTK_EVENT_MERGE);
+
+  stg.add_edge(1, 1); stg.add_edge(1, 2);
+  stg.advance_timestep();
+  REQUIRE(stg.get_events(1).size() == 1);
+  REQUIRE(stg.get_events(1)[0].type() == ftk::FTK_EVENT_SPLIT);
+  REQUIRE(!stg.has_node(0, 1)); // out of the window
+  
+  stg.add_node(3);
+  stg.add_edge(2, 3);
+  stg.advance_timestep();
+  REQUIRE(stg.get_events(2).size() == 1);
+  REQUIRE(stg.get_events(2)[0].type() == ftk::FTK_EVENT_DEATH);
+  REQUIRE(stg.get_global_label(3, 3) == stg.get_global_label(2, 2)); // continued
+  REQUIRE(stg.get_timesteps().size() == 2);
+  REQUIRE(stg.get_number_of_flushed_timesteps() == 2);
+}
+
+TEST_CASE("streaming_tracking_graph_late_nodes") {
+  ftk::streaming_tracking_graph<> stg(3);
+  std::vector<event_t> streamed_events;
+  stg.set_event_callback([&](const event_t& e) { streamed_events.push_back(e); });
+  stg.set_label_callback([&](size_t t, size_t l, size_t label) { // callbacks may query the graph
+    REQUIRE(stg.get_global_label(t, l) == label);
+  });
+
+  // node 2 of t=1 only appears in the edges to t=2
+  stg.add_node(1);
+  stg.advance_timestep();
+  stg.add_edge(1, 1);
+  stg.advance_timestep();
+  REQUIRE(!stg.has_global_label(1, 2));
+
+  stg.add_edge(1, 1); stg.add_edge(2, 3);
+  REQUIRE(stg.has_global_label(1, 2));
+  const auto label = stg.get_global_label(1, 2);
+  REQUIRE(label != stg.get_global_label(1, 1));
+  REQUIRE(stg.get_events(0).size() == 1);
+  REQUIRE(stg.get_events(0)[0].type() == ftk::FTK_EVENT_BIRTH);
+
+  stg.advance_timestep();
+  REQUIRE(stg.get_global_label(2, 3) == label); // continued
+  REQUIRE(streamed_events.size() == 1);
+}
+
+TEST_CASE("streaming_tracking_graph_vs_tracking_graph") {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist(1, 8);
+  const size_t nt = 50;
+
+  ftk::tracking_graph<> tg;
+  ftk::streaming_tracking_graph<> stg(3);
+  std::vector<event_t> streamed_events;
+  stg.set_event_callback([&](const event_t& e) { streamed_events.push_back(e); });
+
+  for (size_t t = 0; t < nt; t ++) {
+    for (int i = 0; i < 6; i ++) {
+      const size_t l = dist(gen);
+      tg.add_node(t, l);
+      stg.add_node(l);
+    }
+    if (t > 0) 
+      for (int i = 0; i < 6; i ++) {
+        const size_t l0 = dist(gen), l1 = dist(gen);
+        if (tg.has_node(t-1, l0) && tg.has_node(t, l1)) {
+          tg.add_edge(t-1, l0, t, l1);
+          stg.add_edge(l0, l1);
+        }
+      }
+    stg.advance_timestep();
+    REQUIRE(stg.get_timesteps().size() <= 3);
+  }
+  stg.finish();
+
+  tg.detect_events();
+  std::vector<event_t> events;
+  for (const auto &kv : tg.get_events())
+    events.insert(events.end(), kv.second.begin(), kv.second.end());
+
+  REQUIRE(event_strings(events) == event_strings(streamed_events));
+  REQUIRE(stg.get_number_of_flushed_timesteps() == nt);
+}
+
+#include "main.hh"
@@ -2,6 +2,8 @@
 #include "catch.hh"
 #include <ftk/basic/union_find.hh>
 #include <ftk/basic/simple_union_find.hh>
+#include <ftk/basic/concurrent_union_find.hh>
+#include <thread>
 #include <string>
 
 // test (sparse) union-find
@@ -38,4 +40,26 @@ TEST_CASE("simple_union_find") {
   REQUIRE(!UF.same_set(1, 5));
 }
 
+// test concurrent union-find
+TEST_CASE("concurrent_union_find") {
+  const int n = 10000, nthreads = 4;
+  ftk::concurrent_union_find<int> UF(n); 
+
+  // chains of even and odd elements, united concurrently
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nthreads; t ++)
+    workers.push_back(std::thread([&, t]() {
+      for (int i = t; i + 2 < n; i += nthreads)
+        UF.unite(i + 2, i);
+    }));
+  for (auto &w : workers) w.join();
+
+  REQUIRE(UF.same_set(0, n-2));
+  REQUIRE(UF.same_set(1, n-1));
+  REQUIRE(!UF.same_set(0, 1));
+
+  REQUIRE(UF.find(n-2) == 0); // roots are the smallest elements
+  REQUIRE(UF.find(n-1) == 1);
+}
+
 #include "main.hh"